@@ -0,0 +1,243 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "bader_partitioning.h"
+#include "cell_list.h"
+
+#include <fstream>
+#include <boost/format.hpp>
+
+/**
+ * @brief      constructor
+ *
+ * @param[in]  _sf   scalar field
+ */
+BaderPartitioning::BaderPartitioning(const ScalarField* _sf) :
+    sf(_sf),
+    nr_maxima(0) {
+    this->sf->copy_grid_dimensions(this->grid_dimensions);
+}
+
+/**
+ * @brief      assign all grid points to the atoms and integrate the field
+ *             over the basins
+ *
+ * The grid points are distributed over the threads. Labels are read and
+ * written atomically; a path that runs into a point that is being assigned
+ * by another thread simply continues to the maximum, which yields the
+ * same atom.
+ */
+void BaderPartitioning::calculate() {
+    ScopedTimer timer("bader partitioning");
+
+    const unsigned int natoms = this->sf->get_nr_atoms();
+    if(natoms == 0) {
+        throw std::runtime_error("Bader partitioning requires at least one atom.");
+    }
+
+    const int nx = this->grid_dimensions[0];
+    const int ny = this->grid_dimensions[1];
+    const int nz = this->grid_dimensions[2];
+    const size_t npoints = (size_t)nx * ny * nz;
+    if(this->sf->get_size() != npoints) {
+        throw std::runtime_error("Grid has not been read.");
+    }
+    const float* grid = this->sf->is_sparse() ? nullptr : this->sf->get_grid_ptr();
+    auto value = [&](size_t idx) {
+        if(grid == nullptr) {
+            return this->sf->get_value(idx % nx, (idx / nx) % ny, idx / ((size_t)nx * ny));
+        }
+        return grid[idx];
+    };
+
+    // offsets to the 26 neighbors and the inverse of their distance
+    const glm::mat3& mat = this->sf->get_mat_unitcell();
+    int offsets[26][3];
+    float inv_dist[26];
+    unsigned int nn = 0;
+    for(int dz=-1; dz<=1; dz++) {
+        for(int dy=-1; dy<=1; dy++) {
+            for(int dx=-1; dx<=1; dx++) {
+                if(dx == 0 && dy == 0 && dz == 0) {
+                    continue;
+                }
+                offsets[nn][0] = dx;
+                offsets[nn][1] = dy;
+                offsets[nn][2] = dz;
+                inv_dist[nn] = 1.0f / glm::length(mat * glm::vec3(dx / (float)nx, dy / (float)ny, dz / (float)nz));
+                nn++;
+            }
+        }
+    }
+
+    // maxima are assigned to the nearest atom
+    const float spacing = std::cbrt(this->sf->get_volume() / natoms);
+    const CellList cell_list(mat, this->sf->get_atom_positions(), spacing);
+
+    this->labels.assign(npoints, -1);
+    int* labels_ptr = this->labels.data();
+    unsigned int maxima = 0;
+
+    #pragma omp parallel reduction(+:maxima)
+    {
+        EDP_TRACE_SCOPE("bader ascent");
+        std::vector<size_t> path;
+
+        #pragma omp for schedule(dynamic, 4096) nowait
+        for(size_t idx=0; idx<npoints; idx++) {
+            int label;
+            #pragma omp atomic read
+            label = labels_ptr[idx];
+            if(label >= 0) {
+                continue;
+            }
+
+            // follow the path of steepest ascent
+            path.clear();
+            size_t cur = idx;
+            while(true) {
+                #pragma omp atomic read
+                label = labels_ptr[cur];
+                if(label >= 0) {
+                    break;
+                }
+                path.push_back(cur);
+
+                const int i = cur % nx;
+                const int j = (cur / nx) % ny;
+                const int k = cur / ((size_t)nx * ny);
+                const float val = value(cur);
+
+                float best_gradient = 0.0f;
+                size_t best = cur;
+                bool has_lower = false;
+                for(unsigned int n=0; n<26; n++) {
+                    const int ii = (i + offsets[n][0] + nx) % nx;
+                    const int jj = (j + offsets[n][1] + ny) % ny;
+                    const int kk = (k + offsets[n][2] + nz) % nz;
+                    const size_t nidx = ((size_t)kk * ny + jj) * nx + ii;
+                    const float gradient = (value(nidx) - val) * inv_dist[n];
+                    has_lower |= gradient < 0.0f;
+                    if(gradient > best_gradient) {
+                        best_gradient = gradient;
+                        best = nidx;
+                    }
+                }
+
+                if(best == cur) {
+                    // maximum; grid values are located at the centers of the voxels
+                    const glm::vec3 p = mat * glm::vec3((i + 0.5f) / nx, (j + 0.5f) / ny, (k + 0.5f) / nz);
+                    label = cell_list.find_nearest(p).atom;
+                    if(has_lower) {
+                        maxima++;   // do not count points on a plateau (e.g. vacuum)
+                    }
+                    break;
+                }
+                cur = best;
+            }
+
+            for(size_t pidx : path) {
+                #pragma omp atomic write
+                labels_ptr[pidx] = label;
+            }
+        }
+    }
+    this->nr_maxima = maxima;
+
+    // integrate over the basins
+    std::vector<double> sum(natoms, 0.0);
+    std::vector<size_t> count(natoms, 0);
+
+    #pragma omp parallel
+    {
+        EDP_TRACE_SCOPE("bader integration");
+        std::vector<double> local_sum(natoms, 0.0);
+        std::vector<size_t> local_count(natoms, 0);
+
+        #pragma omp for schedule(static) nowait
+        for(int k=0; k<nz; k++) {
+            const size_t start = (size_t)k * nx * ny;
+            for(size_t idx=start; idx<start + (size_t)nx * ny; idx++) {
+                local_sum[labels_ptr[idx]] += value(idx);
+                local_count[labels_ptr[idx]]++;
+            }
+        }
+
+        #pragma omp critical
+        {
+            for(unsigned int a=0; a<natoms; a++) {
+                sum[a] += local_sum[a];
+                count[a] += local_count[a];
+            }
+        }
+    }
+
+    const double dv = this->sf->get_volume() / (double)npoints;
+    this->charges.resize(natoms);
+    this->volumes.resize(natoms);
+    for(unsigned int a=0; a<natoms; a++) {
+        this->charges[a] = sum[a] * dv;
+        this->volumes[a] = count[a] * dv;
+    }
+
+    timer.set_bytes(npoints * sizeof(float));
+    timer.set_items(npoints, "values");
+}
+
+/**
+ * @brief      write the volume and charge of each atom to a table
+ *
+ * @param[in]  filename  output file
+ */
+void BaderPartitioning::write(const std::string& filename) const {
+    std::ofstream out(filename);
+    out << boost::format("%6s  %14s  %14s\n") % "# atom" % "volume" % "charge";
+    double total = 0.0;
+    for(unsigned int a=0; a<this->charges.size(); a++) {
+        out << boost::format("%6i  %14.6f  %14.6f\n") % (a + 1) % this->volumes[a] % this->charges[a];
+        total += this->charges[a];
+    }
+    out.close();
+
+    std::cout << "Writing Bader charges of " << this->charges.size() << " atoms (" << this->nr_maxima
+              << " maxima, total: " << total << ") to " << filename << std::endl;
+}
+
+/**
+ * @brief      get the atom whose basin contains a position
+ *
+ * @param[in]  p     cartesian position
+ *
+ * @return     atom index (0-based)
+ */
+int BaderPartitioning::get_atom(const glm::vec3& p) const {
+    if(this->labels.empty()) {
+        throw std::runtime_error("Bader partitioning has not been calculated.");
+    }
+
+    // voxel holding the position
+    const glm::vec3 f = glm::fract(this->sf->get_mat_unitcell_inverse() * p);
+    unsigned int c[3];
+    for(unsigned int d=0; d<3; d++) {
+        c[d] = std::min(this->grid_dimensions[d] - 1, (unsigned int)(f[d] * this->grid_dimensions[d]));
+    }
+
+    return this->labels[((size_t)c[2] * this->grid_dimensions[1] + c[1]) * this->grid_dimensions[0] + c[0]];
+}
@@ -0,0 +1,110 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _BADER_PARTITIONING_H
+#define _BADER_PARTITIONING_H
+
+#include <vector>
+#include <string>
+#include <glm/glm.hpp>
+
+#include "scalar_field.h"
+#include "memory_tracker.h"
+
+/**
+ * @brief      partitions a scalar field into Bader (atomic) basins by
+ *             on-grid steepest ascent
+ *
+ * From every grid point, the path of steepest ascent is followed over the
+ * (26) neighboring grid points until a maximum is reached. Each maximum is
+ * assigned to the nearest atom; all points on the path belong to the basin
+ * of that atom. Paths terminate as soon as they reach a point that has
+ * already been assigned, such that every point is visited only a few times.
+ */
+class BaderPartitioning {
+private:
+    const ScalarField* sf;
+
+    std::vector<int, TrackedAllocator<int, MemoryTracker::ANALYSIS>> labels;  //!< atom of each grid point
+    unsigned int grid_dimensions[3];
+
+    std::vector<double> charges;    //!< integral of the field over the basin of each atom
+    std::vector<double> volumes;    //!< volume of the basin of each atom
+    unsigned int nr_maxima;         //!< number of maxima (excluding plateaus)
+
+public:
+    /**
+     * @brief      constructor
+     *
+     * @param[in]  _sf   scalar field
+     */
+    BaderPartitioning(const ScalarField* _sf);
+
+    /**
+     * @brief      assign all grid points to the atoms and integrate the field
+     *             over the basins
+     */
+    void calculate();
+
+    /**
+     * @brief      write the volume and charge of each atom to a table
+     *
+     * @param[in]  filename  output file
+     */
+    void write(const std::string& filename) const;
+
+    /**
+     * @brief      get the atom whose basin contains a position
+     *
+     * @param[in]  p     cartesian position
+     *
+     * @return     atom index (0-based)
+     */
+    int get_atom(const glm::vec3& p) const;
+
+    /**
+     * @brief      get the integral of the field over the basin of each atom
+     *
+     * @return     charges
+     */
+    inline const std::vector<double>& get_charges() const {
+        return this->charges;
+    }
+
+    /**
+     * @brief      get the volume of the basin of each atom
+     *
+     * @return     volumes in angstrom^3
+     */
+    inline const std::vector<double>& get_volumes() const {
+        return this->volumes;
+    }
+
+    /**
+     * @brief      get the number of maxima of the field
+     *
+     * @return     number of maxima
+     */
+    inline unsigned int get_nr_maxima() const {
+        return this->nr_maxima;
+    }
+};
+
+#endif //_BADER_PARTITIONING_H
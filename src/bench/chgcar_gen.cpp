@@ -0,0 +1,86 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+/*
+ * PURPOSE
+ * =======
+ *
+ * Writes synthetic CHGCAR / LOCPOT files of configurable grid size, cell
+ * shape and number of atoms, e.g. for benchmarking EDP.
+ */
+
+#include <iostream>
+#include <tclap/CmdLine.h>
+
+#include "chgcar_generator.h"
+#include "config.h"
+
+int main(int argc, char *argv[]) {
+    try {
+        TCLAP::CmdLine cmd("Writes a synthetic CHGCAR or LOCPOT file.", ' ', PROGRAM_VERSION);
+
+        TCLAP::ValueArg<std::string> arg_output_filename("o","filename","Filename to write to",true,"CHGCAR","string");
+        cmd.add(arg_output_filename);
+
+        TCLAP::ValueArg<unsigned int> arg_nx("x","nx","Grid points along a",false,100,"unsigned integer");
+        cmd.add(arg_nx);
+
+        TCLAP::ValueArg<unsigned int> arg_ny("y","ny","Grid points along b",false,100,"unsigned integer");
+        cmd.add(arg_ny);
+
+        TCLAP::ValueArg<unsigned int> arg_nz("z","nz","Grid points along c",false,150,"unsigned integer");
+        cmd.add(arg_nz);
+
+        TCLAP::ValueArg<std::string> arg_shape("c","cell","Cell shape (orthorhombic, hexagonal or triclinic)",false,"orthorhombic","string");
+        cmd.add(arg_shape);
+
+        TCLAP::ValueArg<unsigned int> arg_atoms("n","atoms","Number of atoms",false,10,"unsigned integer");
+        cmd.add(arg_atoms);
+
+        TCLAP::ValueArg<float> arg_a("a","lattice","Length of the lattice vectors in angstrom",false,10.0f,"float");
+        cmd.add(arg_a);
+
+        TCLAP::ValueArg<unsigned int> arg_seed("s","seed","Seed for placing the atoms",false,42,"unsigned integer");
+        cmd.add(arg_seed);
+
+        TCLAP::SwitchArg arg_locpot("l","locpot","Write a LOCPOT instead of a CHGCAR", cmd, false);
+
+        cmd.parse(argc, argv);
+
+        ChgcarGenerator gen(arg_nx.getValue(), arg_ny.getValue(), arg_nz.getValue(),
+                            ChgcarGenerator::get_shape(arg_shape.getValue()),
+                            arg_atoms.getValue(), arg_locpot.getValue());
+        gen.set_lattice_constant(arg_a.getValue());
+        gen.set_seed(arg_seed.getValue());
+        gen.write(arg_output_filename.getValue());
+
+        std::cout << "Written " << arg_output_filename.getValue() << std::endl;
+
+        return 0;
+
+    } catch (TCLAP::ArgException &e) {
+        std::cerr << "error: " << e.error() <<
+                     " for arg " << e.argId() << std::endl;
+        return -1;
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return -1;
+    }
+}
@@ -0,0 +1,255 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "chgcar_generator.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+
+/**
+ * @brief      constructor
+ *
+ * @param[in]  nx                grid points along a
+ * @param[in]  ny                grid points along b
+ * @param[in]  nz                grid points along c
+ * @param[in]  _shape            shape of the unit cell
+ * @param[in]  _nr_atoms         number of atoms
+ * @param[in]  _flag_is_locpot   write a LOCPOT (no volume scaling) instead of a CHGCAR
+ */
+ChgcarGenerator::ChgcarGenerator(unsigned int nx, unsigned int ny, unsigned int nz,
+                                 CellShape _shape, unsigned int _nr_atoms, bool _flag_is_locpot) :
+    shape(_shape),
+    nr_atoms(_nr_atoms),
+    lattice_constant(10.0f),
+    flag_is_locpot(_flag_is_locpot),
+    seed(42) {
+    if(nx == 0 || ny == 0 || nz == 0) {
+        throw std::runtime_error("Grid dimensions should be positive.");
+    }
+    this->grid_dimensions[0] = nx;
+    this->grid_dimensions[1] = ny;
+    this->grid_dimensions[2] = nz;
+}
+
+/**
+ * @brief      set length of the lattice vectors
+ *
+ * @param[in]  _lattice_constant  length in angstrom
+ */
+void ChgcarGenerator::set_lattice_constant(float _lattice_constant) {
+    this->lattice_constant = _lattice_constant;
+}
+
+/**
+ * @brief      set the seed of the random number generator
+ *
+ * @param[in]  _seed  seed
+ */
+void ChgcarGenerator::set_seed(unsigned int _seed) {
+    this->seed = _seed;
+}
+
+/**
+ * @brief      convert name of a cell shape to the corresponding enum
+ *
+ * @param[in]  name  orthorhombic, hexagonal or triclinic
+ *
+ * @return     cell shape
+ */
+ChgcarGenerator::CellShape ChgcarGenerator::get_shape(const std::string& name) {
+    if(name == "orthorhombic") {
+        return ORTHORHOMBIC;
+    } else if(name == "hexagonal") {
+        return HEXAGONAL;
+    } else if(name == "triclinic") {
+        return TRICLINIC;
+    }
+
+    throw std::runtime_error("Unknown cell shape: " + name);
+}
+
+/**
+ * @brief      write the file
+ *
+ * @param[in]  filename  path to output file
+ */
+void ChgcarGenerator::write(const std::string& filename) {
+    this->build_unitcell();
+    this->place_atoms();
+    const std::vector<float> grid = this->calculate_grid();
+
+    FILE* f = fopen(filename.c_str(), "w");
+    if(f == NULL) {
+        throw std::runtime_error("Cannot open " + filename + " for writing.");
+    }
+
+    // header; atoms are divided over (at most) three elements
+    static const char* elements[] = {"C", "O", "H"};
+    const unsigned int nr_elements = std::min(this->nr_atoms, 3u);
+    fprintf(f, "synthetic %s\n", this->flag_is_locpot ? "LOCPOT" : "CHGCAR");
+    fprintf(f, "   1.00000000000000\n");
+    for(unsigned int i=0; i<3; i++) {
+        fprintf(f, "  %12.6f  %12.6f  %12.6f\n", this->mat[i][0], this->mat[i][1], this->mat[i][2]);
+    }
+    for(unsigned int i=0; i<nr_elements; i++) {
+        fprintf(f, "   %s", elements[i]);
+    }
+    fprintf(f, "\n");
+    for(unsigned int i=0; i<nr_elements; i++) {
+        fprintf(f, "  %4i", this->nr_atoms / nr_elements + (i < this->nr_atoms % nr_elements ? 1 : 0));
+    }
+    fprintf(f, "\nDirect\n");
+    for(const glm::vec3& p : this->atom_pos) {
+        fprintf(f, "  %10.6f  %10.6f  %10.6f\n", p[0], p[1], p[2]);
+    }
+    fprintf(f, "\n  %i  %i  %i\n", this->grid_dimensions[0], this->grid_dimensions[1], this->grid_dimensions[2]);
+
+    // grid; five values per line
+    for(size_t i=0; i<grid.size(); i++) {
+        fprintf(f, " %17.11E", grid[i]);
+        if(i % 5 == 4 || i + 1 == grid.size()) {
+            fprintf(f, "\n");
+        }
+    }
+
+    fclose(f);
+}
+
+/**
+ * @brief      construct the lattice vectors for the requested cell shape
+ */
+void ChgcarGenerator::build_unitcell() {
+    const float a = this->lattice_constant;
+
+    switch(this->shape) {
+        case ORTHORHOMBIC:
+            this->mat[0] = glm::vec3(a, 0, 0);
+            this->mat[1] = glm::vec3(0, 1.1f * a, 0);
+            this->mat[2] = glm::vec3(0, 0, 1.5f * a);
+        break;
+        case HEXAGONAL:
+            this->mat[0] = glm::vec3(a, 0, 0);
+            this->mat[1] = glm::vec3(-0.5f * a, std::sqrt(3.0f) / 2.0f * a, 0);
+            this->mat[2] = glm::vec3(0, 0, 1.5f * a);
+        break;
+        case TRICLINIC: {
+            // alpha = 80, beta = 70, gamma = 100 degrees
+            const float alpha = 80.0f * M_PI / 180.0f;
+            const float beta = 70.0f * M_PI / 180.0f;
+            const float gamma = 100.0f * M_PI / 180.0f;
+            const float c = 1.2f * a;
+            const float cx = c * std::cos(beta);
+            const float cy = c * (std::cos(alpha) - std::cos(beta) * std::cos(gamma)) / std::sin(gamma);
+            this->mat[0] = glm::vec3(a, 0, 0);
+            this->mat[1] = glm::vec3(a * std::cos(gamma), a * std::sin(gamma), 0);
+            this->mat[2] = glm::vec3(cx, cy, std::sqrt(c * c - cx * cx - cy * cy));
+        }
+        break;
+        default:
+            throw std::runtime_error("Unknown cell shape.");
+    }
+}
+
+/**
+ * @brief      randomly place atoms in the unit cell
+ */
+void ChgcarGenerator::place_atoms() {
+    std::mt19937 rng(this->seed);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    this->atom_pos.clear();
+    for(unsigned int i=0; i<this->nr_atoms; i++) {
+        const float x = dist(rng);
+        const float y = dist(rng);
+        const float z = dist(rng);
+        this->atom_pos.push_back(glm::vec3(x, y, z));
+    }
+}
+
+/**
+ * @brief      calculate the values on the grid as a sum of Gaussians
+ *
+ * @return     grid values (x runs fastest)
+ */
+std::vector<float> ChgcarGenerator::calculate_grid() const {
+    const unsigned int nx = this->grid_dimensions[0];
+    const unsigned int ny = this->grid_dimensions[1];
+    const unsigned int nz = this->grid_dimensions[2];
+    const float volume = glm::dot(glm::cross(this->mat[0], this->mat[1]), this->mat[2]);
+    const glm::mat3 imat = glm::inverse(this->mat);
+
+    // only evaluate the Gaussians within a cutoff radius
+    static const float alpha = 2.0f;
+    static const float cutoff = 3.0f;
+    int extent[3];
+    for(unsigned int d=0; d<3; d++) {
+        // extent of the cutoff sphere in fractional coordinates is given by the
+        // norm of the corresponding row of the inverse matrix
+        const glm::vec3 row(imat[0][d], imat[1][d], imat[2][d]);
+        extent[d] = std::ceil(cutoff * glm::length(row) * this->grid_dimensions[d]);
+        extent[d] = std::min(extent[d], int((this->grid_dimensions[d] - 1) / 2));
+    }
+
+    std::vector<float> grid((size_t)nx * ny * nz, 0.0f);
+
+    #pragma omp parallel for schedule(dynamic)
+    for(unsigned int k=0; k<nz; k++) {
+        for(const glm::vec3& p : this->atom_pos) {
+            // nearest grid point to the atom
+            const int ci = std::round(p[0] * nx);
+            const int cj = std::round(p[1] * ny);
+            const int ck = std::round(p[2] * nz);
+
+            // z-offset of this layer with respect to the atom (minimum image)
+            int dk = (int)k - ck;
+            dk -= (int)nz * (int)std::round(dk / (float)nz);
+            if(std::abs(dk) > extent[2]) {
+                continue;
+            }
+
+            for(int dj=-extent[1]; dj<=extent[1]; dj++) {
+                const unsigned int j = ((cj + dj) % (int)ny + ny) % ny;
+                for(int di=-extent[0]; di<=extent[0]; di++) {
+                    const unsigned int i = ((ci + di) % (int)nx + nx) % nx;
+                    const glm::vec3 frac((ci + di) / (float)nx - p[0],
+                                         (cj + dj) / (float)ny - p[1],
+                                         (ck + dk) / (float)nz - p[2]);
+                    const glm::vec3 r = this->mat * frac;
+                    const float r2 = glm::dot(r, r);
+                    if(r2 > cutoff * cutoff) {
+                        continue;
+                    }
+                    grid[((size_t)k * ny + j) * nx + i] += std::exp(-alpha * r2);
+                }
+            }
+        }
+    }
+
+    // CHGCAR files store the density multiplied by the cell volume; LOCPOT
+    // files store the (negative) potential with a vacuum level of 5 eV
+    #pragma omp parallel for
+    for(size_t i=0; i<grid.size(); i++) {
+        grid[i] = this->flag_is_locpot ? 5.0f - 10.0f * grid[i] : grid[i] * volume;
+    }
+
+    return grid;
+}
@@ -0,0 +1,107 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _CHGCAR_GENERATOR_H
+#define _CHGCAR_GENERATOR_H
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @brief      writes synthetic CHGCAR / LOCPOT files for benchmarking
+ *
+ * The density is a sum of Gaussians centered on randomly placed atoms
+ * (fixed seed), such that files are reproducible between runs.
+ */
+class ChgcarGenerator {
+public:
+    enum CellShape {
+        ORTHORHOMBIC,
+        HEXAGONAL,
+        TRICLINIC,
+
+        NUM_CELL_SHAPES
+    };
+
+private:
+    unsigned int grid_dimensions[3];
+    CellShape shape;
+    unsigned int nr_atoms;
+    float lattice_constant;     //!< length of the lattice vectors in angstrom
+    bool flag_is_locpot;
+    unsigned int seed;
+
+    glm::mat3 mat;              //!< unit cell matrix (columns are lattice vectors)
+    std::vector<glm::vec3> atom_pos;   //!< fractional atom positions
+
+public:
+    /**
+     * @brief      constructor
+     *
+     * @param[in]  nx                grid points along a
+     * @param[in]  ny                grid points along b
+     * @param[in]  nz                grid points along c
+     * @param[in]  _shape            shape of the unit cell
+     * @param[in]  _nr_atoms         number of atoms
+     * @param[in]  _flag_is_locpot   write a LOCPOT (no volume scaling) instead of a CHGCAR
+     */
+    ChgcarGenerator(unsigned int nx, unsigned int ny, unsigned int nz,
+                    CellShape _shape, unsigned int _nr_atoms, bool _flag_is_locpot);
+
+    /**
+     * @brief      set length of the lattice vectors
+     *
+     * @param[in]  _lattice_constant  length in angstrom
+     */
+    void set_lattice_constant(float _lattice_constant);
+
+    /**
+     * @brief      set the seed of the random number generator
+     *
+     * @param[in]  _seed  seed
+     */
+    void set_seed(unsigned int _seed);
+
+    /**
+     * @brief      write the file
+     *
+     * @param[in]  filename  path to output file
+     */
+    void write(const std::string& filename);
+
+    /**
+     * @brief      convert name of a cell shape to the corresponding enum
+     *
+     * @param[in]  name  orthorhombic, hexagonal or triclinic
+     *
+     * @return     cell shape
+     */
+    static CellShape get_shape(const std::string& name);
+
+private:
+    void build_unitcell();
+
+    void place_atoms();
+
+    std::vector<float> calculate_grid() const;
+};
+
+#endif // _CHGCAR_GENERATOR_H
@@ -0,0 +1,236 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+/*
+ * PURPOSE
+ * =======
+ *
+ * Benchmarks of the time-critical routines of EDP on synthetic CHGCAR files.
+ * The files are generated once per configuration in the working directory
+ * and reused afterwards.
+ */
+
+#include <map>
+#include <memory>
+#include <random>
+#include <benchmark/benchmark.h>
+#include <boost/format.hpp>
+
+#include "chgcar_generator.h"
+#include "scalar_field.h"
+#include "planeprojector.h"
+
+namespace {
+
+/**
+ * @brief      generate (if needed) a synthetic CHGCAR file
+ *
+ * @param[in]  n      number of grid points along a and b (1.5n along c)
+ * @param[in]  shape  cell shape
+ * @param[in]  atoms  number of atoms
+ *
+ * @return     path to file
+ */
+std::string get_chgcar(unsigned int n, unsigned int shape, unsigned int atoms) {
+    const std::string filename = (boost::format("CHGCAR_bench_%i_%i_%i") % n % shape % atoms).str();
+    if(!boost::filesystem::exists(filename)) {
+        ChgcarGenerator gen(n, n, n * 3 / 2, (ChgcarGenerator::CellShape)shape, atoms, false);
+        gen.write(filename);
+    }
+    return filename;
+}
+
+/**
+ * @brief      get a loaded scalar field; fields are cached between benchmarks
+ *
+ * @param[in]  n      number of grid points along a and b (1.5n along c)
+ * @param[in]  shape  cell shape
+ *
+ * @return     pointer to scalar field
+ */
+ScalarField* get_field(unsigned int n, unsigned int shape) {
+    static std::map<std::pair<unsigned int, unsigned int>, std::unique_ptr<ScalarField>> fields;
+    auto got = fields.find(std::make_pair(n, shape));
+    if(got != fields.end()) {
+        return got->second.get();
+    }
+
+    std::unique_ptr<ScalarField> sf(new ScalarField(get_chgcar(n, shape, 32), false));
+    sf->read();
+    ScalarField* ptr = sf.get();
+    fields.emplace(std::make_pair(n, shape), std::move(sf));
+    return ptr;
+}
+
+/**
+ * @brief      plane orientations used in the extraction benchmarks
+ */
+void get_orientation(unsigned int id, glm::vec3* v, glm::vec3* w) {
+    switch(id) {
+        case 0: // ac-plane
+            *v = glm::vec3(1,0,0);
+            *w = glm::vec3(0,0,1);
+        break;
+        case 1: // ab-plane
+            *v = glm::vec3(1,0,0);
+            *w = glm::vec3(0,1,0);
+        break;
+        default: // oblique plane
+            *v = glm::normalize(glm::vec3(1,1,0));
+            *w = glm::normalize(glm::vec3(-1,1,1));
+        break;
+    }
+}
+
+/**
+ * @brief      center of the unit cell
+ */
+glm::vec3 get_center(const ScalarField* sf) {
+    return sf->get_mat_unitcell() * glm::vec3(0.5f, 0.5f, 0.5f);
+}
+
+} // namespace
+
+static void BM_Parse(benchmark::State& state) {
+    const std::string filename = get_chgcar(state.range(0), state.range(1), 32);
+    for(auto _ : state) {
+        ScalarField sf(filename, false);
+        sf.read();
+        benchmark::DoNotOptimize(sf.get_grid_ptr());
+    }
+    state.SetBytesProcessed(state.iterations() * boost::filesystem::file_size(filename));
+}
+BENCHMARK(BM_Parse)->ArgsProduct({{32, 64, 128}, {0, 1, 2}})->Unit(benchmark::kMillisecond);
+
+static void BM_GetValueInterp(benchmark::State& state) {
+    const ScalarField* sf = get_field(state.range(0), state.range(1));
+
+    // random points in the unit cell
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    std::vector<glm::vec3> points(1 << 16);
+    for(auto& p : points) {
+        p = sf->get_mat_unitcell() * glm::vec3(dist(rng), dist(rng), dist(rng));
+    }
+
+    for(auto _ : state) {
+        float sum = 0.0f;
+        for(const auto& p : points) {
+            sum += sf->get_value_interp(p[0], p[1], p[2]);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK(BM_GetValueInterp)->ArgsProduct({{64}, {0, 1, 2}});
+
+static void BM_GetValuesInterpBatch(benchmark::State& state) {
+    const ScalarField* sf = get_field(state.range(0), state.range(1));
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(-0.5f, 1.5f);
+    std::vector<float> points(3 << 16);
+    for(unsigned int i=0; i<points.size() / 3; i++) {
+        const glm::vec3 p = sf->get_mat_unitcell() * glm::vec3(dist(rng), dist(rng), dist(rng));
+        points[i*3] = p[0];
+        points[i*3+1] = p[1];
+        points[i*3+2] = p[2];
+    }
+    std::vector<float> values(points.size() / 3);
+
+    for(auto _ : state) {
+        sf->get_values_interp(&points[0], values.size(), &values[0], true);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_GetValuesInterpBatch)->ArgsProduct({{64}, {0, 1, 2}})->UseRealTime();
+
+static void BM_Extract(benchmark::State& state) {
+    ScalarField* sf = get_field(64, state.range(1));
+    glm::vec3 v, w;
+    get_orientation(state.range(0), &v, &w);
+
+    size_t pixels = 0;
+    for(auto _ : state) {
+        PlaneProjector pp(sf, 0);
+        pp.set_scaling(false, -7, 1);
+        pp.extract(v, w, get_center(sf), 50, -10, 10, -10, 10);
+        pixels = (size_t)pp.get_width() * pp.get_height();
+    }
+    state.SetItemsProcessed(state.iterations() * pixels);
+}
+BENCHMARK(BM_Extract)->ArgsProduct({{0, 1, 2}, {0, 1, 2}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_Plot(benchmark::State& state) {
+    ScalarField* sf = get_field(64, 0);
+    PlaneProjector pp(sf, 0);
+    pp.set_scaling(false, -7, 1);
+    pp.extract(glm::vec3(1,0,0), glm::vec3(0,0,1), get_center(sf), 50, -10, 10, -10, 10);
+
+    for(auto _ : state) {
+        pp.plot();
+    }
+    state.SetItemsProcessed(state.iterations() * pp.get_width() * pp.get_height());
+}
+BENCHMARK(BM_Plot)->Unit(benchmark::kMillisecond);
+
+static void BM_Isolines(benchmark::State& state) {
+    ScalarField* sf = get_field(64, 0);
+    PlaneProjector pp(sf, 0);
+    pp.set_scaling(false, -7, 1);
+    pp.extract(glm::vec3(1,0,0), glm::vec3(0,0,1), get_center(sf), 50, -10, 10, -10, 10);
+    pp.plot();
+
+    for(auto _ : state) {
+        pp.isolines(10);
+    }
+    state.SetItemsProcessed(state.iterations() * pp.get_width() * pp.get_height());
+}
+BENCHMARK(BM_Isolines)->Unit(benchmark::kMillisecond);
+
+static void BM_SphereAverage(benchmark::State& state) {
+    ScalarField* sf = get_field(64, state.range(0));
+    PlaneProjector pp(sf, 0);
+
+    std::vector<float> radii;
+    for(float r = 0.0; r <= 2.0f; r += 0.01f) {
+        radii.push_back(r);
+    }
+
+    for(auto _ : state) {
+        benchmark::DoNotOptimize(pp.calculate_sphere_average(get_center(sf), radii));
+    }
+    state.SetItemsProcessed(state.iterations() * radii.size());
+}
+BENCHMARK(BM_SphereAverage)->DenseRange(0, 2)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_PlaneAverage(benchmark::State& state) {
+    ScalarField* sf = get_field(state.range(0), 0);
+    PlaneProjector pp(sf, 0);
+
+    for(auto _ : state) {
+        benchmark::DoNotOptimize(pp.calculate_plane_average());
+    }
+    state.SetBytesProcessed(state.iterations() * sf->get_size() * sizeof(float));
+}
+BENCHMARK(BM_PlaneAverage)->Arg(64)->Arg(128)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,105 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "bond_profiles.h"
+
+#include <fstream>
+#include <boost/format.hpp>
+
+/**
+ * @brief      constructor
+ *
+ * @param[in]  _sf          scalar field
+ * @param[in]  _nr_samples  number of samples along each bond
+ */
+BondProfiles::BondProfiles(const ScalarField* _sf, unsigned int _nr_samples) :
+    sf(_sf),
+    nr_samples(_nr_samples) {
+
+    if(this->nr_samples < 2) {
+        throw std::runtime_error("At least two samples per bond are required.");
+    }
+}
+
+/**
+ * @brief      find all bonds shorter than the cutoff and sample the field
+ *             along each of them
+ *
+ * @param[in]  cutoff  largest bond length in angstrom
+ */
+void BondProfiles::calculate(float cutoff) {
+    ScopedTimer timer("bond profiles");
+
+    const std::vector<glm::vec3> positions = this->sf->get_atom_positions();
+    const CellList cell_list(this->sf->get_mat_unitcell(), positions, cutoff);
+    this->bonds = cell_list.find_pairs();
+
+    const unsigned int n = this->nr_samples;
+    const int nbonds = this->bonds.size();
+    this->values.assign((size_t)nbonds * n, 0.0f);
+
+    #pragma omp parallel
+    {
+        EDP_TRACE_SCOPE("bond profiles");
+        std::vector<float> points((size_t)n * 3);
+
+        #pragma omp for schedule(static) nowait
+        for(int b=0; b<nbonds; b++) {
+            const glm::vec3& p = positions[this->bonds[b].i];
+            for(unsigned int s=0; s<n; s++) {
+                const glm::vec3 pp = p + this->bonds[b].v * (s / (float)(n - 1));
+                points[(size_t)s * 3] = pp[0];
+                points[(size_t)s * 3 + 1] = pp[1];
+                points[(size_t)s * 3 + 2] = pp[2];
+            }
+
+            // bonds to periodic images run outside the cell; their points are wrapped back
+            this->sf->get_values_interp(points.data(), n, &this->values[(size_t)b * n], true, false);
+        }
+    }
+
+    timer.set_items(this->values.size(), "points");
+}
+
+/**
+ * @brief      write the profiles of all bonds to a table
+ *
+ * Each row holds the bond index, both atoms (1-based), the bond length, the
+ * distance from the first atom and the value at that point.
+ *
+ * @param[in]  filename  output file
+ */
+void BondProfiles::write(const std::string& filename) const {
+    const unsigned int n = this->nr_samples;
+
+    std::ofstream out(filename);
+    out << boost::format("%6s  %6s  %6s  %12s  %12s  %14s\n") % "# bond" % "atom1" % "atom2" % "length" % "position" % "value";
+    for(unsigned int b=0; b<this->bonds.size(); b++) {
+        const float length = glm::length(this->bonds[b].v);
+        for(unsigned int s=0; s<n; s++) {
+            out << boost::format("%6i  %6i  %6i  %12.6f  %12.6f  %14.6e\n") % (b + 1)
+                   % (this->bonds[b].i + 1) % (this->bonds[b].j + 1) % length
+                   % (length * s / (float)(n - 1)) % this->values[(size_t)b * n + s];
+        }
+    }
+
+    out.close();
+    std::cout << "Writing " << this->bonds.size() << " bond profiles to " << filename << std::endl;
+}
@@ -0,0 +1,86 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _BOND_PROFILES_H
+#define _BOND_PROFILES_H
+
+#include <vector>
+#include <string>
+#include <glm/glm.hpp>
+
+#include "scalar_field.h"
+#include "cell_list.h"
+
+/**
+ * @brief      samples a scalar field along all bonds (pairs of atoms within
+ *             a cutoff distance, including periodic images)
+ */
+class BondProfiles {
+private:
+    const ScalarField* sf;
+    unsigned int nr_samples;        //!< number of samples along each bond (including both atoms)
+
+    std::vector<AtomPair> bonds;    //!< bonds
+    std::vector<float> values;      //!< values along each bond; sample index runs fastest
+
+public:
+    /**
+     * @brief      constructor
+     *
+     * @param[in]  _sf          scalar field
+     * @param[in]  _nr_samples  number of samples along each bond
+     */
+    BondProfiles(const ScalarField* _sf, unsigned int _nr_samples = 101);
+
+    /**
+     * @brief      find all bonds shorter than the cutoff and sample the field
+     *             along each of them
+     *
+     * @param[in]  cutoff  largest bond length in angstrom
+     */
+    void calculate(float cutoff);
+
+    /**
+     * @brief      write the profiles of all bonds to a table
+     *
+     * @param[in]  filename  output file
+     */
+    void write(const std::string& filename) const;
+
+    /**
+     * @brief      get the bonds
+     *
+     * @return     bonds
+     */
+    inline const std::vector<AtomPair>& get_bonds() const {
+        return this->bonds;
+    }
+
+    /**
+     * @brief      get the values along the bonds
+     *
+     * @return     values; sample index runs fastest
+     */
+    inline const std::vector<float>& get_values() const {
+        return this->values;
+    }
+};
+
+#endif //_BOND_PROFILES_H
@@ -0,0 +1,146 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "brick_summary.h"
+#include "sparse_grid.h"
+
+#include <algorithm>
+
+#include "profiler.h"
+#include "tracer.h"
+
+/**
+ * @brief      constructor (empty summary)
+ */
+BrickSummary::BrickSummary() {
+    for(unsigned int d=0; d<3; d++) {
+        this->grid_dimensions[d] = 0;
+        this->nr_bricks[d] = 0;
+    }
+}
+
+/**
+ * @brief      build the summary of a grid
+ *
+ * @param[in]  grid  grid values (x runs fastest)
+ * @param[in]  dim   grid dimensions
+ */
+void BrickSummary::build(const float* grid, const unsigned int dim[3]) {
+    this->build_rows(dim, [grid, dim](unsigned int j, unsigned int k, unsigned int, unsigned int, float*) {
+        return grid + ((size_t)k * dim[1] + j) * dim[0];
+    });
+}
+
+/**
+ * @brief      build the summary of a block-sparse grid, i.e. of the values
+ *             as they are stored
+ *
+ * @param[in]  grid  sparse grid
+ * @param[in]  dim   grid dimensions
+ */
+void BrickSummary::build(const SparseGrid& grid, const unsigned int dim[3]) {
+    this->build_rows(dim, [&grid](unsigned int j, unsigned int k, unsigned int i0, unsigned int i1, float* buffer) {
+        grid.copy_row(j, k, buffer, i0, i1);
+        return (const float*)buffer;
+    });
+}
+
+/**
+ * @brief      build the summary of a grid that is accessed per row
+ *
+ * @param[in]  dim     grid dimensions
+ * @param[in]  row_of  function returning a pointer to row (j,k) of which at
+ *                     least the span [i0,i1) is valid, possibly decoded into
+ *                     the buffer that is passed
+ */
+template<typename RowFunc>
+void BrickSummary::build_rows(const unsigned int dim[3], RowFunc row_of) {
+    ScopedTimer timer("brick summary");
+
+    for(unsigned int d=0; d<3; d++) {
+        this->grid_dimensions[d] = dim[d];
+        this->nr_bricks[d] = (dim[d] + size - 1) / size;
+    }
+    const size_t nbricks = (size_t)this->nr_bricks[0] * this->nr_bricks[1] * this->nr_bricks[2];
+    this->min.assign(nbricks, 0.0f);
+    this->max.assign(nbricks, 0.0f);
+    this->sum.assign(nbricks, 0.0);
+    this->halo_min.assign(nbricks, 0.0f);
+    this->halo_max.assign(nbricks, 0.0f);
+
+    const unsigned int nx = dim[0];
+    const unsigned int ny = dim[1];
+    const unsigned int nz = dim[2];
+
+    #pragma omp parallel
+    {
+        EDP_TRACE_SCOPE("brick summary");
+        std::vector<float> buffer(nx);
+        #pragma omp for schedule(static) nowait
+        for(size_t b=0; b<nbricks; b++) {
+            const unsigned int bx = b % this->nr_bricks[0];
+            const unsigned int by = (b / this->nr_bricks[0]) % this->nr_bricks[1];
+            const unsigned int bz = b / ((size_t)this->nr_bricks[0] * this->nr_bricks[1]);
+            unsigned int i0, i1, j0, j1, k0, k1;
+            this->get_extent(0, bx, i0, i1);
+            this->get_extent(1, by, j0, j1);
+            this->get_extent(2, bz, k0, k1);
+
+            float vmin = row_of(j0, k0, i0, i0 + 1, buffer.data())[i0];
+            float vmax = vmin;
+            double vsum = 0.0;
+            for(unsigned int k=k0; k<k1; k++) {
+                for(unsigned int j=j0; j<j1; j++) {
+                    const float* row = row_of(j, k, i0, i1, buffer.data());
+                    for(unsigned int i=i0; i<i1; i++) {
+                        vmin = std::min(vmin, row[i]);
+                        vmax = std::max(vmax, row[i]);
+                        vsum += row[i];
+                    }
+                }
+            }
+            this->min[b] = vmin;
+            this->max[b] = vmax;
+            this->sum[b] = vsum;
+
+            // extend the range with the first layer of the next bricks (periodic);
+            // rows inside the brick only contribute their wrapped element i1 % nx
+            for(unsigned int k=k0; k<=k1; k++) {
+                for(unsigned int j=j0; j<=j1; j++) {
+                    if(j == j1 || k == k1) {
+                        const float* row = row_of(j % ny, k % nz, i0, i1, buffer.data());
+                        for(unsigned int i=i0; i<i1; i++) {
+                            vmin = std::min(vmin, row[i]);
+                            vmax = std::max(vmax, row[i]);
+                        }
+                    }
+                    const float wrapped = row_of(j % ny, k % nz, i1 % nx, i1 % nx + 1, buffer.data())[i1 % nx];
+                    vmin = std::min(vmin, wrapped);
+                    vmax = std::max(vmax, wrapped);
+                }
+            }
+            this->halo_min[b] = vmin;
+            this->halo_max[b] = vmax;
+        }
+    }
+
+    timer.set_bytes((size_t)dim[0] * dim[1] * dim[2] * sizeof(float));
+    timer.set_items(nbricks, "bricks");
+}
@@ -0,0 +1,185 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _BRICK_SUMMARY_H
+#define _BRICK_SUMMARY_H
+
+#include <vector>
+#include <cstddef>
+
+class SparseGrid;
+
+/**
+ * @brief      coarse summary of a grid in bricks of size^3 grid points
+ *
+ * For every brick, the minimum, maximum and sum of the values are stored,
+ * such that analyses can skip bricks that cannot contribute (e.g. vacuum)
+ * or use the sum of a brick that lies entirely within a region. Bricks at
+ * the upper boundaries of the grid may be smaller when the grid dimensions
+ * are not a multiple of the brick size.
+ */
+class BrickSummary {
+public:
+    static const unsigned int size = 8;     //!< number of grid points along each edge of a brick
+
+private:
+    unsigned int grid_dimensions[3];
+    unsigned int nr_bricks[3];
+    std::vector<float> min;
+    std::vector<float> max;
+    std::vector<double> sum;
+    std::vector<float> halo_min;    //!< minimum including the first layer of the next bricks
+    std::vector<float> halo_max;    //!< maximum including the first layer of the next bricks
+
+public:
+    /**
+     * @brief      constructor (empty summary)
+     */
+    BrickSummary();
+
+    /**
+     * @brief      build the summary of a grid
+     *
+     * @param[in]  grid  grid values (x runs fastest)
+     * @param[in]  dim   grid dimensions
+     */
+    void build(const float* grid, const unsigned int dim[3]);
+
+    /**
+     * @brief      build the summary of a block-sparse grid, i.e. of the values
+     *             as they are stored
+     *
+     * @param[in]  grid  sparse grid
+     * @param[in]  dim   grid dimensions
+     */
+    void build(const SparseGrid& grid, const unsigned int dim[3]);
+
+    /**
+     * @brief      whether the summary has been built
+     *
+     * @return     true if built
+     */
+    inline bool is_built() const {
+        return !this->min.empty();
+    }
+
+    /**
+     * @brief      get the number of bricks along a lattice vector
+     *
+     * @param[in]  d     lattice vector
+     *
+     * @return     number of bricks
+     */
+    inline unsigned int get_nr_bricks(unsigned int d) const {
+        return this->nr_bricks[d];
+    }
+
+    /**
+     * @brief      get the index of a brick
+     *
+     * @param[in]  bx    brick index along a
+     * @param[in]  by    brick index along b
+     * @param[in]  bz    brick index along c
+     *
+     * @return     index
+     */
+    inline size_t get_index(unsigned int bx, unsigned int by, unsigned int bz) const {
+        return ((size_t)bz * this->nr_bricks[1] + by) * this->nr_bricks[0] + bx;
+    }
+
+    /**
+     * @brief      get the range of grid points of a brick along a lattice vector
+     *
+     * @param[in]  d     lattice vector
+     * @param[in]  b     brick index along d
+     * @param[out] lo    first grid point
+     * @param[out] hi    one beyond the last grid point
+     */
+    inline void get_extent(unsigned int d, unsigned int b, unsigned int& lo, unsigned int& hi) const {
+        lo = b * size;
+        hi = lo + size < this->grid_dimensions[d] ? lo + size : this->grid_dimensions[d];
+    }
+
+    /**
+     * @brief      get the minimum value in a brick
+     *
+     * @param[in]  idx   brick index
+     *
+     * @return     minimum value
+     */
+    inline float get_min(size_t idx) const {
+        return this->min[idx];
+    }
+
+    /**
+     * @brief      get the maximum value in a brick
+     *
+     * @param[in]  idx   brick index
+     *
+     * @return     maximum value
+     */
+    inline float get_max(size_t idx) const {
+        return this->max[idx];
+    }
+
+    /**
+     * @brief      get the sum of the values in a brick
+     *
+     * @param[in]  idx   brick index
+     *
+     * @return     sum of the values
+     */
+    inline double get_sum(size_t idx) const {
+        return this->sum[idx];
+    }
+
+    /**
+     * @brief      get the range of the values in a brick and in the first
+     *             layer of grid points of the next bricks (periodic), i.e. the
+     *             range of all values that are involved in interpolating
+     *             within the brick
+     *
+     * @param[in]  bx    brick index along a
+     * @param[in]  by    brick index along b
+     * @param[in]  bz    brick index along c
+     * @param[out] vmin  minimum value
+     * @param[out] vmax  maximum value
+     */
+    inline void get_range_with_neighbors(unsigned int bx, unsigned int by, unsigned int bz,
+                                         float& vmin, float& vmax) const {
+        const size_t idx = this->get_index(bx, by, bz);
+        vmin = this->halo_min[idx];
+        vmax = this->halo_max[idx];
+    }
+
+private:
+    /**
+     * @brief      build the summary of a grid that is accessed per row
+     *
+     * @param[in]  dim     grid dimensions
+     * @param[in]  row_of  function returning a pointer to row (j,k) of which at
+     *                     least the span [i0,i1) is valid, possibly decoded
+     *                     into the buffer that is passed
+     */
+    template<typename RowFunc>
+    void build_rows(const unsigned int dim[3], RowFunc row_of);
+};
+
+#endif //_BRICK_SUMMARY_H
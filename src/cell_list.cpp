@@ -0,0 +1,299 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "cell_list.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "tracer.h"
+
+namespace {
+
+/**
+ * @brief      reduce a lattice basis such that no basis vector can be
+ *             shortened by adding or subtracting (combinations of) the
+ *             other basis vectors; in three dimensions this yields a
+ *             Minkowski-reduced basis of the same lattice
+ *
+ * @param[in]  m     lattice vectors (columns)
+ *
+ * @return     reduced lattice vectors (columns)
+ */
+glm::mat3 reduce_lattice(const glm::mat3& m) {
+    glm::dvec3 b[3] = {glm::dvec3(m[0]), glm::dvec3(m[1]), glm::dvec3(m[2])};
+
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        for(unsigned int i=0; i<3; i++) {
+            const unsigned int j = (i + 1) % 3;
+            const unsigned int k = (i + 2) % 3;
+
+            // size reduction against both other vectors
+            for(unsigned int o : {j, k}) {
+                const double q = std::round(glm::dot(b[i], b[o]) / glm::dot(b[o], b[o]));
+                if(q != 0.0 && glm::dot(b[i] - q * b[o], b[i] - q * b[o]) < glm::dot(b[i], b[i]) * (1.0 - 1e-10)) {
+                    b[i] -= q * b[o];
+                    changed = true;
+                }
+            }
+
+            // combinations with coefficients -1, 0 and 1 of the other vectors
+            for(int cj=-1; cj<=1; cj++) {
+                for(int ck=-1; ck<=1; ck++) {
+                    const glm::dvec3 w = b[i] + (double)cj * b[j] + (double)ck * b[k];
+                    if(glm::dot(w, w) < glm::dot(b[i], b[i]) * (1.0 - 1e-10)) {
+                        b[i] = w;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+
+    return glm::mat3(glm::vec3(b[0]), glm::vec3(b[1]), glm::vec3(b[2]));
+}
+
+} // namespace
+
+/**
+ * @brief      constructor
+ *
+ * @param[in]  _mat       lattice vectors (columns)
+ * @param[in]  positions  cartesian atom positions
+ * @param[in]  _cutoff    cutoff distance
+ */
+CellList::CellList(const glm::mat3& _mat, const std::vector<glm::vec3>& positions, float _cutoff) :
+    mat(_mat),
+    imat(glm::inverse(_mat)),
+    rmat(reduce_lattice(_mat)),
+    cutoff(_cutoff) {
+
+    this->irmat = glm::inverse(this->rmat);
+
+    if(this->cutoff <= 0.0f) {
+        throw std::runtime_error("Cutoff of the cell list should be positive.");
+    }
+
+    // the distance between opposite faces of the unit cell is the inverse of
+    // the norm of the corresponding row of the inverse matrix
+    static const unsigned int max_cells = 128;
+    for(unsigned int d=0; d<3; d++) {
+        const float cell_width = 1.0f / glm::length(glm::vec3(this->imat[0][d], this->imat[1][d], this->imat[2][d]));
+        this->ncells[d] = std::max(1u, std::min(max_cells, (unsigned int)(cell_width / this->cutoff)));
+        this->width[d] = cell_width / this->ncells[d];
+    }
+
+    // wrap positions to the unit cell
+    this->frac.resize(positions.size());
+    for(unsigned int i=0; i<positions.size(); i++) {
+        this->frac[i] = glm::fract(this->imat * positions[i]);
+    }
+
+    // sort atoms by cell (counting sort)
+    const unsigned int nr_cells = this->ncells[0] * this->ncells[1] * this->ncells[2];
+    std::vector<unsigned int> cell_of_atom(this->frac.size());
+    this->cell_start.assign(nr_cells + 1, 0);
+    for(unsigned int i=0; i<this->frac.size(); i++) {
+        int c[3];
+        this->get_cell(this->frac[i], c);
+        cell_of_atom[i] = (c[2] * this->ncells[1] + c[1]) * this->ncells[0] + c[0];
+        this->cell_start[cell_of_atom[i] + 1]++;
+    }
+    for(unsigned int c=0; c<nr_cells; c++) {
+        this->cell_start[c+1] += this->cell_start[c];
+    }
+    this->cell_atoms.resize(this->frac.size());
+    std::vector<unsigned int> fill(this->cell_start.begin(), this->cell_start.end() - 1);
+    for(unsigned int i=0; i<this->frac.size(); i++) {
+        this->cell_atoms[fill[cell_of_atom[i]]++] = i;
+    }
+}
+
+/**
+ * @brief      find all pairs of atoms (including periodic images) within
+ *             the cutoff distance
+ *
+ * @return     pairs of atoms
+ */
+std::vector<AtomPair> CellList::find_pairs() const {
+    std::vector<AtomPair> pairs;
+    const float cutoff2 = this->cutoff * this->cutoff;
+    const int natoms = this->frac.size();
+
+    #pragma omp parallel
+    {
+        EDP_TRACE_SCOPE("pair search");
+        std::vector<AtomPair> local;
+
+        #pragma omp for schedule(dynamic, 16) nowait
+        for(int i=0; i<natoms; i++) {
+            const glm::vec3& fi = this->frac[i];
+
+            // only report each pair once; images of the atom itself are
+            // reported for one of the two opposite shifts
+            this->visit(fi, this->cutoff, [&](unsigned int j, const glm::vec3& shift, bool positive_shift) {
+                if((int)j < i || ((int)j == i && !positive_shift)) {
+                    return;
+                }
+
+                const glm::vec3 v = this->mat * (this->frac[j] + shift - fi);
+                if(glm::dot(v, v) < cutoff2) {
+                    local.push_back({(unsigned int)i, j, v});
+                }
+            });
+        }
+
+        #pragma omp critical
+        pairs.insert(pairs.end(), local.begin(), local.end());
+    }
+
+    std::sort(pairs.begin(), pairs.end(), [](const AtomPair& a, const AtomPair& b) {
+        if(a.i != b.i) {
+            return a.i < b.i;
+        }
+        if(a.j != b.j) {
+            return a.j < b.j;
+        }
+        return glm::dot(a.v, a.v) < glm::dot(b.v, b.v);
+    });
+
+    return pairs;
+}
+
+/**
+ * @brief      find all atoms (including periodic images) within a radius
+ *             of a position
+ *
+ * @param[in]  p       cartesian position
+ * @param[in]  radius  radius (may exceed the cutoff)
+ *
+ * @return     atoms sorted by distance
+ */
+std::vector<Neighbor> CellList::find_within(const glm::vec3& p, float radius) const {
+    std::vector<Neighbor> neighbors;
+    const float radius2 = radius * radius;
+    const glm::vec3 fp = glm::fract(this->imat * p);
+
+    // positions are expressed relative to the image of p in the unit cell
+    this->visit(fp, radius, [&](unsigned int j, const glm::vec3& shift, bool) {
+        const glm::vec3 v = this->mat * (this->frac[j] + shift - fp);
+        if(glm::dot(v, v) <= radius2) {
+            neighbors.push_back({j, v});
+        }
+    });
+
+    std::sort(neighbors.begin(), neighbors.end(), [](const Neighbor& a, const Neighbor& b) {
+        return glm::dot(a.v, a.v) < glm::dot(b.v, b.v);
+    });
+
+    return neighbors;
+}
+
+/**
+ * @brief      find the atom (or periodic image) nearest to a position
+ *
+ * The search radius starts at the cutoff and is doubled until an atom is
+ * found.
+ *
+ * @param[in]  p     cartesian position
+ *
+ * @return     nearest atom
+ */
+Neighbor CellList::find_nearest(const glm::vec3& p) const {
+    if(this->frac.empty()) {
+        throw std::runtime_error("Cannot find the nearest atom in an empty cell list.");
+    }
+
+    const glm::vec3 fp = glm::fract(this->imat * p);
+    for(float radius = this->cutoff; ; radius *= 2.0f) {
+        Neighbor nearest = {0, glm::vec3(0.0f)};
+        float best = radius * radius;
+        bool found = false;
+        this->visit(fp, radius, [&](unsigned int j, const glm::vec3& shift, bool) {
+            const glm::vec3 v = this->mat * (this->frac[j] + shift - fp);
+            const float r2 = glm::dot(v, v);
+            if(r2 <= best) {
+                best = r2;
+                nearest = {j, v};
+                found = true;
+            }
+        });
+
+        if(found) {
+            return nearest;
+        }
+    }
+}
+
+/**
+ * @brief      get the shortest periodic image of a vector
+ *
+ * The vector is first wrapped by rounding its coordinates with respect to
+ * the reduced lattice. As the Voronoi-relevant vectors of a Minkowski-reduced
+ * lattice in three dimensions only have coefficients -1, 0 and 1, the image
+ * is subsequently shortened by these combinations until none of them
+ * yields a shorter vector, which is then the shortest image.
+ *
+ * @param[in]  v     cartesian vector
+ *
+ * @return     shortest vector v + n1 a1 + n2 a2 + n3 a3
+ */
+glm::vec3 CellList::get_minimum_image(const glm::vec3& v) const {
+    glm::vec3 f = this->irmat * v;
+    f -= glm::round(f);
+
+    glm::vec3 best = this->rmat * f;
+    float best2 = glm::dot(best, best);
+    bool improved = true;
+    while(improved) {
+        improved = false;
+        const glm::vec3 center = best;
+        for(int z=-1; z<=1; z++) {
+            for(int y=-1; y<=1; y++) {
+                for(int x=-1; x<=1; x++) {
+                    const glm::vec3 w = center + this->rmat * glm::vec3(x, y, z);
+                    const float w2 = glm::dot(w, w);
+                    if(w2 < best2 * (1.0f - 1e-6f)) {
+                        best = w;
+                        best2 = w2;
+                        improved = true;
+                    }
+                }
+            }
+        }
+    }
+
+    return best;
+}
+
+/**
+ * @brief      get the index of the cell holding a fractional position
+ *
+ * @param[in]  f     fractional position in [0,1)
+ * @param[out] c     cell index along each lattice vector
+ */
+void CellList::get_cell(const glm::vec3& f, int c[3]) const {
+    for(unsigned int d=0; d<3; d++) {
+        c[d] = std::min((int)this->ncells[d] - 1, (int)(f[d] * this->ncells[d]));
+    }
+}
@@ -0,0 +1,199 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _CELL_LIST_H
+#define _CELL_LIST_H
+
+#include <vector>
+#include <cmath>
+#include <glm/glm.hpp>
+
+/**
+ * @brief      pair of atoms within a cutoff distance
+ */
+struct AtomPair {
+    unsigned int i;     //!< index of the first atom
+    unsigned int j;     //!< index of the second atom
+    glm::vec3 v;        //!< vector from atom i to (the periodic image of) atom j
+};
+
+/**
+ * @brief      atom (or one of its periodic images) near a position
+ */
+struct Neighbor {
+    unsigned int atom;  //!< index of the atom
+    glm::vec3 v;        //!< vector from the position to the (image of the) atom
+};
+
+/**
+ * @brief      periodic cell list over the atoms in a (triclinic) unit cell
+ *
+ * The unit cell is divided in cells along the lattice vectors; the atoms are
+ * sorted by cell such that the atoms in a cell are stored consecutively. Each
+ * cell is at least as wide (measured perpendicular to the faces) as the
+ * cutoff, unless the unit cell is too narrow. Queries beyond the cutoff or
+ * in narrow cells simply search more (images of) cells.
+ */
+class CellList {
+private:
+    glm::mat3 mat;                          //!< lattice vectors (columns)
+    glm::mat3 imat;                         //!< inverse of the lattice matrix
+    glm::mat3 rmat;                         //!< Minkowski-reduced lattice vectors (columns)
+    glm::mat3 irmat;                        //!< inverse of the reduced lattice matrix
+    float cutoff;                           //!< cutoff distance
+
+    std::vector<glm::vec3> frac;            //!< fractional positions in [0,1)
+    unsigned int ncells[3];                 //!< number of cells along each lattice vector
+    float width[3];                         //!< width of a cell perpendicular to its faces
+    std::vector<unsigned int> cell_start;   //!< offset of each cell in cell_atoms
+    std::vector<unsigned int> cell_atoms;   //!< atom indices sorted by cell
+
+public:
+    /**
+     * @brief      constructor
+     *
+     * @param[in]  _mat       lattice vectors (columns)
+     * @param[in]  positions  cartesian atom positions
+     * @param[in]  _cutoff    cutoff distance
+     */
+    CellList(const glm::mat3& _mat, const std::vector<glm::vec3>& positions, float _cutoff);
+
+    /**
+     * @brief      find all pairs of atoms (including periodic images) within
+     *             the cutoff distance
+     *
+     * Each pair is reported once, sorted by the first atom, the second atom
+     * and the distance.
+     *
+     * @return     pairs of atoms
+     */
+    std::vector<AtomPair> find_pairs() const;
+
+    /**
+     * @brief      find all atoms (including periodic images) within a radius
+     *             of a position
+     *
+     * @param[in]  p       cartesian position
+     * @param[in]  radius  radius (may exceed the cutoff)
+     *
+     * @return     atoms sorted by distance
+     */
+    std::vector<Neighbor> find_within(const glm::vec3& p, float radius) const;
+
+    /**
+     * @brief      find the atom (or periodic image) nearest to a position
+     *
+     * @param[in]  p     cartesian position
+     *
+     * @return     nearest atom
+     */
+    Neighbor find_nearest(const glm::vec3& p) const;
+
+    /**
+     * @brief      get the shortest periodic image of a vector
+     *
+     * Rounding the fractional coordinates is not sufficient in skewed cells;
+     * the image is therefore searched in a Minkowski-reduced basis of the
+     * lattice, wherein descending over the neighboring images of the
+     * rounded vector yields the shortest image.
+     *
+     * @param[in]  v     cartesian vector
+     *
+     * @return     shortest vector v + n1 a1 + n2 a2 + n3 a3
+     */
+    glm::vec3 get_minimum_image(const glm::vec3& v) const;
+
+    /**
+     * @brief      get the number of atoms
+     *
+     * @return     number of atoms
+     */
+    inline unsigned int get_nr_atoms() const {
+        return this->frac.size();
+    }
+
+private:
+    /**
+     * @brief      get the index of the cell holding a fractional position
+     *
+     * @param[in]  f     fractional position in [0,1)
+     * @param[out] c     cell index along each lattice vector
+     */
+    void get_cell(const glm::vec3& f, int c[3]) const;
+
+    /**
+     * @brief      visit all (images of) atoms in the cells within reach of a
+     *             fractional position
+     *
+     * All atoms within the radius of the position are guaranteed to be
+     * visited (but more atoms may be visited).
+     *
+     * @param[in]  f       fractional position in [0,1)
+     * @param[in]  radius  search radius
+     * @param[in]  func    function called with the atom index, the image
+     *                     shift (fractional) and whether the shift is positive
+     */
+    template<typename Func>
+    void visit(const glm::vec3& f, float radius, Func func) const;
+};
+
+/**
+ * @brief      visit all (images of) atoms in the cells within reach of a
+ *             fractional position
+ *
+ * @param[in]  f       fractional position in [0,1)
+ * @param[in]  radius  search radius
+ * @param[in]  func    function called with the atom index, the image shift
+ *                     (fractional) and whether the shift is positive
+ */
+template<typename Func>
+void CellList::visit(const glm::vec3& f, float radius, Func func) const {
+    int c[3];
+    int reach[3];
+    this->get_cell(f, c);
+    for(unsigned int d=0; d<3; d++) {
+        reach[d] = (int)std::ceil(radius / this->width[d]);
+    }
+
+    for(int oz=-reach[2]; oz<=reach[2]; oz++) {
+        for(int oy=-reach[1]; oy<=reach[1]; oy++) {
+            for(int ox=-reach[0]; ox<=reach[0]; ox++) {
+                // neighboring cell and the periodic image it lies in
+                const int o[3] = {ox, oy, oz};
+                int cell[3];
+                glm::vec3 shift;
+                for(unsigned int d=0; d<3; d++) {
+                    const int cc = c[d] + o[d];
+                    const int n = this->ncells[d];
+                    cell[d] = ((cc % n) + n) % n;
+                    shift[d] = (float)((cc - cell[d]) / n);
+                }
+                const bool positive_shift = shift[2] > 0 || (shift[2] == 0 && (shift[1] > 0 || (shift[1] == 0 && shift[0] > 0)));
+
+                const unsigned int idx = (cell[2] * this->ncells[1] + cell[1]) * this->ncells[0] + cell[0];
+                for(unsigned int k=this->cell_start[idx]; k<this->cell_start[idx+1]; k++) {
+                    func(this->cell_atoms[k], shift, positive_shift);
+                }
+            }
+        }
+    }
+}
+
+#endif //_CELL_LIST_H
@@ -0,0 +1,275 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "chgcar_writer.h"
+
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <boost/format.hpp>
+
+#include "periodic_table.h"
+#include "file_error.h"
+#include "profiler.h"
+#include "tracer.h"
+
+namespace {
+
+/**
+ * @brief      get a power of ten from a table
+ *
+ * @param[in]  e     exponent (between -64 and 64)
+ *
+ * @return     10^e
+ */
+inline double pow10(int e) {
+    static const std::vector<double> table = [] {
+        std::vector<double> t(129);
+        for(int i=0; i<129; i++) {
+            t[i] = std::pow(10.0, i - 64);
+        }
+        return t;
+    }();
+    return table[e + 64];
+}
+
+} // namespace
+
+const size_t ChgcarWriter::chunk_size;
+const size_t ChgcarWriter::batch_size;
+
+/**
+ * @brief      constructor
+ *
+ * @param[in]  _sf   scalar field
+ */
+ChgcarWriter::ChgcarWriter(const ScalarField* _sf) :
+    sf(_sf) {}
+
+/**
+ * @brief      format a value as VASP does with (1X,E17.11), i.e. " 0.12345678901E+01"
+ *             or " -.12345678901E+01", which suffices to recover every float
+ *             exactly; every value takes 18 characters
+ *
+ * @param[in]  value  value
+ * @param[out] out    output buffer (at least 18 characters)
+ *
+ * @return     pointer beyond the last written character
+ */
+char* ChgcarWriter::format_value(float value, char* out) {
+    static const uint64_t lower = 10000000000ULL;      // 10^10
+    static const uint64_t upper = 100000000000ULL;     // 10^11
+
+    *out++ = ' ';
+    if(!std::isfinite(value)) {
+        const char* text = std::isnan(value) ? "NaN" : (value > 0 ? "Infinity" : "-Infinity");
+        while(*text) {
+            *out++ = *text++;
+        }
+        return out;
+    }
+
+    // the sign of a negative value replaces the leading zero
+    double d = value;
+    const bool negative = d < 0.0;
+    if(negative) {
+        d = -d;
+    }
+
+    // find the exponent such that d = 0.ddddddddddd * 10^e
+    int e = 0;
+    uint64_t digits = 0;
+    if(d > 0.0) {
+        e = (int)std::floor(std::ilogb(d) * 0.30102999566398120) + 1;
+        digits = (uint64_t)std::llround(d * pow10(11 - e));
+        while(digits >= upper) {
+            e++;
+            digits = (uint64_t)std::llround(d * pow10(11 - e));
+        }
+        while(digits < lower) {
+            e--;
+            digits = (uint64_t)std::llround(d * pow10(11 - e));
+        }
+    }
+
+    *out++ = negative ? '-' : '0';
+    *out++ = '.';
+    for(int i=10; i>=0; i--) {
+        out[i] = '0' + digits % 10;
+        digits /= 10;
+    }
+    out += 11;
+
+    *out++ = 'E';
+    *out++ = e < 0 ? '-' : '+';
+    e = std::abs(e);
+    *out++ = '0' + e / 10;
+    *out++ = '0' + e % 10;
+
+    return out;
+}
+
+/**
+ * @brief      write the scalar field; for CHGCAR files, the values are
+ *             multiplied by the cell volume as VASP does
+ *
+ * @param[in]  filename  output file
+ *
+ * @return     number of bytes written
+ */
+size_t ChgcarWriter::write(const std::string& filename) const {
+    unsigned int dim[3];
+    this->sf->copy_grid_dimensions(dim);
+    const size_t n = (size_t)dim[0] * dim[1] * dim[2];
+    if(this->sf->get_size() != n) {
+        throw std::runtime_error("Grid has not been read.");
+    }
+
+    ScopedTimer timer("chgcar write");
+
+    std::ofstream out(filename.c_str(), std::ios::binary);
+    if(!out) {
+        throw FileError("Cannot open " + filename + " for writing.");
+    }
+
+    const std::string header = this->build_header();
+    out.write(header.data(), header.size());
+    size_t bytes = header.size();
+
+    // 18 characters per value and a newline per five values
+    const size_t max_chunk_bytes = chunk_size * 18 + chunk_size / 5 + 1;
+    std::vector<std::vector<char>> buffers(batch_size, std::vector<char>(max_chunk_bytes));
+    std::vector<size_t> lengths(batch_size, 0);
+
+    const float factor = this->sf->is_locpot() ? 1.0f : this->sf->get_volume();
+    const size_t nchunks = (n + chunk_size - 1) / chunk_size;
+
+    for(size_t first=0; first<nchunks; first+=batch_size) {
+        const long count = std::min(batch_size, nchunks - first);
+
+        #pragma omp parallel
+        {
+            EDP_TRACE_SCOPE("chgcar format");
+            std::vector<float> row(dim[0]);
+
+            #pragma omp for schedule(dynamic) nowait
+            for(long c=0; c<count; c++) {
+                const size_t start = (first + c) * chunk_size;
+                lengths[c] = this->format_chunk(start, std::min(start + chunk_size, n), factor, buffers[c].data(), row);
+            }
+        }
+
+        for(long c=0; c<count; c++) {
+            out.write(buffers[c].data(), lengths[c]);
+            bytes += lengths[c];
+        }
+    }
+
+    if(!out) {
+        throw FileError("Error writing " + filename + ".");
+    }
+
+    timer.set_bytes(bytes);
+    timer.set_items(n, "values");
+
+    return bytes;
+}
+
+/**
+ * @brief      build the header (up to and including the grid dimensions)
+ *
+ * @return     header
+ */
+std::string ChgcarWriter::build_header() const {
+    std::string header = this->sf->get_filename() + "\n";
+    header += "   1.00000000000000\n";
+
+    const glm::mat3& mat = this->sf->get_mat_unitcell();
+    for(unsigned int i=0; i<3; i++) {
+        header += (boost::format("  %12.6f %12.6f %12.6f\n") % mat[i][0] % mat[i][1] % mat[i][2]).str();
+    }
+
+    const std::vector<unsigned int>& types = this->sf->get_atom_types();
+    if(!types.empty()) {
+        for(unsigned int elnr : types) {
+            header += (boost::format("%5s") % PeriodicTable::get().get_label_elnr(elnr)).str();
+        }
+        header += "\n";
+    }
+    for(unsigned int nr : this->sf->get_nr_atoms_per_type()) {
+        header += (boost::format("%6u") % nr).str();
+    }
+    header += "\nDirect\n";
+
+    // positions in fractional coordinates
+    const glm::mat3& imat = this->sf->get_mat_unitcell_inverse();
+    for(const glm::vec3& p : this->sf->get_atom_positions()) {
+        const glm::vec3 d = imat * p;
+        header += (boost::format("  %10.6f  %10.6f  %10.6f\n") % d[0] % d[1] % d[2]).str();
+    }
+
+    unsigned int dim[3];
+    this->sf->copy_grid_dimensions(dim);
+    header += (boost::format("\n %5u %5u %5u\n") % dim[0] % dim[1] % dim[2]).str();
+
+    return header;
+}
+
+/**
+ * @brief      format a range of values, five values per line
+ *
+ * @param[in]  start   index of the first value (multiple of five)
+ * @param[in]  end     index beyond the last value
+ * @param[in]  factor  factor to multiply the values with
+ * @param[out] out     output buffer
+ * @param      row     buffer for a row of the grid
+ *
+ * @return     number of characters written
+ */
+size_t ChgcarWriter::format_chunk(size_t start, size_t end, float factor, char* out, std::vector<float>& row) const {
+    unsigned int dim[3];
+    this->sf->copy_grid_dimensions(dim);
+    const size_t nx = dim[0];
+    const size_t ny = dim[1];
+
+    char* p = out;
+    size_t idx = start;
+    while(idx < end) {
+        // values are taken per row of the grid, which may be stored sparsely
+        const size_t i0 = idx % nx;
+        const float* values = this->sf->get_row((idx / nx) % ny, idx / (nx * ny), row.data());
+        const size_t row_end = std::min(end, idx - i0 + nx);
+        for(; idx<row_end; idx++) {
+            p = format_value(values[idx % nx] * factor, p);
+            if(idx % 5 == 4) {
+                *p++ = '\n';
+            }
+        }
+    }
+
+    // terminate an incomplete last line
+    if(end % 5 != 0) {
+        *p++ = '\n';
+    }
+
+    return p - out;
+}
@@ -0,0 +1,97 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _CHGCAR_WRITER_H
+#define _CHGCAR_WRITER_H
+
+#include <string>
+#include <vector>
+
+#include "scalar_field.h"
+
+/**
+ * @brief      write a scalar field in CHGCAR/LOCPOT format
+ *
+ * The header is reconstructed from the unit cell, the atoms and the grid
+ * dimensions of the scalar field. The values are formatted in parallel in
+ * chunks of whole lines into preallocated buffers, which are written to
+ * the file with large sequential writes.
+ */
+class ChgcarWriter {
+public:
+    static const size_t chunk_size = 5 * 8192;     //!< number of values per chunk (whole lines of five values)
+    static const size_t batch_size = 64;            //!< number of chunks formatted before writing
+
+private:
+    const ScalarField* sf;
+
+public:
+    /**
+     * @brief      constructor
+     *
+     * @param[in]  _sf   scalar field
+     */
+    ChgcarWriter(const ScalarField* _sf);
+
+    /**
+     * @brief      write the scalar field; for CHGCAR files, the values are
+     *             multiplied by the cell volume as VASP does
+     *
+     * @param[in]  filename  output file
+     *
+     * @return     number of bytes written
+     */
+    size_t write(const std::string& filename) const;
+
+    /**
+     * @brief      format a value as VASP does with (1X,E17.11), i.e.
+     *             " 0.12345678901E+01" or " -.12345678901E+01"; every value
+     *             takes 18 characters
+     *
+     * @param[in]  value  value
+     * @param[out] out    output buffer (at least 18 characters)
+     *
+     * @return     pointer beyond the last written character
+     */
+    static char* format_value(float value, char* out);
+
+private:
+    /**
+     * @brief      build the header (up to and including the grid dimensions)
+     *
+     * @return     header
+     */
+    std::string build_header() const;
+
+    /**
+     * @brief      format a range of values, five values per line
+     *
+     * @param[in]  start   index of the first value (multiple of five)
+     * @param[in]  end     index beyond the last value
+     * @param[in]  factor  factor to multiply the values with
+     * @param[out] out     output buffer
+     * @param      row     buffer for a row of the grid
+     *
+     * @return     number of characters written
+     */
+    size_t format_chunk(size_t start, size_t end, float factor, char* out, std::vector<float>& row) const;
+};
+
+#endif //_CHGCAR_WRITER_H
@@ -0,0 +1,176 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "cylindrical_average.h"
+#include "planeprojector.h"
+
+#include <cstdint>
+#include <fstream>
+#include <boost/filesystem.hpp>
+
+/**
+ * @brief      constructor
+ *
+ * @param[in]  _sf   scalar field
+ */
+CylindricalAverage::CylindricalAverage(const ScalarField* _sf) :
+    sf(_sf),
+    nz(0),
+    nr(0),
+    z0(0),
+    step(0) {}
+
+/**
+ * @brief      calculate the averages on the rings around the axis
+ *
+ * Each ring is an independent task. The number of points on a ring grows
+ * with its circumference, such that the points are approximately _step
+ * apart.
+ *
+ * @param[in]  p1         start of the axis
+ * @param[in]  p2         end of the axis
+ * @param[in]  radius     largest radius
+ * @param[in]  extension  extension of the axis beyond both points
+ * @param[in]  _step      axial and radial distance between subsequent rings
+ */
+void CylindricalAverage::calculate(const glm::vec3& p1, const glm::vec3& p2, float radius, float extension, float _step) {
+    ScopedTimer timer("cylindrical average");
+
+    if(_step <= 0.0f) {
+        throw std::runtime_error("Step of the cylindrical average should be positive.");
+    }
+    const float length = glm::length(p2 - p1);
+    if(length == 0.0f) {
+        throw std::runtime_error("The axis of the cylindrical average has zero length.");
+    }
+
+    // orthonormal frame with the axis along e
+    const glm::vec3 e = (p2 - p1) / length;
+    const glm::vec3 t = std::fabs(e[0]) < 0.9f ? glm::vec3(1,0,0) : glm::vec3(0,1,0);
+    const glm::vec3 u = glm::normalize(glm::cross(e, t));
+    const glm::vec3 v = glm::cross(e, u);
+
+    this->step = _step;
+    this->z0 = -extension;
+    this->nz = (unsigned int)((length + 2.0f * extension) / _step) + 1;
+    this->nr = (unsigned int)(radius / _step) + 1;
+    this->values.assign((size_t)this->nz * this->nr, 0.0f);
+
+    size_t npoints = 0;
+
+    #pragma omp parallel reduction(+:npoints)
+    {
+        EDP_TRACE_SCOPE("cylindrical average");
+        std::vector<float> ring;
+        std::vector<float> samples;
+
+        #pragma omp for collapse(2) schedule(dynamic) nowait
+        for(unsigned int k=0; k<this->nz; k++) {
+            for(unsigned int l=0; l<this->nr; l++) {
+                const glm::vec3 c = p1 + e * (this->z0 + k * _step);
+                const float r = l * _step;
+                const unsigned int nphi = std::max(8u, (unsigned int)std::ceil(2.0f * M_PI * r / _step));
+
+                // points on the ring
+                ring.resize((size_t)nphi * 3);
+                samples.resize(nphi);
+                for(unsigned int j=0; j<nphi; j++) {
+                    const float phi = 2.0f * M_PI * j / nphi;
+                    const glm::vec3 pp = c + r * (std::cos(phi) * u + std::sin(phi) * v);
+                    ring[(size_t)j * 3] = pp[0];
+                    ring[(size_t)j * 3 + 1] = pp[1];
+                    ring[(size_t)j * 3 + 2] = pp[2];
+                }
+
+                // interpolate the whole ring; points outside the cell wrap periodically
+                this->sf->get_values_interp(ring.data(), nphi, samples.data(), true, false);
+
+                double sum = 0.0;
+                for(unsigned int j=0; j<nphi; j++) {
+                    sum += samples[j];
+                }
+                this->values[(size_t)k * this->nr + l] = sum / nphi;
+                npoints += nphi;
+            }
+        }
+    }
+
+    timer.set_items(npoints, "points");
+}
+
+/**
+ * @brief      write the map as a binary file
+ *
+ * @param[in]  filename  output file
+ */
+void CylindricalAverage::write_binary(const std::string& filename) const {
+    std::ofstream out(filename, std::ios::binary);
+    if(!out) {
+        throw std::runtime_error("Cannot open " + filename + " for writing.");
+    }
+
+    const uint32_t dims[2] = {this->nz, this->nr};
+    const float axes[2] = {this->z0, this->step};
+    out.write(reinterpret_cast<const char*>(dims), sizeof(dims));
+    out.write(reinterpret_cast<const char*>(axes), sizeof(axes));
+    out.write(reinterpret_cast<const char*>(this->values.data()), this->values.size() * sizeof(float));
+    out.close();
+
+    std::cout << "Writing " << filename << std::endl;
+}
+
+/**
+ * @brief      plot the map on a logarithmic color scale and write it as png
+ *
+ * @param[in]  filename         path to png file
+ * @param[in]  color_scheme_id  color scheme identifier
+ * @param[in]  negative         whether to allow negative values
+ * @param[in]  log_min          lower bound (power of ten)
+ * @param[in]  log_max          upper bound (power of ten)
+ * @param[in]  scale            pixels per angstrom
+ */
+void CylindricalAverage::write_png(const std::string& filename, unsigned int color_scheme_id, bool negative,
+                                   float log_min, float log_max, float scale) const {
+    ScopedTimer timer("png write");
+
+    const unsigned int ix = std::max(1u, (unsigned int)((this->nz - 1) * this->step * scale));
+    const unsigned int iy = std::max(1u, (unsigned int)(2.0f * (this->nr - 1) * this->step * scale));
+    timer.set_items((size_t)ix * iy, "pixels");
+
+    ColorScheme scheme(negative ? -1 : 0, 1, color_scheme_id);
+    Plotter plt(ix, iy);
+
+    // same logarithmic scaling as the contour planes
+    for(unsigned int i=0; i<iy; i++) {
+        // radial position (mirrored around the axis in the middle of the image)
+        const float r = std::fabs((i + 0.5f) - 0.5f * iy) / scale;
+        const unsigned int l = std::min(this->nr - 1, (unsigned int)std::round(r / this->step));
+        for(unsigned int j=0; j<ix; j++) {
+            const unsigned int k = std::min(this->nz - 1, (unsigned int)std::round((j + 0.5f) / scale / this->step));
+            const float val = this->values[(size_t)k * this->nr + l];
+            const float scaled = PlaneProjector::scale_value_log(val, negative, log_min, log_max);
+            plt.draw_filled_rectangle(j, i, 1, 1, scheme.get_color(scaled));
+        }
+    }
+
+    plt.write(filename.c_str());
+    timer.set_bytes(boost::filesystem::exists(filename) ? boost::filesystem::file_size(filename) : 0);
+    std::cout << "Writing " << filename << std::endl;
+}
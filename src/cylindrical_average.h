@@ -0,0 +1,124 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _CYLINDRICAL_AVERAGE_H
+#define _CYLINDRICAL_AVERAGE_H
+
+#include <vector>
+#include <string>
+#include <glm/glm.hpp>
+
+#include "scalar_field.h"
+#include "plotter.h"
+
+/**
+ * @brief      averages a scalar field over rings around the axis between
+ *             two points (e.g. a bond) as function of the axial and radial
+ *             position
+ *
+ * The axial coordinate z runs from -extension (before the first point) to
+ * the length of the axis plus the extension (beyond the second point). The
+ * map is stored with the radial index running fastest.
+ */
+class CylindricalAverage {
+private:
+    const ScalarField* sf;
+
+    std::vector<float> values;  //!< average on each ring; radial index runs fastest
+    unsigned int nz;            //!< number of axial positions
+    unsigned int nr;            //!< number of radial positions
+    float z0;                   //!< axial position of the first ring
+    float step;                 //!< distance between subsequent rings
+
+public:
+    /**
+     * @brief      constructor
+     *
+     * @param[in]  _sf   scalar field
+     */
+    CylindricalAverage(const ScalarField* _sf);
+
+    /**
+     * @brief      calculate the averages on the rings around the axis
+     *
+     * @param[in]  p1         start of the axis
+     * @param[in]  p2         end of the axis
+     * @param[in]  radius     largest radius
+     * @param[in]  extension  extension of the axis beyond both points
+     * @param[in]  _step      axial and radial distance between subsequent rings
+     */
+    void calculate(const glm::vec3& p1, const glm::vec3& p2, float radius, float extension, float _step);
+
+    /**
+     * @brief      write the map as a binary file
+     *
+     * The file holds nz and nr (uint32), the axial position of the first ring
+     * and the step (float32), followed by nz * nr values (float32) with the
+     * radial index running fastest.
+     *
+     * @param[in]  filename  output file
+     */
+    void write_binary(const std::string& filename) const;
+
+    /**
+     * @brief      plot the map on a logarithmic color scale and write it as png
+     *
+     * The axis runs horizontally; the map is mirrored around the axis, such
+     * that the image resembles a cross-section through the axis.
+     *
+     * @param[in]  filename         path to png file
+     * @param[in]  color_scheme_id  color scheme identifier
+     * @param[in]  negative         whether to allow negative values
+     * @param[in]  log_min          lower bound (power of ten)
+     * @param[in]  log_max          upper bound (power of ten)
+     * @param[in]  scale            pixels per angstrom
+     */
+    void write_png(const std::string& filename, unsigned int color_scheme_id, bool negative,
+                   float log_min, float log_max, float scale) const;
+
+    /**
+     * @brief      get the averages
+     *
+     * @return     nz * nr values; radial index runs fastest
+     */
+    inline const std::vector<float>& get_values() const {
+        return this->values;
+    }
+
+    /**
+     * @brief      get number of axial positions
+     *
+     * @return     number of axial positions
+     */
+    inline unsigned int get_nz() const {
+        return this->nz;
+    }
+
+    /**
+     * @brief      get number of radial positions
+     *
+     * @return     number of radial positions
+     */
+    inline unsigned int get_nr() const {
+        return this->nr;
+    }
+};
+
+#endif //_CYLINDRICAL_AVERAGE_H
@@ -35,11 +35,24 @@
 
 #include <iostream>
 #include <chrono>
+#include <memory>
 #include <tclap/CmdLine.h>
 #include <boost/format.hpp>
+#include <boost/asio/ip/host_name.hpp>
 
 #include "scalar_field.h"
 #include "planeprojector.h"
+#include "sphere_integrator.h"
+#include "multipole_expansion.h"
+#include "cylindrical_average.h"
+#include "bond_profiles.h"
+#include "cell_list.h"
+#include "voronoi_partitioning.h"
+#include "isosurface.h"
+#include "chgcar_writer.h"
+#include "profiler.h"
+#include "tracer.h"
+#include "memory_tracker.h"
 #include "config.h"
 
 int main(int argc, char *argv[]) {
@@ -55,6 +68,14 @@ int main(int argc, char *argv[]) {
         TCLAP::ValueArg<std::string> arg_input_filename("i","input","Input file (i.e. CHGCAR)",true,"CHGCAR","filename");
         cmd.add(arg_input_filename);
 
+        // additional input files for an expression
+        TCLAP::MultiArg<std::string> arg_fields("","field","Additional input file for --expression (referred to as b, c, ... in order)",false,"filename");
+        cmd.add(arg_fields);
+
+        // elementwise expression of the input files
+        TCLAP::ValueArg<std::string> arg_expression("","expression","Elementwise expression of the input files, e.g. a-b-c (a is the file given by -i)",false,"","expression");
+        cmd.add(arg_expression);
+
         // output filename
         TCLAP::ValueArg<std::string> arg_output_filename("o","filename","Filename to print to",true,"test.png","string");
         cmd.add(arg_output_filename);
@@ -96,13 +117,121 @@ int main(int argc, char *argv[]) {
         TCLAP::ValueArg<std::string> arg_r("r","radius","Extraction at radius on atom",false, "", "Atom and radius");
         cmd.add(arg_r);
 
-        // whether or not to write out a z-average extraction
-        TCLAP::SwitchArg arg_z("z","zaverage","Averaging over z", cmd, false);
+        // whether or not to write out the planar averages along x, y and z
+        TCLAP::SwitchArg arg_z("z","zaverage","Planar averages along x, y and z", cmd, false);
+
+        // number of points of the Lebedev grid used for the sphere averages
+        TCLAP::ValueArg<unsigned int> arg_lebedev("","lebedev","Number of Lebedev points for sphere averages (6, 14, ..., 5810)",false, 194, "unsigned integer");
+        cmd.add(arg_lebedev);
+
+        // distance between the radii of the sphere averages
+        TCLAP::ValueArg<float> arg_radial_step("","radial-step","Distance between the radii of the sphere averages in angstrom",false, 0.01f, "float");
+        cmd.add(arg_radial_step);
+
+        // number of electrons within spheres around all atoms
+        TCLAP::ValueArg<float> arg_sphere_charges("","sphere-charges","Integrate the field within spheres up to this radius around all atoms",false, 0.0f, "float");
+        cmd.add(arg_sphere_charges);
+
+        // radial multipole profiles around (selected) atoms
+        TCLAP::ValueArg<float> arg_multipoles("","multipoles","Project the field on spheres up to this radius onto spherical harmonics",false, 0.0f, "float");
+        cmd.add(arg_multipoles);
+
+        // atoms for the multipole profiles
+        TCLAP::ValueArg<std::string> arg_multipole_atoms("","multipole-atoms","Atoms for the multipole profiles (default: all)",false, "", "comma-separated atom ids");
+        cmd.add(arg_multipole_atoms);
+
+        // maximum angular momentum of the multipole profiles
+        TCLAP::ValueArg<unsigned int> arg_lmax("","lmax","Maximum angular momentum of the multipole profiles",false, 4, "unsigned integer");
+        cmd.add(arg_lmax);
+
+        // planar average along an arbitrary direction
+        TCLAP::ValueArg<std::string> arg_d("d","direction","Planar average along direction",false, "", "vector or two atom ids");
+        cmd.add(arg_d);
+
+        // distance between the planes of the directional average
+        TCLAP::ValueArg<float> arg_binsize("","binsize","Distance between the planes of the directional average in angstrom",false, 0.05f, "float");
+        cmd.add(arg_binsize);
+
+        // line extraction along all bonds shorter than a cutoff
+        TCLAP::ValueArg<float> arg_bonds("","bonds","Extract the field along all bonds shorter than this length in angstrom",false, 0.0f, "float");
+        cmd.add(arg_bonds);
+
+        // number of samples along each bond
+        TCLAP::ValueArg<unsigned int> arg_bond_samples("","bond-samples","Number of samples along each bond",false, 101, "unsigned integer");
+        cmd.add(arg_bond_samples);
+
+        // charge per atom by assigning each grid point to the nearest atom
+        TCLAP::SwitchArg arg_voronoi("","voronoi","Integrate the field over the Voronoi cell of each atom", cmd, false);
+
+        // charge per atom by partitioning the field into Bader basins
+        TCLAP::SwitchArg arg_bader("","bader","Integrate the field over the Bader basin of each atom", cmd, false);
+
+        // draw the boundaries between the Bader basins on the contour plot
+        TCLAP::SwitchArg arg_bader_boundaries("","bader-boundaries","Draw the boundaries of the Bader basins on the contour plot", cmd, false);
+
+        // integral over the region above a threshold
+        TCLAP::ValueArg<float> arg_threshold("","threshold","Integrate the field over the region above this value",false, 0.0f, "float");
+        cmd.add(arg_threshold);
+
+        // isosurface of the scalar field
+        TCLAP::ValueArg<float> arg_isosurface("","isosurface","Extract the isosurface at this value",false, 0.0f, "float");
+        cmd.add(arg_isosurface);
+
+        // output file of the isosurface
+        TCLAP::ValueArg<std::string> arg_mesh("","mesh","Output file of the isosurface (.ply or .obj)",false, "isosurface.ply", "filename");
+        cmd.add(arg_mesh);
+
+        // cylindrical average around the axis between two atoms
+        TCLAP::ValueArg<std::string> arg_cylinder("","cylinder","Average over rings around the axis between two atoms",false, "", "two atom ids");
+        cmd.add(arg_cylinder);
+
+        // largest radius of the cylindrical average (also the extension of the axis beyond the atoms)
+        TCLAP::ValueArg<float> arg_cylinder_radius("","cylinder-radius","Radius of the cylindrical average in angstrom",false, 2.0f, "float");
+        cmd.add(arg_cylinder_radius);
+
+        // distance between the rings of the cylindrical average
+        TCLAP::ValueArg<float> arg_cylinder_step("","cylinder-step","Distance between the rings of the cylindrical average in angstrom",false, 0.02f, "float");
+        cmd.add(arg_cylinder_step);
 
         // graph value bounds (for coloring purposes)
         TCLAP::ValueArg<std::string> arg_b("b","bounds","Lower and upper bounds",false, "", "-3,2");
         cmd.add(arg_b);
 
+        // write timings of all phases to a JSON file
+        TCLAP::ValueArg<std::string> arg_profile("","profile","Write phase timings to JSON file",false, "", "filename");
+        cmd.add(arg_profile);
+
+        // write per-thread events of the parallel regions to a Chrome trace file
+        TCLAP::ValueArg<std::string> arg_trace("","trace","Write Chrome trace (JSON) of phases and parallel regions",false, "", "filename");
+        cmd.add(arg_trace);
+
+        // upper bound on the memory used by the scalar field, plane and image
+        TCLAP::ValueArg<double> arg_memory_budget("","memory-budget","Memory budget in MB; the grid is downsampled when it does not fit",false, 0.0, "MB");
+        cmd.add(arg_memory_budget);
+
+        // average blocks of n grid points along each lattice direction
+        TCLAP::ValueArg<unsigned int> arg_downsample("","downsample","Downsampling factor of the grid",false, 1, "unsigned integer");
+        cmd.add(arg_downsample);
+
+        // store bricks of the grid that are close to zero as a single value
+        TCLAP::ValueArg<float> arg_sparse("","sparse","Store bricks wherein all absolute values are below this threshold as a constant",false, 0.0f, "threshold");
+        cmd.add(arg_sparse);
+
+        // write the field to a compressed archive
+        TCLAP::ValueArg<std::string> arg_archive("","archive","Write the field to a compressed archive (readable as input)",false, "", "filename");
+        cmd.add(arg_archive);
+
+        // write the field in CHGCAR/LOCPOT format
+        TCLAP::ValueArg<std::string> arg_write_field("","write-field","Write the (derived) field in CHGCAR/LOCPOT format",false, "", "filename");
+        cmd.add(arg_write_field);
+
+        // maximum absolute error of the values in the archive
+        TCLAP::ValueArg<float> arg_archive_error("","archive-error","Maximum absolute error of the archived values (0 = lossless)",false, 0.0f, "error");
+        cmd.add(arg_archive_error);
+
+        // print current and peak memory per subsystem
+        TCLAP::SwitchArg arg_memory_report("","memory-report","Print memory usage per subsystem", cmd, false);
+
         cmd.parse(argc, argv);
 
         //**************************************
@@ -118,6 +247,23 @@ int main(int argc, char *argv[]) {
         //**************************************
         std::string input_filename = arg_input_filename.getValue();
         std::string output_filename = arg_output_filename.getValue();
+        const std::string profile_filename = arg_profile.getValue();
+
+        const std::string trace_filename = arg_trace.getValue();
+        if(!trace_filename.empty()) {
+            Tracer::get().set_enabled(true);
+        }
+
+        if(!profile_filename.empty()) {
+            Profiler::get().set_enabled(true);
+            Profiler::get().set_metadata("version", PROGRAM_VERSION);
+            Profiler::get().set_metadata("input", input_filename);
+            Profiler::get().set_metadata("host", boost::asio::ip::host_name());
+        }
+
+        if(arg_memory_budget.getValue() > 0.0) {
+            MemoryTracker::get().set_budget(arg_memory_budget.getValue() * 1e6);
+        }
 
         //***************************************)
         // identify whether this file is a locpot
@@ -207,14 +353,67 @@ int main(int argc, char *argv[]) {
         //**************************************
         std::cout << "Start reading " << input_filename << "..." << std::endl;
         auto start = std::chrono::system_clock::now();
-        sf.read();
+        sf.set_downsampling(arg_downsample.getValue());
+        if(arg_expression.isSet()) {
+            // read all fields concurrently and evaluate the expression in place
+            const FieldExpression expression(arg_expression.getValue());
+            std::vector<std::unique_ptr<ScalarField>> others;
+            std::vector<ScalarField*> fields(1, &sf);
+            std::vector<const ScalarField*> operands;
+            for(const std::string& filename : arg_fields.getValue()) {
+                others.emplace_back(new ScalarField(filename, is_locpot));
+                others.back()->set_downsampling(arg_downsample.getValue());
+                others.back()->set_sparse_threshold(arg_sparse.getValue());
+                fields.push_back(others.back().get());
+                operands.push_back(others.back().get());
+            }
+            ScalarField::read_all(fields);
+            std::cout << "Evaluating " << arg_expression.getValue() << " over " << fields.size() << " fields" << std::endl;
+            sf.apply(expression, operands);
+            sf.set_sparse_threshold(arg_sparse.getValue());
+        } else if(arg_fields.isSet()) {
+            throw std::runtime_error("Additional input files (--field) require an expression (--expression).");
+        } else {
+            // the grid is compacted layer by layer while reading
+            sf.set_sparse_threshold(arg_sparse.getValue());
+            sf.read();
+        }
         auto end = std::chrono::system_clock::now();
         std::chrono::duration<double> elapsed_seconds = end-start;
         std::cout << "Done reading " << input_filename << " in " << elapsed_seconds.count() << " seconds." << std::endl;
         std::cout << "Minimum value: " << sf.get_min() << std::endl;
         std::cout << "Maximum value: " << sf.get_max() << std::endl;
+        if(sf.is_locpot()) {
+            std::cout << "Average value: " << sf.get_mean() << std::endl;
+        } else {
+            std::cout << "Integrated charge: " << sf.get_integrated_charge() << std::endl;
+        }
         std::cout << std::endl;
 
+        //**************************************
+        // Performing optional CHGCAR/LOCPOT output
+        //**************************************
+        if(arg_write_field.isSet()) {
+            start = std::chrono::system_clock::now();
+            const size_t bytes = ChgcarWriter(&sf).write(arg_write_field.getValue());
+            end = std::chrono::system_clock::now();
+            elapsed_seconds = end-start;
+            std::cout << "Wrote " << arg_write_field.getValue() << " (" << bytes / (1024 * 1024) << " MB) in "
+                      << elapsed_seconds.count() << " seconds." << std::endl;
+            std::cout << std::endl;
+        }
+
+        //**************************************
+        // Performing optional archiving
+        //**************************************
+        if(arg_archive.isSet()) {
+            const size_t bytes = sf.write_archive(arg_archive.getValue(), arg_archive_error.getValue());
+            std::cout << "Wrote archive " << arg_archive.getValue() << " ("
+                      << boost::format("%.2f") % ((double)boost::filesystem::file_size(input_filename) / bytes)
+                      << "x smaller than the input file)" << std::endl;
+            std::cout << std::endl;
+        }
+
         //**************************************
         // determine size and colors
         //**************************************
@@ -263,16 +462,27 @@ int main(int argc, char *argv[]) {
             std::cout << "Using specified bounds: [log10(" << bounds[0] << "), log10(" << bounds[1] << ")]." << std::endl;
             pp.set_scaling(negative_values, bounds[0], bounds[1]);
         } else {
-            if(sf.is_locpot()) {
-                pp.set_scaling(negative_values, -3, 1);
-            } else {
-                pp.set_scaling(negative_values, -7, 1);
-            }
+            // select the bounds from the distribution of the absolute values
+            sf.get_statistics().suggest_log_bounds(bounds);
+            std::cout << "Using automatic bounds: [log10(" << bounds[0] << "), log10(" << bounds[1] << ")]." << std::endl;
+            pp.set_scaling(negative_values, bounds[0], bounds[1]);
+        }
+
+        // Bader partitioning (before plotting such that the boundaries can be drawn)
+        std::unique_ptr<BaderPartitioning> bader;
+        if(arg_bader.getValue() || arg_bader_boundaries.getValue()) {
+            std::cout << "Partitioning the field into Bader basins" << std::endl;
+            bader.reset(new BaderPartitioning(&sf));
+            bader->calculate();
+            bader->write("bader_charges.txt");
         }
 
         pp.extract(v, w, p, scale, li, hi, lj, hj);
         pp.plot();
         pp.isolines(10);
+        if(arg_bader_boundaries.getValue()) {
+            pp.draw_partition_boundaries(*bader);
+        }
         if(print_legend) {
             pp.draw_legend();
         }
@@ -302,12 +512,65 @@ int main(int argc, char *argv[]) {
         }
 
         //**************************************
-        // Performing optional z-axis averaging
+        // Performing optional line extraction along all bonds
+        //**************************************
+        if(arg_bonds.getValue() > 0.0f) {
+            std::cout << "Extracting profiles along all bonds shorter than: " << arg_bonds.getValue() << std::endl;
+            BondProfiles bond_profiles(&sf, arg_bond_samples.getValue());
+            bond_profiles.calculate(arg_bonds.getValue());
+            bond_profiles.write("bond_profiles.txt");
+        }
+
+        //**************************************
+        // Performing optional planar averaging
         //**************************************
         if(arg_z.getValue()) {
             pp.extract_plane_average();
         }
 
+        //**************************************
+        // Performing optional directional averaging
+        //**************************************
+        std::string dir_str = arg_d.getValue();
+        glm::vec3 d;
+        if(boost::regex_match(dir_str, what, re_vec3)) {
+            d[0] = boost::lexical_cast<float>(what[1]);
+            d[1] = boost::lexical_cast<float>(what[2]);
+            d[2] = boost::lexical_cast<float>(what[3]);
+            pp.extract_directional_average(d, arg_binsize.getValue());
+        } else if(boost::regex_match(dir_str, what, re_scalar_2)) {
+            d = sf.get_atom_position(boost::lexical_cast<unsigned int>(what[2])-1) -
+                sf.get_atom_position(boost::lexical_cast<unsigned int>(what[1])-1);
+            pp.extract_directional_average(d, arg_binsize.getValue());
+        }
+
+        //**************************************
+        // Performing optional cylindrical averaging
+        //**************************************
+        const std::string cyl_str = arg_cylinder.getValue();
+        if(boost::regex_match(cyl_str, what, re_scalar_2)) {
+            const unsigned int at1 = boost::lexical_cast<unsigned int>(what[1]);
+            const unsigned int at2 = boost::lexical_cast<unsigned int>(what[2]);
+            const float radius = arg_cylinder_radius.getValue();
+
+            std::cout << "Averaging around the axis between atoms " << at1 << " and " << at2 << " up to radius: " << radius << std::endl;
+            if(radius <= 0.0f) {
+                throw std::runtime_error("Radius of the cylindrical average should be positive.");
+            }
+
+            // take the bond to the nearest periodic image of the second atom
+            const glm::vec3 a = sf.get_atom_position(at1-1);
+            const CellList cell_list(sf.get_mat_unitcell(), {a}, radius);
+            const glm::vec3 b = a + cell_list.get_minimum_image(sf.get_atom_position(at2-1) - a);
+
+            CylindricalAverage cyl(&sf);
+            cyl.calculate(a, b, radius, radius, arg_cylinder_step.getValue());
+            cyl.write_binary("cylindrical_average.bin");
+            cyl.write_png("cylindrical_average.png", color_scheme_id, negative_values, bounds[0], bounds[1], scale);
+        } else if(!cyl_str.empty()) {
+            throw std::runtime_error("Could not parse the atoms of the cylindrical average: " + cyl_str);
+        }
+
         //**************************************
         // Performing optional radial extraction
         //**************************************
@@ -318,7 +581,92 @@ int main(int argc, char *argv[]) {
             const float radius = boost::lexical_cast<float>(what[2]);
 
             std::cout << "Averaging sphere surface for atom " << atid << " at radius: " << radius << std::endl;
-            pp.extract_sphere_average(pr, radius);
+            pp.extract_sphere_average(pr, radius, arg_radial_step.getValue(),
+                                      Quadrature::get_lebedev_order(arg_lebedev.getValue()));
+        }
+
+        //**************************************
+        // Performing optional sphere integration
+        //**************************************
+        if(arg_sphere_charges.getValue() > 0.0f) {
+            std::cout << "Integrating spheres around all atoms up to radius: " << arg_sphere_charges.getValue() << std::endl;
+            SphereIntegrator integrator(&sf, Quadrature::get_lebedev_order(arg_lebedev.getValue()));
+            integrator.write_atom_table("sphere_charges.txt", arg_sphere_charges.getValue(), arg_radial_step.getValue());
+        }
+
+        //**************************************
+        // Performing optional threshold integration
+        //**************************************
+        if(arg_threshold.isSet()) {
+            double volume = 0.0;
+            const double integral = sf.integrate_above(arg_threshold.getValue(), volume);
+            std::cout << "Integral above " << arg_threshold.getValue() << ": " << integral
+                      << " (volume: " << volume << " A^3)" << std::endl;
+        }
+
+        //**************************************
+        // Performing optional isosurface extraction
+        //**************************************
+        if(arg_isosurface.isSet()) {
+            std::cout << "Extracting isosurface at: " << arg_isosurface.getValue() << std::endl;
+            Isosurface isosurface(&sf);
+            isosurface.extract(arg_isosurface.getValue());
+            isosurface.write(arg_mesh.getValue());
+        }
+
+        //**************************************
+        // Performing optional Voronoi partitioning
+        //**************************************
+        if(arg_voronoi.getValue()) {
+            std::cout << "Partitioning the field over the Voronoi cells of the atoms" << std::endl;
+            VoronoiPartitioning voronoi(&sf);
+            voronoi.calculate();
+            voronoi.write("voronoi_charges.txt");
+        }
+
+        //**************************************
+        // Performing optional multipole expansion
+        //**************************************
+        if(arg_multipoles.getValue() > 0.0f) {
+            std::vector<unsigned int> atoms;
+            if(arg_multipole_atoms.getValue().empty()) {
+                for(unsigned int i=0; i<sf.get_nr_atoms(); i++) {
+                    atoms.push_back(i);
+                }
+            } else {
+                std::vector<std::string> pieces;
+                boost::split(pieces, arg_multipole_atoms.getValue(), boost::is_any_of(","));
+                for(const std::string& piece : pieces) {
+                    if(!boost::regex_match(piece, what, re_scalar)) {
+                        throw std::runtime_error("Could not parse atom id: " + piece);
+                    }
+                    atoms.push_back(boost::lexical_cast<unsigned int>(what[1]) - 1);
+                }
+            }
+
+            std::cout << "Expanding field in spherical harmonics up to l = " << arg_lmax.getValue()
+                      << " around " << atoms.size() << " atoms up to radius: " << arg_multipoles.getValue() << std::endl;
+            MultipoleExpansion expansion(&sf, Quadrature::get_lebedev_order(arg_lebedev.getValue()), arg_lmax.getValue());
+            if(!expansion.is_grid_sufficient()) {
+                std::cout << "Warning: the Lebedev grid is too coarse to resolve harmonics up to l = "
+                          << arg_lmax.getValue() << "; increase --lebedev." << std::endl;
+            }
+            expansion.write_atom_table("multipoles.txt", atoms, arg_multipoles.getValue(), arg_radial_step.getValue());
+        }
+
+        if(!profile_filename.empty()) {
+            Profiler::get().write_json(profile_filename);
+            std::cout << "Writing timings to " << profile_filename << std::endl;
+        }
+
+        if(!trace_filename.empty()) {
+            Tracer::get().write_json(trace_filename);
+            std::cout << "Writing trace to " << trace_filename << std::endl;
+        }
+
+        if(arg_memory_report.getValue()) {
+            std::cout << std::endl;
+            MemoryTracker::get().report(std::cout);
         }
 
         std::cout << "Done" << std::endl << std::endl;
@@ -329,5 +677,8 @@ int main(int argc, char *argv[]) {
         std::cerr << "error: " << e.error() <<
                      " for arg " << e.argId() << std::endl;
         return -1;
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return -1;
     }
 }
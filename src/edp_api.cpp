@@ -0,0 +1,289 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include <ios>
+#include <memory>
+#include <string>
+
+#include "edp_api.h"
+#include "scalar_field.h"
+#include "file_error.h"
+#include "planeprojector.h"
+#include "config.h"
+
+struct edp_field {
+    std::unique_ptr<ScalarField> sf;
+};
+
+struct edp_plane {
+    std::unique_ptr<PlaneProjector> pp;
+};
+
+namespace {
+
+thread_local std::string last_error;
+
+/**
+ * @brief      store error message and return error code
+ *
+ * @param[in]  code     error code
+ * @param[in]  message  error message
+ *
+ * @return     error code
+ */
+edp_status set_error(edp_status code, const std::string& message) {
+    last_error = message;
+    return code;
+}
+
+/**
+ * @brief      run a function and translate exceptions into status codes;
+ *             errors in reading, parsing or writing files yield EDP_ERROR_IO
+ *
+ * @param[in]  func  function to execute
+ *
+ * @return     status code
+ */
+template <typename F> edp_status guard(F func) {
+    try {
+        func();
+        return EDP_OK;
+    } catch(const FileError& e) {
+        return set_error(EDP_ERROR_IO, e.what());
+    } catch(const std::ios_base::failure& e) {
+        return set_error(EDP_ERROR_IO, e.what());
+    } catch(const std::bad_alloc& e) {
+        return set_error(EDP_ERROR_INTERNAL, "Out of memory");
+    } catch(const std::exception& e) {
+        return set_error(EDP_ERROR_INTERNAL, e.what());
+    }
+}
+
+} // namespace
+
+void edp_version(unsigned int* major, unsigned int* minor, unsigned int* micro) {
+    if(major) *major = PROGRAM_VERSION_MAJOR;
+    if(minor) *minor = PROGRAM_VERSION_MINOR;
+    if(micro) *micro = PROGRAM_VERSION_MICRO;
+}
+
+const char* edp_last_error(void) {
+    return last_error.c_str();
+}
+
+edp_status edp_field_load(const char* filename, int is_locpot, edp_field** field) {
+    if(filename == nullptr || field == nullptr) {
+        return set_error(EDP_ERROR_INVALID_ARGUMENT, "Invalid argument supplied to edp_field_load");
+    }
+
+    if(!boost::filesystem::exists(filename)) {
+        return set_error(EDP_ERROR_IO, std::string("Cannot open ") + filename + "!");
+    }
+
+    return guard([&]() {
+        std::unique_ptr<edp_field> handle(new edp_field);
+        handle->sf.reset(new ScalarField(filename, is_locpot != 0));
+        handle->sf->read();
+        *field = handle.release();
+    });
+}
+
+void edp_field_free(edp_field* field) {
+    delete field;
+}
+
+edp_status edp_field_get_dimensions(const edp_field* field, unsigned int dimensions[3]) {
+    if(field == nullptr || dimensions == nullptr) {
+        return set_error(EDP_ERROR_INVALID_ARGUMENT, "Invalid argument supplied to edp_field_get_dimensions");
+    }
+
+    field->sf->copy_grid_dimensions(dimensions);
+    return EDP_OK;
+}
+
+edp_status edp_field_get_unitcell(const edp_field* field, float mat[9]) {
+    if(field == nullptr || mat == nullptr) {
+        return set_error(EDP_ERROR_INVALID_ARGUMENT, "Invalid argument supplied to edp_field_get_unitcell");
+    }
+
+    const glm::mat3& unitcell = field->sf->get_mat_unitcell();
+    for(unsigned int i=0; i<3; i++) {
+        for(unsigned int j=0; j<3; j++) {
+            mat[i * 3 + j] = unitcell[i][j];
+        }
+    }
+
+    return EDP_OK;
+}
+
+edp_status edp_field_get_grid(const edp_field* field, const float** data, size_t* size) {
+    if(field == nullptr || data == nullptr || size == nullptr) {
+        return set_error(EDP_ERROR_INVALID_ARGUMENT, "Invalid argument supplied to edp_field_get_grid");
+    }
+
+    if(field->sf->is_sparse()) {
+        return set_error(EDP_ERROR_INVALID_ARGUMENT, "Field " + field->sf->get_filename() + " is stored sparsely and has no dense grid");
+    }
+
+    return guard([&]() {
+        *data = field->sf->get_grid_ptr();
+        *size = field->sf->get_size();
+    });
+}
+
+edp_status edp_field_get_min_max(const edp_field* field, float* min, float* max) {
+    if(field == nullptr || min == nullptr || max == nullptr) {
+        return set_error(EDP_ERROR_INVALID_ARGUMENT, "Invalid argument supplied to edp_field_get_min_max");
+    }
+
+    return guard([&]() {
+        *min = field->sf->get_min();
+        *max = field->sf->get_max();
+    });
+}
+
+edp_status edp_field_get_nr_atoms(const edp_field* field, unsigned int* nr_atoms) {
+    if(field == nullptr || nr_atoms == nullptr) {
+        return set_error(EDP_ERROR_INVALID_ARGUMENT, "Invalid argument supplied to edp_field_get_nr_atoms");
+    }
+
+    *nr_atoms = field->sf->get_nr_atoms();
+    return EDP_OK;
+}
+
+edp_status edp_field_get_atom_position(const edp_field* field, unsigned int atid, float pos[3]) {
+    if(field == nullptr || pos == nullptr) {
+        return set_error(EDP_ERROR_INVALID_ARGUMENT, "Invalid argument supplied to edp_field_get_atom_position");
+    }
+    if(atid >= field->sf->get_nr_atoms()) {
+        return set_error(EDP_ERROR_INVALID_ARGUMENT, "Requested atom id lies outside bounds");
+    }
+
+    const glm::vec3 r = field->sf->get_atom_position(atid);
+    for(unsigned int i=0; i<3; i++) {
+        pos[i] = r[i];
+    }
+
+    return EDP_OK;
+}
+
+edp_status edp_field_sample(const edp_field* field, const float* positions, size_t n,
+                            float* values, int periodic) {
+    if(field == nullptr || (n > 0 && (positions == nullptr || values == nullptr))) {
+        return set_error(EDP_ERROR_INVALID_ARGUMENT, "Invalid argument supplied to edp_field_sample");
+    }
+
+    return guard([&]() {
+        field->sf->get_values_interp(positions, n, values, periodic != 0);
+    });
+}
+
+edp_status edp_field_plane_average(const edp_field* field, float* profile, size_t n) {
+    if(field == nullptr || profile == nullptr) {
+        return set_error(EDP_ERROR_INVALID_ARGUMENT, "Invalid argument supplied to edp_field_plane_average");
+    }
+
+    unsigned int dimensions[3];
+    field->sf->copy_grid_dimensions(dimensions);
+    if(n < dimensions[2]) {
+        return set_error(EDP_ERROR_BUFFER_TOO_SMALL, "Buffer should hold at least " + std::to_string(dimensions[2]) + " values");
+    }
+
+    return guard([&]() {
+        PlaneProjector pp(field->sf.get(), 0);
+        const std::vector<float> avg = pp.calculate_plane_average();
+        std::copy(avg.begin(), avg.end(), profile);
+    });
+}
+
+edp_status edp_field_sphere_average(const edp_field* field, const float center[3],
+                                    const float* radii, size_t n, float* values) {
+    if(field == nullptr || center == nullptr || (n > 0 && (radii == nullptr || values == nullptr))) {
+        return set_error(EDP_ERROR_INVALID_ARGUMENT, "Invalid argument supplied to edp_field_sphere_average");
+    }
+
+    return guard([&]() {
+        PlaneProjector pp(field->sf.get(), 0);
+        const std::vector<float> r(radii, radii + n);
+        const std::vector<float> avg = pp.calculate_sphere_average(glm::vec3(center[0], center[1], center[2]), r);
+        std::copy(avg.begin(), avg.end(), values);
+    });
+}
+
+edp_status edp_plane_create(edp_field* field, const edp_plane_settings* settings, edp_plane** plane) {
+    if(field == nullptr || settings == nullptr || plane == nullptr) {
+        return set_error(EDP_ERROR_INVALID_ARGUMENT, "Invalid argument supplied to edp_plane_create");
+    }
+    if(settings->scale <= 0 || settings->hi <= settings->li || settings->hj <= settings->lj) {
+        return set_error(EDP_ERROR_INVALID_ARGUMENT, "Invalid plane dimensions supplied to edp_plane_create");
+    }
+    if(settings->log_min >= settings->log_max) {
+        return set_error(EDP_ERROR_INVALID_ARGUMENT, "Lower bound should be smaller than upper bound");
+    }
+
+    return guard([&]() {
+        std::unique_ptr<edp_plane> handle(new edp_plane);
+        handle->pp.reset(new PlaneProjector(field->sf.get(), settings->color_scheme_id));
+        handle->pp->set_scaling(settings->negative_values != 0, settings->log_min, settings->log_max);
+        handle->pp->extract(glm::vec3(settings->v1[0], settings->v1[1], settings->v1[2]),
+                            glm::vec3(settings->v2[0], settings->v2[1], settings->v2[2]),
+                            glm::vec3(settings->p[0], settings->p[1], settings->p[2]),
+                            settings->scale, settings->li, settings->hi, settings->lj, settings->hj);
+        *plane = handle.release();
+    });
+}
+
+void edp_plane_free(edp_plane* plane) {
+    delete plane;
+}
+
+edp_status edp_plane_get_size(const edp_plane* plane, unsigned int* width, unsigned int* height) {
+    if(plane == nullptr || width == nullptr || height == nullptr) {
+        return set_error(EDP_ERROR_INVALID_ARGUMENT, "Invalid argument supplied to edp_plane_get_size");
+    }
+
+    *width = plane->pp->get_width();
+    *height = plane->pp->get_height();
+    return EDP_OK;
+}
+
+edp_status edp_plane_get_values(const edp_plane* plane, const float** data) {
+    if(plane == nullptr || data == nullptr) {
+        return set_error(EDP_ERROR_INVALID_ARGUMENT, "Invalid argument supplied to edp_plane_get_values");
+    }
+
+    *data = plane->pp->get_planegrid_real();
+    return EDP_OK;
+}
+
+edp_status edp_plane_render(edp_plane* plane, unsigned int nr_isolines, int legend, const char* filename) {
+    if(plane == nullptr || filename == nullptr) {
+        return set_error(EDP_ERROR_INVALID_ARGUMENT, "Invalid argument supplied to edp_plane_render");
+    }
+
+    return guard([&]() {
+        plane->pp->plot();
+        plane->pp->isolines(nr_isolines);
+        if(legend) {
+            plane->pp->draw_legend();
+        }
+        plane->pp->write(filename);
+    });
+}
@@ -0,0 +1,201 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+/*
+ * C interface to libedp
+ *
+ * All functions return an edp_status code. When a call fails, a description
+ * of the error can be obtained (per thread) via edp_last_error(). Functions
+ * that produce arrays write into buffers supplied by the caller; functions
+ * that expose internal arrays return a pointer that remains valid for the
+ * lifetime of the owning handle.
+ *
+ * Failures are reported as follows:
+ *   EDP_ERROR_INVALID_ARGUMENT  a null pointer or an out-of-range argument
+ *   EDP_ERROR_IO                a file cannot be opened, is truncated, cannot
+ *                               be parsed (e.g. a corrupt archive brick) or
+ *                               cannot be written
+ *   EDP_ERROR_BUFFER_TOO_SMALL  a buffer supplied by the caller is too small
+ *   EDP_ERROR_INTERNAL          any other error, including running out of
+ *                               memory
+ */
+
+#ifndef _EDP_API_H
+#define _EDP_API_H
+
+#include <stddef.h>
+
+#if defined(__GNUC__)
+#define EDP_API __attribute__((visibility("default")))
+#else
+#define EDP_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    EDP_OK = 0,
+    EDP_ERROR_INVALID_ARGUMENT = 1,
+    EDP_ERROR_IO = 2,
+    EDP_ERROR_BUFFER_TOO_SMALL = 3,
+    EDP_ERROR_INTERNAL = 4
+} edp_status;
+
+typedef struct edp_field edp_field;     //!< opaque handle to a scalar field
+typedef struct edp_plane edp_plane;     //!< opaque handle to a contour plane
+
+/**
+ * @brief      settings for constructing a contour plane
+ */
+typedef struct {
+    float v1[3];                //!< direction vector 1
+    float v2[3];                //!< direction vector 2
+    float p[3];                 //!< position on the plane
+    float scale;                //!< scaling constant (px / angstrom)
+    float li, hi;               //!< extend in -v1 and +v1 direction (angstrom)
+    float lj, hj;               //!< extend in -v2 and +v2 direction (angstrom)
+    int negative_values;        //!< whether negative values are allowed
+    float log_min, log_max;     //!< lower and upper bound (log10) for coloring
+    unsigned int color_scheme_id;
+} edp_plane_settings;
+
+/**
+ * @brief      get the version of the library
+ */
+EDP_API void edp_version(unsigned int* major, unsigned int* minor, unsigned int* micro);
+
+/**
+ * @brief      description of the last error encountered in this thread
+ */
+EDP_API const char* edp_last_error(void);
+
+/**
+ * @brief      load a CHGCAR/PARCHG/LOCPOT file
+ *
+ * @param[in]  filename   path to file
+ * @param[in]  is_locpot  whether to skip the volume correction (LOCPOT)
+ * @param[out] field      handle to the loaded field
+ */
+EDP_API edp_status edp_field_load(const char* filename, int is_locpot, edp_field** field);
+
+/**
+ * @brief      release a field handle
+ */
+EDP_API void edp_field_free(edp_field* field);
+
+/**
+ * @brief      number of grid points along each lattice vector
+ */
+EDP_API edp_status edp_field_get_dimensions(const edp_field* field, unsigned int dimensions[3]);
+
+/**
+ * @brief      unit cell matrix; row i holds lattice vector i (angstrom)
+ */
+EDP_API edp_status edp_field_get_unitcell(const edp_field* field, float mat[9]);
+
+/**
+ * @brief      direct (non-copying) access to the grid; x runs fastest
+ *
+ * Fails with EDP_ERROR_INVALID_ARGUMENT for a sparsely stored field.
+ */
+EDP_API edp_status edp_field_get_grid(const edp_field* field, const float** data, size_t* size);
+
+/**
+ * @brief      minimum and maximum value of the grid
+ */
+EDP_API edp_status edp_field_get_min_max(const edp_field* field, float* min, float* max);
+
+/**
+ * @brief      number of atoms in the unit cell
+ */
+EDP_API edp_status edp_field_get_nr_atoms(const edp_field* field, unsigned int* nr_atoms);
+
+/**
+ * @brief      cartesian position of an atom (zero-based index)
+ */
+EDP_API edp_status edp_field_get_atom_position(const edp_field* field, unsigned int atid, float pos[3]);
+
+/**
+ * @brief      trilinear interpolation of n cartesian positions
+ *
+ * @param[in]  positions  n x,y,z triplets
+ * @param[in]  n          number of positions
+ * @param[out] values     buffer of at least n floats
+ * @param[in]  periodic   fold positions back into the unit cell
+ */
+EDP_API edp_status edp_field_sample(const edp_field* field, const float* positions, size_t n,
+                                    float* values, int periodic);
+
+/**
+ * @brief      average value of each layer along the c-axis
+ *
+ * @param[out] profile  buffer of at least n floats
+ * @param[in]  n        size of the buffer (should be >= grid dimension c)
+ */
+EDP_API edp_status edp_field_plane_average(const edp_field* field, float* profile, size_t n);
+
+/**
+ * @brief      average value on spheres around a point
+ *
+ * @param[in]  center  cartesian center of the spheres
+ * @param[in]  radii   n radii (angstrom)
+ * @param[out] values  buffer of at least n floats
+ */
+EDP_API edp_status edp_field_sphere_average(const edp_field* field, const float center[3],
+                                            const float* radii, size_t n, float* values);
+
+/**
+ * @brief      extract (and crop) a contour plane from a field
+ *
+ * The field must outlive the plane.
+ */
+EDP_API edp_status edp_plane_create(edp_field* field, const edp_plane_settings* settings, edp_plane** plane);
+
+/**
+ * @brief      release a plane handle
+ */
+EDP_API void edp_plane_free(edp_plane* plane);
+
+/**
+ * @brief      size of the cropped contour plane in pixels
+ */
+EDP_API edp_status edp_plane_get_size(const edp_plane* plane, unsigned int* width, unsigned int* height);
+
+/**
+ * @brief      direct (non-copying) access to the values on the plane (row-major)
+ */
+EDP_API edp_status edp_plane_get_values(const edp_plane* plane, const float** data);
+
+/**
+ * @brief      render the contour plane including isolines to a png file
+ *
+ * @param[in]  nr_isolines  number of isolines
+ * @param[in]  legend       whether to draw a legend
+ * @param[in]  filename     path to png file
+ */
+EDP_API edp_status edp_plane_render(edp_plane* plane, unsigned int nr_isolines, int legend, const char* filename);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _EDP_API_H
@@ -0,0 +1,221 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "field_expression.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+
+/**
+ * @brief      compile an expression
+ *
+ * @param[in]  _expression  expression, e.g. "a - b - c"
+ */
+FieldExpression::FieldExpression(const std::string& _expression) :
+    expression(_expression),
+    nr_variables(0),
+    max_depth(0),
+    pos(0) {
+
+    this->parse_expression();
+    this->skip_whitespace();
+    if(this->pos != this->expression.size()) {
+        throw std::runtime_error("Unexpected character in expression \"" + this->expression + "\" at position " +
+                                 std::to_string(this->pos + 1) + ".");
+    }
+
+    // determine the depth of the stack
+    int depth = 0;
+    for(const Instruction& ins : this->program) {
+        if(ins.op == PUSH_VARIABLE || ins.op == PUSH_CONSTANT) {
+            depth++;
+        } else if(ins.op != NEGATE) {
+            depth--;
+        }
+        this->max_depth = std::max(this->max_depth, (unsigned int)depth);
+    }
+}
+
+/**
+ * @brief      evaluate the expression for a range of values; the output
+ *             may coincide with one of the inputs
+ *
+ * @param[in]  inputs  values of the fields (one pointer per variable)
+ * @param[in]  n       number of values
+ * @param[out] out     result
+ */
+void FieldExpression::evaluate(const float* const* inputs, size_t n, float* out) const {
+    std::vector<float> stack(this->max_depth * block_size);
+
+    for(size_t start=0; start<n; start+=block_size) {
+        const size_t m = std::min(block_size, n - start);
+        unsigned int depth = 0;
+
+        for(const Instruction& ins : this->program) {
+            // the operands are the upper one or two values on the stack
+            float* top = stack.data() + depth * block_size;
+            float* rhs = depth > 0 ? top - block_size : top;
+            float* lhs = depth > 1 ? rhs - block_size : rhs;
+            switch(ins.op) {
+                case PUSH_VARIABLE: {
+                    const float* src = inputs[ins.variable] + start;
+                    std::copy(src, src + m, top);
+                    depth++;
+                }
+                break;
+                case PUSH_CONSTANT:
+                    std::fill(top, top + m, ins.constant);
+                    depth++;
+                break;
+                case ADD:
+                    for(size_t i=0; i<m; i++) {
+                        lhs[i] += rhs[i];
+                    }
+                    depth--;
+                break;
+                case SUBTRACT:
+                    for(size_t i=0; i<m; i++) {
+                        lhs[i] -= rhs[i];
+                    }
+                    depth--;
+                break;
+                case MULTIPLY:
+                    for(size_t i=0; i<m; i++) {
+                        lhs[i] *= rhs[i];
+                    }
+                    depth--;
+                break;
+                case DIVIDE:
+                    for(size_t i=0; i<m; i++) {
+                        lhs[i] /= rhs[i];
+                    }
+                    depth--;
+                break;
+                case NEGATE:
+                    for(size_t i=0; i<m; i++) {
+                        rhs[i] = -rhs[i];
+                    }
+                break;
+            }
+        }
+
+        // all inputs of this block have been read, so the output may alias them
+        std::copy(&stack[0], &stack[0] + m, out + start);
+    }
+}
+
+/**
+ * @brief      parse a sum or difference of terms
+ */
+void FieldExpression::parse_expression() {
+    this->parse_term();
+    while(true) {
+        this->skip_whitespace();
+        if(this->pos < this->expression.size() && (this->expression[this->pos] == '+' || this->expression[this->pos] == '-')) {
+            const char c = this->expression[this->pos++];
+            this->parse_term();
+            this->emit(c == '+' ? ADD : SUBTRACT);
+        } else {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief      parse a product or quotient of factors
+ */
+void FieldExpression::parse_term() {
+    this->parse_factor();
+    while(true) {
+        this->skip_whitespace();
+        if(this->pos < this->expression.size() && (this->expression[this->pos] == '*' || this->expression[this->pos] == '/')) {
+            const char c = this->expression[this->pos++];
+            this->parse_factor();
+            this->emit(c == '*' ? MULTIPLY : DIVIDE);
+        } else {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief      parse a variable, number, negation or parenthesized expression
+ */
+void FieldExpression::parse_factor() {
+    this->skip_whitespace();
+    if(this->pos >= this->expression.size()) {
+        throw std::runtime_error("Unexpected end of expression \"" + this->expression + "\".");
+    }
+
+    const char c = this->expression[this->pos];
+    if(c == '-') {
+        this->pos++;
+        this->parse_factor();
+        this->emit(NEGATE);
+    } else if(c == '(') {
+        this->pos++;
+        this->parse_expression();
+        this->skip_whitespace();
+        if(this->pos >= this->expression.size() || this->expression[this->pos] != ')') {
+            throw std::runtime_error("Missing closing parenthesis in expression \"" + this->expression + "\".");
+        }
+        this->pos++;
+    } else if(c >= 'a' && c <= 'z') {
+        const unsigned int variable = c - 'a';
+        this->nr_variables = std::max(this->nr_variables, variable + 1);
+        this->emit(PUSH_VARIABLE, variable);
+        this->pos++;
+    } else if(std::isdigit(c) || c == '.') {
+        const char* begin = this->expression.c_str() + this->pos;
+        char* end = nullptr;
+        const float value = std::strtof(begin, &end);
+        this->pos += end - begin;
+        this->emit(PUSH_CONSTANT, 0, value);
+    } else {
+        throw std::runtime_error("Unexpected character in expression \"" + this->expression + "\" at position " +
+                                 std::to_string(this->pos + 1) + ".");
+    }
+}
+
+/**
+ * @brief      advance the parser beyond whitespace
+ */
+void FieldExpression::skip_whitespace() {
+    while(this->pos < this->expression.size() && std::isspace(this->expression[this->pos])) {
+        this->pos++;
+    }
+}
+
+/**
+ * @brief      append an instruction to the program
+ *
+ * @param[in]  op        operation
+ * @param[in]  variable  variable to push (PUSH_VARIABLE)
+ * @param[in]  constant  constant to push (PUSH_CONSTANT)
+ */
+void FieldExpression::emit(OpCode op, unsigned int variable, float constant) {
+    Instruction ins;
+    ins.op = op;
+    ins.variable = variable;
+    ins.constant = constant;
+    this->program.push_back(ins);
+}
@@ -0,0 +1,101 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _FIELD_EXPRESSION_H
+#define _FIELD_EXPRESSION_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+/**
+ * @brief      elementwise arithmetic expression of several fields
+ *
+ * The fields are referred to as a, b, c, ... and can be combined with
+ * numbers using +, -, *, / and parentheses, e.g. "a - b - c" for a
+ * difference density. The expression is compiled into a program for a
+ * stack machine that is executed on blocks of values, such that every
+ * instruction is a simple loop over a block (which the compiler
+ * vectorizes) and no intermediate grids are allocated.
+ */
+class FieldExpression {
+public:
+    static const size_t block_size = 256;   //!< number of values processed per instruction
+
+private:
+    enum OpCode {
+        PUSH_VARIABLE,
+        PUSH_CONSTANT,
+        ADD,
+        SUBTRACT,
+        MULTIPLY,
+        DIVIDE,
+        NEGATE
+    };
+
+    struct Instruction {
+        OpCode op;
+        unsigned int variable;
+        float constant;
+    };
+
+    std::string expression;
+    unsigned int nr_variables;          //!< number of fields referred to (highest variable + 1)
+    std::vector<Instruction> program;
+    unsigned int max_depth;             //!< maximum depth of the stack
+
+    size_t pos;                         //!< position of the parser in the expression
+
+public:
+    /**
+     * @brief      compile an expression
+     *
+     * @param[in]  _expression  expression, e.g. "a - b - c"
+     */
+    FieldExpression(const std::string& _expression);
+
+    /**
+     * @brief      get the number of fields that the expression refers to
+     *
+     * @return     number of fields
+     */
+    inline unsigned int get_nr_variables() const {
+        return this->nr_variables;
+    }
+
+    /**
+     * @brief      evaluate the expression for a range of values; the output
+     *             may coincide with one of the inputs
+     *
+     * @param[in]  inputs  values of the fields (one pointer per variable)
+     * @param[in]  n       number of values
+     * @param[out] out     result
+     */
+    void evaluate(const float* const* inputs, size_t n, float* out) const;
+
+private:
+    void parse_expression();
+    void parse_term();
+    void parse_factor();
+    void skip_whitespace();
+    void emit(OpCode op, unsigned int variable = 0, float constant = 0.0f);
+};
+
+#endif //_FIELD_EXPRESSION_H
@@ -0,0 +1,104 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "field_statistics.h"
+
+#include <algorithm>
+
+FieldStatistics::FieldStatistics() {
+    this->clear();
+}
+
+/**
+ * @brief      reset all statistics
+ */
+void FieldStatistics::clear() {
+    this->min = std::numeric_limits<float>::max();
+    this->max = std::numeric_limits<float>::lowest();
+    this->sum = 0.0;
+    this->count = 0;
+    this->zeros = 0;
+    std::fill(this->histogram, this->histogram + NUM_BINS, 0);
+}
+
+/**
+ * @brief      add the statistics of another set of values
+ *
+ * @param[in]  other  statistics
+ */
+void FieldStatistics::merge(const FieldStatistics& other) {
+    this->min = std::min(this->min, other.min);
+    this->max = std::max(this->max, other.max);
+    this->sum += other.sum;
+    this->count += other.count;
+    this->zeros += other.zeros;
+    for(unsigned int i=0; i<NUM_BINS; i++) {
+        this->histogram[i] += other.histogram[i];
+    }
+}
+
+/**
+ * @brief      get the absolute value below which a fraction of all
+ *             non-zero values lies (resolved to a power of two)
+ *
+ * @param[in]  fraction  fraction between 0 and 1
+ *
+ * @return     lower edge of the histogram bin holding the quantile
+ */
+double FieldStatistics::get_abs_quantile(double fraction) const {
+    const size_t nonzero = this->count - this->zeros;
+    if(nonzero == 0) {
+        return 0.0;
+    }
+
+    const size_t target = (size_t)(fraction * (double)nonzero);
+    size_t cumulative = 0;
+    for(unsigned int i=0; i<NUM_BINS; i++) {
+        cumulative += this->histogram[i];
+        if(cumulative > target) {
+            return std::ldexp(1.0, (int)i + EXP_MIN);
+        }
+    }
+
+    return std::ldexp(1.0, EXP_MAX);
+}
+
+/**
+ * @brief      suggest integer log10 bounds for the color scale
+ *
+ * @param[out] bounds  lower and upper bound (log10)
+ */
+void FieldStatistics::suggest_log_bounds(int bounds[2]) const {
+    static const double lower_fraction = 0.01;
+    static const int max_decades = 10;
+
+    const double max_abs = std::max(std::fabs((double)this->min), std::fabs((double)this->max));
+    if(this->count == 0 || max_abs == 0.0) {
+        bounds[0] = -1;
+        bounds[1] = 0;
+        return;
+    }
+
+    bounds[1] = (int)std::ceil(std::log10(max_abs));
+    bounds[0] = (int)std::floor(std::log10(this->get_abs_quantile(lower_fraction)));
+
+    bounds[0] = std::max(bounds[0], bounds[1] - max_decades);
+    bounds[0] = std::min(bounds[0], bounds[1] - 1);
+}
@@ -0,0 +1,139 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _FIELD_STATISTICS_H
+#define _FIELD_STATISTICS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+/**
+ * @brief      summary statistics of a scalar field that are accumulated
+ *             while the grid is parsed
+ *
+ * The histogram counts the absolute values per power of two, i.e. bin e
+ * holds the values in [2^e, 2^(e+1)); this only requires the exponent of
+ * the floating point number and no logarithm per value.
+ */
+class FieldStatistics {
+public:
+    static const int EXP_MIN = -64;       //!< exponent of the lowest bin
+    static const int EXP_MAX = 63;        //!< exponent of the highest bin
+    static const unsigned int NUM_BINS = EXP_MAX - EXP_MIN + 1;
+
+private:
+    float min;
+    float max;
+    double sum;
+    size_t count;
+    size_t zeros;                   //!< number of values equal to zero
+    size_t histogram[NUM_BINS];     //!< counts of |value| per power of two
+
+public:
+    FieldStatistics();
+
+    /**
+     * @brief      reset all statistics
+     */
+    void clear();
+
+    /**
+     * @brief      add a single value
+     *
+     * @param[in]  val   value
+     */
+    inline void add(float val) {
+        this->min = std::min(this->min, val);
+        this->max = std::max(this->max, val);
+        this->sum += val;
+        this->count++;
+
+        if(val == 0.0f) {
+            this->zeros++;
+            return;
+        }
+
+        // ilogb returns the exponent e of |val| = m * 2^e with 1 <= m < 2
+        int e = std::ilogb(val);
+        e = std::min(std::max(e, EXP_MIN), EXP_MAX);
+        this->histogram[e - EXP_MIN]++;
+    }
+
+    /**
+     * @brief      add the statistics of another set of values
+     *
+     * @param[in]  other  statistics
+     */
+    void merge(const FieldStatistics& other);
+
+    inline float get_min() const {
+        return this->min;
+    }
+
+    inline float get_max() const {
+        return this->max;
+    }
+
+    inline double get_sum() const {
+        return this->sum;
+    }
+
+    inline size_t get_count() const {
+        return this->count;
+    }
+
+    inline double get_mean() const {
+        return this->count > 0 ? this->sum / (double)this->count : 0.0;
+    }
+
+    inline const size_t* get_histogram() const {
+        return this->histogram;
+    }
+
+    inline size_t get_zeros() const {
+        return this->zeros;
+    }
+
+    /**
+     * @brief      get the absolute value below which a fraction of all
+     *             non-zero values lies (resolved to a power of two)
+     *
+     * @param[in]  fraction  fraction between 0 and 1
+     *
+     * @return     lower edge of the histogram bin holding the quantile
+     */
+    double get_abs_quantile(double fraction) const;
+
+    /**
+     * @brief      suggest integer log10 bounds for the color scale
+     *
+     * The upper bound covers the largest absolute value and the lower
+     * bound is placed at the 1% quantile of the absolute values, such that
+     * the bulk of the field is resolved without wasting the scale on
+     * numerical noise.
+     *
+     * @param[out] bounds  lower and upper bound (log10)
+     */
+    void suggest_log_bounds(int bounds[2]) const;
+};
+
+#endif //_FIELD_STATISTICS_H
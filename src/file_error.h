@@ -0,0 +1,41 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _FILE_ERROR_H
+#define _FILE_ERROR_H
+
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief      thrown when a file cannot be opened, is truncated or cannot be
+ *             parsed, i.e. on errors in the input rather than in the program
+ */
+class FileError : public std::runtime_error {
+public:
+    /**
+     * @brief      constructor
+     *
+     * @param[in]  message  description of the error
+     */
+    explicit FileError(const std::string& message) : std::runtime_error(message) {}
+};
+
+#endif //_FILE_ERROR_H
@@ -0,0 +1,387 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "grid_archive.h"
+
+#include <fstream>
+#include <cmath>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+
+#include "scalar_field.h"
+#include "file_error.h"
+#include "profiler.h"
+#include "tracer.h"
+
+const char* const GridArchive::marker = "EDP archive";
+
+namespace {
+
+/**
+ * @brief      byte-shuffle and compress an array; grouping the n-th bytes of
+ *             all elements places the slowly varying exponents next to each
+ *             other, which deflate compresses much better
+ *
+ * @param[in]  data    elements
+ * @param[in]  n       number of elements
+ * @param[in]  elsize  size of an element in bytes
+ * @param[out] out     string to append the compressed data to
+ */
+void compress(const void* data, size_t n, size_t elsize, std::string& out) {
+    const char* src = static_cast<const char*>(data);
+    std::vector<char> shuffled(n * elsize);
+    for(size_t i=0; i<n; i++) {
+        for(size_t b=0; b<elsize; b++) {
+            shuffled[b * n + i] = src[i * elsize + b];
+        }
+    }
+
+    boost::iostreams::filtering_ostream os;
+    os.push(boost::iostreams::zlib_compressor());
+    os.push(boost::iostreams::back_inserter(out));
+    os.write(shuffled.data(), shuffled.size());
+    os.reset();
+}
+
+/**
+ * @brief      decompress and un-shuffle an array
+ *
+ * @param[in]  data    compressed data
+ * @param[in]  len     length of the compressed data
+ * @param[out] out     elements
+ * @param[in]  n       number of elements
+ * @param[in]  elsize  size of an element in bytes
+ */
+void decompress(const char* data, size_t len, void* out, size_t n, size_t elsize) {
+    std::vector<char> shuffled(n * elsize);
+    boost::iostreams::filtering_istream is;
+    is.push(boost::iostreams::zlib_decompressor());
+    is.push(boost::iostreams::array_source(data, len));
+    is.read(shuffled.data(), shuffled.size());
+    if((size_t)is.gcount() != shuffled.size()) {
+        throw FileError("Corrupt brick encountered in archive.");
+    }
+
+    char* dest = static_cast<char*>(out);
+    for(size_t i=0; i<n; i++) {
+        for(size_t b=0; b<elsize; b++) {
+            dest[i * elsize + b] = shuffled[b * n + i];
+        }
+    }
+}
+
+/**
+ * @brief      encode the values of a brick
+ *
+ * @param[in]  values       values
+ * @param[in]  n            number of values
+ * @param[in]  error_bound  maximum absolute error (zero for lossless)
+ * @param[out] quantized    whether the brick is stored quantized
+ *
+ * @return     encoded brick
+ */
+std::string encode_brick(const float* values, size_t n, float error_bound, bool& quantized) {
+    std::string out;
+    quantized = false;
+
+    if(error_bound > 0.0f) {
+        const float vmin = *std::min_element(values, values + n);
+        const float vmax = *std::max_element(values, values + n);
+        // a step slightly below twice the error bound leaves room for the
+        // rounding of the reconstructed values
+        const float step = 1.99f * error_bound;
+
+        if(std::isfinite(vmin) && std::isfinite(vmax) && ((double)vmax - vmin) / step < 65535.0) {
+            std::vector<uint16_t> codes(n);
+            quantized = true;
+            for(size_t i=0; i<n && quantized; i++) {
+                codes[i] = (uint16_t)std::min(std::lround(((double)values[i] - vmin) / step), 65535L);
+                // verify the value as reconstructed by the reader
+                const float r = vmin + (float)codes[i] * step;
+                quantized = std::fabs(r - values[i]) <= error_bound;
+            }
+
+            if(quantized) {
+                out.push_back((char)GridArchive::QUANTIZED);
+                out.append(reinterpret_cast<const char*>(&vmin), sizeof(float));
+                out.append(reinterpret_cast<const char*>(&step), sizeof(float));
+                compress(codes.data(), n, sizeof(uint16_t), out);
+                return out;
+            }
+        }
+    }
+
+    out.push_back((char)GridArchive::LOSSLESS);
+    compress(values, n, sizeof(float), out);
+    return out;
+}
+
+} // namespace
+
+/**
+ * @brief      open the binary part of an archive
+ *
+ * @param[in]  _filename  archive file
+ * @param[in]  offset     position of the binary part (after the marker line)
+ * @param[in]  dim        grid dimensions (from the header)
+ */
+GridArchive::GridArchive(const std::string& _filename, std::streamoff offset, const unsigned int dim[3]) :
+    filename(_filename) {
+
+    for(unsigned int d=0; d<3; d++) {
+        this->grid_dimensions[d] = dim[d];
+        this->nr_bricks[d] = (dim[d] + size - 1) / size;
+    }
+    const size_t nbricks = (size_t)this->nr_bricks[0] * this->nr_bricks[1] * this->nr_bricks[2];
+
+    std::ifstream in(this->filename, std::ios::binary);
+    in.seekg(offset);
+    uint32_t _version = 0;
+    uint32_t brick_size = 0;
+    in.read(reinterpret_cast<char*>(&_version), sizeof(uint32_t));
+    in.read(reinterpret_cast<char*>(&brick_size), sizeof(uint32_t));
+    in.read(reinterpret_cast<char*>(&this->flags), sizeof(uint32_t));
+    in.read(reinterpret_cast<char*>(&this->error_bound), sizeof(float));
+    if(!in || _version != version || brick_size != size) {
+        throw FileError("Unsupported archive format in " + this->filename + ".");
+    }
+
+    this->offsets.resize(nbricks + 1);
+    in.read(reinterpret_cast<char*>(this->offsets.data()), this->offsets.size() * sizeof(uint64_t));
+    if(!in) {
+        throw FileError("Archive " + this->filename + " is truncated.");
+    }
+    this->data_start = in.tellg();
+
+    // the bricks are stored consecutively; the last offset is the total size
+    in.seekg(0, std::ios::end);
+    const uint64_t data_size = (uint64_t)((std::streamoff)in.tellg() - this->data_start);
+    for(size_t b=0; b<nbricks; b++) {
+        if(this->offsets[b] > this->offsets[b+1]) {
+            throw FileError("Corrupt brick encountered in archive.");
+        }
+    }
+    if(this->offsets[nbricks] > data_size) {
+        throw FileError("Archive " + this->filename + " is truncated.");
+    }
+}
+
+/**
+ * @brief      decompress a single brick
+ *
+ * @param[in]  in    stream of the archive
+ * @param[in]  b     brick index (x runs fastest)
+ * @param[out] out   values of the brick (x runs fastest, at most size^3)
+ */
+void GridArchive::read_brick(std::istream& in, size_t b, float* out) const {
+    const unsigned int bx = b % this->nr_bricks[0];
+    const unsigned int by = (b / this->nr_bricks[0]) % this->nr_bricks[1];
+    const unsigned int bz = b / ((size_t)this->nr_bricks[0] * this->nr_bricks[1]);
+    unsigned int i0, i1, j0, j1, k0, k1;
+    this->get_extent(0, bx, i0, i1);
+    this->get_extent(1, by, j0, j1);
+    this->get_extent(2, bz, k0, k1);
+    const size_t n = (size_t)(i1 - i0) * (j1 - j0) * (k1 - k0);
+
+    std::vector<char> blob(this->offsets[b+1] - this->offsets[b]);
+    in.seekg(this->data_start + (std::streamoff)this->offsets[b]);
+    in.read(blob.data(), blob.size());
+    if(!in || blob.empty()) {
+        throw FileError("Archive " + this->filename + " is truncated.");
+    }
+
+    switch(blob[0]) {
+        case LOSSLESS:
+            decompress(&blob[1], blob.size() - 1, out, n, sizeof(float));
+        break;
+        case QUANTIZED: {
+            const size_t header = 1 + 2 * sizeof(float);
+            if(blob.size() < header) {
+                throw FileError("Corrupt brick encountered in archive.");
+            }
+            float base, step;
+            std::copy(&blob[1], &blob[1] + sizeof(float), reinterpret_cast<char*>(&base));
+            std::copy(&blob[1] + sizeof(float), &blob[header], reinterpret_cast<char*>(&step));
+            std::vector<uint16_t> codes(n);
+            decompress(&blob[header], blob.size() - header, codes.data(), n, sizeof(uint16_t));
+            for(size_t i=0; i<n; i++) {
+                out[i] = base + (float)codes[i] * step;
+            }
+        }
+        break;
+        default:
+            throw FileError("Unknown brick encoding encountered in archive.");
+    }
+}
+
+/**
+ * @brief      read a box of grid points, only the bricks that overlap
+ *             with the box are decompressed
+ *
+ * @param[in]  lo    first grid point of the box
+ * @param[in]  hi    one beyond the last grid point of the box
+ * @param[out] out   values in the box (x runs fastest)
+ */
+void GridArchive::read_region(const unsigned int lo[3], const unsigned int hi[3], float* out) const {
+    unsigned int blo[3], bhi[3];
+    for(unsigned int d=0; d<3; d++) {
+        if(lo[d] >= hi[d] || hi[d] > this->grid_dimensions[d]) {
+            throw std::runtime_error("Invalid region requested from archive.");
+        }
+        blo[d] = lo[d] / size;
+        bhi[d] = (hi[d] - 1) / size + 1;
+    }
+    const unsigned int nbx = bhi[0] - blo[0];
+    const unsigned int nby = bhi[1] - blo[1];
+    const long nbricks = (long)nbx * nby * (bhi[2] - blo[2]);
+    const size_t sx = hi[0] - lo[0];
+    const size_t sy = hi[1] - lo[1];
+
+    // exceptions cannot leave a parallel region, rethrow the first afterwards
+    std::exception_ptr error;
+
+    #pragma omp parallel
+    {
+        EDP_TRACE_SCOPE("archive read");
+        std::ifstream in(this->filename, std::ios::binary);
+        std::vector<float> values(size * size * size);
+
+        #pragma omp for schedule(dynamic) nowait
+        for(long r=0; r<nbricks; r++) {
+            const unsigned int bx = blo[0] + r % nbx;
+            const unsigned int by = blo[1] + (r / nbx) % nby;
+            const unsigned int bz = blo[2] + r / ((long)nbx * nby);
+            try {
+                this->read_brick(in, ((size_t)bz * this->nr_bricks[1] + by) * this->nr_bricks[0] + bx, values.data());
+            } catch(...) {
+                #pragma omp critical
+                {
+                    if(!error) {
+                        error = std::current_exception();
+                    }
+                }
+                continue;
+            }
+
+            unsigned int i0, i1, j0, j1, k0, k1;
+            this->get_extent(0, bx, i0, i1);
+            this->get_extent(1, by, j0, j1);
+            this->get_extent(2, bz, k0, k1);
+
+            // copy the part of the brick that lies within the box
+            const unsigned int x0 = std::max(i0, lo[0]);
+            const unsigned int x1 = std::min(i1, hi[0]);
+            for(unsigned int k=std::max(k0, lo[2]); k<std::min(k1, hi[2]); k++) {
+                for(unsigned int j=std::max(j0, lo[1]); j<std::min(j1, hi[1]); j++) {
+                    const float* src = &values[((size_t)(k - k0) * (j1 - j0) + (j - j0)) * (i1 - i0) + (x0 - i0)];
+                    std::copy(src, src + (x1 - x0), out + ((k - lo[2]) * sy + (j - lo[1])) * sx + (x0 - lo[0]));
+                }
+            }
+        }
+    }
+
+    if(error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * @brief      write the binary part of an archive
+ *
+ * @param[in]  out          output stream (positioned after the marker line)
+ * @param[in]  sf           scalar field
+ * @param[in]  error_bound  maximum absolute error (zero for lossless)
+ *
+ * @return     number of bricks that are stored quantized
+ */
+size_t GridArchive::write(std::ostream& out, const ScalarField& sf, float error_bound) {
+    ScopedTimer timer("archive write");
+
+    unsigned int dim[3];
+    unsigned int nb[3];
+    sf.copy_grid_dimensions(dim);
+    for(unsigned int d=0; d<3; d++) {
+        nb[d] = (dim[d] + size - 1) / size;
+    }
+    const long nbricks = (long)nb[0] * nb[1] * nb[2];
+    const size_t brick_volume = size * size * size;
+
+    // compress the bricks in parallel, the archive is written afterwards
+    std::vector<std::string> blobs(nbricks);
+    size_t nquantized = 0;
+
+    #pragma omp parallel reduction(+:nquantized)
+    {
+        EDP_TRACE_SCOPE("archive compress");
+        std::vector<float> buffer(dim[0]);
+        std::vector<float> values(brick_volume);
+
+        #pragma omp for schedule(dynamic, 16) nowait
+        for(long b=0; b<nbricks; b++) {
+            const unsigned int i0 = (b % nb[0]) * size;
+            const unsigned int j0 = ((b / nb[0]) % nb[1]) * size;
+            const unsigned int k0 = (b / ((long)nb[0] * nb[1])) * size;
+            const unsigned int i1 = std::min(i0 + size, dim[0]);
+            const unsigned int j1 = std::min(j0 + size, dim[1]);
+            const unsigned int k1 = std::min(k0 + size, dim[2]);
+
+            size_t n = 0;
+            for(unsigned int k=k0; k<k1; k++) {
+                for(unsigned int j=j0; j<j1; j++) {
+                    const float* row = sf.get_row(j, k, buffer.data());
+                    std::copy(row + i0, row + i1, &values[n]);
+                    n += i1 - i0;
+                }
+            }
+
+            bool quantized = false;
+            blobs[b] = encode_brick(values.data(), n, error_bound, quantized);
+            nquantized += quantized ? 1 : 0;
+        }
+    }
+
+    const uint32_t _version = version;
+    const uint32_t brick_size = size;
+    const uint32_t flags = sf.is_locpot() ? 0u : 1u;
+    out.write(reinterpret_cast<const char*>(&_version), sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(&brick_size), sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(&flags), sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(&error_bound), sizeof(float));
+
+    std::vector<uint64_t> offsets(nbricks + 1, 0);
+    for(long b=0; b<nbricks; b++) {
+        offsets[b+1] = offsets[b] + blobs[b].size();
+    }
+    out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    for(long b=0; b<nbricks; b++) {
+        out.write(blobs[b].data(), blobs[b].size());
+    }
+
+    timer.set_bytes(offsets.back());
+    timer.set_items(sf.get_size(), "values");
+
+    return nquantized;
+}
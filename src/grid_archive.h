@@ -0,0 +1,161 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _GRID_ARCHIVE_H
+#define _GRID_ARCHIVE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+
+#include "brick_summary.h"
+
+class ScalarField;
+
+/**
+ * @brief      compressed archive of a grid with random access per brick
+ *
+ * An archive starts with the text header of the CHGCAR/LOCPOT file (up to
+ * and including the line with the grid dimensions), such that the header
+ * is parsed in the same way as for the original file. The header is
+ * followed by a marker line and the binary part (native byte order):
+ *
+ *   uint32  version
+ *   uint32  brick size
+ *   uint32  flags (bit 0: values are divided by the cell volume)
+ *   float   error bound (zero for lossless archives)
+ *   uint64  offsets of the bricks (number of bricks + 1), relative to the
+ *           start of the brick data
+ *   ...     brick data
+ *
+ * Every brick of the BrickSummary is compressed independently, such that a
+ * region of the grid can be read by decompressing only the bricks that it
+ * overlaps. A brick is stored either lossless, as byte-shuffled floats
+ * compressed with deflate, or, when an error bound is given, quantized to
+ * 16-bit integers with a step of twice the error bound (also byte-shuffled
+ * and compressed). Bricks that cannot be quantized within the error bound
+ * are stored lossless.
+ */
+class GridArchive {
+public:
+    static const char* const marker;                    //!< line separating the text header from the binary part
+    static const unsigned int size = BrickSummary::size; //!< number of grid points along each edge of a brick
+    static const uint32_t version = 1;
+
+    /**
+     * @brief      encoding of a brick
+     */
+    enum Encoding : uint8_t {
+        LOSSLESS = 0,
+        QUANTIZED = 1
+    };
+
+private:
+    std::string filename;
+    std::streamoff data_start;          //!< position of the brick data in the file
+    unsigned int grid_dimensions[3];
+    unsigned int nr_bricks[3];
+    uint32_t flags;
+    float error_bound;
+    std::vector<uint64_t> offsets;
+
+public:
+    /**
+     * @brief      open the binary part of an archive
+     *
+     * @param[in]  _filename  archive file
+     * @param[in]  offset     position of the binary part (after the marker line)
+     * @param[in]  dim        grid dimensions (from the header)
+     */
+    GridArchive(const std::string& _filename, std::streamoff offset, const unsigned int dim[3]);
+
+    /**
+     * @brief      whether the values are divided by the cell volume (CHGCAR)
+     *
+     * @return     true if divided by the cell volume
+     */
+    inline bool is_per_volume() const {
+        return this->flags & 1u;
+    }
+
+    /**
+     * @brief      get the maximum absolute error of the values
+     *
+     * @return     error bound (zero for lossless archives)
+     */
+    inline float get_error_bound() const {
+        return this->error_bound;
+    }
+
+    /**
+     * @brief      get the number of bricks
+     *
+     * @return     number of bricks
+     */
+    inline size_t get_nr_bricks() const {
+        return this->offsets.size() - 1;
+    }
+
+    /**
+     * @brief      decompress a single brick
+     *
+     * @param[in]  in    stream of the archive
+     * @param[in]  b     brick index (x runs fastest)
+     * @param[out] out   values of the brick (x runs fastest, at most size^3)
+     */
+    void read_brick(std::istream& in, size_t b, float* out) const;
+
+    /**
+     * @brief      get the range of grid points of a brick along a lattice vector
+     *
+     * @param[in]  d     lattice vector
+     * @param[in]  b     brick index along d
+     * @param[out] lo    first grid point
+     * @param[out] hi    one beyond the last grid point
+     */
+    inline void get_extent(unsigned int d, unsigned int b, unsigned int& lo, unsigned int& hi) const {
+        lo = b * size;
+        hi = lo + size < this->grid_dimensions[d] ? lo + size : this->grid_dimensions[d];
+    }
+
+    /**
+     * @brief      read a box of grid points, only the bricks that overlap
+     *             with the box are decompressed
+     *
+     * @param[in]  lo    first grid point of the box
+     * @param[in]  hi    one beyond the last grid point of the box
+     * @param[out] out   values in the box (x runs fastest)
+     */
+    void read_region(const unsigned int lo[3], const unsigned int hi[3], float* out) const;
+
+    /**
+     * @brief      write the binary part of an archive
+     *
+     * @param[in]  out          output stream (positioned after the marker line)
+     * @param[in]  sf           scalar field
+     * @param[in]  error_bound  maximum absolute error (zero for lossless)
+     *
+     * @return     number of bricks that are stored quantized
+     */
+    static size_t write(std::ostream& out, const ScalarField& sf, float error_bound);
+};
+
+#endif //_GRID_ARCHIVE_H
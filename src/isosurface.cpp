@@ -0,0 +1,372 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "isosurface.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
+
+namespace {
+
+/**
+ * @brief      mesh of a slab of bricks; vertices are identified by the grid
+ *             edge they lie on
+ */
+struct SlabMesh {
+    std::vector<uint64_t> keys;         //!< edge of each vertex
+    std::vector<glm::vec3> vertices;    //!< vertex positions
+    std::vector<uint32_t> triangles;    //!< vertex indices (within the slab)
+    size_t bricks_skipped = 0;          //!< number of bricks without surface
+};
+
+// corners of a cube are encoded as x + 2y + 4z; the six tetrahedra follow
+// the paths from corner 0 to corner 7 along the three axes in any order
+static const unsigned int tetrahedra[6][4] = {
+    {0, 1, 3, 7}, {0, 1, 5, 7}, {0, 2, 3, 7},
+    {0, 2, 6, 7}, {0, 4, 5, 7}, {0, 4, 6, 7}
+};
+
+} // namespace
+
+/**
+ * @brief      constructor
+ *
+ * @param[in]  _sf   scalar field
+ */
+Isosurface::Isosurface(const ScalarField* _sf) :
+    sf(_sf) {}
+
+/**
+ * @brief      extract the isosurface
+ *
+ * The cubes are grouped in the bricks of the brick summary of the scalar
+ * field. Bricks whose range of values (including the first layer of the
+ * next bricks) does not include the isovalue are skipped. The slabs of
+ * bricks along z are distributed over the threads; afterwards, the meshes
+ * of the slabs are merged (in order) into a single mesh.
+ *
+ * @param[in]  isovalue  isovalue
+ */
+void Isosurface::extract(float isovalue) {
+    ScopedTimer timer("isosurface");
+
+    unsigned int dim[3];
+    this->sf->copy_grid_dimensions(dim);
+    const unsigned int nx = dim[0];
+    const unsigned int ny = dim[1];
+    const unsigned int nz = dim[2];
+    if(this->sf->get_size() != (size_t)nx * ny * nz) {
+        throw std::runtime_error("Grid has not been read.");
+    }
+    const float* grid = this->sf->is_sparse() ? nullptr : this->sf->get_grid_ptr();
+
+    // the surface encloses the points on the far side of the isovalue
+    const float sign = isovalue >= 0.0f ? 1.0f : -1.0f;
+    const float iso = sign * isovalue;
+    auto value = [&](unsigned int i, unsigned int j, unsigned int k) {
+        if(grid == nullptr) {
+            return sign * this->sf->get_value(i % nx, j % ny, k % nz);
+        }
+        return sign * grid[((size_t)(k % nz) * ny + (j % ny)) * nx + (i % nx)];
+    };
+
+    // the cubes are processed per brick of the summary of the field
+    const BrickSummary& summary = this->sf->get_brick_summary();
+    const unsigned int bx = summary.get_nr_bricks(0);
+    const unsigned int by = summary.get_nr_bricks(1);
+    const unsigned int bz = summary.get_nr_bricks(2);
+    std::vector<SlabMesh> slabs(bz);
+
+    const glm::mat3& mat = this->sf->get_mat_unitcell();
+
+    #pragma omp parallel
+    {
+        EDP_TRACE_SCOPE("isosurface");
+        #pragma omp for schedule(dynamic) nowait
+        for(unsigned int sz=0; sz<bz; sz++) {
+            SlabMesh& slab = slabs[sz];
+            std::unordered_map<uint64_t, uint32_t> index;
+
+            // vertex on the edge from grid point g (unwrapped) to g + d
+            auto get_vertex = [&](const glm::uvec3& g, unsigned int d, float va, float vb) {
+                const uint64_t key = ((((uint64_t)g[2] * (ny + 1) + g[1]) * (nx + 1) + g[0]) << 3) | d;
+                auto it = index.find(key);
+                if(it != index.end()) {
+                    return it->second;
+                }
+
+                const float t = (iso - va) / (vb - va);
+                const glm::vec3 dv((d & 1) ? 1.0f : 0.0f, (d & 2) ? 1.0f : 0.0f, (d & 4) ? 1.0f : 0.0f);
+                const glm::vec3 gp = glm::vec3(g) + t * dv + glm::vec3(0.5f);  // grid values lie at the voxel centers
+                const uint32_t id = slab.vertices.size();
+                slab.vertices.push_back(mat * glm::vec3(gp[0] / nx, gp[1] / ny, gp[2] / nz));
+                slab.keys.push_back(key);
+                index.emplace(key, id);
+                return id;
+            };
+
+            for(unsigned int sy=0; sy<by; sy++) {
+                for(unsigned int sx=0; sx<bx; sx++) {
+                    unsigned int i0, i1, j0, j1, k0, k1;
+                    summary.get_extent(0, sx, i0, i1);
+                    summary.get_extent(1, sy, j0, j1);
+                    summary.get_extent(2, sz, k0, k1);
+
+                    // skip bricks that do not contain the isovalue (including
+                    // the grid points shared with the next bricks)
+                    float vmin, vmax;
+                    summary.get_range_with_neighbors(sx, sy, sz, vmin, vmax);
+                    if(sign < 0.0f) {
+                        std::swap(vmin, vmax);
+                        vmin = -vmin;
+                        vmax = -vmax;
+                    }
+                    if(vmin > iso || vmax <= iso) {
+                        slab.bricks_skipped++;
+                        continue;
+                    }
+
+                    for(unsigned int k=k0; k<k1; k++) {
+                        for(unsigned int j=j0; j<j1; j++) {
+                            for(unsigned int i=i0; i<i1; i++) {
+                                float v[8];
+                                unsigned int mask = 0;
+                                for(unsigned int c=0; c<8; c++) {
+                                    v[c] = value(i + (c & 1), j + ((c >> 1) & 1), k + ((c >> 2) & 1));
+                                    mask |= (v[c] > iso) << c;
+                                }
+                                if(mask == 0 || mask == 0xFF) {
+                                    continue;
+                                }
+
+                                for(unsigned int t=0; t<6; t++) {
+                                    const unsigned int* tet = tetrahedra[t];
+                                    unsigned int in[4], out[4];
+                                    unsigned int nin = 0, nout = 0;
+                                    for(unsigned int c=0; c<4; c++) {
+                                        if(v[tet[c]] > iso) {
+                                            in[nin++] = tet[c];
+                                        } else {
+                                            out[nout++] = tet[c];
+                                        }
+                                    }
+                                    if(nin == 0 || nout == 0) {
+                                        continue;
+                                    }
+
+                                    // vertex on the edge between corners a and b of the
+                                    // cube; one corner is always a subset of the other
+                                    auto edge = [&](unsigned int a, unsigned int b) {
+                                        const unsigned int lo = std::min(a, b);
+                                        const unsigned int hi = std::max(a, b);
+                                        const glm::uvec3 g(i + (lo & 1), j + ((lo >> 1) & 1), k + ((lo >> 2) & 1));
+                                        return get_vertex(g, hi - lo, v[lo], v[hi]);
+                                    };
+
+                                    // triangles that cut off the inside corners
+                                    uint32_t tri[2][3];
+                                    unsigned int ntri = 0;
+                                    if(nin == 1) {
+                                        tri[0][0] = edge(in[0], out[0]);
+                                        tri[0][1] = edge(in[0], out[1]);
+                                        tri[0][2] = edge(in[0], out[2]);
+                                        ntri = 1;
+                                    } else if(nin == 3) {
+                                        tri[0][0] = edge(out[0], in[0]);
+                                        tri[0][1] = edge(out[0], in[1]);
+                                        tri[0][2] = edge(out[0], in[2]);
+                                        ntri = 1;
+                                    } else {
+                                        const uint32_t q0 = edge(in[0], out[0]);
+                                        const uint32_t q1 = edge(in[0], out[1]);
+                                        const uint32_t q2 = edge(in[1], out[1]);
+                                        const uint32_t q3 = edge(in[1], out[0]);
+                                        tri[0][0] = q0; tri[0][1] = q1; tri[0][2] = q2;
+                                        tri[1][0] = q0; tri[1][1] = q2; tri[1][2] = q3;
+                                        ntri = 2;
+                                    }
+
+                                    // orient the triangles away from the inside corners
+                                    glm::vec3 inside(0.0f);
+                                    for(unsigned int c=0; c<nin; c++) {
+                                        inside += glm::vec3(in[c] & 1, (in[c] >> 1) & 1, (in[c] >> 2) & 1);
+                                    }
+                                    inside = glm::vec3(i, j, k) + inside / (float)nin + glm::vec3(0.5f);
+                                    inside = mat * glm::vec3(inside[0] / nx, inside[1] / ny, inside[2] / nz);
+                                    for(unsigned int n=0; n<ntri; n++) {
+                                        const glm::vec3& a = slab.vertices[tri[n][0]];
+                                        const glm::vec3& b = slab.vertices[tri[n][1]];
+                                        const glm::vec3& c = slab.vertices[tri[n][2]];
+                                        const glm::vec3 normal = glm::cross(b - a, c - a);
+                                        if(glm::dot(normal, (a + b + c) / 3.0f - inside) < 0.0f) {
+                                            std::swap(tri[n][1], tri[n][2]);
+                                        }
+                                        slab.triangles.insert(slab.triangles.end(), tri[n], tri[n] + 3);
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // merge the slabs; vertices on the edges shared between slabs are merged
+    this->vertices.clear();
+    this->triangles.clear();
+    std::unordered_map<uint64_t, uint32_t> index;
+    size_t bricks_skipped = 0;
+    for(const SlabMesh& slab : slabs) {
+        std::vector<uint32_t> remap(slab.vertices.size());
+        for(unsigned int v=0; v<slab.vertices.size(); v++) {
+            auto res = index.emplace(slab.keys[v], (uint32_t)this->vertices.size());
+            if(res.second) {
+                this->vertices.push_back(slab.vertices[v]);
+            }
+            remap[v] = res.first->second;
+        }
+        for(uint32_t t : slab.triangles) {
+            this->triangles.push_back(remap[t]);
+        }
+        bricks_skipped += slab.bricks_skipped;
+    }
+
+    // area-weighted vertex normals
+    this->normals.assign(this->vertices.size(), glm::vec3(0.0f));
+    for(size_t t=0; t<this->triangles.size(); t+=3) {
+        const glm::vec3& a = this->vertices[this->triangles[t]];
+        const glm::vec3& b = this->vertices[this->triangles[t+1]];
+        const glm::vec3& c = this->vertices[this->triangles[t+2]];
+        const glm::vec3 normal = glm::cross(b - a, c - a);
+        for(unsigned int n=0; n<3; n++) {
+            this->normals[this->triangles[t+n]] += normal;
+        }
+    }
+    for(glm::vec3& n : this->normals) {
+        const float l = glm::length(n);
+        if(l > 0.0f) {
+            n /= l;
+        }
+    }
+
+    timer.set_bytes(this->sf->get_size() * sizeof(float));
+    timer.set_items(this->triangles.size() / 3, "triangles");
+
+    std::cout << "Isosurface at " << isovalue << ": " << this->vertices.size() << " vertices, "
+              << this->triangles.size() / 3 << " triangles (skipped " << bricks_skipped << " of "
+              << (size_t)bx * by * bz << " bricks)" << std::endl;
+}
+
+/**
+ * @brief      write the mesh to a binary PLY (.ply) or Wavefront OBJ (.obj)
+ *             file
+ *
+ * @param[in]  filename  output file
+ */
+void Isosurface::write(const std::string& filename) const {
+    ScopedTimer timer("mesh write");
+
+    if(boost::algorithm::iends_with(filename, ".ply")) {
+        this->write_ply(filename);
+    } else if(boost::algorithm::iends_with(filename, ".obj")) {
+        this->write_obj(filename);
+    } else {
+        throw std::runtime_error("Unknown mesh format (use .ply or .obj): " + filename);
+    }
+
+    timer.set_bytes(boost::filesystem::exists(filename) ? boost::filesystem::file_size(filename) : 0);
+    timer.set_items(this->triangles.size() / 3, "triangles");
+    std::cout << "Writing " << filename << std::endl;
+}
+
+/**
+ * @brief      write the mesh to a binary (little endian) PLY file
+ *
+ * @param[in]  filename  output file
+ */
+void Isosurface::write_ply(const std::string& filename) const {
+    std::ofstream out(filename, std::ios::binary);
+    if(!out) {
+        throw std::runtime_error("Cannot open " + filename + " for writing.");
+    }
+
+    out << "ply\n"
+        << "format binary_little_endian 1.0\n"
+        << "comment EDP isosurface\n"
+        << "element vertex " << this->vertices.size() << "\n"
+        << "property float x\nproperty float y\nproperty float z\n"
+        << "property float nx\nproperty float ny\nproperty float nz\n"
+        << "element face " << this->triangles.size() / 3 << "\n"
+        << "property list uchar uint vertex_indices\n"
+        << "end_header\n";
+
+    // vertices and faces are packed in buffers (the host is assumed to be
+    // little endian, as all platforms EDP is built for)
+    std::vector<float> vbuf(this->vertices.size() * 6);
+    for(size_t v=0; v<this->vertices.size(); v++) {
+        for(unsigned int d=0; d<3; d++) {
+            vbuf[v * 6 + d] = this->vertices[v][d];
+            vbuf[v * 6 + 3 + d] = this->normals[v][d];
+        }
+    }
+    out.write(reinterpret_cast<const char*>(vbuf.data()), vbuf.size() * sizeof(float));
+
+    const size_t nfaces = this->triangles.size() / 3;
+    std::vector<char> fbuf(nfaces * 13);
+    for(size_t t=0; t<nfaces; t++) {
+        fbuf[t * 13] = 3;
+        memcpy(&fbuf[t * 13 + 1], &this->triangles[t * 3], 3 * sizeof(uint32_t));
+    }
+    out.write(fbuf.data(), fbuf.size());
+    out.close();
+}
+
+/**
+ * @brief      write the mesh to a Wavefront OBJ file
+ *
+ * @param[in]  filename  output file
+ */
+void Isosurface::write_obj(const std::string& filename) const {
+    FILE* f = fopen(filename.c_str(), "w");
+    if(f == NULL) {
+        throw std::runtime_error("Cannot open " + filename + " for writing.");
+    }
+
+    fprintf(f, "# EDP isosurface\n");
+    for(const glm::vec3& v : this->vertices) {
+        fprintf(f, "v %.6f %.6f %.6f\n", v[0], v[1], v[2]);
+    }
+    for(const glm::vec3& n : this->normals) {
+        fprintf(f, "vn %.6f %.6f %.6f\n", n[0], n[1], n[2]);
+    }
+    for(size_t t=0; t<this->triangles.size(); t+=3) {
+        const uint32_t a = this->triangles[t] + 1;
+        const uint32_t b = this->triangles[t+1] + 1;
+        const uint32_t c = this->triangles[t+2] + 1;
+        fprintf(f, "f %u//%u %u//%u %u//%u\n", a, a, b, b, c, c);
+    }
+
+    fclose(f);
+}
@@ -0,0 +1,121 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _ISOSURFACE_H
+#define _ISOSURFACE_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "scalar_field.h"
+
+/**
+ * @brief      extracts an isosurface from a scalar field as a triangle mesh
+ *
+ * Each cube between eight grid points is divided in six tetrahedra sharing
+ * the main diagonal of the cube (Freudenthal decomposition). Within each
+ * tetrahedron, the isosurface is a single triangle or a quad (two
+ * triangles); because neighboring cubes are divided consistently, the mesh
+ * has no cracks and, unlike marching cubes, no ambiguous cases.
+ *
+ * The grid is periodic; the mesh covers one unit cell. Vertices lie on the
+ * edges between grid points and are shared between the triangles through
+ * a hash map over the edges.
+ */
+class Isosurface {
+private:
+    const ScalarField* sf;
+
+    std::vector<glm::vec3> vertices;    //!< cartesian vertex positions
+    std::vector<glm::vec3> normals;     //!< vertex normals (pointing away from the enclosed region)
+    std::vector<uint32_t> triangles;    //!< three vertex indices per triangle
+
+public:
+    /**
+     * @brief      constructor
+     *
+     * @param[in]  _sf   scalar field
+     */
+    Isosurface(const ScalarField* _sf);
+
+    /**
+     * @brief      extract the isosurface
+     *
+     * For a positive isovalue, the surface encloses the points above the
+     * isovalue; for a negative isovalue, it encloses the points below.
+     *
+     * @param[in]  isovalue  isovalue
+     */
+    void extract(float isovalue);
+
+    /**
+     * @brief      write the mesh to a binary PLY (.ply) or Wavefront OBJ
+     *             (.obj) file
+     *
+     * @param[in]  filename  output file
+     */
+    void write(const std::string& filename) const;
+
+    /**
+     * @brief      get the vertices
+     *
+     * @return     cartesian vertex positions
+     */
+    inline const std::vector<glm::vec3>& get_vertices() const {
+        return this->vertices;
+    }
+
+    /**
+     * @brief      get the vertex normals
+     *
+     * @return     normals
+     */
+    inline const std::vector<glm::vec3>& get_normals() const {
+        return this->normals;
+    }
+
+    /**
+     * @brief      get the triangles
+     *
+     * @return     three vertex indices per triangle
+     */
+    inline const std::vector<uint32_t>& get_triangles() const {
+        return this->triangles;
+    }
+
+private:
+    /**
+     * @brief      write the mesh to a binary (little endian) PLY file
+     *
+     * @param[in]  filename  output file
+     */
+    void write_ply(const std::string& filename) const;
+
+    /**
+     * @brief      write the mesh to a Wavefront OBJ file
+     *
+     * @param[in]  filename  output file
+     */
+    void write_obj(const std::string& filename) const;
+};
+
+#endif //_ISOSURFACE_H
@@ -0,0 +1,101 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "memory_tracker.h"
+
+#include <cstdint>
+#include <boost/format.hpp>
+
+MemoryTracker::MemoryTracker() :
+    total_current(0),
+    total_peak(0),
+    budget(0) {
+    for(unsigned int i=0; i<NUM_SUBSYSTEMS; i++) {
+        this->current[i] = 0;
+        this->peak[i] = 0;
+    }
+}
+
+/**
+ * @brief      register an allocation
+ *
+ * @param[in]  subsystem  subsystem owning the memory
+ * @param[in]  bytes      number of bytes
+ */
+void MemoryTracker::allocate(Subsystem subsystem, size_t bytes) {
+    update_peak(this->peak[subsystem], this->current[subsystem] += bytes);
+    update_peak(this->total_peak, this->total_current += bytes);
+}
+
+/**
+ * @brief      register a deallocation
+ *
+ * @param[in]  subsystem  subsystem owning the memory
+ * @param[in]  bytes      number of bytes
+ */
+void MemoryTracker::release(Subsystem subsystem, size_t bytes) {
+    this->current[subsystem] -= bytes;
+    this->total_current -= bytes;
+}
+
+/**
+ * @brief      get the number of bytes that can still be allocated within
+ *             the budget
+ *
+ * @return     available bytes (SIZE_MAX when no budget is set)
+ */
+size_t MemoryTracker::get_available() const {
+    if(this->budget == 0) {
+        return SIZE_MAX;
+    }
+
+    const size_t used = this->total_current;
+    return used < this->budget ? this->budget - used : 0;
+}
+
+/**
+ * @brief      print current and peak memory usage per subsystem
+ *
+ * @param      out   output stream
+ */
+void MemoryTracker::report(std::ostream& out) const {
+    static const char* names[] = {"field", "projector", "plotter", "analysis"};
+
+    out << "Memory usage (MB):" << std::endl;
+    out << boost::format("  %-12s %12s %12s\n") % "subsystem" % "current" % "peak";
+    for(unsigned int i=0; i<NUM_SUBSYSTEMS; i++) {
+        out << boost::format("  %-12s %12.2f %12.2f\n") % names[i] % (this->current[i] / 1e6) % (this->peak[i] / 1e6);
+    }
+    out << boost::format("  %-12s %12.2f %12.2f\n") % "total" % (this->total_current / 1e6) % (this->total_peak / 1e6);
+    if(this->budget != 0) {
+        out << boost::format("  budget: %.2f MB\n") % (this->budget / 1e6);
+    }
+}
+
+/**
+ * @brief      atomically raise peak to value
+ *
+ * @param      peak   peak value
+ * @param[in]  value  new value
+ */
+void MemoryTracker::update_peak(std::atomic<size_t>& peak, size_t value) {
+    size_t prev = peak;
+    while(prev < value && !peak.compare_exchange_weak(prev, value)) {}
+}
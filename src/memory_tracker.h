@@ -0,0 +1,192 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _MEMORY_TRACKER_H
+#define _MEMORY_TRACKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <new>
+
+/**
+ * @brief      keeps track of the (peak) memory usage of the large buffers
+ *             per subsystem and of an optional memory budget
+ */
+class MemoryTracker {
+public:
+    enum Subsystem {
+        FIELD,          //!< scalar field grids
+        PROJECTOR,      //!< contour planes
+        PLOTTER,        //!< image surfaces
+        ANALYSIS,       //!< per grid point results of analyses (e.g. partition maps)
+
+        NUM_SUBSYSTEMS
+    };
+
+private:
+    std::atomic<size_t> current[NUM_SUBSYSTEMS];
+    std::atomic<size_t> peak[NUM_SUBSYSTEMS];
+    std::atomic<size_t> total_current;
+    std::atomic<size_t> total_peak;
+    size_t budget;      //!< memory budget in bytes (0 means unlimited)
+
+public:
+    static MemoryTracker& get() {
+        static MemoryTracker memory_tracker_instance;
+        return memory_tracker_instance;
+    }
+
+    /**
+     * @brief      register an allocation
+     *
+     * @param[in]  subsystem  subsystem owning the memory
+     * @param[in]  bytes      number of bytes
+     */
+    void allocate(Subsystem subsystem, size_t bytes);
+
+    /**
+     * @brief      register a deallocation
+     *
+     * @param[in]  subsystem  subsystem owning the memory
+     * @param[in]  bytes      number of bytes
+     */
+    void release(Subsystem subsystem, size_t bytes);
+
+    inline size_t get_current(Subsystem subsystem) const {
+        return this->current[subsystem];
+    }
+
+    inline size_t get_peak(Subsystem subsystem) const {
+        return this->peak[subsystem];
+    }
+
+    inline size_t get_total_peak() const {
+        return this->total_peak;
+    }
+
+    /**
+     * @brief      set the memory budget
+     *
+     * @param[in]  _budget  budget in bytes (0 means unlimited)
+     */
+    inline void set_budget(size_t _budget) {
+        this->budget = _budget;
+    }
+
+    inline size_t get_budget() const {
+        return this->budget;
+    }
+
+    /**
+     * @brief      get the number of bytes that can still be allocated within
+     *             the budget
+     *
+     * @return     available bytes (SIZE_MAX when no budget is set)
+     */
+    size_t get_available() const;
+
+    /**
+     * @brief      print current and peak memory usage per subsystem
+     *
+     * @param      out   output stream
+     */
+    void report(std::ostream& out) const;
+
+private:
+    MemoryTracker();
+
+    static void update_peak(std::atomic<size_t>& peak, size_t value);
+
+    MemoryTracker(MemoryTracker const&)    = delete;
+    void operator=(MemoryTracker const&)   = delete;
+};
+
+/**
+ * @brief      STL allocator that registers its allocations with the
+ *             MemoryTracker
+ *
+ * @tparam     T          value type
+ * @tparam     subsystem  subsystem owning the memory
+ */
+template <typename T, MemoryTracker::Subsystem subsystem>
+class TrackedAllocator {
+public:
+    typedef T value_type;
+
+    template <typename U> struct rebind {
+        typedef TrackedAllocator<U, subsystem> other;
+    };
+
+    TrackedAllocator() {}
+
+    template <typename U> TrackedAllocator(const TrackedAllocator<U, subsystem>&) {}
+
+    T* allocate(size_t n) {
+        T* ptr = static_cast<T*>(::operator new(n * sizeof(T)));
+        MemoryTracker::get().allocate(subsystem, n * sizeof(T));
+        return ptr;
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        MemoryTracker::get().release(subsystem, n * sizeof(T));
+        ::operator delete(ptr);
+    }
+};
+
+template <typename T, typename U, MemoryTracker::Subsystem subsystem>
+bool operator==(const TrackedAllocator<T, subsystem>&, const TrackedAllocator<U, subsystem>&) {
+    return true;
+}
+
+template <typename T, typename U, MemoryTracker::Subsystem subsystem>
+bool operator!=(const TrackedAllocator<T, subsystem>&, const TrackedAllocator<U, subsystem>&) {
+    return false;
+}
+
+/**
+ * @brief      allocate a tracked array
+ *
+ * @param[in]  subsystem  subsystem owning the memory
+ * @param[in]  n          number of elements
+ *
+ * @return     pointer to array
+ */
+template <typename T> T* tracked_new(MemoryTracker::Subsystem subsystem, size_t n) {
+    T* ptr = new T[n];
+    MemoryTracker::get().allocate(subsystem, n * sizeof(T));
+    return ptr;
+}
+
+/**
+ * @brief      release a tracked array
+ *
+ * @param[in]  subsystem  subsystem owning the memory
+ * @param      ptr        pointer to array (may be null)
+ * @param[in]  n          number of elements
+ */
+template <typename T> void tracked_delete(MemoryTracker::Subsystem subsystem, T* ptr, size_t n) {
+    if(ptr != nullptr) {
+        delete[] ptr;
+        MemoryTracker::get().release(subsystem, n * sizeof(T));
+    }
+}
+
+#endif // _MEMORY_TRACKER_H
@@ -0,0 +1,167 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "multipole_expansion.h"
+
+#include <fstream>
+#include <boost/format.hpp>
+
+/**
+ * @brief      constructor
+ *
+ * @param[in]  _sf             scalar field
+ * @param[in]  _lebedev_order  Lebedev order of the angular grid
+ * @param[in]  _lmax           maximum angular momentum
+ */
+MultipoleExpansion::MultipoleExpansion(const ScalarField* _sf,
+                                       unsigned int _lebedev_order,
+                                       unsigned int _lmax) :
+    sf(_sf),
+    lebedev_order(_lebedev_order),
+    lmax(_lmax) {
+
+    if(this->lebedev_order >= Quadrature::NUM_LEBEDEV_POINTS) {
+        throw std::runtime_error("Invalid Lebedev order.");
+    }
+
+    // tabulate the weighted harmonics on the Lebedev points
+    const LebedevSpan grid = Quadrature::get_lebedev(this->lebedev_order);
+    const unsigned int nlm = this->get_nr_coefficients();
+    this->ylm_table.resize(grid.size() * nlm);
+    for(unsigned int j=0; j<grid.size(); j++) {
+        double* y = &this->ylm_table[(size_t)j * nlm];
+        SphericalHarmonics::evaluate(this->lmax, glm::dvec3(grid[j].x, grid[j].y, grid[j].z), y);
+        for(unsigned int k=0; k<nlm; k++) {
+            y[k] *= 4.0 * M_PI * grid[j].w;
+        }
+    }
+}
+
+/**
+ * @brief      calculate the multipole coefficients
+ *
+ * The coefficients at one radius around one center are computed by a single
+ * thread.
+ *
+ * @param[in]  centers  centers of the spheres
+ * @param[in]  radii    radii of the spheres
+ *
+ * @return     for each center, the coefficients for each radius (the
+ *             coefficient index runs fastest, see SphericalHarmonics)
+ */
+std::vector<std::vector<double> > MultipoleExpansion::calculate(const std::vector<glm::vec3>& centers,
+                                                                const std::vector<float>& radii) const {
+    const LebedevSpan grid = Quadrature::get_lebedev(this->lebedev_order);
+    const unsigned int npts = grid.size();
+    const unsigned int nlm = this->get_nr_coefficients();
+    const unsigned int ncenters = centers.size();
+    const unsigned int nradii = radii.size();
+
+    std::vector<std::vector<double> > coefficients(ncenters, std::vector<double>((size_t)nradii * nlm, 0.0));
+
+    #pragma omp parallel
+    {
+        EDP_TRACE_SCOPE("multipole expansion");
+        std::vector<float> positions((size_t)npts * 3);
+        std::vector<float> values(npts);
+
+        #pragma omp for collapse(2) schedule(dynamic) nowait
+        for(unsigned int c=0; c<ncenters; c++) {
+            for(unsigned int s=0; s<nradii; s++) {
+                // values at the Lebedev points of this sphere
+                for(unsigned int j=0; j<npts; j++) {
+                    const glm::vec3 pp = centers[c] + glm::vec3(grid[j].x, grid[j].y, grid[j].z) * radii[s];
+                    positions[(size_t)j * 3] = pp[0];
+                    positions[(size_t)j * 3 + 1] = pp[1];
+                    positions[(size_t)j * 3 + 2] = pp[2];
+                }
+                this->sf->get_values_interp(positions.data(), npts, values.data(), true, false);
+
+                // project onto the tabulated harmonics
+                double* out = &coefficients[c][(size_t)s * nlm];
+                for(unsigned int j=0; j<npts; j++) {
+                    const double* y = &this->ylm_table[(size_t)j * nlm];
+                    const double v = values[j];
+                    for(unsigned int k=0; k<nlm; k++) {
+                        out[k] += v * y[k];
+                    }
+                }
+            }
+        }
+    }
+
+    return coefficients;
+}
+
+/**
+ * @brief      calculate the radial multipole profiles around atoms and
+ *             write them to a table
+ *
+ * @param[in]  filename  output file
+ * @param[in]  atoms     atom indices (0-based)
+ * @param[in]  radius    largest radius
+ * @param[in]  step      distance between subsequent radii
+ */
+void MultipoleExpansion::write_atom_table(const std::string& filename, const std::vector<unsigned int>& atoms,
+                                          float radius, float step) const {
+    ScopedTimer timer("multipole expansion");
+
+    if(step <= 0.0f) {
+        throw std::runtime_error("Radial step should be positive.");
+    }
+
+    std::vector<float> radii;
+    for(unsigned int i=1; i * step <= radius; i++) {
+        radii.push_back(i * step);
+    }
+
+    std::vector<glm::vec3> centers;
+    for(unsigned int atom : atoms) {
+        if(atom >= this->sf->get_nr_atoms()) {
+            throw std::runtime_error("Invalid atom id: " + std::to_string(atom + 1));
+        }
+        centers.push_back(this->sf->get_atom_position(atom));
+    }
+
+    const std::vector<std::vector<double> > coefficients = this->calculate(centers, radii);
+    timer.set_items(centers.size() * radii.size() * Quadrature::num_lebedev_points[this->lebedev_order], "points");
+
+    // write to file; one row per atom and radius
+    const unsigned int nlm = this->get_nr_coefficients();
+    std::ofstream out(filename);
+    out << boost::format("%6s  %12s") % "# atom" % "radius";
+    for(unsigned int l=0; l<=this->lmax; l++) {
+        for(int m=-(int)l; m<=(int)l; m++) {
+            out << boost::format("  %14s") % ("c(" + std::to_string(l) + "," + std::to_string(m) + ")");
+        }
+    }
+    out << "\n";
+    for(unsigned int c=0; c<centers.size(); c++) {
+        for(unsigned int s=0; s<radii.size(); s++) {
+            out << boost::format("%6i  %12.6f") % (atoms[c] + 1) % radii[s];
+            for(unsigned int k=0; k<nlm; k++) {
+                out << boost::format("  %14.6e") % coefficients[c][(size_t)s * nlm + k];
+            }
+            out << "\n";
+        }
+    }
+
+    out.close();
+}
@@ -0,0 +1,109 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _MULTIPOLE_EXPANSION_H
+#define _MULTIPOLE_EXPANSION_H
+
+#include <vector>
+#include <string>
+#include <glm/glm.hpp>
+
+#include "scalar_field.h"
+#include "quadrature.h"
+#include "spherical_harmonics.h"
+
+/**
+ * @brief      projects a scalar field on spheres around a set of centers onto
+ *             real spherical harmonics
+ *
+ * For every center and radius r, the coefficients
+ *   c_lm(r) = int rho(center + r n) Y_lm(n) dOmega
+ * are evaluated with a Lebedev grid, such that rho ~ sum_lm c_lm(r) Y_lm.
+ * The monopole c_00 equals sqrt(4 pi) times the sphere average.
+ *
+ * The harmonics (multiplied by the quadrature weights) are tabulated once
+ * on the Lebedev points, such that each (center, radius) pair only requires
+ * one interpolation per point and a matrix-vector product.
+ */
+class MultipoleExpansion {
+private:
+    const ScalarField* sf;
+    unsigned int lebedev_order;     //!< Lebedev order of the angular grid
+    unsigned int lmax;              //!< maximum angular momentum
+
+    std::vector<double> ylm_table;  //!< 4 pi w_j Y_lm(n_j); point index runs slowest
+
+public:
+    /**
+     * @brief      constructor
+     *
+     * @param[in]  _sf             scalar field
+     * @param[in]  _lebedev_order  Lebedev order of the angular grid
+     * @param[in]  _lmax           maximum angular momentum
+     */
+    MultipoleExpansion(const ScalarField* _sf,
+                       unsigned int _lebedev_order = Quadrature::LEBEDEV_194,
+                       unsigned int _lmax = 4);
+
+    /**
+     * @brief      get the number of coefficients per radius
+     *
+     * @return     (lmax + 1)^2
+     */
+    inline unsigned int get_nr_coefficients() const {
+        return SphericalHarmonics::get_size(this->lmax);
+    }
+
+    /**
+     * @brief      whether the Lebedev grid integrates products of two
+     *             harmonics up to lmax exactly
+     *
+     * @return     true if the grid is sufficiently fine
+     */
+    inline bool is_grid_sufficient() const {
+        return Quadrature::lebedev_degree[this->lebedev_order] >= 2 * this->lmax;
+    }
+
+    /**
+     * @brief      calculate the multipole coefficients
+     *
+     * @param[in]  centers  centers of the spheres
+     * @param[in]  radii    radii of the spheres
+     *
+     * @return     for each center, the coefficients for each radius (the
+     *             coefficient index runs fastest, see SphericalHarmonics)
+     */
+    std::vector<std::vector<double> > calculate(const std::vector<glm::vec3>& centers,
+                                                const std::vector<float>& radii) const;
+
+    /**
+     * @brief      calculate the radial multipole profiles around atoms and
+     *             write them to a table
+     *
+     * @param[in]  filename  output file
+     * @param[in]  atoms     atom indices (0-based)
+     * @param[in]  radius    largest radius
+     * @param[in]  step      distance between subsequent radii
+     */
+    void write_atom_table(const std::string& filename, const std::vector<unsigned int>& atoms,
+                          float radius, float step) const;
+};
+
+#endif //_MULTIPOLE_EXPANSION_H
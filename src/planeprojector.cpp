@@ -28,10 +28,26 @@
  * @param[in]  _max              maximum value
  * @param[in]  _color_scheme_id  The color scheme identifier
  */
-PlaneProjector::PlaneProjector(ScalarField* _sf, unsigned int _color_scheme_id) {
-    this->sf = _sf;
-    this->color_scheme_id = _color_scheme_id;
-}
+PlaneProjector::PlaneProjector(ScalarField* _sf, unsigned int _color_scheme_id) :
+    scheme(nullptr),
+    sf(_sf),
+    plt(nullptr),
+    planegrid_log(nullptr),
+    planegrid_real(nullptr),
+    planegrid_box(nullptr),
+    planegrid_size(0),
+    log_min(0),
+    log_max(0),
+    ix(0),
+    iy(0),
+    scale(0),
+    plane_v1(0.0f),
+    plane_v2(0.0f),
+    plane_p(0.0f),
+    plane_i0(0),
+    plane_j0(0),
+    color_scheme_id(_color_scheme_id),
+    flag_negative(false) {}
 
 /**
  * @brief      set the scaling for the graph
@@ -45,6 +61,7 @@ void PlaneProjector::set_scaling(bool allow_negative, float _min, float _max) {
     this->log_min = _min;
     this->log_max = _max;
 
+    delete this->scheme;
     if(this->flag_negative) {
         this->scheme = new ColorScheme(-1, 1, this->color_scheme_id);
     } else {
@@ -56,6 +73,10 @@ void PlaneProjector::set_scaling(bool allow_negative, float _min, float _max) {
  * @brief      plot contour plane
  */
 void PlaneProjector::plot() {
+    ScopedTimer timer("plot");
+    timer.set_items(this->ix * this->iy, "pixels");
+
+    delete this->plt;
     this->plt = new Plotter(this->ix, this->iy);
 
     for(unsigned int i=0; i<uint(this->iy); i++) {
@@ -87,47 +108,59 @@ void PlaneProjector::extract(glm::vec3 _v1, glm::vec3 _v2, const glm::vec3& _p,
     _v1 = glm::normalize(_v1);
     _v2 = glm::normalize(_v2);
 
+    // release any previously extracted plane
+    tracked_delete(MemoryTracker::PROJECTOR, this->planegrid_log, this->planegrid_size);
+    tracked_delete(MemoryTracker::PROJECTOR, this->planegrid_real, this->planegrid_size);
+    tracked_delete(MemoryTracker::PROJECTOR, this->planegrid_box, this->planegrid_size);
+
     this->scale = _scale;
     this->ix = int((hi - li) * _scale);
     this->iy = int((hj - lj) * _scale);
 
-    std::cout << "Creating " << this->ix << "x" << this->iy << "px image..." << std::endl;
+    this->plane_v1 = _v1;
+    this->plane_v2 = _v2;
+    this->plane_p = _p;
+    this->plane_i0 = this->ix / 2;
+    this->plane_j0 = this->iy / 2;
 
-    this->planegrid_log =  new float[this->ix * this->iy];
-    this->planegrid_real = new float[this->ix * this->iy];
-    this->planegrid_box =  new bool[this->ix * this->iy];
-
-    #pragma omp parallel for collapse(2)
-    for(int i=0; i<this->ix; i++) {
-        for(int j=0; j<this->iy; j++) {
-            const float x = _v1[0] * float(i - this->ix / 2) / _scale + _v2[0] * float(j - this->iy / 2) / _scale + _p[0];
-            const float y = _v1[1] * float(i - this->ix / 2) / _scale + _v2[1] * float(j - this->iy / 2) / _scale + _p[1];
-            const float z = _v1[2] * float(i - this->ix / 2) / _scale + _v2[2] * float(j - this->iy / 2) / _scale + _p[2];
-
-            const bool is_inside = this->sf->is_inside(x,y,z);
-            const float val = this->sf->get_value_interp(x,y,z);
-
-            if(!is_inside) {
-                this->planegrid_box[j * this->ix + i] = false;
-                this->planegrid_log[j * this->ix + i] = 0.0f;
-                this->planegrid_real[j * this->ix + i] = 0.0f;
-                continue;
-            } else {
-                this->planegrid_box[j * this->ix + i] = true;
-            }
+    std::cout << "Creating " << this->ix << "x" << this->iy << "px image..." << std::endl;
 
-            if(this->flag_negative) {
-                this->planegrid_log[j * this->ix + i] = this->calculate_scaled_value_log(val);
-            } else {
-                if(val > 0) {
-                    this->planegrid_log[j * this->ix + i] = this->calculate_scaled_value_log(val);
+    this->planegrid_size = this->ix * this->iy;
+    this->planegrid_log =  tracked_new<float>(MemoryTracker::PROJECTOR, this->planegrid_size);
+    this->planegrid_real = tracked_new<float>(MemoryTracker::PROJECTOR, this->planegrid_size);
+    this->planegrid_box =  tracked_new<bool>(MemoryTracker::PROJECTOR, this->planegrid_size);
+
+    ScopedTimer timer("extract");
+    timer.set_items(this->ix * this->iy, "pixels");
+
+    #pragma omp parallel
+    {
+        EDP_TRACE_SCOPE("extract");
+        #pragma omp for collapse(2) nowait
+        for(int i=0; i<this->ix; i++) {
+            for(int j=0; j<this->iy; j++) {
+                const float x = _v1[0] * float(i - this->ix / 2) / _scale + _v2[0] * float(j - this->iy / 2) / _scale + _p[0];
+                const float y = _v1[1] * float(i - this->ix / 2) / _scale + _v2[1] * float(j - this->iy / 2) / _scale + _p[1];
+                const float z = _v1[2] * float(i - this->ix / 2) / _scale + _v2[2] * float(j - this->iy / 2) / _scale + _p[2];
+
+                const bool is_inside = this->sf->is_inside(x,y,z);
+                const float val = this->sf->get_value_interp(x,y,z);
+
+                if(!is_inside) {
+                    this->planegrid_box[j * this->ix + i] = false;
+                    this->planegrid_log[j * this->ix + i] = 0.0f;
+                    this->planegrid_real[j * this->ix + i] = 0.0f;
+                    continue;
                 } else {
-                    this->planegrid_log[j * this->ix + i] = -12;
+                    this->planegrid_box[j * this->ix + i] = true;
                 }
+
+                this->planegrid_log[j * this->ix + i] = this->calculate_scaled_value_log(val);
+                this->planegrid_real[j * this->ix + i] = val;
             }
-            this->planegrid_real[j * this->ix + i] = val;
         }
     }
+    timer.stop();
 
     this->cut_and_recast_plane();
 }
@@ -142,18 +175,20 @@ void PlaneProjector::extract(glm::vec3 _v1, glm::vec3 _v2, const glm::vec3& _p,
  * @param[in]  hi      extend in +e direction
  */
 void PlaneProjector::extract_line(glm::vec3 e, const glm::vec3& p, float _scale, float li, float hi) {
+    ScopedTimer timer("line extraction");
+
     e = glm::normalize(e);
 
-    this->scale = _scale;
-    this->ix = int((hi - li) * _scale);
+    // the line length is kept local so that an extracted plane stays intact
+    const int n = int((hi - li) * _scale);
 
     std::vector<glm::vec3> pos;
     std::vector<float> vals;
 
-    for(int i=0; i<this->ix; i++) {
-        float x = e[0] * float(i - this->ix / 2) / _scale + p[0];
-        float y = e[1] * float(i - this->ix / 2) / _scale + p[1];
-        float z = e[2] * float(i - this->ix / 2) / _scale + p[2];
+    for(int i=0; i<n; i++) {
+        float x = e[0] * float(i - n / 2) / _scale + p[0];
+        float y = e[1] * float(i - n / 2) / _scale + p[1];
+        float z = e[2] * float(i - n / 2) / _scale + p[2];
 
         float val = this->sf->get_value_interp(x,y,z);
 
@@ -162,6 +197,7 @@ void PlaneProjector::extract_line(glm::vec3 e, const glm::vec3& p, float _scale,
             vals.push_back(val);
         }
     }
+    timer.set_items(n, "points");
 
     // open file and output results
     std::ofstream out("line_extraction.txt");
@@ -173,82 +209,247 @@ void PlaneProjector::extract_line(glm::vec3 e, const glm::vec3& p, float _scale,
 }
 
 /**
- * @brief      calculate the average density (electron or potential) and store it as function of z-height
+ * @brief      calculate the average density (electron or potential) and store
+ *             it as function of the position along each of the lattice vectors
  */
 void PlaneProjector::extract_plane_average() {
+    ScopedTimer timer("plane averages");
+
     unsigned int dimensions[3];
     this->sf->copy_grid_dimensions(dimensions);
 
-    const float* grid = this->sf->get_grid_ptr();
-    std::vector<float> avg;
-    std::vector<float> z;
-
-    const float sz = (float)(dimensions[0] * dimensions[1]);
-
-    for(unsigned int i=0; i<dimensions[2]; i++) {   // loop over z-axis
-        float sum = 0.0f;
-        #pragma omp parallel for collapse(2) reduction(+:sum)
-        for(unsigned int j=0; j<dimensions[1]; j++) {   // loop over y-axis
-            for(unsigned int k=0; k<dimensions[0]; k++) {   // loop over x-axis
-                sum += grid[i * dimensions[0] * dimensions[1] +   // z
-                            j * dimensions[0] +                   // y
-                            k];                                   // x
+    const std::vector<std::vector<float> > avg = this->calculate_plane_averages();
+    timer.set_bytes(this->sf->get_size() * sizeof(float));
+    timer.set_items(this->sf->get_size(), "values");
+
+    // write to file
+    // open files and output results
+    static const char* filenames[3] = {"x_extraction.txt", "y_extraction.txt", "z_extraction.txt"};
+    for(unsigned int d=0; d<3; d++) {
+        std::ofstream out(filenames[d]);
+        for(unsigned int i=0; i<avg[d].size(); i++) {
+            out << boost::format("%12.6f  %12.6f\n") % (i / (float)dimensions[d]) % avg[d][i];
+        }
+
+        out.close();
+    }
+}
+
+/**
+ * @brief      calculate the average density (electron or potential) as
+ *             function of z-height
+ *
+ * @return     average value for each layer along the z-axis
+ */
+std::vector<float> PlaneProjector::calculate_plane_average() const {
+    return this->calculate_plane_averages()[2];
+}
+
+/**
+ * @brief      calculate the average density (electron or potential) over the
+ *             planes spanned by two lattice vectors as function of the position
+ *             along the third lattice vector, for all three lattice vectors
+ *
+ * The grid is traversed once in memory order. Each thread handles a range
+ * of z-layers: the sum over a layer is owned by a single thread and the
+ * sums over the x- and y-layers are collected in thread-private arrays
+ * which are merged at the end.
+ *
+ * @return     average value for each layer along x, y and z
+ */
+std::vector<std::vector<float> > PlaneProjector::calculate_plane_averages() const {
+    unsigned int dimensions[3];
+    this->sf->copy_grid_dimensions(dimensions);
+    const unsigned int nx = dimensions[0];
+    const unsigned int ny = dimensions[1];
+    const unsigned int nz = dimensions[2];
+
+    std::vector<double> sum_x(nx, 0.0);
+    std::vector<double> sum_y(ny, 0.0);
+    std::vector<double> sum_z(nz, 0.0);
+
+    #pragma omp parallel
+    {
+        EDP_TRACE_SCOPE("plane average");
+        std::vector<double> local_x(nx, 0.0);
+        std::vector<double> local_y(ny, 0.0);
+        std::vector<float> buffer(nx);
+
+        #pragma omp for schedule(static)
+        for(unsigned int k=0; k<nz; k++) {   // loop over z-axis
+            double layer = 0.0;
+            for(unsigned int j=0; j<ny; j++) {   // loop over y-axis
+                const float* row = this->sf->get_row(j, k, buffer.data());
+                double line = 0.0;
+                for(unsigned int i=0; i<nx; i++) {   // loop over x-axis
+                    line += row[i];
+                    local_x[i] += row[i];
+                }
+                local_y[j] += line;
+                layer += line;
+            }
+            sum_z[k] = layer;
+        }
+
+        #pragma omp critical
+        {
+            for(unsigned int i=0; i<nx; i++) {
+                sum_x[i] += local_x[i];
+            }
+            for(unsigned int j=0; j<ny; j++) {
+                sum_y[j] += local_y[j];
             }
         }
-        avg.push_back(sum / sz);
-        z.push_back(i / (float)dimensions[2]);
     }
 
+    std::vector<std::vector<float> > avg(3);
+    for(unsigned int i=0; i<nx; i++) {
+        avg[0].push_back(sum_x[i] / (double)(ny * nz));
+    }
+    for(unsigned int j=0; j<ny; j++) {
+        avg[1].push_back(sum_y[j] / (double)(nx * nz));
+    }
+    for(unsigned int k=0; k<nz; k++) {
+        avg[2].push_back(sum_z[k] / (double)(nx * ny));
+    }
+
+    return avg;
+}
+
+/**
+ * @brief      calculate the average density (electron or potential) over the
+ *             planes normal to a direction and store it as function of the
+ *             position along that direction
+ *
+ * @param[in]  direction  normal of the planes
+ * @param[in]  binsize    distance between the planes in angstrom
+ */
+void PlaneProjector::extract_directional_average(const glm::vec3& direction, float binsize) {
+    ScopedTimer timer("directional average");
+
+    std::vector<float> positions;
+    std::vector<float> avg;
+    this->calculate_directional_average(direction, binsize, positions, avg);
+    timer.set_bytes(this->sf->get_size() * sizeof(float));
+    timer.set_items(this->sf->get_size(), "values");
+
     // write to file
     // open file and output results
-    std::ofstream out("z_extraction.txt");
+    std::ofstream out("direction_extraction.txt");
     for(unsigned int i=0; i<avg.size(); i++) {
-        out << boost::format("%12.6f  %12.6f\n") % z[i] % avg[i];
+        out << boost::format("%12.6f  %12.6f\n") % positions[i] % avg[i];
     }
 
     out.close();
 }
 
+/**
+ * @brief      calculate the average density (electron or potential) over the
+ *             planes normal to a direction as function of the position along
+ *             that direction
+ *
+ * Every grid point of the unit cell is projected onto the direction and its
+ * value is added to the bin holding the projection. Since the projection is
+ * linear in the grid indices, it is updated incrementally. Each thread
+ * accumulates into its own bins, which are merged at the end.
+ *
+ * @param[in]  direction  normal of the planes
+ * @param[in]  binsize    distance between the planes in angstrom
+ * @param[out] positions  position of each (non-empty) bin along the direction
+ * @param[out] avg        average value in each (non-empty) bin
+ */
+void PlaneProjector::calculate_directional_average(const glm::vec3& direction, float binsize,
+                                                   std::vector<float>& positions,
+                                                   std::vector<float>& avg) const {
+    if(glm::length(direction) == 0.0f || binsize <= 0.0f) {
+        throw std::runtime_error("Directional average requires a non-zero direction and bin size.");
+    }
+
+    unsigned int dimensions[3];
+    this->sf->copy_grid_dimensions(dimensions);
+    const unsigned int nx = dimensions[0];
+    const unsigned int ny = dimensions[1];
+    const unsigned int nz = dimensions[2];
+
+    // projection of a step along each of the grid axes
+    const glm::vec3 n = glm::normalize(direction);
+    const glm::mat3& mat = this->sf->get_mat_unitcell();
+    const float dx = glm::dot(mat[0], n) / (float)nx;
+    const float dy = glm::dot(mat[1], n) / (float)ny;
+    const float dz = glm::dot(mat[2], n) / (float)nz;
+
+    // range of the projections of the grid points (located at the voxel centers);
+    // the first bin is centered at the lowest projection
+    const float s0 = 0.5f * (dx + dy + dz);
+    const float smin = s0 + std::min(0.0f, dx * (nx-1)) + std::min(0.0f, dy * (ny-1)) + std::min(0.0f, dz * (nz-1)) - 0.5f * binsize;
+    const float smax = s0 + std::max(0.0f, dx * (nx-1)) + std::max(0.0f, dy * (ny-1)) + std::max(0.0f, dz * (nz-1));
+    const unsigned int nbins = (unsigned int)((smax - smin) / binsize) + 1;
+
+    std::vector<double> sum(nbins, 0.0);
+    std::vector<size_t> count(nbins, 0);
+
+    #pragma omp parallel
+    {
+        EDP_TRACE_SCOPE("directional average");
+        std::vector<double> local_sum(nbins, 0.0);
+        std::vector<size_t> local_count(nbins, 0);
+        std::vector<float> buffer(nx);
+
+        #pragma omp for schedule(static)
+        for(unsigned int k=0; k<nz; k++) {   // loop over z-axis
+            for(unsigned int j=0; j<ny; j++) {   // loop over y-axis
+                const float* row = this->sf->get_row(j, k, buffer.data());
+                const float srow = s0 + k * dz + j * dy - smin;
+                for(unsigned int i=0; i<nx; i++) {   // loop over x-axis
+                    const unsigned int bin = std::min((unsigned int)((srow + i * dx) / binsize), nbins - 1);
+                    local_sum[bin] += row[i];
+                    local_count[bin]++;
+                }
+            }
+        }
+
+        #pragma omp critical
+        {
+            for(unsigned int b=0; b<nbins; b++) {
+                sum[b] += local_sum[b];
+                count[b] += local_count[b];
+            }
+        }
+    }
+
+    positions.clear();
+    avg.clear();
+    for(unsigned int b=0; b<nbins; b++) {
+        if(count[b] > 0) {
+            positions.push_back(smin + (b + 0.5f) * binsize);
+            avg.push_back(sum[b] / (double)count[b]);
+        }
+    }
+}
+
 /**
  * @brief      calculate the average density projected on a sphere of a
  *             specified radius
  *
  * @param[in]  p       position of the sphere
  * @param[in]  radius  radius of the sphere
+ * @param[in]  step    distance between subsequent radii
+ * @param[in]  order   Lebedev order of the angular grid
  */
-void PlaneProjector::extract_sphere_average(const glm::vec3& p, float radius) {
-    // use Lebedev quadrature points
-    unsigned int level = Quadrature::LEBEDEV_194;
-    unsigned int start_idx = 0;
-    for(unsigned int i=0; i<level-1; i++) {
-        start_idx += Quadrature::num_lebedev_points[i];
+void PlaneProjector::extract_sphere_average(const glm::vec3& p, float radius, float step, unsigned int order) {
+    ScopedTimer timer("sphere extraction");
+
+    if(step <= 0.0f) {
+        throw std::runtime_error("Radial step should be positive.");
     }
 
     // build vectors
     std::vector<float> radii;
-    std::vector<float> values;
-
-    // integrate over points
-    for(float r = 0.0; r <= radius; r += 0.01f) {
-        float sum = 0.0f;
-        #pragma omp parallel for reduction(+:sum)
-        for(unsigned int i=0; i<Quadrature::num_lebedev_points[level]; i++) {
-            glm::vec3 pp = p + glm::vec3(Quadrature::lebedev_coefficients[i][0],
-                                         Quadrature::lebedev_coefficients[i][1],
-                                         Quadrature::lebedev_coefficients[i][2]) * r;
-
-            // align point to unit cell when crossing periodic boundary conditions
-            glm::vec3 pd = this->sf->get_mat_unitcell_inverse() * pp;
-            pd = glm::fract(pd);
-            pp = this->sf->get_mat_unitcell() * pd;
-
-            const float val = this->sf->get_value_interp(pp[0], pp[1], pp[2]);
-
-            sum += val;
-        }
-        radii.push_back(r);
-        values.push_back(sum / (float)Quadrature::num_lebedev_points[level]);
+    for(unsigned int i=0; i * step <= radius; i++) {
+        radii.push_back(i * step);
     }
+    const std::vector<float> values = this->calculate_sphere_average(p, radii, order);
+    timer.set_items(radii.size() * Quadrature::num_lebedev_points[order], "points");
 
     // write to file
     // open file and output results
@@ -260,12 +461,57 @@ void PlaneProjector::extract_sphere_average(const glm::vec3& p, float radius) {
     out.close();
 }
 
+/**
+ * @brief      calculate the average density projected on spheres of
+ *             specified radii
+ *
+ * @param[in]  p      position of the sphere
+ * @param[in]  radii  radii of the spheres
+ * @param[in]  order  Lebedev order of the angular grid
+ *
+ * @return     average value for each radius
+ */
+std::vector<float> PlaneProjector::calculate_sphere_average(const glm::vec3& p, const std::vector<float>& radii,
+                                                         unsigned int order) const {
+    // use Lebedev quadrature points
+    const LebedevSpan grid = Quadrature::get_lebedev(order);
+    const unsigned int npts = grid.size();
+
+    // sample all radii and directions in a single pass
+    std::vector<float> positions(radii.size() * npts * 3);
+    for(unsigned int j=0; j<radii.size(); j++) {
+        for(unsigned int i=0; i<npts; i++) {
+            positions[(j * npts + i) * 3    ] = p[0] + grid[i].x * radii[j];
+            positions[(j * npts + i) * 3 + 1] = p[1] + grid[i].y * radii[j];
+            positions[(j * npts + i) * 3 + 2] = p[2] + grid[i].z * radii[j];
+        }
+    }
+
+    std::vector<float> samples(radii.size() * npts);
+    this->sf->get_values_interp(&positions[0], samples.size(), &samples[0], true);
+
+    // integrate over points; the weights of each order sum to unity
+    std::vector<float> values(radii.size());
+    for(unsigned int j=0; j<radii.size(); j++) {
+        double sum = 0.0;
+        for(unsigned int i=0; i<npts; i++) {
+            sum += grid[i].w * samples[j * npts + i];
+        }
+        values[j] = sum;
+    }
+
+    return values;
+}
+
 /**
  * @brief      draw isolines
  *
  * @param[in]  bins             number of bins
  */
 void PlaneProjector::isolines(unsigned int bins) {
+    ScopedTimer timer("isolines");
+    timer.set_items(this->ix * this->iy, "pixels");
+
     if(this->flag_negative) {
         for(float val = this->log_min; val <= this->log_max; val += 1) {
             this->draw_isoline(-pow(10.0, val));
@@ -287,6 +533,8 @@ void PlaneProjector::isolines(unsigned int bins) {
  * @param[in]  negative_values  whether there are negative values in the plot
  */
 void PlaneProjector::draw_legend() {
+    ScopedTimer timer("legend");
+
     // set sizes
     const float size = this->scale * 1.2;
     const float fontsize = 24.f / 100.f * this->scale;
@@ -393,13 +641,58 @@ void PlaneProjector::draw_legend() {
     }
 }
 
+/**
+ * @brief      draw the boundaries between the Bader basins on the plane
+ *
+ * @param[in]  bader  Bader partitioning of the scalar field
+ */
+void PlaneProjector::draw_partition_boundaries(const BaderPartitioning& bader) {
+    ScopedTimer timer("partition boundaries");
+    timer.set_items(this->ix * this->iy, "pixels");
+
+    // basin of each pixel
+    std::vector<int> basins(this->ix * this->iy, -1);
+
+    #pragma omp parallel
+    {
+        EDP_TRACE_SCOPE("partition boundaries");
+        #pragma omp for collapse(2) nowait
+        for(int i=0; i<this->ix; i++) {
+            for(int j=0; j<this->iy; j++) {
+                if(!this->planegrid_box[j * this->ix + i]) {
+                    continue;
+                }
+                const glm::vec3 pos = this->plane_v1 * float(i - this->plane_i0) / this->scale +
+                                      this->plane_v2 * float(j - this->plane_j0) / this->scale +
+                                      this->plane_p;
+                basins[j * this->ix + i] = bader.get_atom(pos);
+            }
+        }
+    }
+
+    // draw pixels whose basin differs from the next pixel
+    for(int j=0; j<this->iy - 1; j++) {
+        for(int i=0; i<this->ix - 1; i++) {
+            const int b = basins[j * this->ix + i];
+            const int br = basins[j * this->ix + i + 1];
+            const int bd = basins[(j + 1) * this->ix + i];
+            if(b >= 0 && ((br >= 0 && br != b) || (bd >= 0 && bd != b))) {
+                this->plt->draw_filled_rectangle(i, j, 1, 1, Color(255, 255, 255));
+            }
+        }
+    }
+}
+
 /**
  * @brief      write contour plane to file
  *
  * @param[in]  filename  path to png file
  */
 void PlaneProjector::write(std::string filename) {
+    ScopedTimer timer("png write");
+    timer.set_items(this->ix * this->iy, "pixels");
     plt->write(filename.c_str());
+    timer.set_bytes(boost::filesystem::exists(filename) ? boost::filesystem::file_size(filename) : 0);
     std::cout << "Writing " << filename << std::endl;
 }
 
@@ -407,15 +700,20 @@ void PlaneProjector::write(std::string filename) {
  * @brief      Destroys the object.
  */
 PlaneProjector::~PlaneProjector() {
-    delete[] this->planegrid_log;
-    delete[] this->planegrid_real;
-    delete[] this->planegrid_box;
+    delete this->plt;
+    delete this->scheme;
+    tracked_delete(MemoryTracker::PROJECTOR, this->planegrid_log, this->planegrid_size);
+    tracked_delete(MemoryTracker::PROJECTOR, this->planegrid_real, this->planegrid_size);
+    tracked_delete(MemoryTracker::PROJECTOR, this->planegrid_box, this->planegrid_size);
 }
 
 /**
  * @brief      reposition plane within the boundaries of the unit cell
  */
 void PlaneProjector::cut_and_recast_plane() {
+    ScopedTimer timer("recast");
+    timer.set_items(this->ix * this->iy, "pixels");
+
     unsigned int min_x = 0;
     unsigned int max_x = this->ix;
     unsigned int min_y = 0;
@@ -425,10 +723,14 @@ void PlaneProjector::cut_and_recast_plane() {
     for(unsigned int i=0; i<uint(this->ix); i++) {
         bool line = false;
 
-        #pragma omp parallel for
-        for(unsigned int j=0; j<uint(this->iy); j++) {
-            if(this->planegrid_real[(j) * this->ix + i] != 0.0) {
-                line = true;
+        #pragma omp parallel
+        {
+            EDP_TRACE_SCOPE("recast scan");
+            #pragma omp for nowait
+            for(unsigned int j=0; j<uint(this->iy); j++) {
+                if(this->planegrid_real[(j) * this->ix + i] != 0.0) {
+                    line = true;
+                }
             }
         }
         if(line) {
@@ -441,10 +743,14 @@ void PlaneProjector::cut_and_recast_plane() {
     for(unsigned int i=uint(this->ix); i>0; i--) {
         bool line = false;
 
-        #pragma omp parallel for
-        for(unsigned int j=0; j<uint(this->iy); j++) {
-            if(this->planegrid_real[(j) * this->ix + i] != 0.0) {
-                line = true;
+        #pragma omp parallel
+        {
+            EDP_TRACE_SCOPE("recast scan");
+            #pragma omp for nowait
+            for(unsigned int j=0; j<uint(this->iy); j++) {
+                if(this->planegrid_real[(j) * this->ix + i] != 0.0) {
+                    line = true;
+                }
             }
         }
         if(line) {
@@ -457,10 +763,14 @@ void PlaneProjector::cut_and_recast_plane() {
     for(unsigned int j=0; j<uint(this->iy); j++) {
         bool line = false;
 
-        #pragma omp parallel for
-        for(unsigned int i=0; i<uint(this->ix); i++) {
-            if(this->planegrid_real[(j) * this->ix + i] != 0.0) {
-                line = true;
+        #pragma omp parallel
+        {
+            EDP_TRACE_SCOPE("recast scan");
+            #pragma omp for nowait
+            for(unsigned int i=0; i<uint(this->ix); i++) {
+                if(this->planegrid_real[(j) * this->ix + i] != 0.0) {
+                    line = true;
+                }
             }
         }
         if(line) {
@@ -473,10 +783,14 @@ void PlaneProjector::cut_and_recast_plane() {
     for(unsigned int j=uint(this->iy-1); j>0; j--) {
         bool line = false;
 
-        #pragma omp parallel for
-        for(unsigned int i=0; i<uint(this->ix); i++) {
-            if(this->planegrid_real[(j) * this->ix + i] != 0.0) {
-                line = true;
+        #pragma omp parallel
+        {
+            EDP_TRACE_SCOPE("recast scan");
+            #pragma omp for nowait
+            for(unsigned int i=0; i<uint(this->ix); i++) {
+                if(this->planegrid_real[(j) * this->ix + i] != 0.0) {
+                    line = true;
+                }
             }
         }
         if(line) {
@@ -492,29 +806,36 @@ void PlaneProjector::cut_and_recast_plane() {
               << "] x [" << min_y << ":" << max_y << "]" << std::endl;
 
     // recasting
-    float* newgrid_log = new float[nx * ny];
-    float* newgrid_real = new float[nx * ny];
-    bool* newgrid_box = new bool[nx * ny];
-
-    #pragma omp parallel for collapse(2)
-    for(unsigned int i=0; i<nx; i++) {
-        for(unsigned int j=0; j<ny; j++) {
-            newgrid_log[j * nx + i] = this->planegrid_log[(j + min_y) * this->ix + (i + min_x)];
-            newgrid_real[j * nx + i] = this->planegrid_real[(j + min_y) * this->ix + (i + min_x)];
-            newgrid_box[j * nx + i] = this->planegrid_box[(j + min_y) * this->ix + (i + min_x)];
+    float* newgrid_log = tracked_new<float>(MemoryTracker::PROJECTOR, nx * ny);
+    float* newgrid_real = tracked_new<float>(MemoryTracker::PROJECTOR, nx * ny);
+    bool* newgrid_box = tracked_new<bool>(MemoryTracker::PROJECTOR, nx * ny);
+
+    #pragma omp parallel
+    {
+        EDP_TRACE_SCOPE("recast copy");
+        #pragma omp for collapse(2) nowait
+        for(unsigned int i=0; i<nx; i++) {
+            for(unsigned int j=0; j<ny; j++) {
+                newgrid_log[j * nx + i] = this->planegrid_log[(j + min_y) * this->ix + (i + min_x)];
+                newgrid_real[j * nx + i] = this->planegrid_real[(j + min_y) * this->ix + (i + min_x)];
+                newgrid_box[j * nx + i] = this->planegrid_box[(j + min_y) * this->ix + (i + min_x)];
+            }
         }
     }
 
-    delete[] this->planegrid_real;
-    delete[] this->planegrid_log;
-    delete[] this->planegrid_box;
+    tracked_delete(MemoryTracker::PROJECTOR, this->planegrid_real, this->planegrid_size);
+    tracked_delete(MemoryTracker::PROJECTOR, this->planegrid_log, this->planegrid_size);
+    tracked_delete(MemoryTracker::PROJECTOR, this->planegrid_box, this->planegrid_size);
 
     this->planegrid_real = newgrid_real;
     this->planegrid_log = newgrid_log;
     this->planegrid_box = newgrid_box;
 
+    this->planegrid_size = nx * ny;
     this->ix = nx;
     this->iy = ny;
+    this->plane_i0 -= min_x;
+    this->plane_j0 -= min_y;
 }
 
 /**
@@ -565,7 +886,27 @@ bool PlaneProjector::is_crossing(unsigned int i, unsigned int j, float val) {
  * @return     The scaled value.
  */
 float PlaneProjector::calculate_scaled_value_log(float input) {
-    const float scale = (this->log_max - this->log_min + 1.0f);
-    const float logval = std::min(std::max(log10(std::fabs(input)), this->log_min), this->log_max);
-    return sgn(input) * (logval - this->log_min) / scale;
+    return scale_value_log(input, this->flag_negative, this->log_min, this->log_max);
+}
+
+/**
+ * @brief      map a value onto the logarithmic color scale of the plots;
+ *             without negative values, non-positive values are sent below
+ *             the scale
+ *
+ * @param[in]  input           input value
+ * @param[in]  allow_negative  whether to allow negative values
+ * @param[in]  _min            lower bound (power of ten)
+ * @param[in]  _max            upper bound (power of ten)
+ *
+ * @return     scaled value
+ */
+float PlaneProjector::scale_value_log(float input, bool allow_negative, float _min, float _max) {
+    if(!allow_negative && input <= 0) {
+        return -12;
+    }
+
+    const float scale = (_max - _min + 1.0f);
+    const float logval = std::min(std::max(log10(std::fabs(input)), _min), _max);
+    return sgn(input) * (logval - _min) / scale;
 }
@@ -27,6 +27,7 @@
 #include "plotter.h"
 #include "scalar_field.h"
 #include "quadrature.h"
+#include "bader_partitioning.h"
 
 class PlaneProjector {
 private:
@@ -37,10 +38,14 @@ private:
     float* planegrid_log;
     float* planegrid_real;
     bool* planegrid_box;
+    size_t planegrid_size;              //!< number of elements allocated per plane grid
     float log_min, log_max;
 
     int ix, iy;
     float scale;
+
+    glm::vec3 plane_v1, plane_v2, plane_p;  //!< (normalized) vectors spanning the plane and position
+    int plane_i0, plane_j0;                 //!< pixel at the position of the plane
     unsigned int color_scheme_id;
 
     bool flag_negative;
@@ -66,6 +71,20 @@ public:
      */
     void set_scaling(bool allow_negative, float _min, float _max);
 
+    /**
+     * @brief      map a value onto the logarithmic color scale of the plots;
+     *             without negative values, non-positive values are sent
+     *             below the scale
+     *
+     * @param[in]  input           input value
+     * @param[in]  allow_negative  whether to allow negative values
+     * @param[in]  _min            lower bound (power of ten)
+     * @param[in]  _max            upper bound (power of ten)
+     *
+     * @return     scaled value
+     */
+    static float scale_value_log(float input, bool allow_negative, float _min, float _max);
+
     /**
      * @brief      plot contour plane
      */
@@ -98,18 +117,76 @@ public:
     void extract_line(glm::vec3 e, const glm::vec3& p, float _scale, float li, float hi);
 
     /**
-     * @brief      calculate the average density (electron or potential) and store it as function of z-height
+     * @brief      calculate the average density (electron or potential) and store
+     *             it as function of the position along each of the lattice vectors
      */
     void extract_plane_average();
 
+    /**
+     * @brief      calculate the average density (electron or potential) as
+     *             function of z-height
+     *
+     * @return     average value for each layer along the z-axis
+     */
+    std::vector<float> calculate_plane_average() const;
+
+    /**
+     * @brief      calculate the average density (electron or potential) over the
+     *             planes spanned by two lattice vectors as function of the position
+     *             along the third lattice vector, for all three lattice vectors
+     *
+     * @return     average value for each layer along x, y and z
+     */
+    std::vector<std::vector<float> > calculate_plane_averages() const;
+
+    /**
+     * @brief      calculate the average density (electron or potential) over the
+     *             planes normal to a direction and store it as function of the
+     *             position along that direction
+     *
+     * @param[in]  direction  normal of the planes
+     * @param[in]  binsize    distance between the planes in angstrom
+     */
+    void extract_directional_average(const glm::vec3& direction, float binsize);
+
+    /**
+     * @brief      calculate the average density (electron or potential) over the
+     *             planes normal to a direction as function of the position along
+     *             that direction
+     *
+     * @param[in]  direction  normal of the planes
+     * @param[in]  binsize    distance between the planes in angstrom
+     * @param[out] positions  position of each (non-empty) bin along the direction
+     * @param[out] avg        average value in each (non-empty) bin
+     */
+    void calculate_directional_average(const glm::vec3& direction, float binsize,
+                                       std::vector<float>& positions,
+                                       std::vector<float>& avg) const;
+
     /**
      * @brief      calculate the average density projected on a sphere of a
      *             specified radius
      *
      * @param[in]  p       position of the sphere
      * @param[in]  radius  radius of the sphere
+     * @param[in]  step    distance between subsequent radii
+     * @param[in]  order   Lebedev order of the angular grid
+     */
+    void extract_sphere_average(const glm::vec3& p, float radius, float step = 0.01f,
+                                unsigned int order = Quadrature::LEBEDEV_194);
+
+    /**
+     * @brief      calculate the average density projected on spheres of
+     *             specified radii
+     *
+     * @param[in]  p      position of the sphere
+     * @param[in]  radii  radii of the spheres
+     * @param[in]  order  Lebedev order of the angular grid
+     *
+     * @return     average value for each radius
      */
-    void extract_sphere_average(const glm::vec3& p, float radius);
+    std::vector<float> calculate_sphere_average(const glm::vec3& p, const std::vector<float>& radii,
+                                                unsigned int order = Quadrature::LEBEDEV_194) const;
 
     /**
      * @brief      draw isolines
@@ -119,6 +196,13 @@ public:
      */
     void isolines(unsigned int bins);
 
+    /**
+     * @brief      draw the boundaries between the Bader basins on the plane
+     *
+     * @param[in]  bader  Bader partitioning of the scalar field
+     */
+    void draw_partition_boundaries(const BaderPartitioning& bader);
+
     /**
      * @brief      Draws a legend.
      *
@@ -133,6 +217,33 @@ public:
      */
     void write(std::string filename);
 
+    /**
+     * @brief      get width of the (recast) contour plane
+     *
+     * @return     width in pixels
+     */
+    inline int get_width() const {
+        return this->ix;
+    }
+
+    /**
+     * @brief      get height of the (recast) contour plane
+     *
+     * @return     height in pixels
+     */
+    inline int get_height() const {
+        return this->iy;
+    }
+
+    /**
+     * @brief      get pointer to the real values on the contour plane
+     *
+     * @return     pointer to ix * iy floats (row-major)
+     */
+    inline const float* get_planegrid_real() const {
+        return this->planegrid_real;
+    }
+
     /**
      * @brief      Destroys the object.
      */
@@ -28,10 +28,28 @@ Plotter::Plotter(unsigned int _width, unsigned int _height) {
 
     this->surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, this->width, this->height);
     this->cr = cairo_create (this->surface);
+    MemoryTracker::get().allocate(MemoryTracker::PLOTTER, this->get_surface_size());
 
     this->set_background(Color(255, 255, 255, 0));
 }
 
+/*
+ * Releases the cairo context and surface
+ */
+Plotter::~Plotter() {
+    cairo_destroy(this->cr);
+    cairo_surface_destroy(this->surface);
+    MemoryTracker::get().release(MemoryTracker::PLOTTER, this->get_surface_size());
+    delete this->scheme;
+}
+
+/*
+ * Size of the pixel buffer of the image surface in bytes
+ */
+size_t Plotter::get_surface_size() const {
+    return (size_t)cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, this->width) * this->height;
+}
+
 /*
  * Sets the background color of the image
  */
@@ -28,6 +28,8 @@
 #include <cstdlib>
 #include <math.h>
 
+#include "memory_tracker.h"
+
 class Color {
 private:
     unsigned int r,g,b,a;
@@ -66,6 +68,7 @@ private:
 
 public:
   Plotter(const unsigned int _width, const unsigned int _height);
+  ~Plotter();
   void set_background(const Color &_color);
   void write(const char* filename);
   void draw_filled_rectangle(float xstart, float ystart, float xstop, float ystop,
@@ -88,7 +91,7 @@ public:
   }
 
 private:
-
+  size_t get_surface_size() const;
 };
 
 #endif //_PLOTTER_H
@@ -0,0 +1,187 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "potential_profile.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+/**
+ * @brief      constructor
+ *
+ * @param[in]  _values  planar-averaged potential (one value per plane)
+ * @param[in]  length   length of the cell along the slab normal in angstrom
+ */
+PotentialProfile::PotentialProfile(const std::vector<float>& _values, float length) :
+    values(_values) {
+
+    if(this->values.size() < 3) {
+        throw std::runtime_error("A potential profile requires at least three planes.");
+    }
+
+    this->spacing = length / (float)this->values.size();
+
+    this->cumulative.resize(this->values.size() + 1, 0.0);
+    for(unsigned int i=0; i<this->values.size(); i++) {
+        this->cumulative[i+1] = this->cumulative[i] + this->values[i];
+    }
+}
+
+/**
+ * @brief      macroscopic average of the planar average, i.e. the average
+ *             over a window of one period centered at each plane
+ *
+ * Using the prefix sums, the average over the window is obtained from two
+ * lookups per plane irrespective of the width of the window. The window
+ * does not need to span an integer number of planes; the planes at the
+ * edges of the window contribute with their overlapping fraction.
+ *
+ * @param[in]  period  width of the window in angstrom
+ *
+ * @return     macroscopically averaged profile
+ */
+std::vector<float> PotentialProfile::macroscopic_average(float period) const {
+    const double w = period / this->spacing;   // window width in planes
+    if(w <= 1.0) {
+        return this->values;
+    }
+
+    std::vector<float> avg(this->values.size());
+    for(unsigned int i=0; i<this->values.size(); i++) {
+        // plane i covers [i, i+1), hence its center lies at i + 0.5
+        const double center = (double)i + 0.5;
+        avg[i] = (this->integral(center + 0.5 * w) - this->integral(center - 0.5 * w)) / w;
+    }
+
+    return avg;
+}
+
+/**
+ * @brief      find the vacuum plateau(s) in the planar average
+ *
+ * A plane belongs to a plateau when the gradient of both the planar and
+ * the macroscopic average is below the tolerance. The macroscopic average
+ * suppresses residual ripples in the vacuum, whereas the planar average
+ * oscillates strongly around the atomic layers such that flat regions of
+ * the macroscopic average inside the slab are excluded. No assumption is
+ * made on the absolute level of a plateau, hence both vacuum regions are
+ * found irrespective of the size of the dipole step. Runs of flat planes
+ * shorter than the minimum width are discarded and the two widest
+ * remaining runs (taking periodicity into account) are retained.
+ *
+ * @param[in]  min_width  minimum width of a plateau in angstrom
+ * @param[in]  tolerance  maximum absolute gradient in a plateau (V/angstrom)
+ * @param[in]  period     window of the macroscopic average in angstrom
+ *
+ * @return     vacuum level(s)
+ */
+VacuumLevel PotentialProfile::find_vacuum_level(float min_width, float tolerance, float period) const {
+    const unsigned int n = this->values.size();
+    const std::vector<float> macro = this->macroscopic_average(period);
+
+    // central difference of a periodic profile at plane i
+    auto gradient = [&](const std::vector<float>& v, unsigned int i) {
+        return (v[(i + 1) % n] - v[(i + n - 1) % n]) / (2.0f * this->spacing);
+    };
+
+    std::vector<bool> flat(n);
+    for(unsigned int i=0; i<n; i++) {
+        flat[i] = std::fabs(gradient(this->values, i)) < tolerance &&
+                  std::fabs(gradient(macro, i)) < tolerance;
+    }
+
+    VacuumLevel vacuum;
+
+    // a profile that is flat everywhere contains no slab
+    const unsigned int nr_flat = std::count(flat.begin(), flat.end(), true);
+    if(nr_flat == n || nr_flat == 0) {
+        return vacuum;
+    }
+
+    // start at a plane that is not flat such that runs do not wrap around
+    unsigned int start = 0;
+    while(flat[start]) {
+        start++;
+    }
+
+    // collect the runs of flat planes as (length, sum of potential)
+    std::vector<std::pair<unsigned int, double> > runs;
+    unsigned int length = 0;
+    double sum = 0.0;
+    for(unsigned int j=1; j<=n; j++) {
+        const unsigned int i = (start + j) % n;
+        if(flat[i]) {
+            length++;
+            sum += this->values[i];
+        } else if(length > 0) {
+            if(length * this->spacing >= min_width) {
+                runs.emplace_back(length, sum);
+            }
+            length = 0;
+            sum = 0.0;
+        }
+    }
+
+    if(runs.empty()) {
+        return vacuum;
+    }
+
+    // retain the two widest plateaus
+    std::sort(runs.begin(), runs.end(), [](const std::pair<unsigned int, double>& a,
+                                           const std::pair<unsigned int, double>& b) {
+        return a.first > b.first;
+    });
+
+    vacuum.found = true;
+    vacuum.nr_plateaus = std::min((size_t)2, runs.size());
+    float levels[2];
+    for(unsigned int i=0; i<vacuum.nr_plateaus; i++) {
+        levels[i] = runs[i].second / (double)runs[i].first;
+        vacuum.width += runs[i].first * this->spacing;
+    }
+    if(vacuum.nr_plateaus == 1) {
+        levels[1] = levels[0];
+    }
+
+    vacuum.level_low = std::min(levels[0], levels[1]);
+    vacuum.level_high = std::max(levels[0], levels[1]);
+    vacuum.dipole_step = vacuum.level_high - vacuum.level_low;
+
+    return vacuum;
+}
+
+/**
+ * @brief      integral of the piecewise constant planar average from the
+ *             start of the cell up to position u (in units of planes),
+ *             periodically continued beyond the cell
+ *
+ * @param[in]  u     position
+ *
+ * @return     integral in units of potential times planes
+ */
+double PotentialProfile::integral(double u) const {
+    const int n = this->values.size();
+    const double fl = std::floor(u);
+    const int cell = (int)std::floor(fl / (double)n);
+    const int i = (int)fl - cell * n;
+
+    return cell * this->cumulative[n] + this->cumulative[i] + (u - fl) * this->values[i];
+}
@@ -0,0 +1,121 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _POTENTIAL_PROFILE_H
+#define _POTENTIAL_PROFILE_H
+
+#include <vector>
+#include <cmath>
+
+/**
+ * @brief      vacuum level(s) of a slab as found from its potential profile
+ */
+struct VacuumLevel {
+    bool found;             //!< whether a vacuum plateau was found
+    unsigned int nr_plateaus;   //!< number of plateaus (two when a dipole correction is applied)
+    float level_low;        //!< potential of the lower plateau
+    float level_high;       //!< potential of the higher plateau (equal to level_low for one plateau)
+    float dipole_step;      //!< difference between both plateaus
+    float width;            //!< width of the (combined) plateau(s) in angstrom
+
+    VacuumLevel() :
+        found(false),
+        nr_plateaus(0),
+        level_low(0.0f),
+        level_high(0.0f),
+        dipole_step(0.0f),
+        width(0.0f) {}
+};
+
+/**
+ * @brief      analysis of a (periodic) planar-averaged potential along the
+ *             normal of a slab: macroscopic averaging and detection of the
+ *             vacuum level
+ */
+class PotentialProfile {
+private:
+    std::vector<float> values;      //!< planar average
+    std::vector<double> cumulative; //!< prefix sums of the planar average
+    float spacing;                  //!< distance between the planes in angstrom
+
+public:
+    /**
+     * @brief      constructor
+     *
+     * @param[in]  _values  planar-averaged potential (one value per plane)
+     * @param[in]  length   length of the cell along the slab normal in angstrom
+     */
+    PotentialProfile(const std::vector<float>& _values, float length);
+
+    /**
+     * @brief      get the planar average
+     *
+     * @return     planar average
+     */
+    inline const std::vector<float>& get_values() const {
+        return this->values;
+    }
+
+    /**
+     * @brief      get the distance between two subsequent planes
+     *
+     * @return     spacing in angstrom
+     */
+    inline float get_spacing() const {
+        return this->spacing;
+    }
+
+    /**
+     * @brief      macroscopic average of the planar average, i.e. the average
+     *             over a window of one period centered at each plane
+     *
+     * @param[in]  period  width of the window in angstrom (typically the
+     *                     interlayer distance of the slab)
+     *
+     * @return     macroscopically averaged profile
+     */
+    std::vector<float> macroscopic_average(float period) const;
+
+    /**
+     * @brief      find the vacuum plateau(s) in the planar average
+     *
+     * @param[in]  min_width  minimum width of a plateau in angstrom
+     * @param[in]  tolerance  maximum absolute gradient in a plateau (V/angstrom)
+     * @param[in]  period     window of the macroscopic average in angstrom
+     *                        (no averaging when smaller than one plane)
+     *
+     * @return     vacuum level(s)
+     */
+    VacuumLevel find_vacuum_level(float min_width, float tolerance, float period = 0.0f) const;
+
+private:
+    /**
+     * @brief      integral of the piecewise constant planar average from the
+     *             start of the cell up to position u (in units of planes),
+     *             periodically continued beyond the cell
+     *
+     * @param[in]  u     position
+     *
+     * @return     integral in units of potential times planes
+     */
+    double integral(double u) const;
+};
+
+#endif //_POTENTIAL_PROFILE_H
@@ -0,0 +1,228 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "profiler.h"
+#include "tracer.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <boost/format.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+/**
+ * @brief      escape a string for use in a JSON document
+ *
+ * @param[in]  input  input string
+ *
+ * @return     escaped string including quotes
+ */
+std::string json_string(const std::string& input) {
+    std::string out = "\"";
+    for(const char c : input) {
+        switch(c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n";  break;
+            case '\t': out += "\\t";  break;
+            default:
+                if((unsigned char)c < 0x20) {
+                    out += (boost::format("\\u%04x") % (int)c).str();
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out + "\"";
+}
+
+} // namespace
+
+Profiler::Phase::Phase() :
+    calls(0),
+    seconds(0.0),
+    bytes(0),
+    items(0),
+    threads(1) {}
+
+Profiler::Profiler() :
+    enabled(false),
+    start(std::chrono::steady_clock::now()) {}
+
+/**
+ * @brief      enable or disable the profiler
+ *
+ * @param[in]  _enabled  whether to collect timings
+ */
+void Profiler::set_enabled(bool _enabled) {
+    std::lock_guard<std::mutex> lock(this->mtx);
+    this->enabled = _enabled;
+    this->start = std::chrono::steady_clock::now();
+}
+
+/**
+ * @brief      store a key-value pair in the report (e.g. version or input file)
+ *
+ * @param[in]  key    key
+ * @param[in]  value  value
+ */
+void Profiler::set_metadata(const std::string& key, const std::string& value) {
+    std::lock_guard<std::mutex> lock(this->mtx);
+    for(auto& item : this->metadata) {
+        if(item.first == key) {
+            item.second = value;
+            return;
+        }
+    }
+    this->metadata.emplace_back(key, value);
+}
+
+/**
+ * @brief      add a measurement to a phase
+ *
+ * @param[in]  name     name of the phase
+ * @param[in]  seconds  wall-clock time
+ * @param[in]  bytes    number of bytes processed
+ * @param[in]  items    number of items processed
+ * @param[in]  unit     unit of the items
+ * @param[in]  threads  number of threads available to the phase
+ */
+void Profiler::record(const std::string& name, double seconds, size_t bytes, size_t items,
+                      const std::string& unit, unsigned int threads) {
+    std::lock_guard<std::mutex> lock(this->mtx);
+    if(!this->enabled) {
+        return;
+    }
+
+    auto got = this->phase_ids.find(name);
+    if(got == this->phase_ids.end()) {
+        got = this->phase_ids.emplace(name, this->phases.size()).first;
+        this->phases.emplace_back();
+        this->phases.back().name = name;
+    }
+
+    Phase& phase = this->phases[got->second];
+    phase.calls++;
+    phase.seconds += seconds;
+    phase.bytes += bytes;
+    phase.items += items;
+    phase.threads = std::max(phase.threads, threads);
+    if(!unit.empty()) {
+        phase.unit = unit;
+    }
+}
+
+/**
+ * @brief      write the report as JSON
+ *
+ * @param[in]  filename  path to output file
+ */
+void Profiler::write_json(const std::string& filename) const {
+    std::lock_guard<std::mutex> lock(this->mtx);
+
+    std::ofstream out(filename);
+    if(!out.is_open()) {
+        throw std::runtime_error("Cannot open " + filename + " for writing the profile.");
+    }
+
+    const double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->start).count();
+#ifdef _OPENMP
+    const unsigned int max_threads = omp_get_max_threads();
+#else
+    const unsigned int max_threads = 1;
+#endif
+
+    out << "{" << std::endl;
+    for(const auto& item : this->metadata) {
+        out << "  " << json_string(item.first) << ": " << json_string(item.second) << "," << std::endl;
+    }
+    out << boost::format("  \"max_threads\": %i,\n") % max_threads;
+    out << boost::format("  \"total_seconds\": %.6f,\n") % total;
+    out << "  \"phases\": [" << std::endl;
+    for(unsigned int i=0; i<this->phases.size(); i++) {
+        const Phase& phase = this->phases[i];
+        const double mbs = phase.seconds > 0 ? phase.bytes / 1e6 / phase.seconds : 0.0;
+        const double mitems = phase.seconds > 0 ? phase.items / 1e6 / phase.seconds : 0.0;
+
+        out << "    {\"name\": " << json_string(phase.name)
+            << boost::format(", \"calls\": %i, \"seconds\": %.6f, \"threads\": %i")
+               % phase.calls % phase.seconds % phase.threads
+            << boost::format(", \"bytes\": %i, \"mb_per_s\": %.3f") % phase.bytes % mbs
+            << ", \"items\": " << phase.items
+            << ", \"unit\": " << json_string(phase.unit)
+            << boost::format(", \"mitems_per_s\": %.3f}") % mitems
+            << (i + 1 < this->phases.size() ? "," : "") << std::endl;
+    }
+    out << "  ]" << std::endl;
+    out << "}" << std::endl;
+
+    out.close();
+}
+
+/**
+ * @brief      start timing a phase
+ *
+ * @param[in]  _name  name of the phase (string literal)
+ */
+ScopedTimer::ScopedTimer(const char* _name) :
+    name(_name),
+    bytes(0),
+    items(0),
+    active(Profiler::get().is_enabled()),
+    tracing(Tracer::get().is_enabled()),
+    trace_begin(0.0) {
+    if(this->active) {
+        this->start = std::chrono::steady_clock::now();
+    }
+    if(this->tracing) {
+        this->trace_begin = Tracer::get().now();
+    }
+}
+
+/**
+ * @brief      stop timing and report to the profiler before the end of the scope
+ */
+void ScopedTimer::stop() {
+    if(this->tracing) {
+        Tracer::get().record(this->name, this->trace_begin, Tracer::get().now());
+        this->tracing = false;
+    }
+
+    if(!this->active) {
+        return;
+    }
+    this->active = false;
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->start).count();
+#ifdef _OPENMP
+    const unsigned int threads = omp_get_max_threads();
+#else
+    const unsigned int threads = 1;
+#endif
+    Profiler::get().record(this->name, seconds, this->bytes, this->items, this->unit, threads);
+}
+
+ScopedTimer::~ScopedTimer() {
+    this->stop();
+}
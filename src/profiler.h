@@ -0,0 +1,161 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _PROFILER_H
+#define _PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/**
+ * @brief      collects timings and throughput of the phases of a run
+ *
+ * Timings are only collected when the profiler is enabled, such that the
+ * ScopedTimer objects spread over the modules are (nearly) free otherwise.
+ */
+class Profiler {
+private:
+    class Phase {
+    public:
+        std::string name;
+        std::string unit;           //!< unit of the processed items (e.g. pixels)
+        unsigned int calls;
+        double seconds;
+        size_t bytes;
+        size_t items;
+        unsigned int threads;
+
+        Phase();
+    };
+
+    std::atomic<bool> enabled;
+    std::chrono::steady_clock::time_point start;
+    std::vector<Phase> phases;                              //!< phases in order of first appearance
+    std::unordered_map<std::string, unsigned int> phase_ids;
+    std::vector<std::pair<std::string, std::string>> metadata;
+    mutable std::mutex mtx;
+
+public:
+    static Profiler& get() {
+        static Profiler profiler_instance;
+        return profiler_instance;
+    }
+
+    /**
+     * @brief      enable or disable the profiler
+     *
+     * @param[in]  _enabled  whether to collect timings
+     */
+    void set_enabled(bool _enabled);
+
+    inline bool is_enabled() const {
+        return this->enabled;
+    }
+
+    /**
+     * @brief      store a key-value pair in the report (e.g. version or input file)
+     *
+     * @param[in]  key    key
+     * @param[in]  value  value
+     */
+    void set_metadata(const std::string& key, const std::string& value);
+
+    /**
+     * @brief      add a measurement to a phase
+     *
+     * @param[in]  name     name of the phase
+     * @param[in]  seconds  wall-clock time
+     * @param[in]  bytes    number of bytes processed
+     * @param[in]  items    number of items processed
+     * @param[in]  unit     unit of the items
+     * @param[in]  threads  number of threads available to the phase
+     */
+    void record(const std::string& name, double seconds, size_t bytes, size_t items,
+                const std::string& unit, unsigned int threads);
+
+    /**
+     * @brief      write the report as JSON
+     *
+     * @param[in]  filename  path to output file
+     */
+    void write_json(const std::string& filename) const;
+
+private:
+    Profiler();
+
+    Profiler(Profiler const&)          = delete;
+    void operator=(Profiler const&)    = delete;
+};
+
+/**
+ * @brief      measures the wall-clock time of the enclosing scope and reports
+ *             it to the Profiler (and as event to the Tracer) upon destruction
+ */
+class ScopedTimer {
+private:
+    const char* name;
+    std::string unit;
+    size_t bytes;
+    size_t items;
+    bool active;
+    bool tracing;
+    double trace_begin;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    /**
+     * @brief      start timing a phase
+     *
+     * @param[in]  _name  name of the phase (string literal)
+     */
+    ScopedTimer(const char* _name);
+
+    /**
+     * @brief      set the number of bytes processed in this phase
+     */
+    inline void set_bytes(size_t _bytes) {
+        this->bytes = _bytes;
+    }
+
+    /**
+     * @brief      set the number of items (pixels, grid points, ...) processed in this phase
+     */
+    inline void set_items(size_t _items, const std::string& _unit) {
+        this->items = _items;
+        this->unit = _unit;
+    }
+
+    /**
+     * @brief      stop timing and report to the profiler before the end of the scope
+     */
+    void stop();
+
+    ~ScopedTimer();
+
+private:
+    ScopedTimer(ScopedTimer const&)    = delete;
+    void operator=(ScopedTimer const&) = delete;
+};
+
+#endif // _PROFILER_H
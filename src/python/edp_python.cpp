@@ -0,0 +1,230 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+/*
+ * Python bindings for EDP
+ *
+ * The grid of a ScalarField and the values on an extracted plane are exposed
+ * as read-only NumPy arrays that share memory with the C++ objects. These
+ * arrays keep their owner alive, but become invalid once the owner re-reads
+ * or re-extracts its data.
+ */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include "scalar_field.h"
+#include "planeprojector.h"
+#include "config.h"
+
+namespace py = pybind11;
+
+namespace {
+
+/**
+ * @brief      convert a Python sequence of three floats to a vector
+ *
+ * @param[in]  v     sequence of length 3
+ *
+ * @return     glm vector
+ */
+glm::vec3 to_vec3(const std::vector<float>& v) {
+    if(v.size() != 3) {
+        throw std::invalid_argument("Expected a vector of length 3");
+    }
+    return glm::vec3(v[0], v[1], v[2]);
+}
+
+/**
+ * @brief      wrap memory owned by a C++ object in a read-only NumPy array
+ *
+ * @param[in]  data   pointer to the data
+ * @param[in]  shape  shape of the array (C-order)
+ * @param[in]  owner  Python object owning the data
+ *
+ * @return     NumPy array sharing memory with the owner
+ */
+py::array_t<float> view(const float* data, const std::vector<ssize_t>& shape, py::handle owner) {
+    py::array_t<float> arr(shape, data, owner);
+    py::detail::array_proxy(arr.ptr())->flags &= ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+    return arr;
+}
+
+} // namespace
+
+PYBIND11_MODULE(pyedp, m) {
+    m.doc() = "Python bindings for the Electron Density Plotter";
+    m.attr("__version__") = PROGRAM_VERSION;
+
+    py::class_<ScalarField>(m, "ScalarField", py::buffer_protocol())
+        .def(py::init<const std::string&, bool>(), py::arg("filename"), py::arg("is_locpot") = false)
+        .def("read_header_and_atoms", &ScalarField::read_header_and_atoms,
+             py::call_guard<py::gil_scoped_release>())
+        .def("read", &ScalarField::read, py::call_guard<py::gil_scoped_release>(),
+             "Read header, atoms and grid")
+        .def_property_readonly("is_locpot", &ScalarField::is_locpot)
+        .def_property_readonly("filename", &ScalarField::get_filename)
+        .def_property_readonly("dimensions", [](const ScalarField& sf) {
+            unsigned int dim[3];
+            sf.copy_grid_dimensions(dim);
+            return py::make_tuple(dim[0], dim[1], dim[2]);
+        })
+        .def_property_readonly("unitcell", [](const ScalarField& sf) {
+            py::array_t<float> mat({3, 3});
+            auto r = mat.mutable_unchecked<2>();
+            for(unsigned int i=0; i<3; i++) {
+                for(unsigned int j=0; j<3; j++) {
+                    r(i, j) = sf.get_mat_unitcell()[i][j];
+                }
+            }
+            return mat;
+        }, "Unit cell matrix; row i holds lattice vector i")
+        .def_property_readonly("atom_positions", [](const ScalarField& sf) {
+            py::array_t<float> pos({(ssize_t)sf.get_nr_atoms(), (ssize_t)3});
+            auto r = pos.mutable_unchecked<2>();
+            for(unsigned int i=0; i<sf.get_nr_atoms(); i++) {
+                const glm::vec3 p = sf.get_atom_position(i);
+                for(unsigned int j=0; j<3; j++) {
+                    r(i, j) = p[j];
+                }
+            }
+            return pos;
+        }, "Cartesian atom positions")
+        .def_property_readonly("min", &ScalarField::get_min)
+        .def_property_readonly("max", &ScalarField::get_max)
+        .def_property_readonly("mean", &ScalarField::get_mean)
+        .def_property_readonly("integrated_charge", &ScalarField::get_integrated_charge)
+        .def_property_readonly("grid", [](py::object self) {
+            const ScalarField& sf = self.cast<const ScalarField&>();
+            unsigned int dim[3];
+            sf.copy_grid_dimensions(dim);
+            if(sf.get_size() != dim[0] * dim[1] * dim[2]) {
+                throw std::runtime_error("Grid has not been read");
+            }
+            if(sf.is_sparse()) {
+                // a block-sparse grid has no contiguous storage; expand a copy
+                py::array_t<float> grid({(ssize_t)dim[2], (ssize_t)dim[1], (ssize_t)dim[0]});
+                float* out = grid.mutable_data();
+                for(unsigned int k=0; k<dim[2]; k++) {
+                    for(unsigned int j=0; j<dim[1]; j++) {
+                        float* row = out + ((size_t)k * dim[1] + j) * dim[0];
+                        const float* src = sf.get_row(j, k, row);
+                        if(src != row) {
+                            std::copy(src, src + dim[0], row);
+                        }
+                    }
+                }
+                return grid;
+            }
+            return view(sf.get_grid_ptr(), {(ssize_t)dim[2], (ssize_t)dim[1], (ssize_t)dim[0]}, self);
+        }, "Grid values indexed as [z, y, x]; a view without copy, or a dense copy for a block-sparse field")
+        .def_buffer([](ScalarField& sf) -> py::buffer_info {
+            unsigned int dim[3];
+            sf.copy_grid_dimensions(dim);
+            if(sf.get_size() != dim[0] * dim[1] * dim[2]) {
+                throw std::runtime_error("Grid has not been read");
+            }
+            if(sf.is_sparse()) {
+                throw std::runtime_error("The grid of " + sf.get_filename() + " is stored block-sparse and does not "
+                                         "support the buffer protocol; use the grid property for a dense copy");
+            }
+            return py::buffer_info(const_cast<float*>(sf.get_grid_ptr()),
+                                   {(ssize_t)dim[2], (ssize_t)dim[1], (ssize_t)dim[0]},
+                                   {(ssize_t)(sizeof(float) * dim[0] * dim[1]),
+                                    (ssize_t)(sizeof(float) * dim[0]),
+                                    (ssize_t)sizeof(float)},
+                                   true);
+        })
+        .def("interpolate", [](const ScalarField& sf,
+                               py::array_t<float, py::array::c_style | py::array::forcecast> points,
+                               bool periodic) {
+            if(points.ndim() != 2 || points.shape(1) != 3) {
+                throw std::invalid_argument("Expected an array of shape (N, 3)");
+            }
+            const size_t n = points.shape(0);
+            py::array_t<float> values(n);
+            const float* in = points.data();
+            float* out = values.mutable_data();
+            {
+                py::gil_scoped_release release;
+                sf.get_values_interp(in, n, out, periodic);
+            }
+            return values;
+        }, py::arg("points"), py::arg("periodic") = true,
+           "Trilinear interpolation at an (N, 3) array of cartesian positions");
+
+    py::class_<PlaneProjector>(m, "PlaneProjector")
+        .def(py::init<ScalarField*, unsigned int>(), py::arg("field"), py::arg("color_scheme_id") = 0,
+             py::keep_alive<1, 2>())
+        .def("set_scaling", &PlaneProjector::set_scaling,
+             py::arg("allow_negative"), py::arg("min"), py::arg("max"))
+        .def("extract", [](PlaneProjector& pp, const std::vector<float>& v1, const std::vector<float>& v2,
+                           const std::vector<float>& p, float scale, float li, float hi, float lj, float hj) {
+            const glm::vec3 _v1 = to_vec3(v1);
+            const glm::vec3 _v2 = to_vec3(v2);
+            const glm::vec3 _p = to_vec3(p);
+            py::gil_scoped_release release;
+            pp.extract(_v1, _v2, _p, scale, li, hi, lj, hj);
+        }, py::arg("v1"), py::arg("v2"), py::arg("p"), py::arg("scale") = 100.0f,
+           py::arg("li") = -20.0f, py::arg("hi") = 20.0f, py::arg("lj") = -20.0f, py::arg("hj") = 20.0f)
+        .def_property_readonly("planegrid_real", [](py::object self) {
+            const PlaneProjector& pp = self.cast<const PlaneProjector&>();
+            if(pp.get_planegrid_real() == nullptr) {
+                throw std::runtime_error("No plane has been extracted");
+            }
+            return view(pp.get_planegrid_real(), {(ssize_t)pp.get_height(), (ssize_t)pp.get_width()}, self);
+        }, "Values on the extracted plane (without copy) indexed as [row, column]")
+        .def("plane_average", [](const PlaneProjector& pp) {
+            std::vector<float> avg;
+            {
+                py::gil_scoped_release release;
+                avg = pp.calculate_plane_average();
+            }
+            return py::array_t<float>(avg.size(), avg.data());
+        })
+        .def("plane_averages", [](const PlaneProjector& pp) {
+            std::vector<std::vector<float> > avg;
+            {
+                py::gil_scoped_release release;
+                avg = pp.calculate_plane_averages();
+            }
+            return py::make_tuple(py::array_t<float>(avg[0].size(), avg[0].data()),
+                                  py::array_t<float>(avg[1].size(), avg[1].data()),
+                                  py::array_t<float>(avg[2].size(), avg[2].data()));
+        }, "Planar averages along the a, b and c lattice vectors")
+        .def("directional_average", [](const PlaneProjector& pp, const std::vector<float>& direction, float binsize) {
+            const glm::vec3 d = to_vec3(direction);
+            std::vector<float> positions;
+            std::vector<float> avg;
+            {
+                py::gil_scoped_release release;
+                pp.calculate_directional_average(d, binsize, positions, avg);
+            }
+            return py::make_tuple(py::array_t<float>(positions.size(), positions.data()),
+                                  py::array_t<float>(avg.size(), avg.data()));
+        }, py::arg("direction"), py::arg("binsize") = 0.05f,
+           "Planar average along an arbitrary direction as (positions, values)")
+        .def("plot", &PlaneProjector::plot, py::call_guard<py::gil_scoped_release>())
+        .def("isolines", &PlaneProjector::isolines, py::arg("bins") = 10,
+             py::call_guard<py::gil_scoped_release>())
+        .def("draw_legend", &PlaneProjector::draw_legend)
+        .def("write", &PlaneProjector::write, py::arg("filename"));
+}
@@ -1,5 +1,5 @@
 /**************************************************************************
- *   quadrature.cpp  --  This file is part of DFTCXX.                     *
+ *   quadrature.h  --  This file is part of DFTCXX.                       *
  *                                                                        *
  *   Copyright (C) 2016, Ivo Filot                                        *
  *                                                                        *
@@ -19,7 +19,182 @@
  *                                                                        *
  **************************************************************************/
 
+
 #include "quadrature.h"
 
-constexpr unsigned int Quadrature::num_lebedev_points[11];
-constexpr double Quadrature::lebedev_coefficients[][4];
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+constexpr unsigned int Quadrature::num_lebedev_points[];
+constexpr unsigned int Quadrature::lebedev_degree[];
+constexpr unsigned int Quadrature::num_lebedev_generators[];
+constexpr LebedevGenerator Quadrature::lebedev_generators[];
+
+namespace {
+
+/**
+ * @brief      square root that can be evaluated at compile time (Newton)
+ *
+ * @param[in]  x     non-negative value
+ *
+ * @return     square root of x
+ */
+constexpr double ct_sqrt(double x) {
+    if(x <= 0.0) {
+        return 0.0;
+    }
+
+    double r = x > 1.0 ? x : 1.0;
+    for(unsigned int i=0; i<100; i++) {
+        const double next = 0.5 * (r + x / r);
+        if(next >= r) {
+            break;
+        }
+        r = next;
+    }
+    return r;
+}
+
+/**
+ * @brief      add a point and its images under sign changes of its non-zero
+ *             components
+ *
+ * @param      table  table to write to
+ * @param[in]  idx    index of the first point to write
+ * @param[in]  x      x coordinate
+ * @param[in]  y      y coordinate
+ * @param[in]  z      z coordinate
+ * @param[in]  w      weight
+ *
+ * @return     index after the last point written
+ */
+constexpr unsigned int add_signs(LebedevTable& table, unsigned int idx,
+                                 double x, double y, double z, double w) {
+    for(unsigned int s=0; s<8; s++) {
+        if(((s & 1) && x == 0.0) || ((s & 2) && y == 0.0) || ((s & 4) && z == 0.0)) {
+            continue;
+        }
+
+        table.points[idx].x = (s & 1) ? -x : x;
+        table.points[idx].y = (s & 2) ? -y : y;
+        table.points[idx].z = (s & 4) ? -z : z;
+        table.points[idx].w = w;
+        idx++;
+    }
+
+    return idx;
+}
+
+/**
+ * @brief      add the cyclic permutations of (p,q,r) and their sign changes
+ */
+constexpr unsigned int add_cyclic(LebedevTable& table, unsigned int idx,
+                                  double p, double q, double r, double w) {
+    idx = add_signs(table, idx, p, q, r, w);
+    idx = add_signs(table, idx, r, p, q, w);
+    idx = add_signs(table, idx, q, r, p, w);
+    return idx;
+}
+
+/**
+ * @brief      add all permutations of (p,q,r) and their sign changes
+ */
+constexpr unsigned int add_permutations(LebedevTable& table, unsigned int idx,
+                                        double p, double q, double r, double w) {
+    idx = add_cyclic(table, idx, p, q, r, w);
+    idx = add_cyclic(table, idx, q, p, r, w);
+    return idx;
+}
+
+/**
+ * @brief      expand the generators of all Lebedev orders
+ *
+ * @return     table with the points of all orders
+ */
+constexpr LebedevTable build_lebedev_table() {
+    LebedevTable table{};
+
+    unsigned int idx = 0;
+    for(unsigned int i=0; i<Quadrature::num_lebedev_generators_total; i++) {
+        const LebedevGenerator& g = Quadrature::lebedev_generators[i];
+        switch(g.type) {
+            case 1:     // (1,0,0)
+                idx = add_cyclic(table, idx, 1.0, 0.0, 0.0, g.v);
+            break;
+            case 2:     // (0,a,a)
+                idx = add_cyclic(table, idx, 0.0, ct_sqrt(0.5), ct_sqrt(0.5), g.v);
+            break;
+            case 3:     // (a,a,a)
+                idx = add_signs(table, idx, ct_sqrt(1.0 / 3.0), ct_sqrt(1.0 / 3.0), ct_sqrt(1.0 / 3.0), g.v);
+            break;
+            case 4:     // (a,a,b)
+                idx = add_cyclic(table, idx, g.a, g.a, ct_sqrt(1.0 - 2.0 * g.a * g.a), g.v);
+            break;
+            case 5:     // (a,b,0)
+                idx = add_permutations(table, idx, g.a, ct_sqrt(1.0 - g.a * g.a), 0.0, g.v);
+            break;
+            case 6:     // (a,b,c)
+                idx = add_permutations(table, idx, g.a, g.b, ct_sqrt(1.0 - g.a * g.a - g.b * g.b), g.v);
+            break;
+        }
+    }
+
+    return table;
+}
+
+} // namespace
+
+constexpr LebedevTable Quadrature::lebedev_table = build_lebedev_table();
+
+/**
+ * @brief      get the points and weights of a Lebedev grid
+ *
+ * @param[in]  order  Lebedev order (LEBEDEV_6, ..., LEBEDEV_5810)
+ *
+ * @return     points of the grid
+ */
+LebedevSpan Quadrature::get_lebedev(unsigned int order) {
+    if(order >= NUM_LEBEDEV_POINTS) {
+        throw std::runtime_error("Invalid Lebedev order requested.");
+    }
+
+    return LebedevSpan(&lebedev_table.points[get_lebedev_offset(order)], num_lebedev_points[order]);
+}
+
+/**
+ * @brief      get the Lebedev order from its number of points
+ *
+ * @param[in]  npoints  number of points (6, 14, ..., 5810)
+ *
+ * @return     Lebedev order
+ */
+unsigned int Quadrature::get_lebedev_order(unsigned int npoints) {
+    for(unsigned int i=0; i<NUM_LEBEDEV_POINTS; i++) {
+        if(num_lebedev_points[i] == npoints) {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("There is no Lebedev grid with " + std::to_string(npoints) + " points.");
+}
+
+/**
+ * @brief      get the nodes and weights of an n-point Gauss-Chebyshev
+ *             rule (second kind) for unweighted integrals over [-1,1]
+ *
+ * @param[in]  n     number of nodes
+ * @param[out] x     nodes
+ * @param[out] w     weights
+ */
+void Quadrature::get_gauss_chebyshev(unsigned int n, std::vector<double>& x, std::vector<double>& w) {
+    x.resize(n);
+    w.resize(n);
+    for(unsigned int i=0; i<n; i++) {
+        const double theta = (double)(i + 1) * M_PI / (double)(n + 1);
+        const double st = std::sin(theta);
+        const double ct = std::cos(theta);
+        x[i] = 1.0 + 2.0 / M_PI * ((1.0 + 2.0 / 3.0 * st * st) * ct * st - theta);
+        w[i] = 16.0 / (3.0 * (double)(n + 1)) * st * st * st * st;
+    }
+}
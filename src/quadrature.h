@@ -19,10 +19,73 @@
  *                                                                        *
  **************************************************************************/
 
+
 #ifndef _QUADRATURE_H
 #define _QUADRATURE_H
 
 #include <iostream>
+#include <vector>
+
+/**
+ * @brief      point of an angular quadrature: unit direction and weight
+ */
+struct LebedevPoint {
+    double x;
+    double y;
+    double z;
+    double w;   //!< weight; the weights of a grid sum to unity
+};
+
+/**
+ * @brief      orbit of symmetry-equivalent Lebedev points
+ *
+ * The type determines the set of points that is generated under the
+ * octahedral group (Lebedev & Laikov notation):
+ *   1: (1,0,0)                    6 points
+ *   2: (0,a,a), a=1/sqrt(2)      12 points
+ *   3: (a,a,a), a=1/sqrt(3)       8 points
+ *   4: (a,a,b), b=sqrt(1-2a^2)   24 points
+ *   5: (a,b,0), b=sqrt(1-a^2)    24 points
+ *   6: (a,b,c), c=sqrt(1-a^2-b^2) 48 points
+ */
+struct LebedevGenerator {
+    unsigned int type;
+    double a;
+    double b;
+    double v;   //!< weight of each point in the orbit
+};
+
+/**
+ * @brief      read-only view on the points of a single Lebedev grid
+ */
+class LebedevSpan {
+private:
+    const LebedevPoint* ptr;
+    unsigned int n;
+
+public:
+    constexpr LebedevSpan(const LebedevPoint* _ptr, unsigned int _n) :
+        ptr(_ptr),
+        n(_n) {}
+
+    constexpr unsigned int size() const {
+        return this->n;
+    }
+
+    constexpr const LebedevPoint& operator[](unsigned int i) const {
+        return this->ptr[i];
+    }
+
+    constexpr const LebedevPoint* begin() const {
+        return this->ptr;
+    }
+
+    constexpr const LebedevPoint* end() const {
+        return this->ptr + this->n;
+    }
+};
+
+struct LebedevTable;
 
 class Quadrature {
 public:
@@ -39,933 +102,1459 @@ public:
         LEBEDEV_146,
         LEBEDEV_170,
         LEBEDEV_194,
+        LEBEDEV_230,
+        LEBEDEV_266,
+        LEBEDEV_302,
+        LEBEDEV_350,
+        LEBEDEV_434,
+        LEBEDEV_590,
+        LEBEDEV_770,
+        LEBEDEV_974,
+        LEBEDEV_1202,
+        LEBEDEV_1454,
+        LEBEDEV_1730,
+        LEBEDEV_2030,
+        LEBEDEV_2354,
+        LEBEDEV_2702,
+        LEBEDEV_3074,
+        LEBEDEV_3470,
+        LEBEDEV_3890,
+        LEBEDEV_4334,
+        LEBEDEV_4802,
+        LEBEDEV_5294,
+        LEBEDEV_5810,
 
         NUM_LEBEDEV_POINTS
     };
 
-    /* number of coefficients per order */
-    static constexpr unsigned int num_lebedev_points[11] = {6, 14, 26, 38, 50, 74, 86, 110, 146, 170, 194};
+    /* number of points per order */
+    static constexpr unsigned int num_lebedev_points[NUM_LEBEDEV_POINTS] = {
+        6, 14, 26, 38, 50, 74, 86, 110, 146, 170, 194, 230, 266, 302, 350, 434, 590, 770, 974, 1202, 1454, 1730, 2030, 2354, 2702, 3074, 3470, 3890, 4334, 4802, 5294, 5810
+    };
 
-    /* total size of lebedev_coefficient matrix */
-    static constexpr unsigned int num_lebedev_coefficients = 6 + 14 + 26 + 38 + 50 +74 + 86 + 110 + 146 +170 +194;
+    /* algebraic degree per order (spherical harmonics up to this degree are integrated exactly) */
+    static constexpr unsigned int lebedev_degree[NUM_LEBEDEV_POINTS] = {
+        3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31, 35,
+        41, 47, 53, 59, 65, 71, 77, 83, 89, 95, 101, 107, 113, 119, 125, 131
+    };
+
+    /* number of generators (orbits) per order */
+    static constexpr unsigned int num_lebedev_generators[NUM_LEBEDEV_POINTS] = {
+        1, 2, 3, 3, 4, 5, 5, 6, 7, 8, 9, 10, 11, 12, 13, 16, 20, 25, 30, 36, 42, 49, 56, 64, 72, 81, 90, 100, 110, 121, 132, 144
+    };
+
+    /* total number of generators */
+    static constexpr unsigned int num_lebedev_generators_total = 1287;
 
-    /* define Lebedev coefficients */
-    static constexpr double lebedev_coefficients[num_lebedev_coefficients][4] = {
-        {  1.000000000000,  0.000000000000,  0.000000000000,  0.166666666667},
-        { -1.000000000000,  0.000000000000,  0.000000000000,  0.166666666667},
-        {  0.000000000000,  1.000000000000,  0.000000000000,  0.166666666667},
-        {  0.000000000000, -1.000000000000,  0.000000000000,  0.166666666667},
-        {  0.000000000000,  0.000000000000,  1.000000000000,  0.166666666667},
-        {  0.000000000000,  0.000000000000, -1.000000000000,  0.166666666667},
-        {  1.000000000000,  0.000000000000,  0.000000000000,  0.066666666667},
-        { -1.000000000000,  0.000000000000,  0.000000000000,  0.066666666667},
-        {  0.000000000000,  1.000000000000,  0.000000000000,  0.066666666667},
-        {  0.000000000000, -1.000000000000,  0.000000000000,  0.066666666667},
-        {  0.000000000000,  0.000000000000,  1.000000000000,  0.066666666667},
-        {  0.000000000000,  0.000000000000, -1.000000000000,  0.066666666667},
-        {  0.577350269190,  0.577350269190,  0.577350269190,  0.075000000000},
-        { -0.577350269190,  0.577350269190,  0.577350269190,  0.075000000000},
-        {  0.577350269190, -0.577350269190,  0.577350269190,  0.075000000000},
-        { -0.577350269190, -0.577350269190,  0.577350269190,  0.075000000000},
-        {  0.577350269190,  0.577350269190, -0.577350269190,  0.075000000000},
-        { -0.577350269190,  0.577350269190, -0.577350269190,  0.075000000000},
-        {  0.577350269190, -0.577350269190, -0.577350269190,  0.075000000000},
-        { -0.577350269190, -0.577350269190, -0.577350269190,  0.075000000000},
-        {  1.000000000000,  0.000000000000,  0.000000000000,  0.047619047619},
-        { -1.000000000000,  0.000000000000,  0.000000000000,  0.047619047619},
-        {  0.000000000000,  1.000000000000,  0.000000000000,  0.047619047619},
-        {  0.000000000000, -1.000000000000,  0.000000000000,  0.047619047619},
-        {  0.000000000000,  0.000000000000,  1.000000000000,  0.047619047619},
-        {  0.000000000000,  0.000000000000, -1.000000000000,  0.047619047619},
-        {  0.000000000000,  0.707106781187,  0.707106781187,  0.038095238095},
-        {  0.000000000000, -0.707106781187,  0.707106781187,  0.038095238095},
-        {  0.000000000000,  0.707106781187, -0.707106781187,  0.038095238095},
-        {  0.000000000000, -0.707106781187, -0.707106781187,  0.038095238095},
-        {  0.707106781187,  0.000000000000,  0.707106781187,  0.038095238095},
-        { -0.707106781187,  0.000000000000,  0.707106781187,  0.038095238095},
-        {  0.707106781187,  0.000000000000, -0.707106781187,  0.038095238095},
-        { -0.707106781187,  0.000000000000, -0.707106781187,  0.038095238095},
-        {  0.707106781187,  0.707106781187,  0.000000000000,  0.038095238095},
-        { -0.707106781187,  0.707106781187,  0.000000000000,  0.038095238095},
-        {  0.707106781187, -0.707106781187,  0.000000000000,  0.038095238095},
-        { -0.707106781187, -0.707106781187,  0.000000000000,  0.038095238095},
-        {  0.577350269190,  0.577350269190,  0.577350269190,  0.032142857143},
-        { -0.577350269190,  0.577350269190,  0.577350269190,  0.032142857143},
-        {  0.577350269190, -0.577350269190,  0.577350269190,  0.032142857143},
-        { -0.577350269190, -0.577350269190,  0.577350269190,  0.032142857143},
-        {  0.577350269190,  0.577350269190, -0.577350269190,  0.032142857143},
-        { -0.577350269190,  0.577350269190, -0.577350269190,  0.032142857143},
-        {  0.577350269190, -0.577350269190, -0.577350269190,  0.032142857143},
-        { -0.577350269190, -0.577350269190, -0.577350269190,  0.032142857143},
-        {  1.000000000000,  0.000000000000,  0.000000000000,  0.009523809524},
-        { -1.000000000000,  0.000000000000,  0.000000000000,  0.009523809524},
-        {  0.000000000000,  1.000000000000,  0.000000000000,  0.009523809524},
-        {  0.000000000000, -1.000000000000,  0.000000000000,  0.009523809524},
-        {  0.000000000000,  0.000000000000,  1.000000000000,  0.009523809524},
-        {  0.000000000000,  0.000000000000, -1.000000000000,  0.009523809524},
-        {  0.577350269190,  0.577350269190,  0.577350269190,  0.032142857143},
-        { -0.577350269190,  0.577350269190,  0.577350269190,  0.032142857143},
-        {  0.577350269190, -0.577350269190,  0.577350269190,  0.032142857143},
-        { -0.577350269190, -0.577350269190,  0.577350269190,  0.032142857143},
-        {  0.577350269190,  0.577350269190, -0.577350269190,  0.032142857143},
-        { -0.577350269190,  0.577350269190, -0.577350269190,  0.032142857143},
-        {  0.577350269190, -0.577350269190, -0.577350269190,  0.032142857143},
-        { -0.577350269190, -0.577350269190, -0.577350269190,  0.032142857143},
-        {  0.459700843381,  0.888073833977,  0.000000000000,  0.028571428571},
-        { -0.459700843381,  0.888073833977,  0.000000000000,  0.028571428571},
-        {  0.459700843381, -0.888073833977,  0.000000000000,  0.028571428571},
-        { -0.459700843381, -0.888073833977,  0.000000000000,  0.028571428571},
-        {  0.888073833977,  0.459700843381,  0.000000000000,  0.028571428571},
-        { -0.888073833977,  0.459700843381,  0.000000000000,  0.028571428571},
-        {  0.888073833977, -0.459700843381,  0.000000000000,  0.028571428571},
-        { -0.888073833977, -0.459700843381,  0.000000000000,  0.028571428571},
-        {  0.459700843381,  0.000000000000,  0.888073833977,  0.028571428571},
-        { -0.459700843381,  0.000000000000,  0.888073833977,  0.028571428571},
-        {  0.459700843381,  0.000000000000, -0.888073833977,  0.028571428571},
-        { -0.459700843381,  0.000000000000, -0.888073833977,  0.028571428571},
-        {  0.888073833977,  0.000000000000,  0.459700843381,  0.028571428571},
-        { -0.888073833977,  0.000000000000,  0.459700843381,  0.028571428571},
-        {  0.888073833977,  0.000000000000, -0.459700843381,  0.028571428571},
-        { -0.888073833977,  0.000000000000, -0.459700843381,  0.028571428571},
-        {  0.000000000000,  0.459700843381,  0.888073833977,  0.028571428571},
-        {  0.000000000000, -0.459700843381,  0.888073833977,  0.028571428571},
-        {  0.000000000000,  0.459700843381, -0.888073833977,  0.028571428571},
-        {  0.000000000000, -0.459700843381, -0.888073833977,  0.028571428571},
-        {  0.000000000000,  0.888073833977,  0.459700843381,  0.028571428571},
-        {  0.000000000000, -0.888073833977,  0.459700843381,  0.028571428571},
-        {  0.000000000000,  0.888073833977, -0.459700843381,  0.028571428571},
-        {  0.000000000000, -0.888073833977, -0.459700843381,  0.028571428571},
-        {  1.000000000000,  0.000000000000,  0.000000000000,  0.012698412698},
-        { -1.000000000000,  0.000000000000,  0.000000000000,  0.012698412698},
-        {  0.000000000000,  1.000000000000,  0.000000000000,  0.012698412698},
-        {  0.000000000000, -1.000000000000,  0.000000000000,  0.012698412698},
-        {  0.000000000000,  0.000000000000,  1.000000000000,  0.012698412698},
-        {  0.000000000000,  0.000000000000, -1.000000000000,  0.012698412698},
-        {  0.000000000000,  0.707106781187,  0.707106781187,  0.022574955908},
-        {  0.000000000000, -0.707106781187,  0.707106781187,  0.022574955908},
-        {  0.000000000000,  0.707106781187, -0.707106781187,  0.022574955908},
-        {  0.000000000000, -0.707106781187, -0.707106781187,  0.022574955908},
-        {  0.707106781187,  0.000000000000,  0.707106781187,  0.022574955908},
-        { -0.707106781187,  0.000000000000,  0.707106781187,  0.022574955908},
-        {  0.707106781187,  0.000000000000, -0.707106781187,  0.022574955908},
-        { -0.707106781187,  0.000000000000, -0.707106781187,  0.022574955908},
-        {  0.707106781187,  0.707106781187,  0.000000000000,  0.022574955908},
-        { -0.707106781187,  0.707106781187,  0.000000000000,  0.022574955908},
-        {  0.707106781187, -0.707106781187,  0.000000000000,  0.022574955908},
-        { -0.707106781187, -0.707106781187,  0.000000000000,  0.022574955908},
-        {  0.577350269190,  0.577350269190,  0.577350269190,  0.021093750000},
-        { -0.577350269190,  0.577350269190,  0.577350269190,  0.021093750000},
-        {  0.577350269190, -0.577350269190,  0.577350269190,  0.021093750000},
-        { -0.577350269190, -0.577350269190,  0.577350269190,  0.021093750000},
-        {  0.577350269190,  0.577350269190, -0.577350269190,  0.021093750000},
-        { -0.577350269190,  0.577350269190, -0.577350269190,  0.021093750000},
-        {  0.577350269190, -0.577350269190, -0.577350269190,  0.021093750000},
-        { -0.577350269190, -0.577350269190, -0.577350269190,  0.021093750000},
-        {  0.301511344578,  0.301511344578,  0.904534033733,  0.020173335538},
-        { -0.301511344578,  0.301511344578,  0.904534033733,  0.020173335538},
-        {  0.301511344578, -0.301511344578,  0.904534033733,  0.020173335538},
-        { -0.301511344578, -0.301511344578,  0.904534033733,  0.020173335538},
-        {  0.301511344578,  0.301511344578, -0.904534033733,  0.020173335538},
-        { -0.301511344578,  0.301511344578, -0.904534033733,  0.020173335538},
-        {  0.301511344578, -0.301511344578, -0.904534033733,  0.020173335538},
-        { -0.301511344578, -0.301511344578, -0.904534033733,  0.020173335538},
-        {  0.301511344578,  0.904534033733,  0.301511344578,  0.020173335538},
-        { -0.301511344578,  0.904534033733,  0.301511344578,  0.020173335538},
-        {  0.301511344578, -0.904534033733,  0.301511344578,  0.020173335538},
-        { -0.301511344578, -0.904534033733,  0.301511344578,  0.020173335538},
-        {  0.301511344578,  0.904534033733, -0.301511344578,  0.020173335538},
-        { -0.301511344578,  0.904534033733, -0.301511344578,  0.020173335538},
-        {  0.301511344578, -0.904534033733, -0.301511344578,  0.020173335538},
-        { -0.301511344578, -0.904534033733, -0.301511344578,  0.020173335538},
-        {  0.904534033733,  0.301511344578,  0.301511344578,  0.020173335538},
-        { -0.904534033733,  0.301511344578,  0.301511344578,  0.020173335538},
-        {  0.904534033733, -0.301511344578,  0.301511344578,  0.020173335538},
-        { -0.904534033733, -0.301511344578,  0.301511344578,  0.020173335538},
-        {  0.904534033733,  0.301511344578, -0.301511344578,  0.020173335538},
-        { -0.904534033733,  0.301511344578, -0.301511344578,  0.020173335538},
-        {  0.904534033733, -0.301511344578, -0.301511344578,  0.020173335538},
-        { -0.904534033733, -0.301511344578, -0.301511344578,  0.020173335538},
-        {  1.000000000000,  0.000000000000,  0.000000000000,  0.000513067180},
-        { -1.000000000000,  0.000000000000,  0.000000000000,  0.000513067180},
-        {  0.000000000000,  1.000000000000,  0.000000000000,  0.000513067180},
-        {  0.000000000000, -1.000000000000,  0.000000000000,  0.000513067180},
-        {  0.000000000000,  0.000000000000,  1.000000000000,  0.000513067180},
-        {  0.000000000000,  0.000000000000, -1.000000000000,  0.000513067180},
-        {  0.000000000000,  0.707106781187,  0.707106781187,  0.016604069566},
-        {  0.000000000000, -0.707106781187,  0.707106781187,  0.016604069566},
-        {  0.000000000000,  0.707106781187, -0.707106781187,  0.016604069566},
-        {  0.000000000000, -0.707106781187, -0.707106781187,  0.016604069566},
-        {  0.707106781187,  0.000000000000,  0.707106781187,  0.016604069566},
-        { -0.707106781187,  0.000000000000,  0.707106781187,  0.016604069566},
-        {  0.707106781187,  0.000000000000, -0.707106781187,  0.016604069566},
-        { -0.707106781187,  0.000000000000, -0.707106781187,  0.016604069566},
-        {  0.707106781187,  0.707106781187,  0.000000000000,  0.016604069566},
-        { -0.707106781187,  0.707106781187,  0.000000000000,  0.016604069566},
-        {  0.707106781187, -0.707106781187,  0.000000000000,  0.016604069566},
-        { -0.707106781187, -0.707106781187,  0.000000000000,  0.016604069566},
-        {  0.577350269190,  0.577350269190,  0.577350269190, -0.029586038961},
-        { -0.577350269190,  0.577350269190,  0.577350269190, -0.029586038961},
-        {  0.577350269190, -0.577350269190,  0.577350269190, -0.029586038961},
-        { -0.577350269190, -0.577350269190,  0.577350269190, -0.029586038961},
-        {  0.577350269190,  0.577350269190, -0.577350269190, -0.029586038961},
-        { -0.577350269190,  0.577350269190, -0.577350269190, -0.029586038961},
-        {  0.577350269190, -0.577350269190, -0.577350269190, -0.029586038961},
-        { -0.577350269190, -0.577350269190, -0.577350269190, -0.029586038961},
-        {  0.480384461415,  0.480384461415,  0.733799385705,  0.026576207082},
-        { -0.480384461415,  0.480384461415,  0.733799385705,  0.026576207082},
-        {  0.480384461415, -0.480384461415,  0.733799385705,  0.026576207082},
-        { -0.480384461415, -0.480384461415,  0.733799385705,  0.026576207082},
-        {  0.480384461415,  0.480384461415, -0.733799385705,  0.026576207082},
-        { -0.480384461415,  0.480384461415, -0.733799385705,  0.026576207082},
-        {  0.480384461415, -0.480384461415, -0.733799385705,  0.026576207082},
-        { -0.480384461415, -0.480384461415, -0.733799385705,  0.026576207082},
-        {  0.480384461415,  0.733799385705,  0.480384461415,  0.026576207082},
-        { -0.480384461415,  0.733799385705,  0.480384461415,  0.026576207082},
-        {  0.480384461415, -0.733799385705,  0.480384461415,  0.026576207082},
-        { -0.480384461415, -0.733799385705,  0.480384461415,  0.026576207082},
-        {  0.480384461415,  0.733799385705, -0.480384461415,  0.026576207082},
-        { -0.480384461415,  0.733799385705, -0.480384461415,  0.026576207082},
-        {  0.480384461415, -0.733799385705, -0.480384461415,  0.026576207082},
-        { -0.480384461415, -0.733799385705, -0.480384461415,  0.026576207082},
-        {  0.733799385705,  0.480384461415,  0.480384461415,  0.026576207082},
-        { -0.733799385705,  0.480384461415,  0.480384461415,  0.026576207082},
-        {  0.733799385705, -0.480384461415,  0.480384461415,  0.026576207082},
-        { -0.733799385705, -0.480384461415,  0.480384461415,  0.026576207082},
-        {  0.733799385705,  0.480384461415, -0.480384461415,  0.026576207082},
-        { -0.733799385705,  0.480384461415, -0.480384461415,  0.026576207082},
-        {  0.733799385705, -0.480384461415, -0.480384461415,  0.026576207082},
-        { -0.733799385705, -0.480384461415, -0.480384461415,  0.026576207082},
-        {  0.320772648981,  0.947156221363,  0.000000000000,  0.016522170994},
-        { -0.320772648981,  0.947156221363,  0.000000000000,  0.016522170994},
-        {  0.320772648981, -0.947156221363,  0.000000000000,  0.016522170994},
-        { -0.320772648981, -0.947156221363,  0.000000000000,  0.016522170994},
-        {  0.947156221363,  0.320772648981,  0.000000000000,  0.016522170994},
-        { -0.947156221363,  0.320772648981,  0.000000000000,  0.016522170994},
-        {  0.947156221363, -0.320772648981,  0.000000000000,  0.016522170994},
-        { -0.947156221363, -0.320772648981,  0.000000000000,  0.016522170994},
-        {  0.320772648981,  0.000000000000,  0.947156221363,  0.016522170994},
-        { -0.320772648981,  0.000000000000,  0.947156221363,  0.016522170994},
-        {  0.320772648981,  0.000000000000, -0.947156221363,  0.016522170994},
-        { -0.320772648981,  0.000000000000, -0.947156221363,  0.016522170994},
-        {  0.947156221363,  0.000000000000,  0.320772648981,  0.016522170994},
-        { -0.947156221363,  0.000000000000,  0.320772648981,  0.016522170994},
-        {  0.947156221363,  0.000000000000, -0.320772648981,  0.016522170994},
-        { -0.947156221363,  0.000000000000, -0.320772648981,  0.016522170994},
-        {  0.000000000000,  0.320772648981,  0.947156221363,  0.016522170994},
-        {  0.000000000000, -0.320772648981,  0.947156221363,  0.016522170994},
-        {  0.000000000000,  0.320772648981, -0.947156221363,  0.016522170994},
-        {  0.000000000000, -0.320772648981, -0.947156221363,  0.016522170994},
-        {  0.000000000000,  0.947156221363,  0.320772648981,  0.016522170994},
-        {  0.000000000000, -0.947156221363,  0.320772648981,  0.016522170994},
-        {  0.000000000000,  0.947156221363, -0.320772648981,  0.016522170994},
-        {  0.000000000000, -0.947156221363, -0.320772648981,  0.016522170994},
-        {  1.000000000000,  0.000000000000,  0.000000000000,  0.011544011544},
-        { -1.000000000000,  0.000000000000,  0.000000000000,  0.011544011544},
-        {  0.000000000000,  1.000000000000,  0.000000000000,  0.011544011544},
-        {  0.000000000000, -1.000000000000,  0.000000000000,  0.011544011544},
-        {  0.000000000000,  0.000000000000,  1.000000000000,  0.011544011544},
-        {  0.000000000000,  0.000000000000, -1.000000000000,  0.011544011544},
-        {  0.577350269190,  0.577350269190,  0.577350269190,  0.011943909086},
-        { -0.577350269190,  0.577350269190,  0.577350269190,  0.011943909086},
-        {  0.577350269190, -0.577350269190,  0.577350269190,  0.011943909086},
-        { -0.577350269190, -0.577350269190,  0.577350269190,  0.011943909086},
-        {  0.577350269190,  0.577350269190, -0.577350269190,  0.011943909086},
-        { -0.577350269190,  0.577350269190, -0.577350269190,  0.011943909086},
-        {  0.577350269190, -0.577350269190, -0.577350269190,  0.011943909086},
-        { -0.577350269190, -0.577350269190, -0.577350269190,  0.011943909086},
-        {  0.369602846454,  0.369602846454,  0.852518311701,  0.011110555711},
-        { -0.369602846454,  0.369602846454,  0.852518311701,  0.011110555711},
-        {  0.369602846454, -0.369602846454,  0.852518311701,  0.011110555711},
-        { -0.369602846454, -0.369602846454,  0.852518311701,  0.011110555711},
-        {  0.369602846454,  0.369602846454, -0.852518311701,  0.011110555711},
-        { -0.369602846454,  0.369602846454, -0.852518311701,  0.011110555711},
-        {  0.369602846454, -0.369602846454, -0.852518311701,  0.011110555711},
-        { -0.369602846454, -0.369602846454, -0.852518311701,  0.011110555711},
-        {  0.369602846454,  0.852518311701,  0.369602846454,  0.011110555711},
-        { -0.369602846454,  0.852518311701,  0.369602846454,  0.011110555711},
-        {  0.369602846454, -0.852518311701,  0.369602846454,  0.011110555711},
-        { -0.369602846454, -0.852518311701,  0.369602846454,  0.011110555711},
-        {  0.369602846454,  0.852518311701, -0.369602846454,  0.011110555711},
-        { -0.369602846454,  0.852518311701, -0.369602846454,  0.011110555711},
-        {  0.369602846454, -0.852518311701, -0.369602846454,  0.011110555711},
-        { -0.369602846454, -0.852518311701, -0.369602846454,  0.011110555711},
-        {  0.852518311701,  0.369602846454,  0.369602846454,  0.011110555711},
-        { -0.852518311701,  0.369602846454,  0.369602846454,  0.011110555711},
-        {  0.852518311701, -0.369602846454,  0.369602846454,  0.011110555711},
-        { -0.852518311701, -0.369602846454,  0.369602846454,  0.011110555711},
-        {  0.852518311701,  0.369602846454, -0.369602846454,  0.011110555711},
-        { -0.852518311701,  0.369602846454, -0.369602846454,  0.011110555711},
-        {  0.852518311701, -0.369602846454, -0.369602846454,  0.011110555711},
-        { -0.852518311701, -0.369602846454, -0.369602846454,  0.011110555711},
-        {  0.694354006603,  0.694354006603,  0.189063552885,  0.011876501295},
-        { -0.694354006603,  0.694354006603,  0.189063552885,  0.011876501295},
-        {  0.694354006603, -0.694354006603,  0.189063552885,  0.011876501295},
-        { -0.694354006603, -0.694354006603,  0.189063552885,  0.011876501295},
-        {  0.694354006603,  0.694354006603, -0.189063552885,  0.011876501295},
-        { -0.694354006603,  0.694354006603, -0.189063552885,  0.011876501295},
-        {  0.694354006603, -0.694354006603, -0.189063552885,  0.011876501295},
-        { -0.694354006603, -0.694354006603, -0.189063552885,  0.011876501295},
-        {  0.694354006603,  0.189063552885,  0.694354006603,  0.011876501295},
-        { -0.694354006603,  0.189063552885,  0.694354006603,  0.011876501295},
-        {  0.694354006603, -0.189063552885,  0.694354006603,  0.011876501295},
-        { -0.694354006603, -0.189063552885,  0.694354006603,  0.011876501295},
-        {  0.694354006603,  0.189063552885, -0.694354006603,  0.011876501295},
-        { -0.694354006603,  0.189063552885, -0.694354006603,  0.011876501295},
-        {  0.694354006603, -0.189063552885, -0.694354006603,  0.011876501295},
-        { -0.694354006603, -0.189063552885, -0.694354006603,  0.011876501295},
-        {  0.189063552885,  0.694354006603,  0.694354006603,  0.011876501295},
-        { -0.189063552885,  0.694354006603,  0.694354006603,  0.011876501295},
-        {  0.189063552885, -0.694354006603,  0.694354006603,  0.011876501295},
-        { -0.189063552885, -0.694354006603,  0.694354006603,  0.011876501295},
-        {  0.189063552885,  0.694354006603, -0.694354006603,  0.011876501295},
-        { -0.189063552885,  0.694354006603, -0.694354006603,  0.011876501295},
-        {  0.189063552885, -0.694354006603, -0.694354006603,  0.011876501295},
-        { -0.189063552885, -0.694354006603, -0.694354006603,  0.011876501295},
-        {  0.374243039090,  0.927330657151,  0.000000000000,  0.011812303747},
-        { -0.374243039090,  0.927330657151,  0.000000000000,  0.011812303747},
-        {  0.374243039090, -0.927330657151,  0.000000000000,  0.011812303747},
-        { -0.374243039090, -0.927330657151,  0.000000000000,  0.011812303747},
-        {  0.927330657151,  0.374243039090,  0.000000000000,  0.011812303747},
-        { -0.927330657151,  0.374243039090,  0.000000000000,  0.011812303747},
-        {  0.927330657151, -0.374243039090,  0.000000000000,  0.011812303747},
-        { -0.927330657151, -0.374243039090,  0.000000000000,  0.011812303747},
-        {  0.374243039090,  0.000000000000,  0.927330657151,  0.011812303747},
-        { -0.374243039090,  0.000000000000,  0.927330657151,  0.011812303747},
-        {  0.374243039090,  0.000000000000, -0.927330657151,  0.011812303747},
-        { -0.374243039090,  0.000000000000, -0.927330657151,  0.011812303747},
-        {  0.927330657151,  0.000000000000,  0.374243039090,  0.011812303747},
-        { -0.927330657151,  0.000000000000,  0.374243039090,  0.011812303747},
-        {  0.927330657151,  0.000000000000, -0.374243039090,  0.011812303747},
-        { -0.927330657151,  0.000000000000, -0.374243039090,  0.011812303747},
-        {  0.000000000000,  0.374243039090,  0.927330657151,  0.011812303747},
-        {  0.000000000000, -0.374243039090,  0.927330657151,  0.011812303747},
-        {  0.000000000000,  0.374243039090, -0.927330657151,  0.011812303747},
-        {  0.000000000000, -0.374243039090, -0.927330657151,  0.011812303747},
-        {  0.000000000000,  0.927330657151,  0.374243039090,  0.011812303747},
-        {  0.000000000000, -0.927330657151,  0.374243039090,  0.011812303747},
-        {  0.000000000000,  0.927330657151, -0.374243039090,  0.011812303747},
-        {  0.000000000000, -0.927330657151, -0.374243039090,  0.011812303747},
-        {  1.000000000000,  0.000000000000,  0.000000000000,  0.003828270495},
-        { -1.000000000000,  0.000000000000,  0.000000000000,  0.003828270495},
-        {  0.000000000000,  1.000000000000,  0.000000000000,  0.003828270495},
-        {  0.000000000000, -1.000000000000,  0.000000000000,  0.003828270495},
-        {  0.000000000000,  0.000000000000,  1.000000000000,  0.003828270495},
-        {  0.000000000000,  0.000000000000, -1.000000000000,  0.003828270495},
-        {  0.577350269190,  0.577350269190,  0.577350269190,  0.009793737512},
-        { -0.577350269190,  0.577350269190,  0.577350269190,  0.009793737512},
-        {  0.577350269190, -0.577350269190,  0.577350269190,  0.009793737512},
-        { -0.577350269190, -0.577350269190,  0.577350269190,  0.009793737512},
-        {  0.577350269190,  0.577350269190, -0.577350269190,  0.009793737512},
-        { -0.577350269190,  0.577350269190, -0.577350269190,  0.009793737512},
-        {  0.577350269190, -0.577350269190, -0.577350269190,  0.009793737512},
-        { -0.577350269190, -0.577350269190, -0.577350269190,  0.009793737512},
-        {  0.185115635345,  0.185115635345,  0.965124035087,  0.008211737283},
-        { -0.185115635345,  0.185115635345,  0.965124035087,  0.008211737283},
-        {  0.185115635345, -0.185115635345,  0.965124035087,  0.008211737283},
-        { -0.185115635345, -0.185115635345,  0.965124035087,  0.008211737283},
-        {  0.185115635345,  0.185115635345, -0.965124035087,  0.008211737283},
-        { -0.185115635345,  0.185115635345, -0.965124035087,  0.008211737283},
-        {  0.185115635345, -0.185115635345, -0.965124035087,  0.008211737283},
-        { -0.185115635345, -0.185115635345, -0.965124035087,  0.008211737283},
-        {  0.185115635345,  0.965124035087,  0.185115635345,  0.008211737283},
-        { -0.185115635345,  0.965124035087,  0.185115635345,  0.008211737283},
-        {  0.185115635345, -0.965124035087,  0.185115635345,  0.008211737283},
-        { -0.185115635345, -0.965124035087,  0.185115635345,  0.008211737283},
-        {  0.185115635345,  0.965124035087, -0.185115635345,  0.008211737283},
-        { -0.185115635345,  0.965124035087, -0.185115635345,  0.008211737283},
-        {  0.185115635345, -0.965124035087, -0.185115635345,  0.008211737283},
-        { -0.185115635345, -0.965124035087, -0.185115635345,  0.008211737283},
-        {  0.965124035087,  0.185115635345,  0.185115635345,  0.008211737283},
-        { -0.965124035087,  0.185115635345,  0.185115635345,  0.008211737283},
-        {  0.965124035087, -0.185115635345,  0.185115635345,  0.008211737283},
-        { -0.965124035087, -0.185115635345,  0.185115635345,  0.008211737283},
-        {  0.965124035087,  0.185115635345, -0.185115635345,  0.008211737283},
-        { -0.965124035087,  0.185115635345, -0.185115635345,  0.008211737283},
-        {  0.965124035087, -0.185115635345, -0.185115635345,  0.008211737283},
-        { -0.965124035087, -0.185115635345, -0.185115635345,  0.008211737283},
-        {  0.690421048382,  0.690421048382,  0.215957291846,  0.009942814891},
-        { -0.690421048382,  0.690421048382,  0.215957291846,  0.009942814891},
-        {  0.690421048382, -0.690421048382,  0.215957291846,  0.009942814891},
-        { -0.690421048382, -0.690421048382,  0.215957291846,  0.009942814891},
-        {  0.690421048382,  0.690421048382, -0.215957291846,  0.009942814891},
-        { -0.690421048382,  0.690421048382, -0.215957291846,  0.009942814891},
-        {  0.690421048382, -0.690421048382, -0.215957291846,  0.009942814891},
-        { -0.690421048382, -0.690421048382, -0.215957291846,  0.009942814891},
-        {  0.690421048382,  0.215957291846,  0.690421048382,  0.009942814891},
-        { -0.690421048382,  0.215957291846,  0.690421048382,  0.009942814891},
-        {  0.690421048382, -0.215957291846,  0.690421048382,  0.009942814891},
-        { -0.690421048382, -0.215957291846,  0.690421048382,  0.009942814891},
-        {  0.690421048382,  0.215957291846, -0.690421048382,  0.009942814891},
-        { -0.690421048382,  0.215957291846, -0.690421048382,  0.009942814891},
-        {  0.690421048382, -0.215957291846, -0.690421048382,  0.009942814891},
-        { -0.690421048382, -0.215957291846, -0.690421048382,  0.009942814891},
-        {  0.215957291846,  0.690421048382,  0.690421048382,  0.009942814891},
-        { -0.215957291846,  0.690421048382,  0.690421048382,  0.009942814891},
-        {  0.215957291846, -0.690421048382,  0.690421048382,  0.009942814891},
-        { -0.215957291846, -0.690421048382,  0.690421048382,  0.009942814891},
-        {  0.215957291846,  0.690421048382, -0.690421048382,  0.009942814891},
-        { -0.215957291846,  0.690421048382, -0.690421048382,  0.009942814891},
-        {  0.215957291846, -0.690421048382, -0.690421048382,  0.009942814891},
-        { -0.215957291846, -0.690421048382, -0.690421048382,  0.009942814891},
-        {  0.395689473056,  0.395689473056,  0.828769981253,  0.009595471336},
-        { -0.395689473056,  0.395689473056,  0.828769981253,  0.009595471336},
-        {  0.395689473056, -0.395689473056,  0.828769981253,  0.009595471336},
-        { -0.395689473056, -0.395689473056,  0.828769981253,  0.009595471336},
-        {  0.395689473056,  0.395689473056, -0.828769981253,  0.009595471336},
-        { -0.395689473056,  0.395689473056, -0.828769981253,  0.009595471336},
-        {  0.395689473056, -0.395689473056, -0.828769981253,  0.009595471336},
-        { -0.395689473056, -0.395689473056, -0.828769981253,  0.009595471336},
-        {  0.395689473056,  0.828769981253,  0.395689473056,  0.009595471336},
-        { -0.395689473056,  0.828769981253,  0.395689473056,  0.009595471336},
-        {  0.395689473056, -0.828769981253,  0.395689473056,  0.009595471336},
-        { -0.395689473056, -0.828769981253,  0.395689473056,  0.009595471336},
-        {  0.395689473056,  0.828769981253, -0.395689473056,  0.009595471336},
-        { -0.395689473056,  0.828769981253, -0.395689473056,  0.009595471336},
-        {  0.395689473056, -0.828769981253, -0.395689473056,  0.009595471336},
-        { -0.395689473056, -0.828769981253, -0.395689473056,  0.009595471336},
-        {  0.828769981253,  0.395689473056,  0.395689473056,  0.009595471336},
-        { -0.828769981253,  0.395689473056,  0.395689473056,  0.009595471336},
-        {  0.828769981253, -0.395689473056,  0.395689473056,  0.009595471336},
-        { -0.828769981253, -0.395689473056,  0.395689473056,  0.009595471336},
-        {  0.828769981253,  0.395689473056, -0.395689473056,  0.009595471336},
-        { -0.828769981253,  0.395689473056, -0.395689473056,  0.009595471336},
-        {  0.828769981253, -0.395689473056, -0.395689473056,  0.009595471336},
-        { -0.828769981253, -0.395689473056, -0.395689473056,  0.009595471336},
-        {  0.478369028812,  0.878158910604,  0.000000000000,  0.009694996362},
-        { -0.478369028812,  0.878158910604,  0.000000000000,  0.009694996362},
-        {  0.478369028812, -0.878158910604,  0.000000000000,  0.009694996362},
-        { -0.478369028812, -0.878158910604,  0.000000000000,  0.009694996362},
-        {  0.878158910604,  0.478369028812,  0.000000000000,  0.009694996362},
-        { -0.878158910604,  0.478369028812,  0.000000000000,  0.009694996362},
-        {  0.878158910604, -0.478369028812,  0.000000000000,  0.009694996362},
-        { -0.878158910604, -0.478369028812,  0.000000000000,  0.009694996362},
-        {  0.478369028812,  0.000000000000,  0.878158910604,  0.009694996362},
-        { -0.478369028812,  0.000000000000,  0.878158910604,  0.009694996362},
-        {  0.478369028812,  0.000000000000, -0.878158910604,  0.009694996362},
-        { -0.478369028812,  0.000000000000, -0.878158910604,  0.009694996362},
-        {  0.878158910604,  0.000000000000,  0.478369028812,  0.009694996362},
-        { -0.878158910604,  0.000000000000,  0.478369028812,  0.009694996362},
-        {  0.878158910604,  0.000000000000, -0.478369028812,  0.009694996362},
-        { -0.878158910604,  0.000000000000, -0.478369028812,  0.009694996362},
-        {  0.000000000000,  0.478369028812,  0.878158910604,  0.009694996362},
-        {  0.000000000000, -0.478369028812,  0.878158910604,  0.009694996362},
-        {  0.000000000000,  0.478369028812, -0.878158910604,  0.009694996362},
-        {  0.000000000000, -0.478369028812, -0.878158910604,  0.009694996362},
-        {  0.000000000000,  0.878158910604,  0.478369028812,  0.009694996362},
-        {  0.000000000000, -0.878158910604,  0.478369028812,  0.009694996362},
-        {  0.000000000000,  0.878158910604, -0.478369028812,  0.009694996362},
-        {  0.000000000000, -0.878158910604, -0.478369028812,  0.009694996362},
-        {  1.000000000000,  0.000000000000,  0.000000000000,  0.000599631369},
-        { -1.000000000000,  0.000000000000,  0.000000000000,  0.000599631369},
-        {  0.000000000000,  1.000000000000,  0.000000000000,  0.000599631369},
-        {  0.000000000000, -1.000000000000,  0.000000000000,  0.000599631369},
-        {  0.000000000000,  0.000000000000,  1.000000000000,  0.000599631369},
-        {  0.000000000000,  0.000000000000, -1.000000000000,  0.000599631369},
-        {  0.000000000000,  0.707106781187,  0.707106781187,  0.007372999719},
-        {  0.000000000000, -0.707106781187,  0.707106781187,  0.007372999719},
-        {  0.000000000000,  0.707106781187, -0.707106781187,  0.007372999719},
-        {  0.000000000000, -0.707106781187, -0.707106781187,  0.007372999719},
-        {  0.707106781187,  0.000000000000,  0.707106781187,  0.007372999719},
-        { -0.707106781187,  0.000000000000,  0.707106781187,  0.007372999719},
-        {  0.707106781187,  0.000000000000, -0.707106781187,  0.007372999719},
-        { -0.707106781187,  0.000000000000, -0.707106781187,  0.007372999719},
-        {  0.707106781187,  0.707106781187,  0.000000000000,  0.007372999719},
-        { -0.707106781187,  0.707106781187,  0.000000000000,  0.007372999719},
-        {  0.707106781187, -0.707106781187,  0.000000000000,  0.007372999719},
-        { -0.707106781187, -0.707106781187,  0.000000000000,  0.007372999719},
-        {  0.577350269190,  0.577350269190,  0.577350269190,  0.007210515360},
-        { -0.577350269190,  0.577350269190,  0.577350269190,  0.007210515360},
-        {  0.577350269190, -0.577350269190,  0.577350269190,  0.007210515360},
-        { -0.577350269190, -0.577350269190,  0.577350269190,  0.007210515360},
-        {  0.577350269190,  0.577350269190, -0.577350269190,  0.007210515360},
-        { -0.577350269190,  0.577350269190, -0.577350269190,  0.007210515360},
-        {  0.577350269190, -0.577350269190, -0.577350269190,  0.007210515360},
-        { -0.577350269190, -0.577350269190, -0.577350269190,  0.007210515360},
-        {  0.676441040011,  0.676441040011,  0.291298882210,  0.007116355493},
-        { -0.676441040011,  0.676441040011,  0.291298882210,  0.007116355493},
-        {  0.676441040011, -0.676441040011,  0.291298882210,  0.007116355493},
-        { -0.676441040011, -0.676441040011,  0.291298882210,  0.007116355493},
-        {  0.676441040011,  0.676441040011, -0.291298882210,  0.007116355493},
-        { -0.676441040011,  0.676441040011, -0.291298882210,  0.007116355493},
-        {  0.676441040011, -0.676441040011, -0.291298882210,  0.007116355493},
-        { -0.676441040011, -0.676441040011, -0.291298882210,  0.007116355493},
-        {  0.676441040011,  0.291298882210,  0.676441040011,  0.007116355493},
-        { -0.676441040011,  0.291298882210,  0.676441040011,  0.007116355493},
-        {  0.676441040011, -0.291298882210,  0.676441040011,  0.007116355493},
-        { -0.676441040011, -0.291298882210,  0.676441040011,  0.007116355493},
-        {  0.676441040011,  0.291298882210, -0.676441040011,  0.007116355493},
-        { -0.676441040011,  0.291298882210, -0.676441040011,  0.007116355493},
-        {  0.676441040011, -0.291298882210, -0.676441040011,  0.007116355493},
-        { -0.676441040011, -0.291298882210, -0.676441040011,  0.007116355493},
-        {  0.291298882210,  0.676441040011,  0.676441040011,  0.007116355493},
-        { -0.291298882210,  0.676441040011,  0.676441040011,  0.007116355493},
-        {  0.291298882210, -0.676441040011,  0.676441040011,  0.007116355493},
-        { -0.291298882210, -0.676441040011,  0.676441040011,  0.007116355493},
-        {  0.291298882210,  0.676441040011, -0.676441040011,  0.007116355493},
-        { -0.291298882210,  0.676441040011, -0.676441040011,  0.007116355493},
-        {  0.291298882210, -0.676441040011, -0.676441040011,  0.007116355493},
-        { -0.291298882210, -0.676441040011, -0.676441040011,  0.007116355493},
-        {  0.417496122797,  0.417496122797,  0.807089818360,  0.006753829486},
-        { -0.417496122797,  0.417496122797,  0.807089818360,  0.006753829486},
-        {  0.417496122797, -0.417496122797,  0.807089818360,  0.006753829486},
-        { -0.417496122797, -0.417496122797,  0.807089818360,  0.006753829486},
-        {  0.417496122797,  0.417496122797, -0.807089818360,  0.006753829486},
-        { -0.417496122797,  0.417496122797, -0.807089818360,  0.006753829486},
-        {  0.417496122797, -0.417496122797, -0.807089818360,  0.006753829486},
-        { -0.417496122797, -0.417496122797, -0.807089818360,  0.006753829486},
-        {  0.417496122797,  0.807089818360,  0.417496122797,  0.006753829486},
-        { -0.417496122797,  0.807089818360,  0.417496122797,  0.006753829486},
-        {  0.417496122797, -0.807089818360,  0.417496122797,  0.006753829486},
-        { -0.417496122797, -0.807089818360,  0.417496122797,  0.006753829486},
-        {  0.417496122797,  0.807089818360, -0.417496122797,  0.006753829486},
-        { -0.417496122797,  0.807089818360, -0.417496122797,  0.006753829486},
-        {  0.417496122797, -0.807089818360, -0.417496122797,  0.006753829486},
-        { -0.417496122797, -0.807089818360, -0.417496122797,  0.006753829486},
-        {  0.807089818360,  0.417496122797,  0.417496122797,  0.006753829486},
-        { -0.807089818360,  0.417496122797,  0.417496122797,  0.006753829486},
-        {  0.807089818360, -0.417496122797,  0.417496122797,  0.006753829486},
-        { -0.807089818360, -0.417496122797,  0.417496122797,  0.006753829486},
-        {  0.807089818360,  0.417496122797, -0.417496122797,  0.006753829486},
-        { -0.807089818360,  0.417496122797, -0.417496122797,  0.006753829486},
-        {  0.807089818360, -0.417496122797, -0.417496122797,  0.006753829486},
-        { -0.807089818360, -0.417496122797, -0.417496122797,  0.006753829486},
-        {  0.157467667204,  0.157467667204,  0.974888643677,  0.007574394159},
-        { -0.157467667204,  0.157467667204,  0.974888643677,  0.007574394159},
-        {  0.157467667204, -0.157467667204,  0.974888643677,  0.007574394159},
-        { -0.157467667204, -0.157467667204,  0.974888643677,  0.007574394159},
-        {  0.157467667204,  0.157467667204, -0.974888643677,  0.007574394159},
-        { -0.157467667204,  0.157467667204, -0.974888643677,  0.007574394159},
-        {  0.157467667204, -0.157467667204, -0.974888643677,  0.007574394159},
-        { -0.157467667204, -0.157467667204, -0.974888643677,  0.007574394159},
-        {  0.157467667204,  0.974888643677,  0.157467667204,  0.007574394159},
-        { -0.157467667204,  0.974888643677,  0.157467667204,  0.007574394159},
-        {  0.157467667204, -0.974888643677,  0.157467667204,  0.007574394159},
-        { -0.157467667204, -0.974888643677,  0.157467667204,  0.007574394159},
-        {  0.157467667204,  0.974888643677, -0.157467667204,  0.007574394159},
-        { -0.157467667204,  0.974888643677, -0.157467667204,  0.007574394159},
-        {  0.157467667204, -0.974888643677, -0.157467667204,  0.007574394159},
-        { -0.157467667204, -0.974888643677, -0.157467667204,  0.007574394159},
-        {  0.974888643677,  0.157467667204,  0.157467667204,  0.007574394159},
-        { -0.974888643677,  0.157467667204,  0.157467667204,  0.007574394159},
-        {  0.974888643677, -0.157467667204,  0.157467667204,  0.007574394159},
-        { -0.974888643677, -0.157467667204,  0.157467667204,  0.007574394159},
-        {  0.974888643677,  0.157467667204, -0.157467667204,  0.007574394159},
-        { -0.974888643677,  0.157467667204, -0.157467667204,  0.007574394159},
-        {  0.974888643677, -0.157467667204, -0.157467667204,  0.007574394159},
-        { -0.974888643677, -0.157467667204, -0.157467667204,  0.007574394159},
-        {  0.140355381171,  0.449332832327,  0.882270011260,  0.006991087353},
-        { -0.140355381171,  0.449332832327,  0.882270011260,  0.006991087353},
-        {  0.140355381171, -0.449332832327,  0.882270011260,  0.006991087353},
-        { -0.140355381171, -0.449332832327,  0.882270011260,  0.006991087353},
-        {  0.140355381171,  0.449332832327, -0.882270011260,  0.006991087353},
-        { -0.140355381171,  0.449332832327, -0.882270011260,  0.006991087353},
-        {  0.140355381171, -0.449332832327, -0.882270011260,  0.006991087353},
-        { -0.140355381171, -0.449332832327, -0.882270011260,  0.006991087353},
-        {  0.140355381171,  0.882270011260,  0.449332832327,  0.006991087353},
-        { -0.140355381171,  0.882270011260,  0.449332832327,  0.006991087353},
-        {  0.140355381171, -0.882270011260,  0.449332832327,  0.006991087353},
-        { -0.140355381171, -0.882270011260,  0.449332832327,  0.006991087353},
-        {  0.140355381171,  0.882270011260, -0.449332832327,  0.006991087353},
-        { -0.140355381171,  0.882270011260, -0.449332832327,  0.006991087353},
-        {  0.140355381171, -0.882270011260, -0.449332832327,  0.006991087353},
-        { -0.140355381171, -0.882270011260, -0.449332832327,  0.006991087353},
-        {  0.449332832327,  0.140355381171,  0.882270011260,  0.006991087353},
-        { -0.449332832327,  0.140355381171,  0.882270011260,  0.006991087353},
-        {  0.449332832327, -0.140355381171,  0.882270011260,  0.006991087353},
-        { -0.449332832327, -0.140355381171,  0.882270011260,  0.006991087353},
-        {  0.449332832327,  0.140355381171, -0.882270011260,  0.006991087353},
-        { -0.449332832327,  0.140355381171, -0.882270011260,  0.006991087353},
-        {  0.449332832327, -0.140355381171, -0.882270011260,  0.006991087353},
-        { -0.449332832327, -0.140355381171, -0.882270011260,  0.006991087353},
-        {  0.449332832327,  0.882270011260,  0.140355381171,  0.006991087353},
-        { -0.449332832327,  0.882270011260,  0.140355381171,  0.006991087353},
-        {  0.449332832327, -0.882270011260,  0.140355381171,  0.006991087353},
-        { -0.449332832327, -0.882270011260,  0.140355381171,  0.006991087353},
-        {  0.449332832327,  0.882270011260, -0.140355381171,  0.006991087353},
-        { -0.449332832327,  0.882270011260, -0.140355381171,  0.006991087353},
-        {  0.449332832327, -0.882270011260, -0.140355381171,  0.006991087353},
-        { -0.449332832327, -0.882270011260, -0.140355381171,  0.006991087353},
-        {  0.882270011260,  0.140355381171,  0.449332832327,  0.006991087353},
-        { -0.882270011260,  0.140355381171,  0.449332832327,  0.006991087353},
-        {  0.882270011260, -0.140355381171,  0.449332832327,  0.006991087353},
-        { -0.882270011260, -0.140355381171,  0.449332832327,  0.006991087353},
-        {  0.882270011260,  0.140355381171, -0.449332832327,  0.006991087353},
-        { -0.882270011260,  0.140355381171, -0.449332832327,  0.006991087353},
-        {  0.882270011260, -0.140355381171, -0.449332832327,  0.006991087353},
-        { -0.882270011260, -0.140355381171, -0.449332832327,  0.006991087353},
-        {  0.882270011260,  0.449332832327,  0.140355381171,  0.006991087353},
-        { -0.882270011260,  0.449332832327,  0.140355381171,  0.006991087353},
-        {  0.882270011260, -0.449332832327,  0.140355381171,  0.006991087353},
-        { -0.882270011260, -0.449332832327,  0.140355381171,  0.006991087353},
-        {  0.882270011260,  0.449332832327, -0.140355381171,  0.006991087353},
-        { -0.882270011260,  0.449332832327, -0.140355381171,  0.006991087353},
-        {  0.882270011260, -0.449332832327, -0.140355381171,  0.006991087353},
-        { -0.882270011260, -0.449332832327, -0.140355381171,  0.006991087353},
-        {  1.000000000000,  0.000000000000,  0.000000000000,  0.005544842902},
-        { -1.000000000000,  0.000000000000,  0.000000000000,  0.005544842902},
-        {  0.000000000000,  1.000000000000,  0.000000000000,  0.005544842902},
-        {  0.000000000000, -1.000000000000,  0.000000000000,  0.005544842902},
-        {  0.000000000000,  0.000000000000,  1.000000000000,  0.005544842902},
-        {  0.000000000000,  0.000000000000, -1.000000000000,  0.005544842902},
-        {  0.000000000000,  0.707106781187,  0.707106781187,  0.006071332771},
-        {  0.000000000000, -0.707106781187,  0.707106781187,  0.006071332771},
-        {  0.000000000000,  0.707106781187, -0.707106781187,  0.006071332771},
-        {  0.000000000000, -0.707106781187, -0.707106781187,  0.006071332771},
-        {  0.707106781187,  0.000000000000,  0.707106781187,  0.006071332771},
-        { -0.707106781187,  0.000000000000,  0.707106781187,  0.006071332771},
-        {  0.707106781187,  0.000000000000, -0.707106781187,  0.006071332771},
-        { -0.707106781187,  0.000000000000, -0.707106781187,  0.006071332771},
-        {  0.707106781187,  0.707106781187,  0.000000000000,  0.006071332771},
-        { -0.707106781187,  0.707106781187,  0.000000000000,  0.006071332771},
-        {  0.707106781187, -0.707106781187,  0.000000000000,  0.006071332771},
-        { -0.707106781187, -0.707106781187,  0.000000000000,  0.006071332771},
-        {  0.577350269190,  0.577350269190,  0.577350269190,  0.006383674774},
-        { -0.577350269190,  0.577350269190,  0.577350269190,  0.006383674774},
-        {  0.577350269190, -0.577350269190,  0.577350269190,  0.006383674774},
-        { -0.577350269190, -0.577350269190,  0.577350269190,  0.006383674774},
-        {  0.577350269190,  0.577350269190, -0.577350269190,  0.006383674774},
-        { -0.577350269190,  0.577350269190, -0.577350269190,  0.006383674774},
-        {  0.577350269190, -0.577350269190, -0.577350269190,  0.006383674774},
-        { -0.577350269190, -0.577350269190, -0.577350269190,  0.006383674774},
-        {  0.255125262111,  0.255125262111,  0.932642590313,  0.005183387588},
-        { -0.255125262111,  0.255125262111,  0.932642590313,  0.005183387588},
-        {  0.255125262111, -0.255125262111,  0.932642590313,  0.005183387588},
-        { -0.255125262111, -0.255125262111,  0.932642590313,  0.005183387588},
-        {  0.255125262111,  0.255125262111, -0.932642590313,  0.005183387588},
-        { -0.255125262111,  0.255125262111, -0.932642590313,  0.005183387588},
-        {  0.255125262111, -0.255125262111, -0.932642590313,  0.005183387588},
-        { -0.255125262111, -0.255125262111, -0.932642590313,  0.005183387588},
-        {  0.255125262111,  0.932642590313,  0.255125262111,  0.005183387588},
-        { -0.255125262111,  0.932642590313,  0.255125262111,  0.005183387588},
-        {  0.255125262111, -0.932642590313,  0.255125262111,  0.005183387588},
-        { -0.255125262111, -0.932642590313,  0.255125262111,  0.005183387588},
-        {  0.255125262111,  0.932642590313, -0.255125262111,  0.005183387588},
-        { -0.255125262111,  0.932642590313, -0.255125262111,  0.005183387588},
-        {  0.255125262111, -0.932642590313, -0.255125262111,  0.005183387588},
-        { -0.255125262111, -0.932642590313, -0.255125262111,  0.005183387588},
-        {  0.932642590313,  0.255125262111,  0.255125262111,  0.005183387588},
-        { -0.932642590313,  0.255125262111,  0.255125262111,  0.005183387588},
-        {  0.932642590313, -0.255125262111,  0.255125262111,  0.005183387588},
-        { -0.932642590313, -0.255125262111,  0.255125262111,  0.005183387588},
-        {  0.932642590313,  0.255125262111, -0.255125262111,  0.005183387588},
-        { -0.932642590313,  0.255125262111, -0.255125262111,  0.005183387588},
-        {  0.932642590313, -0.255125262111, -0.255125262111,  0.005183387588},
-        { -0.932642590313, -0.255125262111, -0.255125262111,  0.005183387588},
-        {  0.674360146036,  0.674360146036,  0.300793595138,  0.006317929010},
-        { -0.674360146036,  0.674360146036,  0.300793595138,  0.006317929010},
-        {  0.674360146036, -0.674360146036,  0.300793595138,  0.006317929010},
-        { -0.674360146036, -0.674360146036,  0.300793595138,  0.006317929010},
-        {  0.674360146036,  0.674360146036, -0.300793595138,  0.006317929010},
-        { -0.674360146036,  0.674360146036, -0.300793595138,  0.006317929010},
-        {  0.674360146036, -0.674360146036, -0.300793595138,  0.006317929010},
-        { -0.674360146036, -0.674360146036, -0.300793595138,  0.006317929010},
-        {  0.674360146036,  0.300793595138,  0.674360146036,  0.006317929010},
-        { -0.674360146036,  0.300793595138,  0.674360146036,  0.006317929010},
-        {  0.674360146036, -0.300793595138,  0.674360146036,  0.006317929010},
-        { -0.674360146036, -0.300793595138,  0.674360146036,  0.006317929010},
-        {  0.674360146036,  0.300793595138, -0.674360146036,  0.006317929010},
-        { -0.674360146036,  0.300793595138, -0.674360146036,  0.006317929010},
-        {  0.674360146036, -0.300793595138, -0.674360146036,  0.006317929010},
-        { -0.674360146036, -0.300793595138, -0.674360146036,  0.006317929010},
-        {  0.300793595138,  0.674360146036,  0.674360146036,  0.006317929010},
-        { -0.300793595138,  0.674360146036,  0.674360146036,  0.006317929010},
-        {  0.300793595138, -0.674360146036,  0.674360146036,  0.006317929010},
-        { -0.300793595138, -0.674360146036,  0.674360146036,  0.006317929010},
-        {  0.300793595138,  0.674360146036, -0.674360146036,  0.006317929010},
-        { -0.300793595138,  0.674360146036, -0.674360146036,  0.006317929010},
-        {  0.300793595138, -0.674360146036, -0.674360146036,  0.006317929010},
-        { -0.300793595138, -0.674360146036, -0.674360146036,  0.006317929010},
-        {  0.431891069672,  0.431891069672,  0.791795559393,  0.006201670007},
-        { -0.431891069672,  0.431891069672,  0.791795559393,  0.006201670007},
-        {  0.431891069672, -0.431891069672,  0.791795559393,  0.006201670007},
-        { -0.431891069672, -0.431891069672,  0.791795559393,  0.006201670007},
-        {  0.431891069672,  0.431891069672, -0.791795559393,  0.006201670007},
-        { -0.431891069672,  0.431891069672, -0.791795559393,  0.006201670007},
-        {  0.431891069672, -0.431891069672, -0.791795559393,  0.006201670007},
-        { -0.431891069672, -0.431891069672, -0.791795559393,  0.006201670007},
-        {  0.431891069672,  0.791795559393,  0.431891069672,  0.006201670007},
-        { -0.431891069672,  0.791795559393,  0.431891069672,  0.006201670007},
-        {  0.431891069672, -0.791795559393,  0.431891069672,  0.006201670007},
-        { -0.431891069672, -0.791795559393,  0.431891069672,  0.006201670007},
-        {  0.431891069672,  0.791795559393, -0.431891069672,  0.006201670007},
-        { -0.431891069672,  0.791795559393, -0.431891069672,  0.006201670007},
-        {  0.431891069672, -0.791795559393, -0.431891069672,  0.006201670007},
-        { -0.431891069672, -0.791795559393, -0.431891069672,  0.006201670007},
-        {  0.791795559393,  0.431891069672,  0.431891069672,  0.006201670007},
-        { -0.791795559393,  0.431891069672,  0.431891069672,  0.006201670007},
-        {  0.791795559393, -0.431891069672,  0.431891069672,  0.006201670007},
-        { -0.791795559393, -0.431891069672,  0.431891069672,  0.006201670007},
-        {  0.791795559393,  0.431891069672, -0.431891069672,  0.006201670007},
-        { -0.791795559393,  0.431891069672, -0.431891069672,  0.006201670007},
-        {  0.791795559393, -0.431891069672, -0.431891069672,  0.006201670007},
-        { -0.791795559393, -0.431891069672, -0.431891069672,  0.006201670007},
-        {  0.261393136034,  0.965232421976,  0.000000000000,  0.005477143385},
-        { -0.261393136034,  0.965232421976,  0.000000000000,  0.005477143385},
-        {  0.261393136034, -0.965232421976,  0.000000000000,  0.005477143385},
-        { -0.261393136034, -0.965232421976,  0.000000000000,  0.005477143385},
-        {  0.965232421976,  0.261393136034,  0.000000000000,  0.005477143385},
-        { -0.965232421976,  0.261393136034,  0.000000000000,  0.005477143385},
-        {  0.965232421976, -0.261393136034,  0.000000000000,  0.005477143385},
-        { -0.965232421976, -0.261393136034,  0.000000000000,  0.005477143385},
-        {  0.261393136034,  0.000000000000,  0.965232421976,  0.005477143385},
-        { -0.261393136034,  0.000000000000,  0.965232421976,  0.005477143385},
-        {  0.261393136034,  0.000000000000, -0.965232421976,  0.005477143385},
-        { -0.261393136034,  0.000000000000, -0.965232421976,  0.005477143385},
-        {  0.965232421976,  0.000000000000,  0.261393136034,  0.005477143385},
-        { -0.965232421976,  0.000000000000,  0.261393136034,  0.005477143385},
-        {  0.965232421976,  0.000000000000, -0.261393136034,  0.005477143385},
-        { -0.965232421976,  0.000000000000, -0.261393136034,  0.005477143385},
-        {  0.000000000000,  0.261393136034,  0.965232421976,  0.005477143385},
-        {  0.000000000000, -0.261393136034,  0.965232421976,  0.005477143385},
-        {  0.000000000000,  0.261393136034, -0.965232421976,  0.005477143385},
-        {  0.000000000000, -0.261393136034, -0.965232421976,  0.005477143385},
-        {  0.000000000000,  0.965232421976,  0.261393136034,  0.005477143385},
-        {  0.000000000000, -0.965232421976,  0.261393136034,  0.005477143385},
-        {  0.000000000000,  0.965232421976, -0.261393136034,  0.005477143385},
-        {  0.000000000000, -0.965232421976, -0.261393136034,  0.005477143385},
-        {  0.499045316180,  0.144663074433,  0.854415804685,  0.005968383988},
-        { -0.499045316180,  0.144663074433,  0.854415804685,  0.005968383988},
-        {  0.499045316180, -0.144663074433,  0.854415804685,  0.005968383988},
-        { -0.499045316180, -0.144663074433,  0.854415804685,  0.005968383988},
-        {  0.499045316180,  0.144663074433, -0.854415804685,  0.005968383988},
-        { -0.499045316180,  0.144663074433, -0.854415804685,  0.005968383988},
-        {  0.499045316180, -0.144663074433, -0.854415804685,  0.005968383988},
-        { -0.499045316180, -0.144663074433, -0.854415804685,  0.005968383988},
-        {  0.499045316180,  0.854415804685,  0.144663074433,  0.005968383988},
-        { -0.499045316180,  0.854415804685,  0.144663074433,  0.005968383988},
-        {  0.499045316180, -0.854415804685,  0.144663074433,  0.005968383988},
-        { -0.499045316180, -0.854415804685,  0.144663074433,  0.005968383988},
-        {  0.499045316180,  0.854415804685, -0.144663074433,  0.005968383988},
-        { -0.499045316180,  0.854415804685, -0.144663074433,  0.005968383988},
-        {  0.499045316180, -0.854415804685, -0.144663074433,  0.005968383988},
-        { -0.499045316180, -0.854415804685, -0.144663074433,  0.005968383988},
-        {  0.144663074433,  0.499045316180,  0.854415804685,  0.005968383988},
-        { -0.144663074433,  0.499045316180,  0.854415804685,  0.005968383988},
-        {  0.144663074433, -0.499045316180,  0.854415804685,  0.005968383988},
-        { -0.144663074433, -0.499045316180,  0.854415804685,  0.005968383988},
-        {  0.144663074433,  0.499045316180, -0.854415804685,  0.005968383988},
-        { -0.144663074433,  0.499045316180, -0.854415804685,  0.005968383988},
-        {  0.144663074433, -0.499045316180, -0.854415804685,  0.005968383988},
-        { -0.144663074433, -0.499045316180, -0.854415804685,  0.005968383988},
-        {  0.144663074433,  0.854415804685,  0.499045316180,  0.005968383988},
-        { -0.144663074433,  0.854415804685,  0.499045316180,  0.005968383988},
-        {  0.144663074433, -0.854415804685,  0.499045316180,  0.005968383988},
-        { -0.144663074433, -0.854415804685,  0.499045316180,  0.005968383988},
-        {  0.144663074433,  0.854415804685, -0.499045316180,  0.005968383988},
-        { -0.144663074433,  0.854415804685, -0.499045316180,  0.005968383988},
-        {  0.144663074433, -0.854415804685, -0.499045316180,  0.005968383988},
-        { -0.144663074433, -0.854415804685, -0.499045316180,  0.005968383988},
-        {  0.854415804685,  0.499045316180,  0.144663074433,  0.005968383988},
-        { -0.854415804685,  0.499045316180,  0.144663074433,  0.005968383988},
-        {  0.854415804685, -0.499045316180,  0.144663074433,  0.005968383988},
-        { -0.854415804685, -0.499045316180,  0.144663074433,  0.005968383988},
-        {  0.854415804685,  0.499045316180, -0.144663074433,  0.005968383988},
-        { -0.854415804685,  0.499045316180, -0.144663074433,  0.005968383988},
-        {  0.854415804685, -0.499045316180, -0.144663074433,  0.005968383988},
-        { -0.854415804685, -0.499045316180, -0.144663074433,  0.005968383988},
-        {  0.854415804685,  0.144663074433,  0.499045316180,  0.005968383988},
-        { -0.854415804685,  0.144663074433,  0.499045316180,  0.005968383988},
-        {  0.854415804685, -0.144663074433,  0.499045316180,  0.005968383988},
-        { -0.854415804685, -0.144663074433,  0.499045316180,  0.005968383988},
-        {  0.854415804685,  0.144663074433, -0.499045316180,  0.005968383988},
-        { -0.854415804685,  0.144663074433, -0.499045316180,  0.005968383988},
-        {  0.854415804685, -0.144663074433, -0.499045316180,  0.005968383988},
-        { -0.854415804685, -0.144663074433, -0.499045316180,  0.005968383988},
-        {  1.000000000000,  0.000000000000,  0.000000000000,  0.001782340447},
-        { -1.000000000000,  0.000000000000,  0.000000000000,  0.001782340447},
-        {  0.000000000000,  1.000000000000,  0.000000000000,  0.001782340447},
-        {  0.000000000000, -1.000000000000,  0.000000000000,  0.001782340447},
-        {  0.000000000000,  0.000000000000,  1.000000000000,  0.001782340447},
-        {  0.000000000000,  0.000000000000, -1.000000000000,  0.001782340447},
-        {  0.000000000000,  0.707106781187,  0.707106781187,  0.005716905950},
-        {  0.000000000000, -0.707106781187,  0.707106781187,  0.005716905950},
-        {  0.000000000000,  0.707106781187, -0.707106781187,  0.005716905950},
-        {  0.000000000000, -0.707106781187, -0.707106781187,  0.005716905950},
-        {  0.707106781187,  0.000000000000,  0.707106781187,  0.005716905950},
-        { -0.707106781187,  0.000000000000,  0.707106781187,  0.005716905950},
-        {  0.707106781187,  0.000000000000, -0.707106781187,  0.005716905950},
-        { -0.707106781187,  0.000000000000, -0.707106781187,  0.005716905950},
-        {  0.707106781187,  0.707106781187,  0.000000000000,  0.005716905950},
-        { -0.707106781187,  0.707106781187,  0.000000000000,  0.005716905950},
-        {  0.707106781187, -0.707106781187,  0.000000000000,  0.005716905950},
-        { -0.707106781187, -0.707106781187,  0.000000000000,  0.005716905950},
-        {  0.577350269190,  0.577350269190,  0.577350269190,  0.005573383179},
-        { -0.577350269190,  0.577350269190,  0.577350269190,  0.005573383179},
-        {  0.577350269190, -0.577350269190,  0.577350269190,  0.005573383179},
-        { -0.577350269190, -0.577350269190,  0.577350269190,  0.005573383179},
-        {  0.577350269190,  0.577350269190, -0.577350269190,  0.005573383179},
-        { -0.577350269190,  0.577350269190, -0.577350269190,  0.005573383179},
-        {  0.577350269190, -0.577350269190, -0.577350269190,  0.005573383179},
-        { -0.577350269190, -0.577350269190, -0.577350269190,  0.005573383179},
-        {  0.671297344270,  0.671297344270,  0.314196994183,  0.005608704083},
-        { -0.671297344270,  0.671297344270,  0.314196994183,  0.005608704083},
-        {  0.671297344270, -0.671297344270,  0.314196994183,  0.005608704083},
-        { -0.671297344270, -0.671297344270,  0.314196994183,  0.005608704083},
-        {  0.671297344270,  0.671297344270, -0.314196994183,  0.005608704083},
-        { -0.671297344270,  0.671297344270, -0.314196994183,  0.005608704083},
-        {  0.671297344270, -0.671297344270, -0.314196994183,  0.005608704083},
-        { -0.671297344270, -0.671297344270, -0.314196994183,  0.005608704083},
-        {  0.671297344270,  0.314196994183,  0.671297344270,  0.005608704083},
-        { -0.671297344270,  0.314196994183,  0.671297344270,  0.005608704083},
-        {  0.671297344270, -0.314196994183,  0.671297344270,  0.005608704083},
-        { -0.671297344270, -0.314196994183,  0.671297344270,  0.005608704083},
-        {  0.671297344270,  0.314196994183, -0.671297344270,  0.005608704083},
-        { -0.671297344270,  0.314196994183, -0.671297344270,  0.005608704083},
-        {  0.671297344270, -0.314196994183, -0.671297344270,  0.005608704083},
-        { -0.671297344270, -0.314196994183, -0.671297344270,  0.005608704083},
-        {  0.314196994183,  0.671297344270,  0.671297344270,  0.005608704083},
-        { -0.314196994183,  0.671297344270,  0.671297344270,  0.005608704083},
-        {  0.314196994183, -0.671297344270,  0.671297344270,  0.005608704083},
-        { -0.314196994183, -0.671297344270,  0.671297344270,  0.005608704083},
-        {  0.314196994183,  0.671297344270, -0.671297344270,  0.005608704083},
-        { -0.314196994183,  0.671297344270, -0.671297344270,  0.005608704083},
-        {  0.314196994183, -0.671297344270, -0.671297344270,  0.005608704083},
-        { -0.314196994183, -0.671297344270, -0.671297344270,  0.005608704083},
-        {  0.289246562758,  0.289246562758,  0.912509096867,  0.005158237712},
-        { -0.289246562758,  0.289246562758,  0.912509096867,  0.005158237712},
-        {  0.289246562758, -0.289246562758,  0.912509096867,  0.005158237712},
-        { -0.289246562758, -0.289246562758,  0.912509096867,  0.005158237712},
-        {  0.289246562758,  0.289246562758, -0.912509096867,  0.005158237712},
-        { -0.289246562758,  0.289246562758, -0.912509096867,  0.005158237712},
-        {  0.289246562758, -0.289246562758, -0.912509096867,  0.005158237712},
-        { -0.289246562758, -0.289246562758, -0.912509096867,  0.005158237712},
-        {  0.289246562758,  0.912509096867,  0.289246562758,  0.005158237712},
-        { -0.289246562758,  0.912509096867,  0.289246562758,  0.005158237712},
-        {  0.289246562758, -0.912509096867,  0.289246562758,  0.005158237712},
-        { -0.289246562758, -0.912509096867,  0.289246562758,  0.005158237712},
-        {  0.289246562758,  0.912509096867, -0.289246562758,  0.005158237712},
-        { -0.289246562758,  0.912509096867, -0.289246562758,  0.005158237712},
-        {  0.289246562758, -0.912509096867, -0.289246562758,  0.005158237712},
-        { -0.289246562758, -0.912509096867, -0.289246562758,  0.005158237712},
-        {  0.912509096867,  0.289246562758,  0.289246562758,  0.005158237712},
-        { -0.912509096867,  0.289246562758,  0.289246562758,  0.005158237712},
-        {  0.912509096867, -0.289246562758,  0.289246562758,  0.005158237712},
-        { -0.912509096867, -0.289246562758,  0.289246562758,  0.005158237712},
-        {  0.912509096867,  0.289246562758, -0.289246562758,  0.005158237712},
-        { -0.912509096867,  0.289246562758, -0.289246562758,  0.005158237712},
-        {  0.912509096867, -0.289246562758, -0.289246562758,  0.005158237712},
-        { -0.912509096867, -0.289246562758, -0.289246562758,  0.005158237712},
-        {  0.444693317872,  0.444693317872,  0.777493219315,  0.005518771467},
-        { -0.444693317872,  0.444693317872,  0.777493219315,  0.005518771467},
-        {  0.444693317872, -0.444693317872,  0.777493219315,  0.005518771467},
-        { -0.444693317872, -0.444693317872,  0.777493219315,  0.005518771467},
-        {  0.444693317872,  0.444693317872, -0.777493219315,  0.005518771467},
-        { -0.444693317872,  0.444693317872, -0.777493219315,  0.005518771467},
-        {  0.444693317872, -0.444693317872, -0.777493219315,  0.005518771467},
-        { -0.444693317872, -0.444693317872, -0.777493219315,  0.005518771467},
-        {  0.444693317872,  0.777493219315,  0.444693317872,  0.005518771467},
-        { -0.444693317872,  0.777493219315,  0.444693317872,  0.005518771467},
-        {  0.444693317872, -0.777493219315,  0.444693317872,  0.005518771467},
-        { -0.444693317872, -0.777493219315,  0.444693317872,  0.005518771467},
-        {  0.444693317872,  0.777493219315, -0.444693317872,  0.005518771467},
-        { -0.444693317872,  0.777493219315, -0.444693317872,  0.005518771467},
-        {  0.444693317872, -0.777493219315, -0.444693317872,  0.005518771467},
-        { -0.444693317872, -0.777493219315, -0.444693317872,  0.005518771467},
-        {  0.777493219315,  0.444693317872,  0.444693317872,  0.005518771467},
-        { -0.777493219315,  0.444693317872,  0.444693317872,  0.005518771467},
-        {  0.777493219315, -0.444693317872,  0.444693317872,  0.005518771467},
-        { -0.777493219315, -0.444693317872,  0.444693317872,  0.005518771467},
-        {  0.777493219315,  0.444693317872, -0.444693317872,  0.005518771467},
-        { -0.777493219315,  0.444693317872, -0.444693317872,  0.005518771467},
-        {  0.777493219315, -0.444693317872, -0.444693317872,  0.005518771467},
-        { -0.777493219315, -0.444693317872, -0.444693317872,  0.005518771467},
-        {  0.129933544765,  0.129933544765,  0.982972302707,  0.004106777028},
-        { -0.129933544765,  0.129933544765,  0.982972302707,  0.004106777028},
-        {  0.129933544765, -0.129933544765,  0.982972302707,  0.004106777028},
-        { -0.129933544765, -0.129933544765,  0.982972302707,  0.004106777028},
-        {  0.129933544765,  0.129933544765, -0.982972302707,  0.004106777028},
-        { -0.129933544765,  0.129933544765, -0.982972302707,  0.004106777028},
-        {  0.129933544765, -0.129933544765, -0.982972302707,  0.004106777028},
-        { -0.129933544765, -0.129933544765, -0.982972302707,  0.004106777028},
-        {  0.129933544765,  0.982972302707,  0.129933544765,  0.004106777028},
-        { -0.129933544765,  0.982972302707,  0.129933544765,  0.004106777028},
-        {  0.129933544765, -0.982972302707,  0.129933544765,  0.004106777028},
-        { -0.129933544765, -0.982972302707,  0.129933544765,  0.004106777028},
-        {  0.129933544765,  0.982972302707, -0.129933544765,  0.004106777028},
-        { -0.129933544765,  0.982972302707, -0.129933544765,  0.004106777028},
-        {  0.129933544765, -0.982972302707, -0.129933544765,  0.004106777028},
-        { -0.129933544765, -0.982972302707, -0.129933544765,  0.004106777028},
-        {  0.982972302707,  0.129933544765,  0.129933544765,  0.004106777028},
-        { -0.982972302707,  0.129933544765,  0.129933544765,  0.004106777028},
-        {  0.982972302707, -0.129933544765,  0.129933544765,  0.004106777028},
-        { -0.982972302707, -0.129933544765,  0.129933544765,  0.004106777028},
-        {  0.982972302707,  0.129933544765, -0.129933544765,  0.004106777028},
-        { -0.982972302707,  0.129933544765, -0.129933544765,  0.004106777028},
-        {  0.982972302707, -0.129933544765, -0.129933544765,  0.004106777028},
-        { -0.982972302707, -0.129933544765, -0.129933544765,  0.004106777028},
-        {  0.345770219761,  0.938319218138,  0.000000000000,  0.005051846065},
-        { -0.345770219761,  0.938319218138,  0.000000000000,  0.005051846065},
-        {  0.345770219761, -0.938319218138,  0.000000000000,  0.005051846065},
-        { -0.345770219761, -0.938319218138,  0.000000000000,  0.005051846065},
-        {  0.938319218138,  0.345770219761,  0.000000000000,  0.005051846065},
-        { -0.938319218138,  0.345770219761,  0.000000000000,  0.005051846065},
-        {  0.938319218138, -0.345770219761,  0.000000000000,  0.005051846065},
-        { -0.938319218138, -0.345770219761,  0.000000000000,  0.005051846065},
-        {  0.345770219761,  0.000000000000,  0.938319218138,  0.005051846065},
-        { -0.345770219761,  0.000000000000,  0.938319218138,  0.005051846065},
-        {  0.345770219761,  0.000000000000, -0.938319218138,  0.005051846065},
-        { -0.345770219761,  0.000000000000, -0.938319218138,  0.005051846065},
-        {  0.938319218138,  0.000000000000,  0.345770219761,  0.005051846065},
-        { -0.938319218138,  0.000000000000,  0.345770219761,  0.005051846065},
-        {  0.938319218138,  0.000000000000, -0.345770219761,  0.005051846065},
-        { -0.938319218138,  0.000000000000, -0.345770219761,  0.005051846065},
-        {  0.000000000000,  0.345770219761,  0.938319218138,  0.005051846065},
-        {  0.000000000000, -0.345770219761,  0.938319218138,  0.005051846065},
-        {  0.000000000000,  0.345770219761, -0.938319218138,  0.005051846065},
-        {  0.000000000000, -0.345770219761, -0.938319218138,  0.005051846065},
-        {  0.000000000000,  0.938319218138,  0.345770219761,  0.005051846065},
-        {  0.000000000000, -0.938319218138,  0.345770219761,  0.005051846065},
-        {  0.000000000000,  0.938319218138, -0.345770219761,  0.005051846065},
-        {  0.000000000000, -0.938319218138, -0.345770219761,  0.005051846065},
-        {  0.159041710538,  0.836036015482,  0.525118572444,  0.005530248916},
-        { -0.159041710538,  0.836036015482,  0.525118572444,  0.005530248916},
-        {  0.159041710538, -0.836036015482,  0.525118572444,  0.005530248916},
-        { -0.159041710538, -0.836036015482,  0.525118572444,  0.005530248916},
-        {  0.159041710538,  0.836036015482, -0.525118572444,  0.005530248916},
-        { -0.159041710538,  0.836036015482, -0.525118572444,  0.005530248916},
-        {  0.159041710538, -0.836036015482, -0.525118572444,  0.005530248916},
-        { -0.159041710538, -0.836036015482, -0.525118572444,  0.005530248916},
-        {  0.159041710538,  0.525118572444,  0.836036015482,  0.005530248916},
-        { -0.159041710538,  0.525118572444,  0.836036015482,  0.005530248916},
-        {  0.159041710538, -0.525118572444,  0.836036015482,  0.005530248916},
-        { -0.159041710538, -0.525118572444,  0.836036015482,  0.005530248916},
-        {  0.159041710538,  0.525118572444, -0.836036015482,  0.005530248916},
-        { -0.159041710538,  0.525118572444, -0.836036015482,  0.005530248916},
-        {  0.159041710538, -0.525118572444, -0.836036015482,  0.005530248916},
-        { -0.159041710538, -0.525118572444, -0.836036015482,  0.005530248916},
-        {  0.836036015482,  0.159041710538,  0.525118572444,  0.005530248916},
-        { -0.836036015482,  0.159041710538,  0.525118572444,  0.005530248916},
-        {  0.836036015482, -0.159041710538,  0.525118572444,  0.005530248916},
-        { -0.836036015482, -0.159041710538,  0.525118572444,  0.005530248916},
-        {  0.836036015482,  0.159041710538, -0.525118572444,  0.005530248916},
-        { -0.836036015482,  0.159041710538, -0.525118572444,  0.005530248916},
-        {  0.836036015482, -0.159041710538, -0.525118572444,  0.005530248916},
-        { -0.836036015482, -0.159041710538, -0.525118572444,  0.005530248916},
-        {  0.836036015482,  0.525118572444,  0.159041710538,  0.005530248916},
-        { -0.836036015482,  0.525118572444,  0.159041710538,  0.005530248916},
-        {  0.836036015482, -0.525118572444,  0.159041710538,  0.005530248916},
-        { -0.836036015482, -0.525118572444,  0.159041710538,  0.005530248916},
-        {  0.836036015482,  0.525118572444, -0.159041710538,  0.005530248916},
-        { -0.836036015482,  0.525118572444, -0.159041710538,  0.005530248916},
-        {  0.836036015482, -0.525118572444, -0.159041710538,  0.005530248916},
-        { -0.836036015482, -0.525118572444, -0.159041710538,  0.005530248916},
-        {  0.525118572444,  0.159041710538,  0.836036015482,  0.005530248916},
-        { -0.525118572444,  0.159041710538,  0.836036015482,  0.005530248916},
-        {  0.525118572444, -0.159041710538,  0.836036015482,  0.005530248916},
-        { -0.525118572444, -0.159041710538,  0.836036015482,  0.005530248916},
-        {  0.525118572444,  0.159041710538, -0.836036015482,  0.005530248916},
-        { -0.525118572444,  0.159041710538, -0.836036015482,  0.005530248916},
-        {  0.525118572444, -0.159041710538, -0.836036015482,  0.005530248916},
-        { -0.525118572444, -0.159041710538, -0.836036015482,  0.005530248916},
-        {  0.525118572444,  0.836036015482,  0.159041710538,  0.005530248916},
-        { -0.525118572444,  0.836036015482,  0.159041710538,  0.005530248916},
-        {  0.525118572444, -0.836036015482,  0.159041710538,  0.005530248916},
-        { -0.525118572444, -0.836036015482,  0.159041710538,  0.005530248916},
-        {  0.525118572444,  0.836036015482, -0.159041710538,  0.005530248916},
-        { -0.525118572444,  0.836036015482, -0.159041710538,  0.005530248916},
-        {  0.525118572444, -0.836036015482, -0.159041710538,  0.005530248916},
-        { -0.525118572444, -0.836036015482, -0.159041710538,  0.005530248916}
+    /*
+     * Generators of the Lebedev grids, taken from the tables of
+     * V.I. Lebedev and D.N. Laikov, "A quadrature formula for the sphere of
+     * the 131st algebraic order of accuracy", Doklady Mathematics 59 (1999)
+     * 477-481. The full grids are expanded from these at compile time (see
+     * quadrature.cpp).
+     */
+    static constexpr LebedevGenerator lebedev_generators[num_lebedev_generators_total] = {
+        // 6 points
+        {1,                    0.0,                    0.0,     0.1666666666666667},
+        // 14 points
+        {1,                    0.0,                    0.0,    0.06666666666666667},
+        {3,                    0.0,                    0.0,                  0.075},
+        // 26 points
+        {1,                    0.0,                    0.0,    0.04761904761904762},
+        {2,                    0.0,                    0.0,     0.0380952380952381},
+        {3,                    0.0,                    0.0,    0.03214285714285714},
+        // 38 points
+        {1,                    0.0,                    0.0,   0.009523809523809525},
+        {3,                    0.0,                    0.0,    0.03214285714285714},
+        {5,     0.4597008433809831,                    0.0,    0.02857142857142857},
+        // 50 points
+        {1,                    0.0,                    0.0,     0.0126984126984127},
+        {2,                    0.0,                    0.0,    0.02257495590828924},
+        {3,                    0.0,                    0.0,             0.02109375},
+        {4,     0.3015113445777636,                    0.0,    0.02017333553791887},
+        // 74 points
+        {1,                    0.0,                    0.0,  0.0005130671797338464},
+        {2,                    0.0,                    0.0,    0.01660406956574204},
+        {3,                    0.0,                    0.0,   -0.02958603896103896},
+        {4,     0.4803844614152614,                    0.0,    0.02657620708215946},
+        {5,     0.3207726489807764,                    0.0,    0.01652217099371571},
+        // 86 points
+        {1,                    0.0,                    0.0,    0.01154401154401154},
+        {3,                    0.0,                    0.0,    0.01194390908585628},
+        {4,     0.3696028464541502,                    0.0,     0.0111105557106034},
+        {4,     0.6943540066026664,                    0.0,    0.01187650129453714},
+        {5,     0.3742430390903412,                    0.0,    0.01181230374690448},
+        // 110 points
+        {1,                    0.0,                    0.0,   0.003828270494937162},
+        {3,                    0.0,                    0.0,   0.009793737512487513},
+        {4,     0.1851156353447362,                    0.0,   0.008211737283191111},
+        {4,     0.6904210483822922,                    0.0,   0.009942814891178103},
+        {4,     0.3956894730559419,                    0.0,   0.009595471336070962},
+        {5,     0.4783690288121502,                    0.0,   0.009694996361663029},
+        // 146 points
+        {1,                    0.0,                    0.0,  0.0005996313688621381},
+        {2,                    0.0,                    0.0,   0.007372999718620756},
+        {3,                    0.0,                    0.0,   0.007210515360144488},
+        {4,     0.6764410400114264,                    0.0,   0.007116355493117555},
+        {4,     0.4174961227965453,                    0.0,   0.006753829486314477},
+        {4,     0.1574676672039082,                    0.0,   0.007574394159054034},
+        {6,     0.1403553811713183,     0.4493328323269557,   0.006991087353303262},
+        // 170 points
+        {1,                    0.0,                    0.0,   0.005544842902037365},
+        {2,                    0.0,                    0.0,   0.006071332770670752},
+        {3,                    0.0,                    0.0,   0.006383674773515093},
+        {4,     0.2551252621114134,                    0.0,    0.00518338758774779},
+        {4,     0.6743601460362766,                    0.0,   0.006317929009813725},
+        {4,      0.431891069671941,                    0.0,   0.006201670006589077},
+        {5,     0.2613931360335988,                    0.0,   0.005477143385137348},
+        {6,     0.4990453161796037,     0.1446630744325115,   0.005968383987681156},
+        // 194 points
+        {1,                    0.0,                    0.0,   0.001782340447244611},
+        {2,                    0.0,                    0.0,   0.005716905949977102},
+        {3,                    0.0,                    0.0,   0.005573383178848738},
+        {4,     0.6712973442695226,                    0.0,   0.005608704082587997},
+        {4,     0.2892465627575439,                    0.0,   0.005158237711805383},
+        {4,     0.4446933178717437,                    0.0,   0.005518771467273614},
+        {4,     0.1299335447650067,                    0.0,   0.004106777028169394},
+        {5,     0.3457702197611283,                    0.0,   0.005051846064614808},
+        {6,      0.159041710538353,     0.8360360154824589,   0.005530248916233094},
+        // 230 points
+        {1,                    0.0,                    0.0,   -0.05522639919727325},
+        {3,                    0.0,                    0.0,   0.004450274607445226},
+        {4,     0.4492044687397611,                    0.0,   0.004496841067921404},
+        {4,     0.2520419490210201,                    0.0,    0.00504915345047875},
+        {4,     0.6981906658447242,                    0.0,   0.003976408018051883},
+        {4,      0.658740524346096,                    0.0,   0.004401400650381014},
+        {4,     0.0403854405009766,                    0.0,    0.01724544350544401},
+        {5,     0.5823842309715584,                    0.0,   0.004231083095357343},
+        {5,     0.3545877390518688,                    0.0,   0.005198069864064399},
+        {6,     0.2272181808998187,     0.4864661535886647,   0.004695720972568883},
+        // 266 points
+        {1,                    0.0,                    0.0,  -0.001313769127326952},
+        {2,                    0.0,                    0.0,  -0.002522728704859336},
+        {3,                    0.0,                    0.0,   0.004186853881700583},
+        {4,     0.7039373391585475,                    0.0,   0.005315167977810885},
+        {4,     0.1012526248572414,                    0.0,   0.004047142377086219},
+        {4,     0.4647448726420539,                    0.0,    0.00411248239440699},
+        {4,     0.3277420654971629,                    0.0,   0.003595584899758782},
+        {4,     0.6620338663699974,                    0.0,   0.004256131351428158},
+        {5,     0.8506508083520399,                    0.0,    0.00422958270064724},
+        {6,     0.3233484542692899,     0.1153112011009701,   0.004080914225780505},
+        {6,     0.2314790158712601,     0.5244939240922365,   0.004071467593830964},
+        // 302 points
+        {1,                    0.0,                    0.0,  0.0008545911725128148},
+        {3,                    0.0,                    0.0,   0.003599119285025571},
+        {4,     0.3515640345570105,                    0.0,   0.003449788424305883},
+        {4,     0.6566329410219612,                    0.0,   0.003604822601419882},
+        {4,     0.4729054132581005,                    0.0,   0.003576729661743367},
+        {4,    0.09618308522614784,                    0.0,   0.002352101413689164},
+        {4,     0.2219645236294178,                    0.0,   0.003108953122413675},
+        {4,     0.7011766416089545,                    0.0,   0.003650045807677255},
+        {5,     0.2644152887060663,                    0.0,   0.002982344963171804},
+        {5,     0.5718955891878961,                    0.0,    0.00360082093221646},
+        {6,     0.2510034751770465,     0.8000727494073951,   0.003571540554273387},
+        {6,     0.1233548532583327,     0.4127724083168531,    0.00339231220500617},
+        // 350 points
+        {1,                    0.0,                    0.0,   0.003006796749453936},
+        {3,                    0.0,                    0.0,   0.003050627745650771},
+        {4,     0.7068965463912316,                    0.0,   0.001621104600288991},
+        {4,     0.4794682625712025,                    0.0,   0.003005701484901752},
+        {4,     0.1927533154878019,                    0.0,   0.002990992529653774},
+        {4,     0.6930357961327123,                    0.0,   0.002982170644107595},
+        {4,     0.3608302115520091,                    0.0,   0.002721564237310992},
+        {4,     0.6498486161496169,                    0.0,   0.003033513795811141},
+        {5,     0.1932945013230339,                    0.0,   0.003007949555218533},
+        {5,     0.3800494919899303,                    0.0,   0.002881964603055307},
+        {6,     0.2899558825499574,     0.7934537856582315,   0.002958357626535696},
+        {6,    0.09684121455103957,     0.8280801506686862,   0.003036020026407088},
+        {6,     0.1833434647041659,     0.9074658265305127,   0.002832187403926303},
+        // 434 points
+        {1,                    0.0,                    0.0,  0.0005265897968224436},
+        {2,                    0.0,                    0.0,   0.002548219972002607},
+        {3,                    0.0,                    0.0,   0.002512317418927307},
+        {4,     0.6909346307509111,                    0.0,   0.002530403801186355},
+        {4,     0.1774836054609158,                    0.0,   0.002014279020918528},
+        {4,     0.4914342637784746,                    0.0,   0.002501725168402936},
+        {4,     0.6456664707424256,                    0.0,   0.002513267174597564},
+        {4,     0.2861289010307638,                    0.0,   0.002302694782227416},
+        {4,    0.07568084367178018,                    0.0,   0.001462495621594614},
+        {4,     0.3927259763368002,                    0.0,    0.00244537343731298},
+        {5,     0.8818132877794288,                    0.0,   0.002417442375638981},
+        {5,     0.9776428111182649,                    0.0,   0.001910951282179532},
+        {6,     0.2054823696403044,     0.8689460322872412,   0.002416930044324775},
+        {6,     0.5905157048925271,     0.7999278543857286,   0.002512236854563495},
+        {6,     0.5550152361076807,     0.7717462626915901,   0.002496644054553086},
+        {6,     0.9371809858553722,     0.3344363145343455,   0.002236607760437849},
+        // 590 points
+        {1,                    0.0,                    0.0,  0.0003095121295306187},
+        {3,                    0.0,                    0.0,   0.001852379698597489},
+        {4,     0.7040954938227469,                    0.0,   0.001871790639277744},
+        {4,     0.6807744066455244,                    0.0,   0.001858812585438317},
+        {4,     0.6372546939258752,                    0.0,   0.001852028828296213},
+        {4,     0.5044419707800358,                    0.0,   0.001846715956151242},
+        {4,     0.4215761784010967,                    0.0,   0.001818471778162769},
+        {4,     0.3317920736472123,                    0.0,   0.001749564657281154},
+        {4,     0.2384736701421887,                    0.0,   0.001617210647254411},
+        {4,     0.1459036449157763,                    0.0,   0.001384737234851692},
+        {4,    0.06095034115507196,                    0.0,   0.000976433116505105},
+        {5,     0.6116843442009876,                    0.0,   0.001857161196774078},
+        {5,     0.3964755348199858,                    0.0,   0.001705153996395864},
+        {5,     0.1724782009907724,                    0.0,   0.001300321685886048},
+        {6,      0.561026380862206,     0.3518280927733519,   0.001842866472905286},
+        {6,      0.474239284255198,      0.263471665593795,   0.001802658934377451},
+        {6,      0.598412649788538,     0.1816640840360209,    0.00184983056044366},
+        {6,     0.3791035407695563,     0.1720795225656878,   0.001713904507106709},
+        {6,     0.2778673190586244,    0.08213021581932511,   0.001555213603396808},
+        {6,     0.5033564271075117,    0.08999205842074876,   0.001802239128008525},
+        // 770 points
+        {1,                    0.0,                    0.0,  0.0002192942088181184},
+        {2,                    0.0,                    0.0,    0.00143643361731908},
+        {3,                    0.0,                    0.0,   0.001421940344335877},
+        {4,     0.0508720441050236,                    0.0,  0.0006798123511050502},
+        {4,     0.1228198790178831,                    0.0,  0.0009913184235294911},
+        {4,     0.2026890814408786,                    0.0,   0.001180207833238949},
+        {4,     0.2847745156464294,                    0.0,   0.001296599602080921},
+        {4,     0.3656719078978026,                    0.0,   0.001365871427428316},
+        {4,     0.4428264886713469,                    0.0,   0.001402988604775325},
+        {4,     0.5140619627249735,                    0.0,   0.001418645563595609},
+        {4,     0.6306401219166803,                    0.0,   0.001421376741851662},
+        {4,     0.6716883332022612,                    0.0,   0.001423996475490962},
+        {4,     0.6979792685336881,                    0.0,   0.001431554042178567},
+        {5,     0.1446865674195309,                    0.0,  0.0009254401499865368},
+        {5,     0.3390263475411216,                    0.0,   0.001250239995053509},
+        {5,     0.5335804651263506,                    0.0,    0.00139436584332923},
+        {6,    0.06944024393349413,     0.2355187894242326,   0.001127089094671749},
+        {6,      0.226900410952946,      0.410218247404573,    0.00134575376091067},
+        {6,    0.08025574607775339,     0.6214302417481605,   0.001424957283316783},
+        {6,     0.1467999527896572,     0.3245284345717394,    0.00126152334123775},
+        {6,     0.1571507769824727,      0.522448218969663,   0.001392547106052696},
+        {6,     0.2365702993157246,     0.6017546634089558,   0.001418761677877656},
+        {6,    0.07714815866765733,     0.4346575516141163,   0.001338366684479554},
+        {6,      0.306293666621073,     0.4908826589037616,   0.001393700862676131},
+        {6,     0.3822477379524787,       0.56487681490995,   0.001415914757466932},
+        // 974 points
+        {1,                    0.0,                    0.0,  0.0001438294190527431},
+        {3,                    0.0,                    0.0,   0.001125772288287004},
+        {4,    0.04292963545341347,                    0.0,  0.0004948029341949241},
+        {4,     0.1051426854086404,                    0.0,   0.000735799010912547},
+        {4,     0.1750024867623087,                    0.0,  0.0008889132771304384},
+        {4,     0.2477653379650257,                    0.0,  0.0009888347838921435},
+        {4,     0.3206567123955957,                    0.0,   0.001053299681709471},
+        {4,     0.3916520749849983,                    0.0,   0.001092778807014578},
+        {4,     0.4590825874187624,                    0.0,   0.001114389394063227},
+        {4,     0.5214563888415861,                    0.0,   0.001123724788051555},
+        {4,     0.6253170244654199,                    0.0,   0.001125239325243814},
+        {4,      0.663792674452317,                    0.0,   0.001126153271815905},
+        {4,     0.6910410398498301,                    0.0,   0.001130286931123841},
+        {4,      0.705290700745776,                    0.0,   0.001134986534363955},
+        {5,      0.123668676265799,                    0.0,  0.0006823367927109931},
+        {5,     0.2940777114468387,                    0.0,  0.0009454158160447096},
+        {5,     0.4697753849207649,                    0.0,   0.001074429975385679},
+        {5,     0.6334563241139567,                    0.0,   0.001129300086569132},
+        {6,    0.05974048614181342,     0.2029128752777523,  0.0008436884500901954},
+        {6,     0.1375760408473636,     0.4602621942484054,   0.001075255720448885},
+        {6,     0.3391016526336286,     0.5030673999662036,   0.001108577236864462},
+        {6,      0.127167519143982,     0.2817606422442134,  0.0009566475323783357},
+        {6,     0.2693120740413512,     0.4331561291720157,   0.001080663250717391},
+        {6,     0.1419786452601918,     0.6256167358580814,   0.001126797131196295},
+        {6,    0.06709284600738255,     0.3798395216859157,   0.001022568715358061},
+        {6,    0.07057738183256172,      0.551750542142352,   0.001108960267713108},
+        {6,     0.2783888477882155,     0.6029619156159187,   0.001122790653435766},
+        {6,     0.1979578938917407,     0.3589606329589096,    0.00103240184711746},
+        {6,     0.2087307061103274,     0.5348666438135476,   0.001107249382283854},
+        {6,     0.4055122137872836,     0.5674997546074373,   0.001121780048519972},
+        // 1202 points
+        {1,                    0.0,                    0.0,  0.0001105189233267572},
+        {2,                    0.0,                    0.0,  0.0009205232738090741},
+        {3,                    0.0,                    0.0,  0.0009133159786443561},
+        {4,    0.03712636449657089,                    0.0,  0.0003690421898017899},
+        {4,    0.09140060412262223,                    0.0,   0.000560399092868066},
+        {4,     0.1531077852469906,                    0.0,  0.0006865297629282609},
+        {4,     0.2180928891660612,                    0.0,   0.000772033855114563},
+        {4,     0.2839874532200175,                    0.0,  0.0008301545958894795},
+        {4,     0.3491177600963764,                    0.0,  0.0008686692550179628},
+        {4,     0.4121431461444309,                    0.0,   0.000892707628584689},
+        {4,     0.4718993627149127,                    0.0,  0.0009060820238568219},
+        {4,     0.5273145452842337,                    0.0,  0.0009119777254940867},
+        {4,     0.6209475332444019,                    0.0,  0.0009128720138604181},
+        {4,     0.6569722711857291,                    0.0,  0.0009130714935691735},
+        {4,     0.6841788309070143,                    0.0,  0.0009152873784554116},
+        {4,     0.7012604330123631,                    0.0,  0.0009187436274321654},
+        {5,     0.1072382215478166,                    0.0,  0.0005176977312965694},
+        {5,     0.2582068959496968,                    0.0,  0.0007331143682101417},
+        {5,     0.4172752955306717,                    0.0,  0.0008463232836379928},
+        {5,     0.5700366911792503,                    0.0,  0.0009031122694253992},
+        {6,     0.9827986018263947,     0.1771774022615325,  0.0006485778453163257},
+        {6,     0.9624249230326228,     0.2475716463426288,  0.0007435030910982369},
+        {6,     0.9402007994128811,     0.3354616289066489,  0.0007998527891839054},
+        {6,     0.9320822040143202,     0.3173615246611977,  0.0008101731497468018},
+        {6,     0.9043674199393299,     0.4090268427085357,   0.000848338957459433},
+        {6,     0.8912407560074747,     0.3854291150669224,  0.0008556299257311812},
+        {6,     0.8676435628462708,     0.4932221184851285,   0.000880320867973826},
+        {6,     0.8581979986041619,     0.4785320675922435,   0.000881104818242572},
+        {6,     0.8396753624049856,     0.4507422593157064,  0.0008850282341265444},
+        {6,     0.8165288564022188,       0.56321230207621,  0.0009021342299040653},
+        {6,     0.8015469370783529,       0.54343035696939,  0.0009010091677105086},
+        {6,      0.777356306907035,     0.5123518486419871,  0.0009022692938426915},
+        {6,     0.7661621213900394,     0.6394279634749102,  0.0009158016174693465},
+        {6,      0.755358414353351,     0.6269805509024392,  0.0009131578003189435},
+        {6,     0.7344305757559503,      0.603116169309631,  0.0009107813579482705},
+        {6,     0.7043837184021765,     0.5693702498468441,  0.0009105760258970126},
+        // 1454 points
+        {1,                    0.0,                    0.0,  7.777160743261247e-05},
+        {3,                    0.0,                    0.0,  0.0007557646413004701},
+        {4,    0.03229290663413854,                    0.0,  0.0002841633806090617},
+        {4,    0.08036733271462222,                    0.0,  0.0004374419127053555},
+        {4,     0.1354289960531653,                    0.0,  0.0005417174740872172},
+        {4,     0.1938963861114426,                    0.0,  0.0006148000891358593},
+        {4,     0.2537343715011275,                    0.0,  0.0006664394485800704},
+        {4,      0.313525143475257,                    0.0,   0.000702503935692322},
+        {4,     0.3721558339375338,                    0.0,  0.0007268511789249627},
+        {4,     0.4286809575195696,                    0.0,  0.0007422637534208629},
+        {4,     0.4822510128282994,                    0.0,  0.0007509545035841214},
+        {4,     0.5320679333566263,                    0.0,  0.0007548535057718401},
+        {4,     0.6172998195394274,                    0.0,  0.0007554088969774001},
+        {4,     0.6510679849127481,                    0.0,  0.0007553147174442808},
+        {4,      0.677731525168736,                    0.0,  0.0007564767653292297},
+        {4,     0.6963109410648741,                    0.0,   0.000758799180851873},
+        {4,     0.7058935009831749,                    0.0,  0.0007608261832033027},
+        {5,     0.9955546194091857,                    0.0,  0.0004021680447874916},
+        {5,     0.9734115901794209,                    0.0,  0.0005804871793945964},
+        {5,     0.9275693732388626,                    0.0,  0.0006792151955945159},
+        {5,     0.8568022422795103,                    0.0,  0.0007336741211286294},
+        {5,     0.7623495553719372,                    0.0,  0.0007581866300989608},
+        {6,     0.5707522908892223,     0.4387028039889501,  0.0007538257859800743},
+        {6,     0.5196463388403083,     0.3858908414762617,  0.0007483517247053123},
+        {6,     0.4646337531215351,     0.3301937372343854,  0.0007371763661112059},
+        {6,     0.4063901697557691,     0.2725423573563777,  0.0007183448895756934},
+        {6,     0.3456329466643087,      0.213951023749525,  0.0006895815529822191},
+        {6,     0.2831395121050332,     0.1555922309786647,  0.0006480105801792886},
+        {6,      0.219768202292533,    0.09892878979686097,  0.0005897558896594636},
+        {6,     0.1564696098650355,     0.0459864291067551,  0.0005095708849247346},
+        {6,     0.6027356673721295,     0.3376625140173426,  0.0007536906428909755},
+        {6,     0.5496032320255096,     0.2822301309727988,  0.0007472505965575118},
+        {6,     0.4921707755234567,      0.224863234259254,  0.0007343017132279698},
+        {6,     0.4309422998598483,     0.1666224723456479,  0.0007130871582177445},
+        {6,     0.3664108182313672,     0.1086964901822169,  0.0006817022032112776},
+        {6,     0.2990189057758436,    0.05251989784120085,  0.0006380941145604121},
+        {6,     0.6268724013144998,     0.2297523657550023,   0.000755038137792031},
+        {6,     0.5707324144834607,       0.17230806070938,  0.0007478646640144802},
+        {6,     0.5096360901960365,     0.1140238465390513,   0.000733591872060122},
+        {6,     0.4438729938312456,    0.05611522095882537,  0.0007110120527658118},
+        {6,     0.6419978471082389,     0.1164174423140873,  0.0007571363978689501},
+        {6,     0.5817218061802611,    0.05797589531445219,  0.0007489908329079233},
+        // 1730 points
+        {1,                    0.0,                    0.0,  6.309049437420976e-05},
+        {2,                    0.0,                    0.0,  0.0006398287705571748},
+        {3,                    0.0,                    0.0,   0.000635718507353072},
+        {4,    0.02860923126194662,                    0.0,  0.0002221207162188168},
+        {4,    0.07142556767711522,                    0.0,  0.0003475784022286848},
+        {4,     0.1209199540995559,                    0.0,  0.0004350742443589804},
+        {4,     0.1738673106594379,                    0.0,  0.0004978569136522127},
+        {4,     0.2284645438467734,                    0.0,  0.0005435036221998053},
+        {4,     0.2834807671701512,                    0.0,  0.0005765913388219542},
+        {4,     0.3379680145467339,                    0.0,  0.0006001200359226003},
+        {4,     0.3911355454819537,                    0.0,  0.0006162178172717512},
+        {4,     0.4422860353001403,                    0.0,  0.0006265218152438484},
+        {4,     0.4907781568726057,                    0.0,  0.0006323987160974212},
+        {4,     0.5360006153211468,                    0.0,  0.0006350767851540569},
+        {4,     0.6142105973596603,                    0.0,  0.0006354362775297107},
+        {4,     0.6459300387977503,                    0.0,  0.0006352302462706236},
+        {4,     0.6718056125089225,                    0.0,  0.0006358117881417972},
+        {4,     0.6910888533186254,                    0.0,  0.0006373101590310116},
+        {4,     0.7030467416823252,                    0.0,  0.0006390428961368665},
+        {5,    0.08354951166354646,                    0.0,  0.0003186913449946576},
+        {5,     0.2050143009099486,                    0.0,  0.0004678028558591711},
+        {5,     0.3370208290706637,                    0.0,  0.0005538829697598626},
+        {5,     0.4689051484233963,                    0.0,  0.0006044475907190476},
+        {5,     0.5939400424557334,                    0.0,  0.0006313575103509012},
+        {6,     0.1394983311832261,    0.04097581162050343,   0.000407862643185563},
+        {6,     0.1967999180485014,    0.08851987391293348,  0.0004759933057812725},
+        {6,     0.2546183732548967,     0.1397680182969819,   0.000526815118641344},
+        {6,     0.3121281074713875,     0.1929452542226526,  0.0005643048560507316},
+        {6,     0.3685981078502492,     0.2467898337061562,  0.0005914501076613073},
+        {6,     0.4233760321547856,     0.3003104124785409,  0.0006104561257874195},
+        {6,     0.4758671236059246,     0.3526684328175033,  0.0006230252860707806},
+        {6,     0.5255178579796463,     0.4031134861145713,  0.0006305618761760796},
+        {6,     0.5718025633734589,     0.4509426448342351,  0.0006343092767597889},
+        {6,     0.2686927772723415,    0.04711322502423248,  0.0005176268945737827},
+        {6,     0.3306006819904809,    0.09784487303942695,  0.0005564840313313692},
+        {6,     0.3904906850594983,     0.1505395810025273,   0.000585642667103898},
+        {6,      0.447995795190439,      0.203972815629605,  0.0006066386925777091},
+        {6,      0.502707684891978,     0.2571529941121107,  0.0006208824962234458},
+        {6,     0.5542087392260217,      0.309219137581567,  0.0006296314297822907},
+        {6,     0.6020850887375186,     0.3593807506130276,  0.0006340423756791859},
+        {6,     0.4019851409179594,    0.05063389934378671,  0.0005829627677107342},
+        {6,       0.46356145674498,     0.1032422269160612,   0.000604869337608111},
+        {6,     0.5215860931591575,     0.1566322094006254,  0.0006202362317732461},
+        {6,     0.5758202499099271,     0.2098082827491099,  0.0006299005328403779},
+        {6,     0.6259893683876795,     0.2618824114553391,  0.0006347722390609352},
+        {6,     0.5313795124811891,    0.05263245019338556,  0.0006203778981238834},
+        {6,     0.5893317955931995,     0.1061059730982005,  0.0006308414671239979},
+        {6,       0.64262463212158,     0.1594171564034221,  0.0006362706466959498},
+        {6,     0.6511904367376113,     0.0535478953656554,  0.0006375414170333233},
+        // 2030 points
+        {1,                    0.0,                    0.0,  4.656031899197431e-05},
+        {3,                    0.0,                    0.0,  0.0005421549195295507},
+        {4,    0.02540835336814348,                    0.0,  0.0001778522133346553},
+        {4,    0.06399322800504915,                    0.0,  0.0002811325405682796},
+        {4,     0.1088269469804125,                    0.0,  0.0003548896312631459},
+        {4,     0.1570670798818287,                    0.0,  0.0004090310897173364},
+        {4,     0.2071163932282514,                    0.0,  0.0004493286134169965},
+        {4,     0.2578914044450844,                    0.0,  0.0004793728447962723},
+        {4,     0.3085687558169623,                    0.0,  0.0005015415319164265},
+        {4,     0.3584719706267024,                    0.0,  0.0005175127372677937},
+        {4,     0.4070135594428709,                    0.0,  0.0005285522262081019},
+        {4,     0.4536618626222638,                    0.0,  0.0005356832703713962},
+        {4,     0.4979195686463577,                    0.0,   0.000539791473617517},
+        {4,     0.5393075111126999,                    0.0,   0.000541689944159993},
+        {4,     0.6115617676843916,                    0.0,  0.0005419308476889938},
+        {4,     0.6414308435160159,                    0.0,  0.0005416936902030596},
+        {4,     0.6664099412721607,                    0.0,  0.0005419544338703164},
+        {4,     0.6859161771214913,                    0.0,  0.0005428983656630974},
+        {4,      0.699362559350389,                    0.0,  0.0005442286500098193},
+        {4,      0.706239338771938,                    0.0,  0.0005452250345057301},
+        {5,    0.07479028168349763,                    0.0,   0.000256800249772853},
+        {5,     0.1848951153969366,                    0.0,  0.0003827211700292145},
+        {5,     0.3059529066581305,                    0.0,  0.0004579491561917824},
+        {5,     0.4285556101021362,                    0.0,  0.0005042003969083574},
+        {5,     0.5468758653496526,                    0.0,  0.0005312708889976024},
+        {5,     0.6565821978343439,                    0.0,  0.0005438401790747117},
+        {6,     0.1253901572367117,    0.03681917226439641,  0.0003316041873197344},
+        {6,     0.1775721510383941,    0.07982487607213301,  0.0003899113567153771},
+        {6,     0.2305693358216114,     0.1264640966592335,  0.0004343343327201309},
+        {6,     0.2836502845992063,     0.1751585683418957,  0.0004679415262318919},
+        {6,      0.336179474623259,      0.224799590763267,  0.0004930847981631031},
+        {6,     0.3875979172264824,     0.2745299257422246,  0.0005115031867540091},
+        {6,     0.4374019316999074,     0.3236373482441118,  0.0005245217148457367},
+        {6,     0.4851275843340022,     0.3714967859436741,  0.0005332041499895321},
+        {6,     0.5303391803806868,     0.4175353646321745,  0.0005384583126021542},
+        {6,     0.5726197380596287,     0.4612084406355461,  0.0005411067210798852},
+        {6,     0.2431520732564863,    0.04258040133043952,  0.0004259797391468714},
+        {6,     0.3002096800895869,    0.08869424306722722,  0.0004604931368460021},
+        {6,     0.3558554457457432,     0.1368811706510655,  0.0004871814878255202},
+        {6,     0.4097782537048887,     0.1860739985015033,  0.0005072242910074885},
+        {6,     0.4616337666067458,     0.2354235077395853,   0.000521706984523535},
+        {6,     0.5110707008417874,     0.2842074921347011,   0.000531578596628031},
+        {6,     0.5577415286163795,     0.3317784414984102,  0.0005376833708758905},
+        {6,      0.601306043136695,       0.37752990020407,  0.0005408032092069521},
+        {6,     0.3661596767261781,    0.04599367887164592,  0.0004842744917904866},
+        {6,     0.4237633153506581,    0.09404893773654421,   0.000504892607618813},
+        {6,     0.4786328454658452,     0.1431377109091971,  0.0005202607980478373},
+        {6,     0.5305702076789774,      0.192418638884357,  0.0005309932388325743},
+        {6,     0.5793436224231788,      0.241159094477519,  0.0005377419770895208},
+        {6,     0.6247069017094747,     0.2886871491583605,  0.0005411696331677717},
+        {6,     0.4874315552535204,    0.04804978774953206,   0.000519799629328242},
+        {6,     0.5427337322059053,    0.09716857199366664,  0.0005311120836622945},
+        {6,       0.59434937472467,     0.1465205839795055,  0.0005384309319956951},
+        {6,     0.6421314033564943,     0.1953579449803574,  0.0005421859504051886},
+        {6,      0.602062837471398,    0.04916375015738108,  0.0005390948355046314},
+        {6,     0.6529222529856881,    0.09861621540127005,  0.0005433312705027845},
+        // 2354 points
+        {1,                    0.0,                    0.0,  3.922616270665292e-05},
+        {2,                    0.0,                    0.0,  0.0004703831750854424},
+        {3,                    0.0,                    0.0,  0.0004678202801282136},
+        {4,    0.02290024646530589,                    0.0,    0.00014378322289799},
+        {4,    0.05779086652271284,                    0.0,  0.0002303572493577644},
+        {4,    0.09863103576375984,                    0.0,  0.0002933110752447454},
+        {4,     0.1428155792982185,                    0.0,  0.0003402905998359838},
+        {4,     0.1888978116601463,                    0.0,  0.0003759138466870372},
+        {4,      0.235909168297021,                    0.0,  0.0004030638447899798},
+        {4,     0.2831228833706171,                    0.0,  0.0004236591432242211},
+        {4,     0.3299495857966693,                    0.0,  0.0004390522656946746},
+        {4,     0.3758840802660796,                    0.0,  0.0004502523466626247},
+        {4,      0.420475183100948,                    0.0,  0.0004580577727783541},
+        {4,     0.4633068518751051,                    0.0,  0.0004631391616615899},
+        {4,     0.5039849474507313,                    0.0,  0.0004660928953698676},
+        {4,     0.5421265793440747,                    0.0,  0.0004674751807936953},
+        {4,      0.609266023055731,                    0.0,   0.000467641490393292},
+        {4,     0.6374654204984869,                    0.0,   0.000467408649234787},
+        {4,     0.6615136472609892,                    0.0,  0.0004674928539483207},
+        {4,     0.6809487285958127,                    0.0,  0.0004680748979686447},
+        {4,     0.6952980021665196,                    0.0,   0.000469044980638904},
+        {4,       0.70412454976954,                    0.0,  0.0004699877075860818},
+        {5,    0.06744033088306065,                    0.0,  0.0002099942281069176},
+        {5,     0.1678684485334166,                    0.0,  0.0003172269150712804},
+        {5,     0.2793559049539613,                    0.0,  0.0003832051358546523},
+        {5,     0.3935264218057639,                    0.0,  0.0004252193818146985},
+        {5,     0.5052629268232558,                    0.0,     0.0004513807963755},
+        {5,     0.6107905315437531,                    0.0,  0.0004657797469114178},
+        {6,     0.1135081039843524,    0.03331954884662588,  0.0002733362800522836},
+        {6,     0.1612866626099378,    0.07247167465436538,  0.0003235485368463559},
+        {6,     0.2100786550168205,     0.1151539110849745,  0.0003624908726013453},
+        {6,     0.2592282009459942,     0.1599491097143677,  0.0003925540070712828},
+        {6,     0.3081740561320203,     0.2058699956028027,  0.0004156129781116235},
+        {6,     0.3564289781578164,     0.2521624953502911,  0.0004330644984623263},
+        {6,     0.4035587288240703,     0.2982090785797674,  0.0004459677725921312},
+        {6,     0.4491671196373903,     0.3434762087235733,  0.0004551593004456795},
+        {6,     0.4928854782917489,     0.3874831357203437,  0.0004613341462749918},
+        {6,     0.5343646791958988,     0.4297814821746926,  0.0004651019618269806},
+        {6,      0.573268321653099,     0.4699402260943537,  0.0004670249536100625},
+        {6,     0.2214131583218986,    0.03873602040643895,  0.0003549555576441708},
+        {6,     0.2741796504750071,    0.08089496256902012,   0.000385610824524901},
+        {6,     0.3259797439149485,     0.1251732177620872,  0.0004098622845756882},
+        {6,     0.3765441148826891,     0.1706260286403185,   0.000428632860426895},
+        {6,     0.4255773574530558,     0.2165115147300408,  0.0004427802198993945},
+        {6,      0.472779511705843,     0.2622089812225259,  0.0004530473511488561},
+        {6,     0.5178546895819012,     0.3071721431296201,  0.0004600805475703138},
+        {6,      0.560514119209746,     0.3508998998801138,  0.0004644599059958017},
+        {6,     0.6004763319352512,     0.3929160876166931,  0.0004667274455712508},
+        {6,     0.3352842634946949,    0.04202563457288019,  0.0004069360518020356},
+        {6,      0.389197162981467,     0.0861430975887085,  0.0004260442819919195},
+        {6,     0.4409875565542281,     0.1314500879380001,  0.0004408678508029063},
+        {6,     0.4904893058592484,     0.1772189657383859,  0.0004518748115548597},
+        {6,      0.537505613876955,     0.2228277110050294,  0.0004595564875375116},
+        {6,     0.5818255708669969,     0.2677179935014386,  0.0004643988774315846},
+        {6,     0.6232334858144959,     0.3113675035544165,  0.0004668827491646946},
+        {6,     0.4489485354492058,    0.04409162378368174,  0.0004400541823741973},
+        {6,      0.501513687593315,    0.08939009917748489,  0.0004514512890193797},
+        {6,     0.5511300550512623,     0.1351806029383365,  0.0004596198627347549},
+        {6,        0.5976720409858,     0.1808370355053196,  0.0004648659016801781},
+        {6,     0.6409956378989354,     0.2257852192301602,  0.0004675502017157673},
+        {6,     0.5581222330827514,     0.0453217342163716,  0.0004598494476455523},
+        {6,     0.6074705984161695,    0.09117488031840314,  0.0004654916955152048},
+        {6,     0.6532272537379032,     0.1369294213140155,  0.0004684709779505137},
+        {6,     0.6594761494500487,    0.04589901487275583,  0.0004691445539106986},
+        // 2702 points
+        {1,                    0.0,                    0.0,  2.998675149888161e-05},
+        {3,                    0.0,                    0.0,  0.0004077860529495355},
+        {4,    0.02065562538818703,                    0.0,  0.0001185349192520667},
+        {4,    0.05250918173022379,                    0.0,  0.0001913408643425751},
+        {4,    0.08993480082038376,                    0.0,  0.0002452886577209897},
+        {4,     0.1306023924436019,                    0.0,  0.0002862408183288702},
+        {4,     0.1732060388531418,                    0.0,  0.0003178032258257357},
+        {4,     0.2168727084820249,                    0.0,   0.000342294566763369},
+        {4,     0.2609528309173586,                    0.0,  0.0003612790520235922},
+        {4,     0.3049252927938952,                    0.0,  0.0003758638229818521},
+        {4,     0.3483484138084404,                    0.0,  0.0003868711798859953},
+        {4,     0.3908321549106406,                    0.0,  0.0003949429933189938},
+        {4,     0.4320210071894814,                    0.0,  0.0004006068107541156},
+        {4,     0.4715824795890053,                    0.0,  0.0004043192149672723},
+        {4,     0.5091984794078454,                    0.0,  0.0004064947495808078},
+        {4,     0.5445580145650804,                    0.0,  0.0004075245619813152},
+        {4,     0.6072575796841768,                    0.0,  0.0004076423540893566},
+        {4,     0.6339484505755802,                    0.0,  0.0004074280862251555},
+        {4,     0.6570718257486958,                    0.0,  0.0004074163756012244},
+        {4,     0.6762557330090709,                    0.0,  0.0004077647795071246},
+        {4,      0.691116169692379,                    0.0,   0.000408451755278253},
+        {4,      0.701284191165996,                    0.0,  0.0004092468459224052},
+        {4,      0.706455927241002,                    0.0,  0.0004097872687240906},
+        {5,    0.06123554989894765,                    0.0,  0.0001738986811745028},
+        {5,     0.1533070348312393,                    0.0,  0.0002659616045280191},
+        {5,     0.2563902605244206,                    0.0,  0.0003240596008171533},
+        {5,     0.3629346991663361,                    0.0,  0.0003621195964432943},
+        {5,     0.4683949968987538,                    0.0,  0.0003868838330760539},
+        {5,     0.5694479240657953,                    0.0,  0.0004018911532693111},
+        {5,     0.6634465430993955,                    0.0,  0.0004089929432983252},
+        {6,     0.1033958573552305,    0.03034544009063584,  0.0002279907527706409},
+        {6,     0.1473521412414395,    0.06618803044247135,  0.0002715205490578897},
+        {6,     0.1924552158705967,     0.1054431128987715,  0.0003057917896703976},
+        {6,     0.2381094362890328,     0.1468263551238858,  0.0003326913052452555},
+        {6,      0.283812170793676,     0.1894486108187886,  0.0003537334711890037},
+        {6,     0.3291323133373415,     0.2326374238761579,  0.0003700567500783129},
+        {6,      0.373689697874146,     0.2758485808485768,  0.0003825245372589122},
+        {6,     0.4171406040760013,     0.3186179331996921,  0.0003918125171518296},
+        {6,     0.4591677985256915,     0.3605329796303794,  0.0003984720419937579},
+        {6,     0.4994733831718418,     0.4012147253586509,  0.0004029746003338211},
+        {6,     0.5377731830445096,     0.4403050025570692,  0.0004057428632156627},
+        {6,     0.5737917830001331,     0.4774565904277483,  0.0004071719274114857},
+        {6,     0.2027323586271389,    0.03544122504976147,  0.0002990236950664119},
+        {6,     0.2516942375187273,    0.07418304388646328,  0.0003262951734212878},
+        {6,     0.3000227995257181,     0.1150502745727186,  0.0003482634608242413},
+        {6,     0.3474806691046342,     0.1571963371209364,  0.0003656596681700892},
+        {6,     0.3938103180359209,       0.19996318772471,  0.0003791740467794218},
+        {6,     0.4387519590455703,     0.2428073457846535,  0.0003894034450156905},
+        {6,     0.4820503960077787,     0.2852575132906155,  0.0003968600245508371},
+        {6,     0.5234573778475101,     0.3268884208674639,   0.000401993135142005},
+        {6,     0.5627318647235282,     0.3673033321675939,  0.0004052108801278599},
+        {6,     0.5996390607156954,      0.406121155183029,  0.0004068978613940934},
+        {6,     0.3084780753791947,    0.03860125523100059,  0.0003454275351319704},
+        {6,     0.3589988275920223,    0.07928938987104867,   0.000362996353700792},
+        {6,     0.4078628415881973,     0.1212614643030087,  0.0003770187233889873},
+        {6,     0.4549287258889735,     0.1638770827382693,  0.0003878608613694378},
+        {6,     0.5000278512957279,     0.2065965798260176,  0.0003959065270221274},
+        {6,     0.5429785044928199,     0.2489436378852235,   0.000401528697546357},
+        {6,     0.5835939850491711,     0.2904811368946891,  0.0004050866785614717},
+        {6,     0.6216870353444856,     0.3307941957666609,  0.0004069320185051913},
+        {6,     0.4151104662709091,    0.04064829146052554,  0.0003760120964062763},
+        {6,     0.4649804275009218,    0.08258424547294756,  0.0003870969564418064},
+        {6,     0.5124695757009662,     0.1251841962027289,  0.0003955287790534055},
+        {6,     0.5574711100606224,     0.1679107505976331,  0.0004015361911302668},
+        {6,     0.5998597333287227,     0.2102805057358715,  0.0004053836986719548},
+        {6,       0.63950071485166,     0.2518418087774107,  0.0004073578673299117},
+        {6,     0.5188456224746252,    0.04194321676077518,  0.0003954628379231406},
+        {6,     0.5664190707942778,    0.08457661551921498,   0.000401764550884753},
+        {6,     0.6110464353283153,     0.1273652932519396,  0.0004059030348651293},
+        {6,     0.6526430302051563,     0.1698173239076354,   0.000408056580948488},
+        {6,     0.6167551880377548,    0.04266398851548864,  0.0004063018753664651},
+        {6,     0.6607195418355383,     0.0855192581423835,  0.0004087191292799671},
+        // 3074 points
+        {1,                    0.0,                    0.0,  2.599095953754734e-05},
+        {2,                    0.0,                    0.0,  0.0003603134089687541},
+        {3,                    0.0,                    0.0,  0.0003586067974412447},
+        {4,    0.01886108518723392,                    0.0,   9.83152847438588e-05},
+        {4,    0.04800217244625303,                    0.0,   0.000160502310795445},
+        {4,    0.08244922058397242,                    0.0,  0.0002072200131464099},
+        {4,     0.1200408362484023,                    0.0,  0.0002431297618814187},
+        {4,     0.1595773530809965,                    0.0,  0.0002711819064496707},
+        {4,     0.2002635973434064,                    0.0,  0.0002932762038321116},
+        {4,     0.2415127590139982,                    0.0,  0.0003107032514197368},
+        {4,     0.2828584158458477,                    0.0,  0.0003243808058921213},
+        {4,     0.3239091015338138,                    0.0,   0.000334989909137403},
+        {4,     0.3643225097962194,                    0.0,  0.0003430580688505218},
+        {4,     0.4037897083691802,                    0.0,  0.0003490124109290343},
+        {4,     0.4420247515194127,                    0.0,  0.0003532148948561955},
+        {4,     0.4787572538464938,                    0.0,  0.0003559862669062833},
+        {4,     0.5137265251275234,                    0.0,  0.0003576224317551411},
+        {4,      0.546676405665461,                    0.0,  0.0003584050533086076},
+        {4,     0.6054859420813535,                    0.0,  0.0003584903581373224},
+        {4,     0.6308106701764562,                    0.0,  0.0003582991879040586},
+        {4,     0.6530369230179583,                    0.0,  0.0003582371187963125},
+        {4,     0.6718609524611158,                    0.0,   0.000358435363112235},
+        {4,     0.6869676499894013,                    0.0,  0.0003589120166517785},
+        {4,     0.6980467077240748,                    0.0,  0.0003595445704531601},
+        {4,     0.7048241721250522,                    0.0,  0.0003600943557111074},
+        {5,    0.05591105222058232,                    0.0,  0.0001456447096742039},
+        {5,     0.1407384078513916,                    0.0,  0.0002252370188283782},
+        {5,     0.2364035438976309,                    0.0,  0.0002766135443474897},
+        {5,      0.336060273781817,                    0.0,  0.0003110729491500851},
+        {5,     0.4356292630054665,                    0.0,  0.0003342506712303391},
+        {5,     0.5321569415256174,                    0.0,   0.000349198183402686},
+        {5,     0.6232956305040555,                    0.0,  0.0003576003604348932},
+        {6,     0.0946987008683847,     0.0277874838730947,  0.0001921921305788564},
+        {6,     0.1353170300568141,    0.06076569878628364,  0.0002301458216495632},
+        {6,     0.1771679481726077,     0.0970307276271104,  0.0002604248549522893},
+        {6,     0.2197066664231751,     0.1354112458524762,  0.0002845275425870697},
+        {6,     0.2624783557374927,       0.17509964797441,   0.000303687089797484},
+        {6,     0.3050969521214442,     0.2154896907449802,  0.0003188414832298066},
+        {6,     0.3472252637196021,     0.2560954625740152,  0.0003307046414722089},
+        {6,      0.388561021902636,     0.2965070050624096,   0.000339833096903136},
+        {6,     0.4288273776062765,     0.3363641488734497,  0.0003466757899705373},
+        {6,     0.4677662471302948,     0.3753400029836788,  0.0003516095923230054},
+        {6,      0.505133358955336,     0.4131297522144286,  0.0003549645184048486},
+        {6,     0.5406942145810492,     0.4494423776081795,  0.0003570415969441392},
+        {6,     0.5742204122576458,     0.4839938958841502,  0.0003581251798496118},
+        {6,     0.1865407027225188,    0.03259144851070796,  0.0002543491329913348},
+        {6,     0.2321186453689432,    0.06835679505297343,  0.0002786711051330776},
+        {6,     0.2773159142523882,     0.1062284864451989,  0.0002985552361083679},
+        {6,     0.3219200192237254,     0.1454404409323047,  0.0003145867929154039},
+        {6,     0.3657032593944029,      0.185401828258251,  0.0003273290662067609},
+        {6,     0.4084376778363622,      0.225629741201475,  0.0003372705511943501},
+        {6,     0.4499004945751427,     0.2657104425000896,   0.000344827443785151},
+        {6,     0.4898758141326335,     0.3052755487631557,  0.0003503592783048583},
+        {6,     0.5281547442266309,     0.3439863920645423,  0.0003541854792663162},
+        {6,     0.5645346989813992,     0.3815229456121914,  0.0003565995517909428},
+        {6,     0.5988181252159848,     0.4175752420966734,  0.0003578802078302898},
+        {6,     0.2850425424471603,    0.03562149509862536,  0.0002958644592860982},
+        {6,     0.3324619433027876,    0.07330318886871096,  0.0003119548129116835},
+        {6,     0.3785848333076282,     0.1123226296008472,  0.0003250745225005984},
+        {6,     0.4232891028562115,     0.1521084193337708,  0.0003355153415935208},
+        {6,     0.4664287050829722,      0.192184445922361,  0.0003435847568549328},
+        {6,     0.5078458493735726,     0.2321360989678303,  0.0003495786831622488},
+        {6,      0.547377981620418,      0.271588648636052,  0.0003537767805534621},
+        {6,     0.5848617133811376,     0.3101924707571355,  0.0003564459815421428},
+        {6,     0.6201348281584887,     0.3476121052890973,  0.0003578464061225468},
+        {6,     0.3852191185387871,    0.03763224880035108,  0.0003239748762836212},
+        {6,     0.4325025061073423,    0.07659581935637134,  0.0003345491784174287},
+        {6,      0.477848622973449,       0.11633813060839,  0.0003429126177301782},
+        {6,        0.5211663693009,     0.1563890598752899,  0.0003492420343097421},
+        {6,     0.5623469504853703,       0.19633208101492,  0.0003537399050235257},
+        {6,     0.6012718188659246,     0.2357847407258738,  0.0003566209152659172},
+        {6,     0.6378179206390117,      0.274384612124406,  0.0003581084321919782},
+        {6,     0.4836936460214534,    0.03895902610739024,  0.0003426522117591512},
+        {6,     0.5293792562683797,     0.0787124681931264,  0.0003491848770121379},
+        {6,     0.5726281253100033,     0.1187963808202981,  0.0003539318235231476},
+        {6,     0.6133658776169068,     0.1587914708061787,  0.0003570231438458694},
+        {6,     0.6515085491865307,     0.1983058575227646,  0.0003586207335051714},
+        {6,     0.5778692716064976,    0.03977209689791542,  0.0003541196205164025},
+        {6,     0.6207904288086192,    0.07990157592981152,  0.0003574296911573953},
+        {6,     0.6608688171046802,     0.1199671308754309,  0.0003591993279818963},
+        {6,      0.665626308948913,    0.04015955957805969,  0.0003595855034661997},
+        // 3470 points
+        {1,                    0.0,                    0.0,   2.04038273082633e-05},
+        {3,                    0.0,                    0.0,  0.0003178149703889544},
+        {4,    0.01721420832906233,                    0.0,   8.28811512807611e-05},
+        {4,     0.0440887537498177,                    0.0,  0.0001360883192522954},
+        {4,     0.0759468081387868,                    0.0,  0.0001766854454542662},
+        {4,     0.1108335359204799,                    0.0,  0.0002083153161230153},
+        {4,     0.1476517054388567,                    0.0,  0.0002333279544657158},
+        {4,     0.1856731870860615,                    0.0,  0.0002532809539930247},
+        {4,     0.2243634099428821,                    0.0,  0.0002692472184211158},
+        {4,     0.2633006881662727,                    0.0,  0.0002819949946811885},
+        {4,     0.3021340904916283,                    0.0,   0.000292095359397303},
+        {4,     0.3405594048030089,                    0.0,  0.0002999889782948352},
+        {4,     0.3783044434007372,                    0.0,  0.0003060292120496902},
+        {4,      0.415119476740791,                    0.0,  0.0003105109167522192},
+        {4,     0.4507705766443257,                    0.0,  0.0003136902387550312},
+        {4,     0.4850346056573187,                    0.0,  0.0003157984652454632},
+        {4,      0.517695081779247,                    0.0,  0.0003170516518425422},
+        {4,     0.5485384240820989,                    0.0,  0.0003176568425633755},
+        {4,     0.6039117238943308,                    0.0,  0.0003177198411207062},
+        {4,     0.6279956655573113,                    0.0,  0.0003175519492394733},
+        {4,     0.6493636169568952,                    0.0,  0.0003174654952634756},
+        {4,     0.6677644117704504,                    0.0,  0.0003175676415467654},
+        {4,     0.6829368572115624,                    0.0,   0.000317892341783541},
+        {4,     0.6946195818184121,                    0.0,  0.0003183788287531909},
+        {4,     0.7025711542057026,                    0.0,  0.0003188755151918807},
+        {4,     0.7066004767140119,                    0.0,  0.0003191916889313849},
+        {5,    0.05132537689946062,                    0.0,  0.0001231779611744508},
+        {5,     0.1297994661331225,                    0.0,   0.000192466137383988},
+        {5,     0.2188852049401307,                    0.0,  0.0002380881867403424},
+        {5,     0.3123174824903457,                    0.0,  0.0002693100663037885},
+        {5,     0.4064037620738195,                    0.0,  0.0002908673382834366},
+        {5,     0.4984958396944782,                    0.0,  0.0003053914619381535},
+        {5,     0.5864975046021365,                    0.0,  0.0003143916684147777},
+        {5,     0.6686711634580175,                    0.0,  0.0003187042244055363},
+        {6,     0.0871573878083595,    0.02557175233367578,   0.000163521953586979},
+        {6,     0.1248383123134007,    0.05604823383376681,   0.000196810991769607},
+        {6,     0.1638062693383378,    0.08968568601900764,  0.0002236754342249974},
+        {6,     0.2035586203373176,     0.1254086651976279,  0.0002453186687017181},
+        {6,     0.2436798975293774,     0.1624780150162012,  0.0002627551791580541},
+        {6,     0.2838207507773806,     0.2003422342683208,   0.000276765486015222},
+        {6,     0.3236787502217692,     0.2385628026255263,  0.0002879467027765895},
+        {6,     0.3629849554840691,     0.2767731148783578,  0.0002967639918918702},
+        {6,     0.4014948081992087,     0.3146542308245309,  0.0003035900684660351},
+        {6,     0.4389818379260225,     0.3519196415895088,  0.0003087338237298308},
+        {6,     0.4752331143674377,     0.3883050984023654,  0.0003124608838860167},
+        {6,     0.5100457318374018,     0.4235613423908649,  0.0003150084294226743},
+        {6,     0.5432238388954868,      0.457448471719622,  0.0003165958398598402},
+        {6,     0.5745758685072442,     0.4897311639255524,  0.0003174320440957372},
+        {6,     0.1723981437592809,    0.03010630597881105,  0.0002182188909812599},
+        {6,     0.2149553257844597,    0.06326031554204695,  0.0002399727933921445},
+        {6,     0.2573256081247422,    0.09848566980258631,  0.0002579796133514652},
+        {6,     0.2993163751238106,     0.1350835952384266,  0.0002727114052623535},
+        {6,        0.3407238005148,     0.1725184055442181,  0.0002846327656281355},
+        {6,     0.3813454978483264,     0.2103559279730725,  0.0002941491102051334},
+        {6,     0.4209848104423343,      0.248227877455486,  0.0003016049492136107},
+        {6,       0.45945196999963,     0.2858099509982883,  0.0003072949726175648},
+        {6,      0.496564016618593,     0.3228075659915428,   0.000311476814288646},
+        {6,     0.5321441655571562,     0.3589459907204151,  0.0003143823673666223},
+        {6,     0.5660208438582166,      0.393963008886431,  0.0003162269764661535},
+        {6,     0.5980264315964364,     0.4276029922949089,  0.0003172164663759821},
+        {6,     0.2644215852350733,    0.03300939429072552,  0.0002554575398967435},
+        {6,     0.3090113743443063,    0.06803887650078501,  0.0002701704069135677},
+        {6,     0.3525871079197808,     0.1044326136206709,   0.000282369341346894},
+        {6,     0.3950418005354029,     0.1416751597517679,  0.0002922898463214289},
+        {6,     0.4362475663430163,     0.1793408610504821,  0.0003001829062162428},
+        {6,     0.4760661812145854,     0.2170630750175722,  0.0003062890864542953},
+        {6,     0.5143551042512103,     0.2545145157815807,  0.0003108328279264746},
+        {6,     0.5509709026935597,     0.2913940101706601,  0.0003140243146201245},
+        {6,     0.5857711030329428,     0.3274169910910705,   0.000316063803097713},
+        {6,     0.6186149917404392,     0.3623081329317265,  0.0003171462882206275},
+        {6,     0.3586894569557064,     0.0349735438645004,  0.0002812388416031796},
+        {6,     0.4035266610019441,    0.07129736739757095,  0.0002912137500288045},
+        {6,      0.446777531233251,     0.1084758620193165,  0.0002993241256502206},
+        {6,     0.4883638346608543,     0.1460915689241772,  0.0003057101738983822},
+        {6,     0.5281908348434601,      0.183779083236998,  0.0003105319326251432},
+        {6,     0.5661542687149311,     0.2212075390874021,  0.0003139565514428167},
+        {6,     0.6021450102031451,     0.2580682841160985,  0.0003161543006806366},
+        {6,      0.636052078361005,     0.2940656362094121,  0.0003172985960613294},
+        {6,     0.4521611065087196,    0.03631055365867002,  0.0002989400336901431},
+        {6,     0.4959365651560963,     0.0734831846848435,  0.0003054555883947677},
+        {6,     0.5376815804038283,     0.1111087643812648,  0.0003104764960807702},
+        {6,     0.5773314480243767,     0.1488226085145408,  0.0003141015825977616},
+        {6,     0.6148113245575056,     0.1862892274135151,  0.0003164520621159896},
+        {6,      0.650040746284238,     0.2231909701714456,  0.0003176652305912204},
+        {6,     0.5425151448707213,    0.03718201306118944,  0.0003105097161023939},
+        {6,     0.5841860556907931,    0.07483616335067346,   0.000314301411789055},
+        {6,       0.62346321868515,      0.112599083426612,    0.00031681728662872},
+        {6,     0.6602934551848842,     0.1501303813157619,  0.0003181401865570968},
+        {6,     0.6278573968375105,     0.0376755993024572,  0.0003170663659156037},
+        {6,     0.6665611711264577,    0.07548443301360158,   0.000318544794462551},
+        // 3890 points
+        {1,                    0.0,                    0.0,   1.80739525219692e-05},
+        {2,                    0.0,                    0.0,  0.0002848008782238827},
+        {3,                    0.0,                    0.0,  0.0002836065837530581},
+        {4,    0.01587876419858352,                    0.0,  7.013149266673816e-05},
+        {4,    0.04069193593751206,                    0.0,  0.0001162798021956766},
+        {4,    0.07025888115257997,                    0.0,  0.0001518728583972105},
+        {4,     0.1027495450028704,                    0.0,  0.0001798796108216934},
+        {4,     0.1371457730893426,                    0.0,  0.0002022593385972785},
+        {4,     0.1727758532671953,                    0.0,  0.0002203093105575464},
+        {4,     0.2091492038929037,                    0.0,  0.0002349294234299855},
+        {4,     0.2458813281751915,                    0.0,  0.0002467682058747003},
+        {4,     0.2826545859450066,                    0.0,  0.0002563092683572224},
+        {4,     0.3191957291799622,                    0.0,  0.0002639253896763318},
+        {4,     0.3552621469299578,                    0.0,  0.0002699137479265108},
+        {4,      0.390632950340623,                    0.0,  0.0002745196420166739},
+        {4,     0.4251028614093031,                    0.0,  0.0002779529197397593},
+        {4,      0.458477752011187,                    0.0,  0.0002803996086684265},
+        {4,     0.4905711358710193,                    0.0,  0.0002820302356715842},
+        {4,     0.5212011669847385,                    0.0,  0.0002830056747491068},
+        {4,     0.5501878488737995,                    0.0,  0.0002834808950776839},
+        {4,     0.6025037877479342,                    0.0,  0.0002835282339078929},
+        {4,     0.6254572689549016,                    0.0,    0.00028338192670658},
+        {4,     0.6460107179528248,                    0.0,  0.0002832858336906784},
+        {4,     0.6639541138154251,                    0.0,  0.0002833268235451244},
+        {4,     0.6790688515667495,                    0.0,  0.0002835432677029253},
+        {4,     0.6911338580371512,                    0.0,  0.0002839091722743049},
+        {4,      0.699938595612649,                    0.0,  0.0002843308178875841},
+        {4,     0.7053037748656896,                    0.0,  0.0002846703550533846},
+        {5,    0.04732224387180115,                    0.0,    0.00010511934069719},
+        {5,     0.1202100529326803,                    0.0,  0.0001657871838796974},
+        {5,     0.2034304820664855,                    0.0,  0.0002064648113714232},
+        {5,     0.2912285643573002,                    0.0,  0.0002347942745819741},
+        {5,     0.3802361792726768,                    0.0,  0.0002547775326597726},
+        {5,     0.4680598511056146,                    0.0,  0.0002686876684847025},
+        {5,     0.5528151052155599,                    0.0,  0.0002778665755515867},
+        {5,     0.6329386307803041,                    0.0,  0.0002830996616782929},
+        {6,     0.0805651665136907,    0.02363454684003124,  0.0001403063340168372},
+        {6,     0.1156476077139389,    0.05191291632545936,  0.0001696504125939477},
+        {6,     0.1520473382760421,     0.0832271573699452,   0.000193578724274539},
+        {6,     0.1892986699745931,     0.1165855667993712,  0.0002130614510521968},
+        {6,     0.2270194446777792,     0.1513077167409504,  0.0002289381265931048},
+        {6,     0.2648908185093273,     0.1868882025807859,  0.0002418630292816186},
+        {6,     0.3026389259574136,     0.2229277629776224,  0.0002523400495631193},
+        {6,     0.3400220296151384,     0.2590951840746235,  0.0002607623973449605},
+        {6,      0.376821795333551,     0.2951047291750847,  0.0002674441032689209},
+        {6,     0.4128372900921884,      0.330701971416993,  0.0002726432360343356},
+        {6,      0.447880713181563,     0.3656544101087634,  0.0002765787685924545},
+        {6,     0.4817742034089257,     0.3997448951939695,  0.0002794428690642224},
+        {6,     0.5143472814653344,     0.4327667110812024,  0.0002814099002062895},
+        {6,      0.545434621390565,     0.4645196123532293,  0.0002826429531578994},
+        {6,     0.5748739313170252,     0.4948063555703345,  0.0002832983542550884},
+        {6,     0.1599598738286342,    0.02792357590048985,  0.0001886695565284976},
+        {6,     0.1998097412500951,    0.05877141038139065,  0.0002081867882748234},
+        {6,     0.2396228952566202,    0.09164573914691378,  0.0002245148680600796},
+        {6,     0.2792228341097746,     0.1259049641962687,  0.0002380370491511872},
+        {6,     0.3184251107546741,     0.1610594823400863,  0.0002491398041852455},
+        {6,     0.3570481164426244,     0.1967151653460898,   0.000258163240588123},
+        {6,     0.3949164710492144,     0.2325404606175168,  0.0002653965506227417},
+        {6,     0.4318617293970503,     0.2682461141151439,  0.0002710857216747087},
+        {6,     0.4677221009931678,     0.3035720116011973,  0.0002754434093903659},
+        {6,     0.5023417939270955,     0.3382781859197439,   0.000278657993251938},
+        {6,     0.5355701836636128,     0.3721383065625942,  0.0002809011080679474},
+        {6,     0.5672608451328771,     0.4049346360466055,  0.0002823336184560987},
+        {6,     0.5972704202540162,     0.4364538098633802,  0.0002831101175806309},
+        {6,     0.2461687022333596,    0.03070423166833368,  0.0002221679970354546},
+        {6,     0.2881774566286831,    0.06338034669281885,  0.0002356185734270703},
+        {6,     0.3293963604116978,    0.09742862487067941,   0.000246922834480559},
+        {6,     0.3697303822241377,      0.132379953228229,  0.0002562726348642046},
+        {6,     0.4090663023135127,     0.1678497018129336,  0.0002638756726753028},
+        {6,     0.4472819355411712,     0.2035095105326114,  0.0002699311157390862},
+        {6,     0.4842513377231437,     0.2390692566672091,  0.0002746233268403837},
+        {6,     0.5198477629962928,     0.2742649818076149,  0.0002781225674454771},
+        {6,     0.5539453011883145,     0.3088503806580094,  0.0002805881254045684},
+        {6,     0.5864196762401251,     0.3425904245906614,  0.0002821719877004913},
+        {6,      0.617148446666839,     0.3752562294789468,  0.0002830222502333124},
+        {6,     0.3350337830565727,    0.03261589934634747,   0.000245799595674487},
+        {6,     0.3775773224758284,    0.06658438928081573,  0.0002551474407503706},
+        {6,     0.4188155229848973,     0.1014565797157954,  0.0002629065335195311},
+        {6,     0.4586805892009344,     0.1368573320843822,  0.0002691900449925075},
+        {6,     0.4970895714224235,     0.1724614851951608,  0.0002741275485754276},
+        {6,     0.5339505133960747,     0.2079779381416412,  0.0002778530970122595},
+        {6,      0.569166579253144,     0.2431385788322288,  0.0002805010567646741},
+        {6,     0.6026387682680377,     0.2776901883049853,   0.000282205583403104},
+        {6,     0.6342676150163307,     0.3113881356386632,  0.0002831016901243473},
+        {6,     0.4237951119537067,    0.03394877848664351,  0.0002624474901131803},
+        {6,     0.4656918683234929,    0.06880219556291448,  0.0002688034163039377},
+        {6,      0.505885706918598,     0.1041946859721635,  0.0002738932751287636},
+        {6,     0.5443204666713995,     0.1398039738736393,  0.0002777944791242523},
+        {6,     0.5809298813759742,     0.1753373381196155,  0.0002806011661660987},
+        {6,     0.6156416039447128,      0.210521579351401,   0.000282418145659746},
+        {6,     0.6483801351066604,     0.2450953312157051,  0.0002833585216577828},
+        {6,     0.5103616577251688,    0.03485560643800719,  0.0002738165236962878},
+        {6,     0.5506738792580681,    0.07026308631512033,   0.000277836520820318},
+        {6,     0.5889573040995292,     0.1059035061296403,  0.0002807852940418966},
+        {6,      0.625164158951693,     0.1414823925236026,  0.0002827245949674705},
+        {6,     0.6592414921570178,      0.176720790821453,  0.0002837342344829828},
+        {6,     0.5930314017533383,    0.03542189339561672,  0.0002809233907610981},
+        {6,     0.6309812253390175,    0.07109574040369548,  0.0002829930809742694},
+        {6,      0.666629601135323,      0.106725979228273,  0.0002841097874111479},
+        {6,     0.6703715271049921,    0.03569455268820809,  0.0002843455206008783},
+        // 4334 points
+        {1,                    0.0,                    0.0,  1.449063022537883e-05},
+        {3,                    0.0,                    0.0,  0.0002546377329828424},
+        {4,    0.01462896151831013,                    0.0,  6.018432961087496e-05},
+        {4,    0.03769840812493139,                    0.0,  0.0001002286583263673},
+        {4,    0.06524701904096891,                    0.0,  0.0001315222931028093},
+        {4,    0.09560543416134648,                    0.0,  0.0001564213746876724},
+        {4,     0.1278335898929198,                    0.0,  0.0001765118841507736},
+        {4,     0.1613096104466031,                    0.0,   0.000192873709931108},
+        {4,     0.1955806225745371,                    0.0,   0.000206265853426327},
+        {4,     0.2302935218498028,                    0.0,  0.0002172395445953787},
+        {4,     0.2651584344113027,                    0.0,  0.0002262076188876047},
+        {4,     0.2999276825183209,                    0.0,  0.0002334885699462397},
+        {4,     0.3343828669718798,                    0.0,  0.0002393355273179203},
+        {4,     0.3683265013750518,                    0.0,  0.0002439559200468863},
+        {4,     0.4015763206518108,                    0.0,  0.0002475251866060002},
+        {4,      0.433961202639977,                    0.0,  0.0002501965558158773},
+        {4,     0.4653180651114582,                    0.0,  0.0002521081407925925},
+        {4,     0.4954893331080803,                    0.0,  0.0002533881002388081},
+        {4,      0.524320706892493,                    0.0,  0.0002541582900848261},
+        {4,     0.5516590479041704,                    0.0,   0.000254536573752586},
+        {4,     0.6012371927804177,                    0.0,  0.0002545726993066799},
+        {4,     0.6231574466449818,                    0.0,  0.0002544456197465555},
+        {4,     0.6429416514181271,                    0.0,  0.0002543481596881064},
+        {4,     0.6604124272943594,                    0.0,  0.0002543506451429194},
+        {4,      0.675385147040825,                    0.0,  0.0002544905675493763},
+        {4,      0.687671797062616,                    0.0,  0.0002547611407344429},
+        {4,     0.6970895061319234,                    0.0,  0.0002551060375448869},
+        {4,      0.703474691255331,                    0.0,  0.0002554291933816039},
+        {4,     0.7067017217542295,                    0.0,  0.0002556255710686343},
+        {5,    0.04382223501131123,                    0.0,  9.041339695118196e-05},
+        {5,     0.1117474077400006,                    0.0,  0.0001438426330079022},
+        {5,      0.189715325291144,                    0.0,  0.0001802523089820518},
+        {5,     0.2724023009910331,                    0.0,  0.0002060052290565496},
+        {5,     0.3567163308709902,                    0.0,  0.0002245002248967466},
+        {5,     0.4404784483028087,                    0.0,   0.000237705984773115},
+        {5,     0.5219833154161411,                    0.0,  0.0002468118955882525},
+        {5,     0.5998179868977553,                    0.0,  0.0002525410872966528},
+        {5,     0.6727803154548222,                    0.0,  0.0002553101409933397},
+        {6,    0.07476563943166085,    0.02193168509461185,  0.0001212879733668632},
+        {6,     0.1075341482001416,    0.04826419281533887,  0.0001472872881270931},
+        {6,     0.1416344885203259,    0.07751191883575742,  0.0001686846601010828},
+        {6,     0.1766325315388586,      0.108755813924768,  0.0001862698414660208},
+        {6,     0.2121744174481514,     0.1413661374253096,  0.0002007430956991861},
+        {6,     0.2479669443408145,      0.174876821425888,  0.0002126568125394796},
+        {6,     0.2837600452294113,     0.2089216406612073,  0.0002224394603372113},
+        {6,     0.3193344933193984,     0.2431987685545972,  0.0002304264522673135},
+        {6,     0.3544935442438745,      0.277449705437777,  0.0002368854288424087},
+        {6,     0.3890571932288154,     0.3114460356156915,  0.0002420352089461772},
+        {6,      0.422858121425909,     0.3449806851913012,  0.0002460597113081295},
+        {6,     0.4557387211304052,     0.3778618641248256,  0.0002491181912257687},
+        {6,     0.4875487950541643,     0.4099086391698978,  0.0002513528194205857},
+        {6,     0.5181436529962997,     0.4409474925853973,   0.000252894309669322},
+        {6,     0.5473824095600661,     0.4708094517711291,  0.0002538660368488136},
+        {6,     0.5751263398976174,     0.4993275140354637,  0.0002543868648299022},
+        {6,     0.1489515746840028,    0.02599381993267017,  0.0001642595537825183},
+        {6,     0.1863656444351767,     0.0547928653246219,  0.0001818246659849308},
+        {6,     0.2238602880356348,    0.08556763251425253,   0.000196656564949242},
+        {6,      0.261272337572816,     0.1177257802267011,  0.0002090677905657991},
+        {6,      0.298433299020619,       0.15081684561927,  0.0002193820409510504},
+        {6,     0.3351786584663333,     0.1844801892177727,  0.0002278870827661928},
+        {6,      0.371350552220912,     0.2184145236087598,   0.000234828319228209},
+        {6,     0.4067981098954663,     0.2523590641486229,  0.0002404139755581477},
+        {6,     0.4413769993687534,     0.2860812976901373,  0.0002448227407760734},
+        {6,     0.4749487182516394,     0.3193686757808996,  0.0002482110455592573},
+        {6,     0.5073798105075426,     0.3520226949547602,  0.0002507192397774103},
+        {6,     0.5385410448878654,      0.383854439566789,   0.000252476596853488},
+        {6,      0.568306535367053,     0.4146810037640963,  0.0002536052388539425},
+        {6,      0.596552762066351,     0.4443224094681121,  0.0002542230588033068},
+        {6,     0.2299227700856157,    0.02865757664057584,  0.0001944817013047896},
+        {6,     0.2695752998553267,    0.05923421684485993,  0.0002067862362746635},
+        {6,     0.3086178716611389,    0.09117817776057716,  0.0002172440734649114},
+        {6,     0.3469649871659077,     0.1240593814082605,  0.0002260125991723423},
+        {6,     0.3845153566319655,     0.1575272058259175,  0.0002332655008689523},
+        {6,     0.4211600033403215,     0.1912845163525413,  0.0002391699681532458},
+        {6,     0.4567867834329882,     0.2250710177858171,  0.0002438801528273928},
+        {6,     0.4912829319232061,      0.258652130344091,  0.0002475370504260665},
+        {6,     0.5245364793303812,     0.2918112242865407,  0.0002502707235640574},
+        {6,     0.5564369788915756,      0.324343923906789,  0.0002522031701054241},
+        {6,     0.5868757697775288,     0.3560536787835351,  0.0002534511269978784},
+        {6,     0.6157458853519617,     0.3867480821242581,  0.0002541284914955151},
+        {6,     0.3138461110672113,    0.03051374637507278,  0.0002161509250688394},
+        {6,     0.3542495872050569,    0.06237111233730755,  0.0002248778513437852},
+        {6,     0.3935751553120181,    0.09516223952401907,  0.0002322388803404617},
+        {6,     0.4317634668111147,     0.1285467341508517,  0.0002383265471001355},
+        {6,     0.4687413842250821,     0.1622318931656033,  0.0002432476675019525},
+        {6,     0.5044274237060283,     0.1959581153836453,  0.0002471122223750674},
+        {6,     0.5387354077925727,     0.2294888081183837,   0.000250029175248687},
+        {6,     0.5715768898356105,     0.2626031152713945,  0.0002521055942764682},
+        {6,     0.6028627200136111,     0.2950904075286713,  0.0002534472785575503},
+        {6,     0.6325039812653463,     0.3267458451113286,  0.0002541599713080121},
+        {6,     0.3981986708423407,    0.03183291458749821,  0.0002317380975862936},
+        {6,       0.43827911821333,    0.06459548193880908,  0.0002378550733719775},
+        {6,     0.4769233057218166,    0.09795757037087952,  0.0002428884456739118},
+        {6,     0.5140823911194238,     0.1316307235126655,  0.0002469002655757292},
+        {6,     0.5496977833862983,     0.1653556486358704,  0.0002499657574265851},
+        {6,     0.5837047306512727,      0.198893172412651,  0.0002521676168486082},
+        {6,     0.6160349566926879,      0.232017458143895,  0.0002535935662645334},
+        {6,      0.646618535320944,     0.2645106562168662,  0.0002543356743363214},
+        {6,     0.4810835158795404,    0.03275917807743992,  0.0002427353285201535},
+        {6,     0.5199925041324341,    0.06612546183967181,  0.0002468258039744386},
+        {6,     0.5571717692207494,    0.09981498331474142,   0.000250006095644031},
+        {6,     0.5925789250836379,     0.1335687001410374,  0.0002523238365420979},
+        {6,      0.626165852385967,     0.1671444402896463,  0.0002538399260252846},
+        {6,      0.657881112666933,     0.2003106382156076,  0.0002546255927268069},
+        {6,       0.56096246129981,    0.03337500940231335,  0.0002500583360048449},
+        {6,      0.597995965998467,    0.06708750335901803,  0.0002524777638260203},
+        {6,     0.6330523711054002,      0.100879212642485,  0.0002540951193860656},
+        {6,     0.6660960998103972,     0.1345050343171794,  0.0002549524085027472},
+        {6,     0.6365384364585819,    0.03372799460737052,  0.0002542569507009158},
+        {6,     0.6710994302899275,    0.06755249309678028,  0.0002552114127580376},
+        // 4802 points
+        {1,                    0.0,                    0.0,  9.687521879420705e-05},
+        {2,                    0.0,                    0.0,  0.0002307897895367918},
+        {3,                    0.0,                    0.0,  0.0002297310852498558},
+        {4,    0.02335728608887064,                    0.0,  7.386265944001918e-05},
+        {4,    0.04352987836550653,                    0.0,   8.25797769854221e-05},
+        {4,      0.064392005210888,                    0.0,   9.70604476205763e-05},
+        {4,     0.0900394363199318,                    0.0,  0.0001302393847117003},
+        {4,     0.1196706615548473,                    0.0,  0.0001541957004600968},
+        {4,     0.1511715412838134,                    0.0,  0.0001704459770092199},
+        {4,     0.1835982828503801,                    0.0,  0.0001827374890942906},
+        {4,     0.2165081259155405,                    0.0,  0.0001926360817436107},
+        {4,     0.2496208720417563,                    0.0,  0.0002008010239494833},
+        {4,       0.28272006735679,                    0.0,  0.0002075635983209175},
+        {4,     0.3156190823994346,                    0.0,  0.0002131306638690909},
+        {4,     0.3481476793749115,                    0.0,  0.0002176562329937335},
+        {4,     0.3801466086947226,                    0.0,  0.0002212682262991018},
+        {4,     0.4114652119634011,                    0.0,  0.0002240799515668565},
+        {4,     0.4419598786519751,                    0.0,  0.0002261959816187525},
+        {4,     0.4714925949329543,                    0.0,  0.0002277156368808855},
+        {4,     0.4999293972879466,                    0.0,  0.0002287351772128336},
+        {4,     0.5271387221431248,                    0.0,  0.0002293490814084085},
+        {4,     0.5529896780837761,                    0.0,  0.0002296505312376273},
+        {4,     0.6000856099481712,                    0.0,  0.0002296793832318756},
+        {4,     0.6210562192785175,                    0.0,  0.0002295785443842974},
+        {4,      0.640116587993424,                    0.0,  0.0002295017931529102},
+        {4,     0.6571144029244333,                    0.0,  0.0002295059638184868},
+        {4,     0.6718910821718863,                    0.0,  0.0002296232343237362},
+        {4,      0.684284559109901,                    0.0,  0.0002298530178740771},
+        {4,     0.6941353476269816,                    0.0,  0.0002301579790280501},
+        {4,     0.7012965242212991,                    0.0,  0.0002304690404996513},
+        {4,     0.7056471428242644,                    0.0,  0.0002307027995907102},
+        {5,    0.04595557643585895,                    0.0,  9.312274696671092e-05},
+        {5,     0.1049316742435023,                    0.0,  0.0001199919385876926},
+        {5,     0.1773548879549274,                    0.0,   0.000159803913887769},
+        {5,     0.2559071411236127,                    0.0,    0.00018222537635749},
+        {5,     0.3358156837985898,                    0.0,   0.000198857959365504},
+        {5,     0.4155835743763893,                    0.0,  0.0002112620102533307},
+        {5,     0.4937894296167472,                    0.0,  0.0002201594887699007},
+        {5,     0.5691569694793316,                    0.0,  0.0002261622590895036},
+        {5,     0.6405840854894251,                    0.0,  0.0002296458453435705},
+        {6,    0.07345133894143348,    0.02177844081486067,     0.0001006006990267},
+        {6,     0.1009859834044931,    0.04590362185775188,  0.0001227676689635876},
+        {6,     0.1324289619748758,    0.07255063095690877,  0.0001467864280270117},
+        {6,     0.1654272109607127,     0.1017825451960684,  0.0001644178912101232},
+        {6,     0.1990767186776461,     0.1325652320980364,  0.0001777664890718961},
+        {6,     0.2330125945523278,     0.1642765374496765,   0.000188482566451669},
+        {6,     0.2670080611108287,     0.1965360374337889,  0.0001973269246453848},
+        {6,     0.3008753376294316,     0.2290726770542238,  0.0002046767775855328},
+        {6,      0.334447559616786,     0.2616645495370823,   0.000210760012591804},
+        {6,     0.3675709724070786,     0.2941150728843141,  0.0002157416362266829},
+        {6,     0.4001000887587812,     0.3262440400919066,  0.0002197557816920721},
+        {6,     0.4318956350436028,     0.3578835350611916,  0.0002229192611835437},
+        {6,     0.4628239056795531,     0.3888751854043678,  0.0002253385110212775},
+        {6,     0.4927563229773636,      0.419067800322284,  0.0002271137107548774},
+        {6,     0.5215687136707969,     0.4483151836883852,  0.0002283414092917525},
+        {6,     0.5491402346984905,      0.476474067608788,  0.0002291161673130077},
+        {6,     0.5753520160126075,     0.5034021310998277,  0.0002295313908576598},
+        {6,     0.1388326356417754,    0.02435436510372806,  0.0001438204721359031},
+        {6,     0.1743686900537244,    0.05118897057342652,  0.0001607738025495257},
+        {6,     0.2099737037950268,    0.08014695048539634,  0.0001741483853528379},
+        {6,     0.2454492590908548,     0.1105117874155699,  0.0001851918467519151},
+        {6,     0.2807219257864278,     0.1417950531570966,  0.0001944628638070613},
+        {6,     0.3156842271975842,     0.1736604945719597,  0.0002022495446275152},
+        {6,     0.3502090945177752,     0.2058466324693981,  0.0002087462382438514},
+        {6,     0.3841684849519686,     0.2381284261195919,  0.0002141074754818308},
+        {6,     0.4174372367906016,     0.2703031270422569,  0.0002184640913748162},
+        {6,     0.4498926465011892,     0.3021845683091309,  0.0002219309165220329},
+        {6,     0.4814146229807701,      0.333599335516572,  0.0002246123118340624},
+        {6,     0.5118863625734701,     0.3643833735518232,  0.0002266062766915125},
+        {6,     0.5411947455119144,     0.3943789541958179,  0.0002280072952230796},
+        {6,     0.5692301500357246,     0.4234320144403542,  0.0002289082025202583},
+        {6,     0.5958857204139576,      0.451389794741926,  0.0002294012695120025},
+        {6,     0.2156270284785766,    0.02681225755444491,  0.0001722434488736947},
+        {6,      0.253238505490971,    0.05557495747805614,  0.0001830237421455091},
+        {6,     0.2902564617771537,    0.08569368062950249,  0.0001923855349997633},
+        {6,     0.3266979823143256,     0.1167367450324135,  0.0002004067861936271},
+        {6,     0.3625039627493614,     0.1483861994003304,  0.0002071817297354263},
+        {6,     0.3975838937548699,     0.1803821503011405,  0.0002128250834102103},
+        {6,     0.4318396099009774,     0.2124962965666424,  0.0002174513719440102},
+        {6,     0.4651706555732742,     0.2445221837805913,  0.0002211661839150214},
+        {6,     0.4974752649620969,     0.2762701224322987,  0.0002240665257813102},
+        {6,     0.5286517579627517,     0.3075627775211328,   0.000226243951663262},
+        {6,     0.5586001195731894,     0.3382311089826877,  0.0002277874557231869},
+        {6,     0.5872229902021319,     0.3681108834741399,  0.0002287854314454994},
+        {6,     0.6144258616235123,     0.3970397446872839,  0.0002293268499615575},
+        {6,     0.2951676508064861,    0.02867499538750441,  0.0001912628201529828},
+        {6,     0.3335085485472725,     0.0586787934190351,  0.0001992499672238701},
+        {6,     0.3709561760636381,    0.08961099205022284,  0.0002061275533454027},
+        {6,     0.4074722861667498,     0.1211627927626297,  0.0002119318215968572},
+        {6,     0.4429923648839117,     0.1530748903554898,  0.0002167416581882652},
+        {6,     0.4774428052721736,     0.1851176436721877,    0.00022064307305166},
+        {6,     0.5107446539535904,     0.2170829107658179,  0.0002237186938699523},
+        {6,     0.5428151370542935,     0.2487786689026271,  0.0002260480075032884},
+        {6,     0.5735699292556964,     0.2800239952795016,  0.0002277098884558542},
+        {6,     0.6029253794562865,     0.3106445702878119,  0.0002287845715109671},
+        {6,     0.6307998987073145,     0.3404689500841194,  0.0002293547268236294},
+        {6,     0.3752652273692719,    0.02997145098184479,  0.0002056073839852528},
+        {6,     0.4135383879344028,    0.06086725898678011,  0.0002114235865831876},
+        {6,     0.4506113885153907,    0.09238849548435643,  0.0002163175629770551},
+        {6,     0.4864401554606072,     0.1242786603851851,   0.000220339215811165},
+        {6,     0.5209708076611709,     0.1563086731483386,  0.0002235473176847839},
+        {6,     0.5541422135830122,     0.1882696509388506,  0.0002260024141501235},
+        {6,     0.5858880915113817,     0.2199672979126059,  0.0002277675929329182},
+        {6,     0.6161399390603444,     0.2512165482924867,  0.0002289102112284834},
+        {6,      0.644829648225509,     0.2818368701871888,  0.0002295027954625118},
+        {6,     0.4544796274917948,    0.03088970405060312,  0.0002161281589879992},
+        {6,     0.4919389072146628,    0.06240947677636835,  0.0002201980477395102},
+        {6,     0.5279313026985183,    0.09430706144280313,  0.0002234952066593166},
+        {6,     0.5624169925571135,     0.1263547818770374,  0.0002260540098520838},
+        {6,     0.5953484627093287,     0.1583430788822594,  0.0002279157981899988},
+        {6,     0.6266730715339185,     0.1900748462555988,  0.0002291296918565571},
+        {6,     0.6563363204278871,     0.2213599519592567,  0.0002297533752536649},
+        {6,     0.5314574716585696,    0.03152508811515374,  0.0002234927356465995},
+        {6,     0.5674614932298185,    0.06343865291465561,  0.0002261288012985219},
+        {6,     0.6017706004970264,    0.09551503504223952,  0.0002280818160923688},
+        {6,     0.6343471270264178,     0.1275440099801196,  0.0002293773295180159},
+        {6,     0.6651494599127802,      0.159325203767196,  0.0002300528767338634},
+        {6,     0.6050184986005704,    0.03192538338496105,  0.0002281893855065666},
+        {6,       0.63901635508804,    0.06402824353962305,  0.0002295720444840727},
+        {6,     0.6711199107088448,    0.09609805077002909,  0.0002303227649026753},
+        {6,     0.6741354429572275,    0.03211853196273233,  0.0002304831913227114},
+        // 5294 points
+        {1,                    0.0,                    0.0,  9.080510764308163e-05},
+        {3,                    0.0,                    0.0,  0.0002084824361987793},
+        {4,     0.0230326168626145,                    0.0,  5.011105657239616e-05},
+        {4,    0.03757208620162394,                    0.0,  5.942520409683854e-05},
+        {4,    0.05821912033821852,                    0.0,  9.564394826109721e-05},
+        {4,    0.08403127529194872,                    0.0,  0.0001185530657126338},
+        {4,     0.1122927798060578,                    0.0,  0.0001364510114230331},
+        {4,     0.1420125319192987,                    0.0,  0.0001505828825605415},
+        {4,     0.1726396437341978,                    0.0,  0.0001619298749867023},
+        {4,     0.2038170058115696,                    0.0,  0.0001712450504267789},
+        {4,     0.2352849892876508,                    0.0,  0.0001789891098164999},
+        {4,     0.2668363354312461,                    0.0,  0.0001854474955629795},
+        {4,     0.2982941279900452,                    0.0,  0.0001908148636673661},
+        {4,     0.3295002922087076,                    0.0,  0.0001952377405281833},
+        {4,     0.3603094918363593,                    0.0,  0.0001988349254282232},
+        {4,      0.390585789517392,                    0.0,   0.000201707980716005},
+        {4,     0.4202005758160837,                    0.0,  0.0002039473082709094},
+        {4,     0.4490310061597227,                    0.0,  0.0002056360279288953},
+        {4,     0.4769586160311491,                    0.0,  0.0002068525823066865},
+        {4,      0.503867988704975,                    0.0,  0.0002076724877534488},
+        {4,     0.5296454286519962,                    0.0,  0.0002081694278237885},
+        {4,      0.554177620716485,                    0.0,  0.0002084157631219326},
+        {4,     0.5990467321921213,                    0.0,  0.0002084381531128593},
+        {4,     0.6191467096294587,                    0.0,  0.0002083476277129307},
+        {4,     0.6375251212901849,                    0.0,  0.0002082686194459732},
+        {4,     0.6540514381131168,                    0.0,  0.0002082475686112415},
+        {4,      0.668589906439151,                    0.0,  0.0002083139860289915},
+        {4,     0.6810013009681648,                    0.0,  0.0002084745561831237},
+        {4,      0.691146957873034,                    0.0,   0.000208709131337589},
+        {4,     0.6988956915141736,                    0.0,  0.0002089718413297697},
+        {4,      0.704133579486872,                    0.0,  0.0002092003303479793},
+        {4,     0.7067754398018568,                    0.0,  0.0002093336148263241},
+        {5,    0.03840368707853623,                    0.0,  7.591708117365266e-05},
+        {5,    0.09835485954117398,                    0.0,  0.0001083383968169186},
+        {5,     0.1665774947612998,                    0.0,   0.000140301939529251},
+        {5,      0.240570233536291,                    0.0,  0.0001615970179286436},
+        {5,     0.3165270770189046,                    0.0,  0.0001771144187504911},
+        {5,     0.3927386145645443,                    0.0,  0.0001887760022988168},
+        {5,     0.4678825918374656,                    0.0,  0.0001973474670768214},
+        {5,     0.5408022024266935,                    0.0,  0.0002033787661234659},
+        {5,     0.6104967445752438,                    0.0,  0.0002072343626517331},
+        {5,     0.6760910702685738,                    0.0,  0.0002091177834226918},
+        {6,    0.06655644120217392,    0.01936508874588424,  9.316684484675566e-05},
+        {6,    0.09446246161270182,    0.04252442002115869,  0.0001116193688682976},
+        {6,     0.1242651925452509,    0.06806529315354375,  0.0001298623551559414},
+        {6,     0.1553438064846751,    0.09560957491205369,  0.0001450236832456426},
+        {6,      0.187113711054267,     0.1245931657452888,  0.0001572719958149914},
+        {6,     0.2192612628836257,     0.1545385828778978,  0.0001673234785867195},
+        {6,     0.2515682807206955,     0.1851004249723368,  0.0001756860118725188},
+        {6,      0.283853586628729,     0.2160182608272384,  0.0001826776290439367},
+        {6,     0.3159578817528521,     0.2470799012277111,  0.0001885116347992865},
+        {6,     0.3477370882791392,     0.2781014208986402,  0.0001933457860170574},
+        {6,      0.379057696089054,     0.3089172523515731,  0.0001973060671902064},
+        {6,       0.40979383178102,     0.3393750055472244,  0.0002004987099616311},
+        {6,     0.4398256572859637,      0.369332247098773,  0.0002030170909281499},
+        {6,      0.469038411471848,     0.3986541005609877,   0.000204946146011908},
+        {6,     0.4973216048301053,     0.4272112491408562,  0.0002063653565200186},
+        {6,     0.5245681526132446,     0.4548781735309936,  0.0002073507927381027},
+        {6,     0.5506733911803888,     0.4815315355023251,  0.0002079764593256122},
+        {6,     0.5755339829522474,     0.5070486445801855,  0.0002083150534968778},
+        {6,     0.1305472386056362,    0.02284970375722366,  0.0001262715121590664},
+        {6,     0.1637327908216477,    0.04812254338288384,  0.0001414386128545972},
+        {6,     0.1972734634149637,    0.07531734457511935,  0.0001538740401313898},
+        {6,      0.230869465311013,     0.1039043639882017,  0.0001642434942331432},
+        {6,      0.264389921833816,     0.1334526587117626,  0.0001729790609237496},
+        {6,     0.2977171599622171,     0.1636414868936382,  0.0001803505190260828},
+        {6,      0.330729390303231,     0.1942195406166568,  0.0001865475350079657},
+        {6,     0.3633069198219073,     0.2249752879943753,  0.0001917182669679069},
+        {6,     0.3953346955922727,     0.2557218821820032,  0.0001959851709034382},
+        {6,     0.4267018394184914,     0.2862897925213193,  0.0001994529548117882},
+        {6,     0.4573009622571704,     0.3165224536636518,  0.0002022138911146548},
+        {6,     0.4870279559856109,     0.3462730221636496,  0.0002043518024208592},
+        {6,     0.5157819581450322,     0.3754016870282835,   0.000205945031301811},
+        {6,     0.5434651666465393,     0.4037733784993613,  0.0002070685715318472},
+        {6,     0.5699823887764627,     0.4312557784139123,  0.0002077955310694373},
+        {6,     0.5952403350947741,      0.457717536712211,  0.0002081980387824712},
+        {6,     0.2025152599210369,    0.02520253617719557,  0.0001521318610377956},
+        {6,     0.2381066653274425,       0.05223254506119,  0.0001622772720185755},
+        {6,     0.2732823383651612,     0.0806066968858862,  0.0001710498139420709},
+        {6,     0.3080137692611118,     0.1099335754081255,  0.0001785911149448736},
+        {6,     0.3422405614587601,     0.1399120955959857,  0.0001850125313687736},
+        {6,      0.375880877389042,     0.1702977801651705,  0.0001904229703933298},
+        {6,     0.4088458383438932,      0.200879925660168,  0.0001949259956121987},
+        {6,     0.4410450550841152,     0.2314703052180836,   0.000198616154536396},
+        {6,     0.4723879420561312,     0.2618972111375892,   0.000201579058564137},
+        {6,     0.5027843561874343,      0.292001319560027,  0.0002038934198707418},
+        {6,     0.5321453674452458,     0.3216322555190551,  0.0002056334060538251},
+        {6,      0.560383911383403,     0.3506456615934198,  0.0002068705959462289},
+        {6,     0.5874150706875146,     0.3789007181306267,  0.0002076753906106002},
+        {6,     0.6131559381660038,     0.4062580170572782,  0.0002081179391734803},
+        {6,     0.2778497016394506,    0.02696271276876226,  0.0001700345216228943},
+        {6,     0.3143733562261912,    0.05523469316960465,   0.000177490677999041},
+        {6,     0.3501485810261827,    0.08445193201626464,  0.0001839659377002642},
+        {6,     0.3851430322303653,     0.1143263119336083,  0.0001894987462975169},
+        {6,     0.4193013979470415,     0.1446177898344475,  0.0001941548809452595},
+        {6,     0.4525585960458567,     0.1751165438438091,  0.0001980078427252384},
+        {6,     0.4848447779622947,      0.205633830674566,  0.0002011296284744488},
+        {6,     0.5160871208276894,     0.2359965487229226,  0.0002035888456966776},
+        {6,     0.5462112185696926,     0.2660430223139146,  0.0002054516325352142},
+        {6,     0.5751425068101756,     0.2956193664498032,  0.0002067831033092635},
+        {6,     0.6028073872853597,     0.3245763905312779,  0.0002076485320284876},
+        {6,     0.6291338275278409,     0.3527670026206972,  0.0002081141439525255},
+        {6,     0.3541797528439391,     0.0282385347943555,  0.0001834383015469222},
+        {6,     0.3908234972074657,    0.05741296374713106,  0.0001889540591777677},
+        {6,      0.426440845010759,    0.08724646633650199,  0.0001936677023597375},
+        {6,     0.4609949666553286,     0.1175034422915616,  0.0001976176495066504},
+        {6,     0.4944389496536006,     0.1479755652628428,  0.0002008536004560983},
+        {6,     0.5267194884346086,     0.1784740659484352,  0.0002034280351712291},
+        {6,      0.557778781022099,     0.2088245700431244,  0.0002053944466027758},
+        {6,      0.587556376353667,     0.2388628136570763,   0.000206807764288236},
+        {6,     0.6159910016391269,     0.2684308928769185,  0.0002077250949661599},
+        {6,     0.6430219602956267,     0.2973740761960252,   0.000208206244070532},
+        {6,     0.4300647036213646,    0.02916399920493977,  0.0001934374486546626},
+        {6,     0.4661486308935531,    0.05898803024755659,    0.00019741070104843},
+        {6,     0.5009658555287261,    0.08924162698525409,  0.0002007129290388658},
+        {6,     0.5344824270447704,     0.1197185199637321,  0.0002033736947471293},
+        {6,     0.5666575997416371,     0.1502300756161382,  0.0002054287125902493},
+        {6,     0.5974457471404752,     0.1806004191913564,  0.0002069184936818894},
+        {6,     0.6267984444116886,     0.2106621764786252,  0.0002078883689808782},
+        {6,     0.6546664713575417,     0.2402526932671914,  0.0002083886366116359},
+        {6,     0.5042711004437253,    0.02982529203607657,  0.0002006593275470817},
+        {6,      0.539212745677438,    0.06008728062339922,  0.0002033728426135397},
+        {6,     0.5726819437668618,    0.09058227674571398,  0.0002055008781377608},
+        {6,     0.6046469254207278,       0.12112192358034,  0.0002070651783518502},
+        {6,     0.6350716157434952,      0.151528640479158,   0.000208095333509432},
+        {6,     0.6639177679185454,     0.1816314681255552,  0.0002086284998988521},
+        {6,     0.5757276040972253,     0.0302699175257544,  0.0002055549387644668},
+        {6,     0.6090265823139756,     0.0607840229787077,  0.0002071871850267654},
+        {6,     0.6406735344387661,    0.09135459984176636,  0.0002082856600431965},
+        {6,     0.6706397927793709,      0.121802415596659,  0.0002088705858819358},
+        {6,     0.6435019674426665,    0.03052608357660639,  0.0002083995867536322},
+        {6,     0.6747218676375681,    0.06112185773983089,  0.0002090509712889637},
+        // 5810 points
+        {1,                    0.0,                    0.0,  9.735347946175486e-06},
+        {2,                    0.0,                    0.0,  0.0001907581241803167},
+        {3,                    0.0,                    0.0,  0.0001901059546737578},
+        {4,    0.01182361662400277,                    0.0,  3.926424538919212e-05},
+        {4,    0.03062145009138958,                    0.0,  6.667905467294381e-05},
+        {4,    0.05329794036834243,                    0.0,  8.868891315019136e-05},
+        {4,     0.0784816553286222,                    0.0,  0.0001066306000958872},
+        {4,     0.1054038157636201,                    0.0,  0.0001214506743336128},
+        {4,     0.1335577797766211,                    0.0,  0.0001338054681640871},
+        {4,     0.1625769955502252,                    0.0,  0.0001441677023628504},
+        {4,     0.1921787193412792,                    0.0,  0.0001528880200826557},
+        {4,     0.2221340534690548,                    0.0,  0.0001602330623773609},
+        {4,     0.2522504912791132,                    0.0,  0.0001664102653445244},
+        {4,     0.2823610860679697,                    0.0,  0.0001715845854011323},
+        {4,      0.312317396626756,                    0.0,  0.0001758901000133069},
+        {4,     0.3419847036953789,                    0.0,  0.0001794382485256736},
+        {4,     0.3712386456999758,                    0.0,  0.0001823238106757407},
+        {4,     0.3999627649876828,                    0.0,  0.0001846293252959976},
+        {4,     0.4280466458648093,                    0.0,  0.0001864284079323098},
+        {4,     0.4553844360185711,                    0.0,  0.0001877882694626914},
+        {4,     0.4818736094437834,                    0.0,  0.0001887716321852025},
+        {4,     0.5074138709260629,                    0.0,  0.0001894381638175673},
+        {4,     0.5319061304570707,                    0.0,  0.0001898454899533629},
+        {4,     0.5552514978677286,                    0.0,  0.0001900497929577815},
+        {4,     0.5981009025246183,                    0.0,  0.0001900671501924092},
+        {4,     0.6173990192228116,                    0.0,   0.000189983755553351},
+        {4,     0.6351365239411131,                    0.0,  0.0001899014113156229},
+        {4,       0.65120102282272,                    0.0,  0.0001898581257705106},
+        {4,      0.665475836394812,                    0.0,  0.0001898804756095753},
+        {4,      0.677841041485337,                    0.0,  0.0001899793610426402},
+        {4,      0.688176088748411,                    0.0,  0.0001901464554844117},
+        {4,     0.6963645267094598,                    0.0,  0.0001903533246259542},
+        {4,     0.7023010617153579,                    0.0,  0.0001905556158463228},
+        {4,     0.7059004636628753,                    0.0,  0.0001907037155663528},
+        {5,    0.03552470312472575,                    0.0,  5.992997844249967e-05},
+        {5,    0.09151176620841284,                    0.0,  9.749059382456977e-05},
+        {5,      0.156619793006898,                    0.0,  0.0001241680804599158},
+        {5,     0.2265467599271907,                    0.0,   0.000143762615429936},
+        {5,     0.2988242318581361,                    0.0,  0.0001584200054793902},
+        {5,     0.3717482419703886,                    0.0,  0.0001694436550982744},
+        {5,     0.4440094491758889,                    0.0,  0.0001776617014018108},
+        {5,     0.5145337096756643,                    0.0,  0.0001836132434440077},
+        {5,      0.582405367286023,                    0.0,  0.0001876494727075983},
+        {5,      0.646828396104337,                    0.0,  0.0001899906535336482},
+        {6,    0.06095964259104373,    0.01787828275342931,   8.14325282076735e-05},
+        {6,    0.08811962270959388,    0.03953888740792096,  9.998859890887728e-05},
+        {6,     0.1165936722428831,     0.0637812179772299,  0.0001156199403068359},
+        {6,     0.1460232857031785,    0.08985890813745037,  0.0001287632092635513},
+        {6,     0.1761197110181755,     0.1172606510576162,  0.0001398378643365139},
+        {6,     0.2066471190463718,     0.1456102876970995,  0.0001491876468417391},
+        {6,     0.2374076026328152,     0.1746153823011775,  0.0001570855679175456},
+        {6,     0.2682305474337051,     0.2040383070295584,  0.0001637483948103775},
+        {6,     0.2989653312142369,     0.2336788634003698,  0.0001693500566632843},
+        {6,     0.3294762752772209,     0.2633632752654219,  0.0001740322769393633},
+        {6,     0.3596390887276086,     0.2929369098051601,  0.0001779126637278296},
+        {6,     0.3893383046398812,     0.3222592785275512,  0.0001810908108835412},
+        {6,     0.4184653789358347,     0.3512004791195743,   0.000183652913260019},
+        {6,     0.4469172319076166,     0.3796385677684537,  0.0001856752841777379},
+        {6,     0.4745950813276976,     0.4074575378263879,  0.0001872270566606832},
+        {6,     0.5014034601410262,     0.4345456906027828,  0.0001883722645591307},
+        {6,      0.527249340455124,     0.4607942515205134,  0.0001891714324525297},
+        {6,     0.5520413051846366,      0.486096128418172,  0.0001896827480450146},
+        {6,     0.5756887237503077,      0.510344739534279,  0.0001899628417059528},
+        {6,     0.1225039430588352,    0.02136455922655793,  0.0001123301829001669},
+        {6,     0.1539113217321372,    0.04520926166137188,  0.0001253698826711277},
+        {6,     0.1856213098637712,    0.07086468177864819,  0.0001366266117678531},
+        {6,     0.2174998728035131,    0.09785239488772918,  0.0001462736856106918},
+        {6,      0.249412833693833,      0.125810639626721,  0.0001545076466685412},
+        {6,      0.281232156214348,     0.1544529125047001,  0.0001615096280814007},
+        {6,     0.3128372276456111,     0.1835433512202753,  0.0001674366639741759},
+        {6,     0.3441145160177973,     0.2128813258619585,    0.00017242250024379},
+        {6,      0.374956771485351,     0.2422913734880829,  0.0001765810822987288},
+        {6,      0.405262173201561,     0.2716163748391453,  0.0001800104126010751},
+        {6,     0.4349335453522385,      0.300712767124028,  0.0001827960437331284},
+        {6,     0.4638776641524965,     0.3294470677216479,  0.0001850140300716308},
+        {6,     0.4920046410462687,     0.3576932543699155,  0.0001867333507394938},
+        {6,     0.5192273554861704,     0.3853307059757764,  0.0001880178688638289},
+        {6,     0.5454609081136522,     0.4122425044452694,  0.0001889278925654758},
+        {6,      0.570622066142414,     0.4383139587781027,  0.0001895213832507346},
+        {6,     0.5946286755181518,     0.4634312536300553,   0.000189854827739742},
+        {6,     0.1905370790924295,    0.02371311537781979,  0.0001349105935937341},
+        {6,     0.2242518717748009,    0.04917878059254806,  0.0001444060068369326},
+        {6,     0.2577190808025936,    0.07595498960495142,  0.0001526797390930008},
+        {6,     0.2908724534927187,       0.10369910831911,  0.0001598208771406474},
+        {6,     0.3236354020056219,     0.1321348584450234,  0.0001659354368615331},
+        {6,     0.3559267359304543,     0.1610316571314789,   0.000171127991094644},
+        {6,     0.3876637123676956,     0.1901912080395707,   0.000175495272560144},
+        {6,     0.4187636705218842,      0.219438495013795,  0.0001791247850802529},
+        {6,     0.4491449019883107,     0.2486155334763858,  0.0001820954300877716},
+        {6,     0.4787270932425445,     0.2775768931812335,  0.0001844788524548449},
+        {6,     0.5074315153055574,      0.306186378659112,   0.000186340948170622},
+        {6,     0.5351810507738336,     0.3343144718152556,  0.0001877433008795068},
+        {6,     0.5619001025975381,     0.3618362729028427,  0.0001887444543705232},
+        {6,     0.5875144035268046,     0.3886297583620408,  0.0001894009829375006},
+        {6,     0.6119507308734495,     0.4145742277792031,  0.0001897683345035198},
+        {6,     0.2619733870119463,    0.02540047186389353,  0.0001517327037467653},
+        {6,     0.2968149743237949,    0.05208107018543989,  0.0001587740557483543},
+        {6,     0.3310451504860488,    0.07971828470885599,  0.0001649093382274097},
+        {6,     0.3646215567376676,     0.1080465999177927,  0.0001701915216193265},
+        {6,      0.397491678527936,     0.1368413849366629,  0.0001746847753144065},
+        {6,     0.4295967403772029,     0.1659073184763559,   0.000178455551200757},
+        {6,     0.4608742854473447,     0.1950703730454614,  0.0001815687562112174},
+        {6,     0.4912598858949903,     0.2241721144376724,  0.0001840864370663302},
+        {6,     0.5206882758945558,     0.2530655255406489,  0.0001860676785390006},
+        {6,      0.549094091401982,     0.2816118409731066,  0.0001875690583743703},
+        {6,     0.5764123302025542,     0.3096780504593238,  0.0001886453236347225},
+        {6,     0.6025786004213506,     0.3371348366394987,  0.0001893501123329645},
+        {6,     0.6275291964794956,     0.3638547827694396,  0.0001897366184519868},
+        {6,     0.3348189479861771,    0.02664841935537443,  0.0001643908815152736},
+        {6,     0.3699515545855295,    0.05424000066843495,  0.0001696300350907768},
+        {6,     0.4042003071474669,    0.08251992715430854,  0.0001741553103844483},
+        {6,     0.4375320100182624,      0.111269518248371,  0.0001780015282386092},
+        {6,     0.4699054490335947,     0.1402964116467816,  0.0001812116787077125},
+        {6,     0.5012739879431952,     0.1694275117584291,  0.0001838323158085421},
+        {6,     0.5315874883754966,     0.1985038235312689,  0.0001859113119837737},
+        {6,     0.5607937109622116,     0.2273765660020893,  0.0001874969220221698},
+        {6,      0.588839322349552,     0.2559041492849764,  0.0001886375612681076},
+        {6,     0.6156705979160163,     0.2839497251976899,  0.0001893819575809276},
+        {6,     0.6412338809078123,      0.311379106050069,  0.0001897794748256767},
+        {6,     0.4076051259257167,    0.02757792290858463,  0.0001738963926584846},
+        {6,      0.442378812579152,    0.05584136834984293,  0.0001777442359873466},
+        {6,     0.4760480917328258,    0.08457772087727143,  0.0001810010815068719},
+        {6,     0.5085838725946297,     0.1135975846359248,  0.0001836920318248129},
+        {6,     0.5399513637391218,     0.1427286904765053,  0.0001858489473214328},
+        {6,      0.570111843363638,     0.1718112740057635,  0.0001875079342496592},
+        {6,     0.5990240530606021,     0.2006944855985351,   0.000188708023910231},
+        {6,     0.6266452685139695,     0.2292335090598907,  0.0001894905752176822},
+        {6,     0.6529320971415942,     0.2572871512353714,  0.0001898991061200695},
+        {6,     0.4791583834610126,    0.02826094197735932,  0.0001809065016458791},
+        {6,      0.513037395279694,    0.05699871359683649,  0.0001836297121596799},
+        {6,     0.5456252429628476,    0.08602712528554395,  0.0001858426916241869},
+        {6,     0.5768956329682385,     0.1151748137221281,  0.0001875654101134641},
+        {6,     0.6068186944699046,     0.1442811654136362,  0.0001888240751833503},
+        {6,     0.6353622248024907,      0.173193032165768,  0.0001896497383866979},
+        {6,     0.6624927035731797,     0.2017619958756061,  0.0001900775530219121},
+        {6,     0.5484933508028488,    0.02874219755907391,  0.0001858525041478814},
+        {6,     0.5810207682142106,    0.05778312123713695,  0.0001876248690077947},
+        {6,     0.6120955197181353,    0.08695262371439526,  0.0001889404439064607},
+        {6,     0.6416944284294319,     0.1160893767057166,   0.000189816853926529},
+        {6,      0.669792639173126,     0.1450378826743251,  0.0001902779940661772},
+        {6,     0.6147594390585488,    0.02904957622341456,  0.0001890125641731815},
+        {6,     0.6455390026356783,    0.05823809152617197,  0.0001899434637795751},
+        {6,     0.6747258588365477,    0.08740384899884715,  0.0001904520856831751},
+        {6,     0.6772135750395347,    0.02919946135808105,  0.0001905534498734563}
     };
+
+    /**
+     * @brief      get the index of the first point of a Lebedev order in
+     *             the table of all Lebedev points
+     *
+     * @param[in]  order  Lebedev order (LEBEDEV_6, ..., LEBEDEV_5810)
+     *
+     * @return     index
+     */
+    static constexpr unsigned int get_lebedev_offset(unsigned int order) {
+        unsigned int offset = 0;
+        for(unsigned int i=0; i<order && i<NUM_LEBEDEV_POINTS; i++) {
+            offset += num_lebedev_points[i];
+        }
+        return offset;
+    }
+
+    /**
+     * @brief      get the index of the first generator of a Lebedev order
+     *
+     * @param[in]  order  Lebedev order (LEBEDEV_6, ..., LEBEDEV_5810)
+     *
+     * @return     index
+     */
+    static constexpr unsigned int get_lebedev_generator_offset(unsigned int order) {
+        unsigned int offset = 0;
+        for(unsigned int i=0; i<order && i<NUM_LEBEDEV_POINTS; i++) {
+            offset += num_lebedev_generators[i];
+        }
+        return offset;
+    }
+
+    /* total number of points over all orders */
+    static constexpr unsigned int num_lebedev_coefficients = 46976;
+
+    /* points and weights of all orders (generated at compile time) */
+    static const LebedevTable lebedev_table;
+
+    /**
+     * @brief      get the points and weights of a Lebedev grid
+     *
+     * @param[in]  order  Lebedev order (LEBEDEV_6, ..., LEBEDEV_5810)
+     *
+     * @return     points of the grid
+     */
+    static LebedevSpan get_lebedev(unsigned int order);
+
+    /**
+     * @brief      get the Lebedev order from its number of points
+     *
+     * @param[in]  npoints  number of points (6, 14, ..., 5810)
+     *
+     * @return     Lebedev order
+     */
+    static unsigned int get_lebedev_order(unsigned int npoints);
+
+    /**
+     * @brief      get the nodes and weights of an n-point Gauss-Chebyshev
+     *             rule (second kind) for unweighted integrals over [-1,1]
+     *
+     * Uses the transformation of Perez-Jorda, San-Fabian and Moscardo
+     * (Phys. Rev. A 45 (1992) 6425), for which the error decreases
+     * exponentially with n for smooth functions.
+     *
+     * @param[in]  n     number of nodes
+     * @param[out] x     nodes
+     * @param[out] w     weights
+     */
+    static void get_gauss_chebyshev(unsigned int n, std::vector<double>& x, std::vector<double>& w);
 };
 
+/**
+ * @brief      all Lebedev grids, stored consecutively in order
+ */
+struct LebedevTable {
+    LebedevPoint points[Quadrature::num_lebedev_coefficients];
+};
+
+static_assert(Quadrature::get_lebedev_offset(Quadrature::NUM_LEBEDEV_POINTS) == Quadrature::num_lebedev_coefficients,
+              "Number of Lebedev points does not match the table sizes");
+static_assert(Quadrature::get_lebedev_generator_offset(Quadrature::NUM_LEBEDEV_POINTS) == Quadrature::num_lebedev_generators_total,
+              "Number of Lebedev generators does not match the table sizes");
+
 #endif //_QUADRATURE_H
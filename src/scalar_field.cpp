@@ -19,6 +19,21 @@
  **************************************************************************/
 
 #include "scalar_field.h"
+#include "grid_archive.h"
+
+#include <exception>
+
+namespace {
+
+/**
+ * @brief      thrown when the dense bricks of a grid that is compacted while
+ *             reading exceed the memory budget
+ */
+struct budget_exceeded {
+    double fraction;    //!< fraction of the grid that has been read
+};
+
+} // namespace
 
 /**
  * @brief      constructor
@@ -32,11 +47,17 @@ ScalarField::ScalarField(const std::string &_filename, bool _flag_is_locpot) {
     this->vasp5_input = false;
     this->has_read = false;
     this->header_read = false;
+    this->budget_fitted = false;
+    this->budget_share = SIZE_MAX;
+    this->stride_locked = false;
+    this->read_layer = -1;
     this->flag_is_locpot = _flag_is_locpot;
+    this->stride[0] = this->stride[1] = this->stride[2] = 1;
+    this->sparse_threshold = 0.0f;
 
     // test existence of file, else throw an error
     if (!boost::filesystem::exists(this->filename)) {
-        throw std::runtime_error("Cannot open " + this->filename + "!");
+        throw FileError("Cannot open " + this->filename + "!");
     }
 }
 
@@ -94,12 +115,17 @@ void ScalarField::read_header_and_atoms() {
         return;
     }
 
-    this->test_vasp5();
-    this->read_scalar();
-    this->read_matrix();
-    this->read_nr_atoms();
-    this->read_atom_positions();
-    this->read_grid_dimensions();
+    ScopedTimer timer("header parse");
+    try {
+        this->test_vasp5();
+        this->read_scalar();
+        this->read_matrix();
+        this->read_nr_atoms();
+        this->read_atom_positions();
+        this->read_grid_dimensions();
+    } catch(const boost::bad_lexical_cast&) {
+        throw FileError("Could not parse the header of " + this->filename + ".");
+    }
 }
 
 /*
@@ -119,6 +145,263 @@ void ScalarField::read() {
     this->read_grid();
 }
 
+/**
+ * @brief      average blocks of n grid points in each direction into a
+ *             single point when reading the grid; the stride is rounded
+ *             up to a divisor of the grid dimensions
+ *
+ * @param[in]  n     downsampling factor
+ */
+void ScalarField::set_downsampling(unsigned int n) {
+    if(this->has_read) {
+        throw std::runtime_error("Downsampling should be set before reading the grid.");
+    }
+
+    this->read_header_and_atoms();
+
+    for(unsigned int i=0; i<3; i++) {
+        // use a divisor of the grid dimension such that the spacing of the
+        // stored grid points remains uniform under periodic boundary conditions
+        unsigned int s = std::max(n, 1u);
+        while(this->grid_dimensions[i] % s != 0) {
+            s++;
+        }
+        this->stride[i] = s;
+    }
+}
+
+/**
+ * @brief      store the grid block-sparse: bricks wherein all absolute
+ *             values are below the threshold are replaced by their mean
+ *             value; when the grid has already been read, it is
+ *             compacted right away
+ *
+ * @param[in]  threshold  threshold (zero to store the grid densely)
+ */
+void ScalarField::set_sparse_threshold(float threshold) {
+    if(this->sparse.is_built()) {
+        throw std::runtime_error("The grid is already stored block-sparse.");
+    }
+
+    this->sparse_threshold = std::max(threshold, 0.0f);
+    if(this->has_read) {
+        this->compact();
+    }
+}
+
+/**
+ * @brief      open the archive of this field for random access per brick;
+ *             the grid itself does not need to be read
+ *
+ * @return     archive
+ */
+GridArchive ScalarField::open_archive() {
+    this->read_header_and_atoms();
+
+    std::ifstream in(this->filename.c_str());
+    if(!this->seek_grid(in)) {
+        throw FileError(this->filename + " is not an archive.");
+    }
+
+    // the archive holds the full grid, also when the field was downsampled
+    unsigned int dim[3];
+    for(unsigned int d=0; d<3; d++) {
+        dim[d] = this->has_read ? this->grid_dimensions[d] * this->stride[d] : this->grid_dimensions[d];
+    }
+    return GridArchive(this->filename, in.tellg(), dim);
+}
+
+/**
+ * @brief      skip the header and the atoms of the input file
+ *
+ * @param      in    stream of the input file (positioned at the start)
+ *
+ * @return     true if the file is an archive; the stream is then positioned
+ *             after the marker line, otherwise at the first line of the grid
+ */
+bool ScalarField::seek_grid(std::ifstream& in) const {
+    std::string line;
+    for(unsigned int i=0; i<(this->vasp5_input ? 10 : 9); i++) {
+        std::getline(in, line);
+    }
+    for(unsigned int i=0; i<this->atom_pos.size(); i++) {
+        std::getline(in, line);
+    }
+
+    // archives hold the grid in compressed bricks after a marker line
+    const std::streampos grid_start = in.tellg();
+    std::getline(in, line);
+    if(line == GridArchive::marker) {
+        return true;
+    }
+    in.seekg(grid_start);
+    return false;
+}
+
+/**
+ * @brief      read several scalar fields concurrently (one parse per thread);
+ *             the fields should have the same grid dimensions and unit cell,
+ *             which is verified from the headers before the grids are read
+ *
+ * @param[in]  fields  scalar fields
+ */
+void ScalarField::read_all(const std::vector<ScalarField*>& fields) {
+    if(fields.empty()) {
+        return;
+    }
+
+    for(ScalarField* field : fields) {
+        field->read_header_and_atoms();
+    }
+
+    // reject mismatched inputs before any grid is parsed
+    check_matching_grids(std::vector<const ScalarField*>(fields.begin(), fields.end()));
+
+    // fit all fields within a single snapshot of the memory budget (split
+    // evenly over the fields) and use the same, largest, stride for all of
+    // them, such that the grids keep matching and the budget is respected
+    // while the grids are allocated concurrently
+    const size_t share = MemoryTracker::get().get_available() / fields.size();
+    unsigned int n = 1;
+    for(ScalarField* field : fields) {
+        field->fit_memory_budget(share);
+        n = std::max(n, std::max(field->stride[0], std::max(field->stride[1], field->stride[2])));
+    }
+    for(ScalarField* field : fields) {
+        field->set_downsampling(n);
+        field->stride_locked = true;
+    }
+
+    // exceptions cannot leave a parallel region, rethrow the first afterwards
+    std::vector<std::exception_ptr> errors(fields.size());
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(int i=0; i<(int)fields.size(); i++) {
+        try {
+            fields[i]->read();
+        } catch(...) {
+            errors[i] = std::current_exception();
+        }
+    }
+
+    for(const std::exception_ptr& error : errors) {
+        if(error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+/**
+ * @brief      verify that fields have the same grid dimensions and unit cell
+ *             as the first field
+ *
+ * @param[in]  fields  scalar fields (headers read)
+ */
+void ScalarField::check_matching_grids(const std::vector<const ScalarField*>& fields) {
+    const ScalarField* first = fields.front();
+    for(const ScalarField* other : fields) {
+        for(unsigned int i=0; i<3; i++) {
+            if(other->grid_dimensions[i] != first->grid_dimensions[i]) {
+                throw std::runtime_error("Grid dimensions of " + other->filename + " do not match those of " + first->filename + ".");
+            }
+            for(unsigned int j=0; j<3; j++) {
+                if(std::fabs(other->mat[i][j] - first->mat[i][j]) > 1e-4f * std::max(1.0f, std::fabs(first->mat[i][j]))) {
+                    throw std::runtime_error("Unit cell of " + other->filename + " does not match that of " + first->filename + ".");
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief      replace the grid by an elementwise expression of this field (a)
+ *             and other fields (b, c, ...) on the same grid
+ *
+ * The expression is evaluated in place in a single pass over the grid,
+ * after which the statistics and the brick summary are rebuilt. Block-sparse
+ * inputs are decoded row by row; a block-sparse grid of this field is
+ * expanded for the evaluation and compacted again afterwards.
+ *
+ * @param[in]  expression  expression
+ * @param[in]  others      other fields, referred to as b, c, ...
+ */
+void ScalarField::apply(const FieldExpression& expression, const std::vector<const ScalarField*>& others) {
+    if(expression.get_nr_variables() > others.size() + 1) {
+        throw std::runtime_error("The expression refers to " + std::to_string(expression.get_nr_variables()) +
+                                 " fields, but only " + std::to_string(others.size() + 1) + " are given.");
+    }
+
+    std::vector<const ScalarField*> fields(1, this);
+    fields.insert(fields.end(), others.begin(), others.end());
+    check_matching_grids(fields);
+
+    const size_t n = (size_t)this->grid_dimensions[0] * this->grid_dimensions[1] * this->grid_dimensions[2];
+    for(const ScalarField* field : fields) {
+        if(n == 0 || field->get_size() != n) {
+            throw std::runtime_error("The grid of " + field->filename + " has not been read.");
+        }
+    }
+
+    // the result is written in place, hence a block-sparse grid is expanded
+    // first and compacted again once the expression has been evaluated
+    if(this->is_sparse()) {
+        this->densify();
+    }
+
+    ScopedTimer timer("field expression");
+
+    // the grid is processed in chunks of whole rows, such that the rows of
+    // block-sparse inputs can be decoded into a buffer per chunk
+    const unsigned int nx = this->grid_dimensions[0];
+    const size_t nrows = (size_t)this->grid_dimensions[1] * this->grid_dimensions[2];
+    const size_t rows_per_chunk = std::max((size_t)1, (size_t)(64 * FieldExpression::block_size) / nx);
+    const long nchunks = (nrows + rows_per_chunk - 1) / rows_per_chunk;
+    float* out = this->gridptr.data();
+    this->stats.clear();
+
+    #pragma omp parallel
+    {
+        EDP_TRACE_SCOPE("field expression");
+        FieldStatistics local_stats;
+        std::vector<const float*> inputs(fields.size());
+        std::vector<std::vector<float>> buffers(fields.size());
+
+        #pragma omp for schedule(static) nowait
+        for(long c=0; c<nchunks; c++) {
+            const size_t r0 = c * rows_per_chunk;
+            const size_t r1 = std::min(r0 + rows_per_chunk, nrows);
+            const size_t start = r0 * nx;
+            const size_t m = (r1 - r0) * nx;
+            for(unsigned int v=0; v<fields.size(); v++) {
+                if(fields[v]->is_sparse()) {
+                    buffers[v].resize(m);
+                    for(size_t r=r0; r<r1; r++) {
+                        fields[v]->sparse.copy_row(r % this->grid_dimensions[1], r / this->grid_dimensions[1],
+                                                   &buffers[v][(r - r0) * nx]);
+                    }
+                    inputs[v] = buffers[v].data();
+                } else {
+                    inputs[v] = fields[v]->gridptr.data() + start;
+                }
+            }
+            expression.evaluate(inputs.data(), m, out + start);
+            for(size_t i=start; i<start + m; i++) {
+                local_stats.add(out[i]);
+            }
+        }
+
+        #pragma omp critical
+        {
+            this->stats.merge(local_stats);
+        }
+    }
+
+    timer.set_items(n * fields.size(), "values");
+    timer.stop();
+
+    this->finalize_grid();
+}
+
 /*
  * void test_vasp5()
  *
@@ -272,6 +555,9 @@ void ScalarField::read_atom_positions() {
                 std::getline(infile, line);
                 std::vector<std::string> pieces;
                 boost::split(pieces, line, boost::is_any_of("\t "), boost::token_compress_on);
+                if(pieces.size() < 4) {
+                    throw FileError("Could not parse the atom positions of " + this->filename + ".");
+                }
                 this->atom_pos.push_back(glm::vec3(boost::lexical_cast<float>(pieces[1]), boost::lexical_cast<float>(pieces[2]), boost::lexical_cast<float>(pieces[3])));
         }
     }
@@ -312,6 +598,9 @@ void ScalarField::read_grid_dimensions() {
 
     std::vector<std::string> pieces;
     boost::split(pieces, line, boost::is_any_of("\t "), boost::token_compress_on);
+    if(pieces.size() != 3) {
+        throw FileError("Could not parse the grid dimensions of " + this->filename + ".");
+    }
     for(unsigned int i=0; i<pieces.size(); i++) {
         this->grid_dimensions[i] = boost::lexical_cast<unsigned int>(pieces[i]);
     }
@@ -339,71 +628,449 @@ void ScalarField::read_grid_dimensions() {
 void ScalarField::read_grid() {
     this->read_header_and_atoms();
 
+    if(!this->budget_fitted) {
+        this->fit_memory_budget(MemoryTracker::get().get_available());
+    }
+
+    while(true) {
+        try {
+            this->read_grid_pass();
+            return;
+        } catch(const budget_exceeded& e) {
+            this->infile.close();
+            this->refit_memory_budget(e.fraction);
+        }
+    }
+}
+
+/**
+ * @brief      read the grid once with the current stride; when a sparse
+ *             threshold has been set, every layer of bricks is compacted as
+ *             soon as it is complete, such that the dense grid is never held
+ *             in memory
+ */
+void ScalarField::read_grid_pass() {
+    ScopedTimer timer("grid parse");
+
+    const unsigned int nx = this->grid_dimensions[0];
+    const unsigned int ny = this->grid_dimensions[1];
+    const bool downsample = (this->stride[0] * this->stride[1] * this->stride[2]) > 1;
+    const bool compact = this->sparse_threshold > 0.0f;
+    const unsigned int coarse[3] = {nx / this->stride[0], ny / this->stride[1], this->grid_dimensions[2] / this->stride[2]};
+    const unsigned int ngridsize = coarse[0] * coarse[1] * coarse[2];
+    if(compact) {
+        // gridptr only holds the layer of bricks that is being read
+        this->sparse.begin(coarse);
+        this->read_layer = 0;
+        this->gridptr.assign((size_t)coarse[0] * coarse[1] * std::min(SparseGrid::size, coarse[2]), 0.0f);
+    } else if(downsample) {
+        this->gridptr.assign(ngridsize, 0.0f);
+    } else {
+        this->gridptr.reserve(ngridsize);
+    }
+    size_t idx = 0;     // position in the full grid
+    this->stats.clear();
+
     this->infile.open(this->filename.c_str());
     std::string line;
-    // skip irrelevant lines
-    for(unsigned int i=0; i<(this->vasp5_input ? 10 : 9); i++) {
-        std::getline(this->infile, line);
+    if(this->seek_grid(this->infile)) {
+        this->read_archive(this->infile.tellg());
+    } else {
+
+        float_parser p;
+
+        /* read spin up */
+        unsigned int linecounter=0; // for the counter
+        static const boost::regex regex_augmentation("augmentation.*");
+
+        while(std::getline(this->infile, line)) {
+            // stop looping when a second gridline appears (this
+            // is where the spin down part starts)
+            if(line.compare(this->gridline) == 0) {
+                std::cout << "I am breaking the loop" << std::endl;
+                break;
+            }
+
+            boost::smatch what;
+            if(boost::regex_match(line, what, regex_augmentation)) {
+                std::cout << "Augmentation break encountered" << std::endl;
+                break;
+            }
+
+            // set iterators
+            std::string::const_iterator b = line.begin();
+            std::string::const_iterator e = line.end();
+
+            // parse
+            std::vector<float> floats;
+            boost::spirit::qi::phrase_parse(b, e, p, boost::spirit::ascii::space, floats);
+            if(b != e && !this->has_read) {
+                this->infile.close();
+                throw FileError("Could not parse line " + std::to_string(linecounter + 1) +
+                                " of the grid of " + this->filename + ".");
+            }
+
+            if(downsample || compact) {
+                // average the grid points onto the coarse grid; the
+                // statistics are collected over the full grid
+                for(unsigned int j=0; j<floats.size() && idx < this->gridsize; j++, idx++) {
+                    const float val = this->flag_is_locpot ? floats[j] : floats[j] / this->volume;
+                    this->stats.add(val);
+                    this->add_to_coarse_grid(idx, val);
+                }
+            } else {
+                // expand gridptr with the new size
+                unsigned int cursize = this->gridptr.size();
+                this->gridptr.resize(cursize + floats.size());
+
+                // For CHGCAR type files, the electron density is multiplied by the cell volume
+                // as described by the link below:
+                // https://cms.mpi.univie.ac.at/vasp/vasp/CHGCAR_file.html#file-chgcar
+                // Hence, for these files, we have to divide the value at the grid point by the
+                // cell volume. For LOCPOT files, we should *not* do this.
+                if(this->flag_is_locpot) {      // LOCPOT type files
+                    for(unsigned int j=0; j<floats.size(); j++) {
+                        this->gridptr[cursize + j] = floats[j];
+                        this->stats.add(floats[j]);
+                    }
+                } else {    // CHGCAR type files
+                    for(unsigned int j=0; j<floats.size(); j++) {
+                        this->gridptr[cursize + j] = floats[j] / this->volume;
+                        this->stats.add(this->gridptr[cursize + j]);
+                    }
+                }
+            }
+
+            linecounter++;
+
+            if((downsample || compact) ? idx >= this->gridsize : this->gridptr.size() >= ngridsize) {
+                this->has_read = true;
+            }
+        }
+
+        if(!this->has_read) {
+            this->infile.close();
+            throw FileError("Grid of " + this->filename + " is truncated.");
+        }
     }
-    for(unsigned int i=0; i<this->atom_pos.size(); i++) {
-        std::getline(this->infile, line);
+
+    infile.close();
+
+    // compact the last layer of bricks and release the layer buffer
+    if(compact) {
+        this->flush_layer();
+        this->read_layer = -1;
+        decltype(this->gridptr)().swap(this->gridptr);
+    }
+
+    // from here on, the scalar field is represented by the coarse grid
+    if(downsample) {
+        for(unsigned int i=0; i<3; i++) {
+            this->grid_dimensions[i] /= this->stride[i];
+        }
+        this->gridsize = ngridsize;
+        std::cout << "Downsampled grid to " << this->grid_dimensions[0] << "x"
+                  << this->grid_dimensions[1] << "x" << this->grid_dimensions[2] << std::endl;
+    }
+
+    timer.set_bytes(boost::filesystem::file_size(this->filename));
+    timer.set_items(ngridsize, "values");
+    timer.stop();
+
+    this->finalize_grid();
+}
+
+/**
+ * @brief      build the brick summary of the grid and compact the grid when
+ *             a sparse threshold has been set
+ */
+void ScalarField::finalize_grid() {
+    if(this->sparse.is_built()) {
+        // compacted while reading
+        this->bricks.build(this->sparse, this->grid_dimensions);
+        this->report_compaction();
+        return;
+    }
+
+    this->bricks.build(this->gridptr.data(), this->grid_dimensions);
+    this->compact();
+}
+
+/**
+ * @brief      replace the dense grid by its block-sparse representation when
+ *             a sparse threshold has been set; the brick summary remains
+ *             valid as the constant of a brick lies within its range
+ */
+void ScalarField::compact() {
+    if(this->sparse_threshold <= 0.0f || this->sparse.is_built()) {
+        return;
     }
 
-    float_parser p;
+    this->sparse.build(this->gridptr.data(), this->grid_dimensions, this->sparse_threshold);
+    decltype(this->gridptr)().swap(this->gridptr);
+    this->report_compaction();
+}
 
-    /* read spin up */
-    unsigned int linecounter=0; // for the counter
-    static const boost::regex regex_augmentation("augmentation.*");
+/**
+ * @brief      report the memory usage of the block-sparse grid
+ */
+void ScalarField::report_compaction() const {
+    const size_t dense_bytes = this->sparse.get_size() * sizeof(float);
+    std::cout << "Stored " << this->sparse.get_nr_dense_bricks() << " of " << this->sparse.get_nr_bricks()
+              << " bricks densely (" << this->sparse.get_memory_usage() / (1024 * 1024) << " MB instead of "
+              << dense_bytes / (1024 * 1024) << " MB)" << std::endl;
+}
+
+/**
+ * @brief      compact the layer of bricks held in gridptr while reading and
+ *             clear the buffer for the next layer
+ *
+ * When the dense bricks exceed the memory available to this field and the
+ * stride may still be changed, reading is aborted such that the grid can be
+ * read again with a larger stride.
+ */
+void ScalarField::flush_layer() {
+    const unsigned int nlayers = (this->grid_dimensions[2] / this->stride[2] + SparseGrid::size - 1) / SparseGrid::size;
+    this->sparse.add_layer(this->read_layer, this->gridptr.data(), this->sparse_threshold);
+    std::fill(this->gridptr.begin(), this->gridptr.end(), 0.0f);
+
+    if(!this->stride_locked &&
+       this->sparse.get_memory_usage() + this->gridptr.size() * sizeof(float) > this->budget_share) {
+        throw budget_exceeded{(double)(this->read_layer + 1) / (double)nlayers};
+    }
+}
+
+/**
+ * @brief      replace the block-sparse representation by a dense grid, e.g.
+ *             to modify the values in place
+ */
+void ScalarField::densify() {
+    if(!this->sparse.is_built()) {
+        return;
+    }
 
-    while(std::getline(this->infile, line)) {
-        // stop looping when a second gridline appears (this
-        // is where the spin down part starts)
-        if(line.compare(this->gridline) == 0) {
-            std::cout << "I am breaking the loop" << std::endl;
-            break;
+    const unsigned int nx = this->grid_dimensions[0];
+    const unsigned int ny = this->grid_dimensions[1];
+    const unsigned int nz = this->grid_dimensions[2];
+    this->gridptr.resize(this->sparse.get_size());
+    for(unsigned int k=0; k<nz; k++) {
+        for(unsigned int j=0; j<ny; j++) {
+            this->sparse.copy_row(j, k, &this->gridptr[((size_t)k * ny + j) * nx]);
         }
+    }
+    this->sparse = SparseGrid();
+}
 
-        boost::smatch what;
-        if(boost::regex_match(line, what, regex_augmentation)) {
-            std::cout << "Augmentation break encountered" << std::endl;
-            break;
+/**
+ * @brief      add a point of the full grid to the average over its block of
+ *             stride[0] x stride[1] x stride[2] points on the coarse grid
+ *
+ * The center of such a block coincides with the center of the voxel of the
+ * coarse grid point, such that the downsampled field is not shifted with
+ * respect to the full grid. While the grid is compacted during reading, the
+ * points arrive layer by layer and a layer of bricks is compacted as soon
+ * as the first point of the next layer arrives.
+ *
+ * @param[in]  idx   position in the full grid
+ * @param[in]  val   value
+ */
+void ScalarField::add_to_coarse_grid(size_t idx, float val) {
+    const unsigned int nx = this->grid_dimensions[0];
+    const unsigned int ny = this->grid_dimensions[1];
+    const unsigned int x = idx % nx;
+    const unsigned int y = (idx / nx) % ny;
+    const unsigned int z = idx / ((size_t)nx * ny);
+    unsigned int cz = z / this->stride[2];
+
+    // while compacting, gridptr only holds the current layer of bricks
+    if(this->read_layer >= 0) {
+        const int layer = cz / SparseGrid::size;
+        if(layer != this->read_layer) {
+            this->flush_layer();
+            this->read_layer = layer;
         }
+        cz -= layer * SparseGrid::size;
+    }
 
-        // set iterators
-        std::string::const_iterator b = line.begin();
-        std::string::const_iterator e = line.end();
-
-        // parse
-        std::vector<float> floats;
-        boost::spirit::qi::phrase_parse(b, e, p, boost::spirit::ascii::space, floats);
-
-        // expand gridptr with the new size
-        unsigned int cursize = this->gridptr.size();
-        this->gridptr.resize(cursize + floats.size());
-
-        // For CHGCAR type files, the electron density is multiplied by the cell volume
-        // as described by the link below:
-        // https://cms.mpi.univie.ac.at/vasp/vasp/CHGCAR_file.html#file-chgcar
-        // Hence, for these files, we have to divide the value at the grid point by the
-        // cell volume. For LOCPOT files, we should *not* do this.
-        if(this->flag_is_locpot) {      // LOCPOT type files
-            for(unsigned int j=0; j<floats.size(); j++) {
-                this->gridptr[cursize + j] = floats[j];
-            }
-        } else {    // CHGCAR type files
-            for(unsigned int j=0; j<floats.size(); j++) {
-                this->gridptr[cursize + j] = floats[j] / this->volume;
+    const size_t c = ((size_t)cz * (ny / this->stride[1]) + y / this->stride[1]) *
+                     (nx / this->stride[0]) + x / this->stride[0];
+    this->gridptr[c] += val / (float)(this->stride[0] * this->stride[1] * this->stride[2]);
+}
+
+/**
+ * @brief      read the grid from the binary part of an archive; the bricks
+ *             are decompressed per layer of bricks along the third lattice
+ *             vector, such that downsampling does not require the full grid
+ *
+ * @param[in]  offset  position of the binary part in the file
+ */
+void ScalarField::read_archive(std::streamoff offset) {
+    const GridArchive archive(this->filename, offset, this->grid_dimensions);
+    const unsigned int nx = this->grid_dimensions[0];
+    const unsigned int ny = this->grid_dimensions[1];
+    const unsigned int nz = this->grid_dimensions[2];
+    const bool downsample = (this->stride[0] * this->stride[1] * this->stride[2]) > 1;
+
+    // convert the values when the archive was written for the other file type
+    float factor = 1.0f;
+    if(archive.is_per_volume() && this->flag_is_locpot) {
+        factor = this->volume;
+    } else if(!archive.is_per_volume() && !this->flag_is_locpot) {
+        factor = 1.0f / this->volume;
+    }
+
+    const bool coarse = downsample || this->read_layer >= 0;
+
+    std::vector<float> layer((size_t)nx * ny * GridArchive::size);
+    for(unsigned int k0=0; k0<nz; k0+=GridArchive::size) {
+        const unsigned int lo[3] = {0, 0, k0};
+        const unsigned int hi[3] = {nx, ny, std::min(k0 + GridArchive::size, nz)};
+        archive.read_region(lo, hi, layer.data());
+
+        const size_t n = (size_t)nx * ny * (hi[2] - k0);
+        for(size_t idx=0; idx<n; idx++) {
+            const float val = factor == 1.0f ? layer[idx] : layer[idx] * factor;
+            this->stats.add(val);
+            if(coarse) {
+                this->add_to_coarse_grid((size_t)k0 * nx * ny + idx, val);
+            } else {
+                this->gridptr.push_back(val);
             }
         }
+    }
+
+    this->has_read = true;
+}
+
+/**
+ * @brief      write the header and the grid to a compressed archive, which
+ *             can be read again as input file
+ *
+ * @param[in]  filename     output file
+ * @param[in]  error_bound  maximum absolute error of the stored values
+ *                          (zero for lossless compression)
+ *
+ * @return     number of bytes written
+ */
+size_t ScalarField::write_archive(const std::string& filename, float error_bound) const {
+    if(this->get_size() != (size_t)this->grid_dimensions[0] * this->grid_dimensions[1] * this->grid_dimensions[2]) {
+        throw std::runtime_error("Grid has not been read.");
+    }
+
+    // copy the text header of the input file up to the grid dimensions, which
+    // are written anew as the grid may have been downsampled
+    std::ifstream in(this->filename.c_str());
+    std::string header;
+    std::string line;
+    for(unsigned int i=0; i<(this->vasp5_input ? 9 : 8) + this->atom_pos.size(); i++) {
+        std::getline(in, line);
+        header += line + "\n";
+    }
+    in.close();
+
+    std::ofstream out(filename.c_str(), std::ios::binary);
+    if(!out) {
+        throw FileError("Cannot open " + filename + " for writing.");
+    }
+    out << header << "   " << this->grid_dimensions[0] << "   " << this->grid_dimensions[1]
+        << "   " << this->grid_dimensions[2] << "\n" << GridArchive::marker << "\n";
+
+    const size_t nquantized = GridArchive::write(out, *this, error_bound);
+    if(error_bound > 0.0f) {
+        std::cout << "Stored " << nquantized << " bricks quantized within an error of " << error_bound << std::endl;
+    }
+
+    return out.tellp();
+}
+
+/**
+ * @brief      increase the downsampling such that the grid fits within the
+ *             available memory
+ *
+ * @param[in]  available  number of bytes available for the grid
+ */
+void ScalarField::fit_memory_budget(size_t available) {
+    this->budget_fitted = true;
+    this->budget_share = available;
+
+    const unsigned int n0 = std::max(this->stride[0], std::max(this->stride[1], this->stride[2]));
+    unsigned int n = n0;
+    while(this->get_required_memory() > available) {
+        n++;
+        if(n > std::max(this->grid_dimensions[0], std::max(this->grid_dimensions[1], this->grid_dimensions[2]))) {
+            throw std::runtime_error("Grid of " + this->filename + " does not fit within the memory budget.");
+        }
+        this->set_downsampling(n);
+    }
 
-        linecounter++;
+    if(n > n0) {
+        std::cout << "Reading " << this->filename << " with stride (" << this->stride[0] << ","
+                  << this->stride[1] << "," << this->stride[2] << ") to fit within the memory budget." << std::endl;
+    }
+}
 
-        if(this->gridptr.size() >= this->gridsize) {
-            this->has_read = true;
+/**
+ * @brief      choose a larger stride after the dense bricks of a sparse
+ *             grid exceeded the memory budget while reading
+ *
+ * The memory of the dense bricks of the complete grid is extrapolated from
+ * the part that has been read and scaled with the number of grid points.
+ *
+ * @param[in]  fraction  fraction of the grid that has been read
+ */
+void ScalarField::refit_memory_budget(double fraction) {
+    const double dense_bytes = this->sparse.get_nr_dense_bricks() * SparseGrid::size * SparseGrid::size *
+                               SparseGrid::size * sizeof(float) / std::max(fraction, 1e-6);
+    const double points = (double)this->get_coarse_size();
+
+    this->sparse = SparseGrid();
+    decltype(this->gridptr)().swap(this->gridptr);
+    this->read_layer = -1;
+    this->has_read = false;
+
+    unsigned int n = std::max(this->stride[0], std::max(this->stride[1], this->stride[2]));
+    do {
+        n++;
+        if(n > std::max(this->grid_dimensions[0], std::max(this->grid_dimensions[1], this->grid_dimensions[2]))) {
+            throw std::runtime_error("Grid of " + this->filename + " does not fit within the memory budget.");
         }
+        this->set_downsampling(n);
+    } while(this->get_required_memory() + dense_bytes * this->get_coarse_size() / points > this->budget_share);
+
+    std::cout << "Dense bricks of " << this->filename << " exceed the memory budget; reading again with stride ("
+              << this->stride[0] << "," << this->stride[1] << "," << this->stride[2] << ")." << std::endl;
+}
+
+/**
+ * @brief      get the number of grid points that are stored with the
+ *             current stride
+ *
+ * @return     number of grid points
+ */
+size_t ScalarField::get_coarse_size() const {
+    return (size_t)(this->grid_dimensions[0] / this->stride[0]) *
+           (this->grid_dimensions[1] / this->stride[1]) *
+           (this->grid_dimensions[2] / this->stride[2]);
+}
+
+/**
+ * @brief      get the memory required to read the grid with the current
+ *             stride; for a sparse grid only the layer buffer and the brick
+ *             metadata are known beforehand, the dense bricks are checked
+ *             while reading
+ *
+ * @return     number of bytes
+ */
+size_t ScalarField::get_required_memory() const {
+    if(this->sparse_threshold <= 0.0f) {
+        return this->get_coarse_size() * sizeof(float);
     }
 
-    infile.close();
+    const unsigned int coarse[3] = {this->grid_dimensions[0] / this->stride[0],
+                                    this->grid_dimensions[1] / this->stride[1],
+                                    this->grid_dimensions[2] / this->stride[2]};
+    return (size_t)coarse[0] * coarse[1] * std::min(SparseGrid::size, coarse[2]) * sizeof(float) +
+           SparseGrid::get_metadata_size(coarse);
 }
 
 /*
@@ -458,6 +1125,45 @@ float ScalarField::get_value_interp(float x, float y, float z) const {
     this->get_value(x1, y1, z1) * xd                 * yd                 * zd;
 }
 
+/**
+ * @brief      interpolate the scalar field for a batch of points
+ *
+ * @param[in]  positions  realspace positions (x,y,z triplets)
+ * @param[in]  n          number of positions
+ * @param[out] values     output buffer (at least n floats)
+ * @param[in]  periodic   whether to fold positions back into the unit cell
+ * @param[in]  parallel   whether to distribute the points over threads;
+ *                        disable when called from a parallel region
+ */
+void ScalarField::get_values_interp(const float* positions, size_t n, float* values, bool periodic, bool parallel) const {
+    auto sample = [&](size_t i) {
+        glm::vec3 pp(positions[i*3], positions[i*3+1], positions[i*3+2]);
+
+        // align point to unit cell when crossing periodic boundary conditions
+        if(periodic) {
+            pp = this->mat33 * glm::fract(this->imat33 * pp);
+        }
+
+        values[i] = this->get_value_interp(pp[0], pp[1], pp[2]);
+    };
+
+    if(!parallel) {
+        for(size_t i=0; i<n; i++) {
+            sample(i);
+        }
+        return;
+    }
+
+    #pragma omp parallel
+    {
+        EDP_TRACE_SCOPE("interpolate");
+        #pragma omp for schedule(static) nowait
+        for(size_t i=0; i<n; i++) {
+            sample(i);
+        }
+    }
+}
+
 /**
  * @brief      test whether point is inside unit cell
  *
@@ -550,6 +1256,9 @@ float ScalarField::get_value(unsigned int i, unsigned int j, unsigned int k) con
     unsigned int idx = k * this->grid_dimensions[0] * this->grid_dimensions[1] +
                        j * this->grid_dimensions[0] +
                        i;
+    if(this->sparse.is_built()) {
+        return this->sparse.get(i, j, k);
+    }
     return this->gridptr[idx];
 }
 
@@ -613,14 +1322,6 @@ void ScalarField::copy_grid_dimensions(unsigned int _grid_dimensions[]) const {
     }
 }
 
-float ScalarField::get_max() const {
-    return *std::max_element(this->gridptr.begin(), this->gridptr.end());
-}
-
-float ScalarField::get_min() const {
-    return *std::min_element(this->gridptr.begin(), this->gridptr.end());
-}
-
 glm::vec3 ScalarField::get_atom_position(unsigned int atid) const {
     if(atid < this->atom_pos.size()) {
         return this->mat33 * this->atom_pos[atid];
@@ -628,3 +1329,82 @@ glm::vec3 ScalarField::get_atom_position(unsigned int atid) const {
         throw std::runtime_error("Requested atom id lies outside bounds");
     }
 }
+
+/**
+ * @brief      integrate the scalar field over the region where it exceeds a
+ *             threshold
+ *
+ * Bricks whose maximum does not exceed the threshold are skipped; for bricks
+ * whose minimum exceeds the threshold, the sum of the brick is used.
+ *
+ * @param[in]  threshold  threshold
+ * @param[out] volume     volume of the region in angstrom^3
+ *
+ * @return     integral over the region
+ */
+double ScalarField::integrate_above(float threshold, double& volume) const {
+    ScopedTimer timer("threshold integral");
+
+    const unsigned int nx = this->grid_dimensions[0];
+    const long nbricks = (long)this->bricks.get_nr_bricks(0) * this->bricks.get_nr_bricks(1) * this->bricks.get_nr_bricks(2);
+    double sum = 0.0;
+    size_t count = 0;
+    size_t visited = 0;
+
+    #pragma omp parallel reduction(+:sum,count,visited)
+    {
+        EDP_TRACE_SCOPE("threshold integral");
+        std::vector<float> buffer(nx);
+        #pragma omp for schedule(dynamic, 16) nowait
+        for(long b=0; b<nbricks; b++) {
+            const unsigned int bx = b % this->bricks.get_nr_bricks(0);
+            const unsigned int by = (b / this->bricks.get_nr_bricks(0)) % this->bricks.get_nr_bricks(1);
+            const unsigned int bz = b / ((long)this->bricks.get_nr_bricks(0) * this->bricks.get_nr_bricks(1));
+            unsigned int i0, i1, j0, j1, k0, k1;
+            this->bricks.get_extent(0, bx, i0, i1);
+            this->bricks.get_extent(1, by, j0, j1);
+            this->bricks.get_extent(2, bz, k0, k1);
+
+            if(this->bricks.get_max(b) <= threshold) {
+                continue;
+            }
+            if(this->bricks.get_min(b) > threshold) {
+                sum += this->bricks.get_sum(b);
+                count += (size_t)(i1 - i0) * (j1 - j0) * (k1 - k0);
+                continue;
+            }
+
+            for(unsigned int k=k0; k<k1; k++) {
+                for(unsigned int j=j0; j<j1; j++) {
+                    const float* row = this->get_row(j, k, buffer.data(), i0, i1);
+                    for(unsigned int i=i0; i<i1; i++) {
+                        if(row[i] > threshold) {
+                            sum += row[i];
+                            count++;
+                        }
+                    }
+                }
+            }
+            visited += (size_t)(i1 - i0) * (j1 - j0) * (k1 - k0);
+        }
+    }
+
+    timer.set_items(visited, "values");
+
+    const double dv = this->volume / (double)this->get_size();
+    volume = count * dv;
+    return sum * dv;
+}
+
+/**
+ * @brief      get the cartesian positions of all atoms
+ *
+ * @return     atom positions
+ */
+std::vector<glm::vec3> ScalarField::get_atom_positions() const {
+    std::vector<glm::vec3> positions(this->atom_pos.size());
+    for(unsigned int i=0; i<this->atom_pos.size(); i++) {
+        positions[i] = this->mat33 * this->atom_pos[i];
+    }
+    return positions;
+}
@@ -28,6 +28,7 @@
 #include <sstream>
 #include <fstream>
 #include <math.h>
+#include <stdexcept>
 
 #include <boost/regex.hpp>
 #include <boost/lexical_cast.hpp>
@@ -38,6 +39,16 @@
 
 #include "float_parser.h"
 #include "periodic_table.h"
+#include "profiler.h"
+#include "tracer.h"
+#include "memory_tracker.h"
+#include "field_statistics.h"
+#include "brick_summary.h"
+#include "sparse_grid.h"
+#include "field_expression.h"
+#include "file_error.h"
+
+class GridArchive;
 
 class ScalarField{
 private:
@@ -61,12 +72,20 @@ private:
     std::vector<unsigned int> atom_charges_exp;
 
     std::string gridline;
-    std::vector<float> gridptr;  //!< grid to first pos of float array
-    std::vector<float> gridptr2; //!< grid to first pos of float array
+    std::vector<float, TrackedAllocator<float, MemoryTracker::FIELD>> gridptr;  //!< grid to first pos of float array
     unsigned int gridsize;
+    unsigned int stride[3];      //!< blocks of stride grid points are averaged into one point (downsampling)
+    FieldStatistics stats;       //!< statistics accumulated while parsing the grid
+    BrickSummary bricks;         //!< min/max/sum per brick, built after reading the grid
+    float sparse_threshold;      //!< bricks with absolute values below this threshold are stored as a constant
+    SparseGrid sparse;           //!< block-sparse grid, replaces gridptr when built
     bool vasp5_input;
     bool has_read;
     bool header_read;
+    bool budget_fitted;          //!< whether the stride has been fitted to the memory budget
+    size_t budget_share;         //!< memory available to this field when the stride was fitted
+    bool stride_locked;          //!< whether the stride is shared with other fields and cannot be increased while reading
+    int read_layer;              //!< layer of bricks held in gridptr while compacting during reading (-1 otherwise)
     std::ifstream infile;
     bool flag_is_locpot;         //!< whether scalar field is in LOCPOT style
 
@@ -106,6 +125,83 @@ public:
 
     void read_header_and_atoms();
 
+    /**
+     * @brief      read several scalar fields concurrently (one parse per
+     *             thread); the fields should have the same grid dimensions
+     *             and unit cell, which is verified from the headers before
+     *             the grids are read
+     *
+     * @param[in]  fields  scalar fields
+     */
+    static void read_all(const std::vector<ScalarField*>& fields);
+
+    /**
+     * @brief      replace the grid by an elementwise expression of this
+     *             field (a) and other fields (b, c, ...) on the same grid
+     *
+     * @param[in]  expression  expression
+     * @param[in]  others      other fields, referred to as b, c, ...
+     */
+    void apply(const FieldExpression& expression, const std::vector<const ScalarField*>& others);
+
+    /**
+     * @brief      write the header and the grid to a compressed archive,
+     *             which can be read again as input file
+     *
+     * @param[in]  filename     output file
+     * @param[in]  error_bound  maximum absolute error of the stored values
+     *                          (zero for lossless compression)
+     *
+     * @return     number of bytes written
+     */
+    size_t write_archive(const std::string& filename, float error_bound) const;
+
+    /**
+     * @brief      open the archive of this field for random access per brick
+     *             (e.g. GridArchive::read_region) without reading the grid;
+     *             the archive always holds the full grid
+     *
+     * @return     archive
+     */
+    GridArchive open_archive();
+
+    /**
+     * @brief      average blocks of n grid points in each direction into a
+     *             single point when reading the grid; the stride is rounded
+     *             up to a divisor of the grid dimensions
+     *
+     * @param[in]  n     downsampling factor
+     */
+    void set_downsampling(unsigned int n);
+
+    /**
+     * @brief      store the grid block-sparse: bricks wherein all absolute
+     *             values are below the threshold are replaced by their mean
+     *             value; when the grid has already been read, it is
+     *             compacted right away
+     *
+     * @param[in]  threshold  threshold (zero to store the grid densely)
+     */
+    void set_sparse_threshold(float threshold);
+
+    /**
+     * @brief      whether the grid is stored block-sparse
+     *
+     * @return     true if sparse
+     */
+    inline bool is_sparse() const {
+        return this->sparse.is_built();
+    }
+
+    /**
+     * @brief      get the block-sparse representation of the grid
+     *
+     * @return     sparse grid
+     */
+    inline const SparseGrid& get_sparse_grid() const {
+        return this->sparse;
+    }
+
     /*
      * float get_value_interp(x,y,z)
      *
@@ -120,6 +216,18 @@ public:
      */
     float get_value_interp(float x, float y, float z) const;
 
+    /**
+     * @brief      interpolate the scalar field for a batch of points
+     *
+     * @param[in]  positions  realspace positions (x,y,z triplets)
+     * @param[in]  n          number of positions
+     * @param[out] values     output buffer (at least n floats)
+     * @param[in]  periodic   whether to fold positions back into the unit cell
+     * @param[in]  parallel   whether to distribute the points over threads;
+     *                        disable when called from a parallel region
+     */
+    void get_values_interp(const float* positions, size_t n, float* values, bool periodic, bool parallel = true) const;
+
     /**
      * @brief      test whether point is inside unit cell
      *
@@ -133,6 +241,42 @@ public:
 
     float get_value(unsigned int i, unsigned int j, unsigned int k) const;
 
+    /**
+     * @brief      get a row of grid points along a, irrespective of whether
+     *             the grid is stored densely or block-sparse
+     *
+     * @param[in]  j       grid index along b
+     * @param[in]  k       grid index along c
+     * @param[out] buffer  buffer to decode a sparse row into (at least as
+     *                     long as the grid along a)
+     *
+     * @return     pointer to the row (either into the grid or the buffer)
+     */
+    inline const float* get_row(unsigned int j, unsigned int k, float* buffer) const {
+        return this->get_row(j, k, buffer, 0, this->grid_dimensions[0]);
+    }
+
+    /**
+     * @brief      get part of a row of grid points along a; for a block-sparse
+     *             grid only the span [i0, i1) is decoded
+     *
+     * @param[in]  j       grid index along b
+     * @param[in]  k       grid index along c
+     * @param[out] buffer  buffer to decode a sparse row into (at least as
+     *                     long as the grid along a)
+     * @param[in]  i0      first grid index along a
+     * @param[in]  i1      one past the last grid index along a
+     *
+     * @return     pointer to the row, valid for indices i0 to i1
+     */
+    inline const float* get_row(unsigned int j, unsigned int k, float* buffer, unsigned int i0, unsigned int i1) const {
+        if(this->sparse.is_built()) {
+            this->sparse.copy_row(j, k, buffer, i0, i1);
+            return buffer;
+        }
+        return &this->gridptr[((size_t)k * this->grid_dimensions[1] + j) * this->grid_dimensions[0]];
+    }
+
     glm::vec3 grid_to_realspace(float i, float j, float k) const;
 
     glm::vec3 realspace_to_grid(float i, float j, float k) const;
@@ -141,12 +285,96 @@ public:
 
     void copy_grid_dimensions(unsigned int _grid_dimensions[]) const;
 
-    float get_max() const;
+    /**
+     * @brief      get the number of atoms in the unit cell
+     *
+     * @return     number of atoms
+     */
+    inline unsigned int get_nr_atoms() const {
+        return this->atom_pos.size();
+    }
 
-    float get_min() const;
+    inline float get_max() const {
+        return this->stats.get_max();
+    }
+
+    inline float get_min() const {
+        return this->stats.get_min();
+    }
+
+    inline float get_mean() const {
+        return this->stats.get_mean();
+    }
+
+    /**
+     * @brief      get the integral of the scalar field over the unit cell
+     *             (the number of electrons for CHGCAR files)
+     *
+     * @return     integrated value
+     */
+    inline float get_integrated_charge() const {
+        return this->stats.get_count() > 0 ? this->stats.get_sum() * this->volume / (double)this->stats.get_count() : 0.0f;
+    }
+
+    /**
+     * @brief      get the statistics (min, max, sum and histogram) of the
+     *             scalar field, these are collected while parsing the grid
+     *
+     * @return     statistics
+     */
+    inline const FieldStatistics& get_statistics() const {
+        return this->stats;
+    }
+
+    /**
+     * @brief      get the summary (min, max and sum) of the grid per brick of
+     *             8x8x8 grid points, this is built after reading the grid
+     *
+     * @return     brick summary
+     */
+    inline const BrickSummary& get_brick_summary() const {
+        return this->bricks;
+    }
+
+    /**
+     * @brief      integrate the scalar field over the region where it exceeds
+     *             a threshold
+     *
+     * @param[in]  threshold  threshold
+     * @param[out] volume     volume of the region in angstrom^3
+     *
+     * @return     integral over the region
+     */
+    double integrate_above(float threshold, double& volume) const;
 
     glm::vec3 get_atom_position(unsigned int atid) const;
 
+    /**
+     * @brief      get the cartesian positions of all atoms
+     *
+     * @return     atom positions
+     */
+    std::vector<glm::vec3> get_atom_positions() const;
+
+    /**
+     * @brief      get the element number of every atom type (empty when the
+     *             input file does not list the elements)
+     *
+     * @return     element numbers
+     */
+    inline const std::vector<unsigned int>& get_atom_types() const {
+        return this->atom_charges;
+    }
+
+    /**
+     * @brief      get the number of atoms of every atom type
+     *
+     * @return     number of atoms per type
+     */
+    inline const std::vector<unsigned int>& get_nr_atoms_per_type() const {
+        return this->nrat;
+    }
+
     inline const glm::mat3& get_mat_unitcell() const {
         return this->mat33;
     }
@@ -155,12 +383,19 @@ public:
         return this->imat33;
     }
 
+    inline float get_volume() const {
+        return this->volume;
+    }
+
     inline const float* get_grid_ptr() const {
+        if(this->sparse.is_built()) {
+            throw std::runtime_error("The grid is stored block-sparse and cannot be accessed as a contiguous array.");
+        }
         return &this->gridptr[0];
     }
 
     unsigned int get_size() const {
-        return this->gridptr.size();
+        return this->sparse.is_built() ? this->sparse.get_size() : this->gridptr.size();
     }
 
     inline const std::string& get_filename() const {
@@ -175,6 +410,20 @@ private:
     void read_nr_atoms();
     void read_atom_positions();
     void read_grid();
+    void read_grid_pass();
+    bool seek_grid(std::ifstream& in) const;
+    void read_archive(std::streamoff offset);
+    void add_to_coarse_grid(size_t idx, float val);
+    void finalize_grid();
+    void compact();
+    void flush_layer();
+    void report_compaction() const;
+    void densify();
+    static void check_matching_grids(const std::vector<const ScalarField*>& fields);
+    void fit_memory_budget(size_t available);
+    void refit_memory_budget(double fraction);
+    size_t get_coarse_size() const;
+    size_t get_required_memory() const;
     float get_max_direction(unsigned int dim);
     void calculate_inverse();
     void calculate_volume();
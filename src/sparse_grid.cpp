@@ -0,0 +1,207 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "sparse_grid.h"
+
+#include <cmath>
+#include <algorithm>
+#include <omp.h>
+
+#include "profiler.h"
+#include "tracer.h"
+
+/**
+ * @brief      constructor (empty grid)
+ */
+SparseGrid::SparseGrid() {
+    for(unsigned int d=0; d<3; d++) {
+        this->grid_dimensions[d] = 0;
+        this->nr_bricks[d] = 0;
+    }
+}
+
+/**
+ * @brief      build the sparse representation of a grid
+ *
+ * @param[in]  grid       grid values (x runs fastest)
+ * @param[in]  dim        grid dimensions
+ * @param[in]  threshold  bricks wherein all absolute values are below
+ *                        this threshold are stored as a constant
+ */
+void SparseGrid::build(const float* grid, const unsigned int dim[3], float threshold) {
+    ScopedTimer timer("sparse grid");
+
+    this->begin(dim);
+    for(unsigned int bz=0; bz<this->nr_bricks[2]; bz++) {
+        this->add_layer(bz, grid + (size_t)bz * size * dim[0] * dim[1], threshold);
+    }
+
+    timer.set_items(this->get_size(), "values");
+}
+
+/**
+ * @brief      start building the sparse representation layer by layer;
+ *             all bricks are constant (zero) until their layer is added
+ *
+ * @param[in]  dim   grid dimensions
+ */
+void SparseGrid::begin(const unsigned int dim[3]) {
+    for(unsigned int d=0; d<3; d++) {
+        this->grid_dimensions[d] = dim[d];
+        this->nr_bricks[d] = (dim[d] + size - 1) / size;
+    }
+    const size_t nbricks = (size_t)this->nr_bricks[0] * this->nr_bricks[1] * this->nr_bricks[2];
+    this->constants.assign(nbricks, 0.0f);
+    this->slots.assign(nbricks, -1);
+    this->pool.clear();
+    this->pool.resize(this->nr_bricks[2]);
+}
+
+/**
+ * @brief      add a layer of bricks along c
+ *
+ * @param[in]  bz         brick index along c
+ * @param[in]  layer      grid values of the planes in the layer (x runs
+ *                        fastest, the first plane is plane bz * size)
+ * @param[in]  threshold  bricks wherein all absolute values are below
+ *                        this threshold are stored as a constant
+ */
+void SparseGrid::add_layer(unsigned int bz, const float* layer, float threshold) {
+    const unsigned int nx = this->grid_dimensions[0];
+    const unsigned int ny = this->grid_dimensions[1];
+    const unsigned int nk = std::min(size, this->grid_dimensions[2] - bz * size);
+    const unsigned int nb = this->nr_bricks[0] * this->nr_bricks[1];
+    const size_t b0 = (size_t)bz * nb;
+    const size_t brick_volume = size * size * size;
+
+    // classify the bricks of the layer; constant bricks store their mean
+    // (serially when the grid is read from within a parallel region)
+    const bool parallel = !omp_in_parallel();
+    #pragma omp parallel for schedule(static) if(parallel)
+    for(unsigned int b=0; b<nb; b++) {
+        const unsigned int i0 = (b % this->nr_bricks[0]) * size;
+        const unsigned int j0 = (b / this->nr_bricks[0]) * size;
+        const unsigned int i1 = std::min(i0 + size, nx);
+        const unsigned int j1 = std::min(j0 + size, ny);
+
+        float vmax = 0.0f;
+        double vsum = 0.0;
+        for(unsigned int k=0; k<nk; k++) {
+            for(unsigned int j=j0; j<j1; j++) {
+                const float* row = layer + ((size_t)k * ny + j) * nx;
+                for(unsigned int i=i0; i<i1; i++) {
+                    vmax = std::max(vmax, std::fabs(row[i]));
+                    vsum += row[i];
+                }
+            }
+        }
+        if(vmax < threshold) {
+            this->constants[b0 + b] = vsum / (double)((size_t)(i1 - i0) * (j1 - j0) * nk);
+            this->slots[b0 + b] = -1;
+        } else {
+            this->slots[b0 + b] = 0;
+        }
+    }
+
+    // assign the dense bricks to consecutive slots in the pool of the layer
+    int nr_dense = 0;
+    for(unsigned int b=0; b<nb; b++) {
+        if(this->slots[b0 + b] >= 0) {
+            this->slots[b0 + b] = nr_dense++;
+        }
+    }
+    this->pool[bz].assign((size_t)nr_dense * brick_volume, 0.0f);
+
+    #pragma omp parallel for schedule(static) if(parallel)
+    for(unsigned int b=0; b<nb; b++) {
+        const int slot = this->slots[b0 + b];
+        if(slot < 0) {
+            continue;
+        }
+        const unsigned int i0 = (b % this->nr_bricks[0]) * size;
+        const unsigned int j0 = (b / this->nr_bricks[0]) * size;
+        const unsigned int i1 = std::min(i0 + size, nx);
+        const unsigned int j1 = std::min(j0 + size, ny);
+
+        float* dest = &this->pool[bz][(size_t)slot * brick_volume];
+        for(unsigned int k=0; k<nk; k++) {
+            for(unsigned int j=j0; j<j1; j++) {
+                const float* row = layer + ((size_t)k * ny + j) * nx;
+                std::copy(row + i0, row + i1, dest + (k * size + (j - j0)) * size);
+            }
+        }
+    }
+}
+
+/**
+ * @brief      get the number of bricks that are stored densely
+ *
+ * @return     number of dense bricks
+ */
+size_t SparseGrid::get_nr_dense_bricks() const {
+    size_t n = 0;
+    for(const Pool& p : this->pool) {
+        n += p.size();
+    }
+    return n / (size * size * size);
+}
+
+/**
+ * @brief      estimate the memory used by the sparse representation of a
+ *             grid of which only the brick metadata is known beforehand
+ *
+ * @param[in]  dim   grid dimensions
+ *
+ * @return     number of bytes of the constants and slots
+ */
+size_t SparseGrid::get_metadata_size(const unsigned int dim[3]) {
+    size_t nbricks = 1;
+    for(unsigned int d=0; d<3; d++) {
+        nbricks *= (dim[d] + size - 1) / size;
+    }
+    return nbricks * (sizeof(float) + sizeof(int));
+}
+
+/**
+ * @brief      copy part of a row of grid points along a; only the bricks
+ *             overlapping [i0, i1) are decoded
+ *
+ * @param[in]  j     grid index along b
+ * @param[in]  k     grid index along c
+ * @param[out] row   output buffer, indexed by i (elements i0 to i1 are set)
+ * @param[in]  i0    first grid index along a
+ * @param[in]  i1    one past the last grid index along a
+ */
+void SparseGrid::copy_row(unsigned int j, unsigned int k, float* row, unsigned int i0, unsigned int i1) const {
+    const size_t b0 = ((size_t)(k / size) * this->nr_bricks[1] + j / size) * this->nr_bricks[0];
+    const size_t offset = ((k % size) * size + j % size) * size;
+
+    for(unsigned int bx=i0 / size; bx * size < i1; bx++) {
+        const unsigned int lo = std::max(bx * size, i0);
+        const unsigned int hi = std::min(bx * size + size, i1);
+        const int slot = this->slots[b0 + bx];
+        if(slot < 0) {
+            std::fill(row + lo, row + hi, this->constants[b0 + bx]);
+        } else {
+            const float* src = &this->pool[k / size][(size_t)slot * size * size * size + offset];
+            std::copy(src + (lo - bx * size), src + (hi - bx * size), row + lo);
+        }
+    }
+}
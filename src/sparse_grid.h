@@ -0,0 +1,185 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _SPARSE_GRID_H
+#define _SPARSE_GRID_H
+
+#include <vector>
+#include <cstddef>
+
+#include "memory_tracker.h"
+#include "brick_summary.h"
+
+/**
+ * @brief      block-sparse representation of a grid
+ *
+ * The grid is divided into the same bricks as the BrickSummary. Bricks in
+ * which all values lie within a tolerance of zero are stored as a single
+ * constant (the mean of the brick, such that the integral over the brick is
+ * retained), all other bricks are stored densely in a pool per layer of
+ * bricks along c. This strongly reduces the memory footprint of grids
+ * dominated by vacuum. As every layer of bricks is stored independently,
+ * the grid can be built layer by layer while it is read.
+ */
+class SparseGrid {
+public:
+    static const unsigned int size = BrickSummary::size;    //!< number of grid points along each edge of a brick
+
+private:
+    typedef std::vector<float, TrackedAllocator<float, MemoryTracker::FIELD>> Pool;
+
+    unsigned int grid_dimensions[3];
+    unsigned int nr_bricks[3];
+    std::vector<float, TrackedAllocator<float, MemoryTracker::FIELD>> constants;  //!< value of the constant bricks
+    std::vector<int, TrackedAllocator<int, MemoryTracker::FIELD>> slots;          //!< position of a brick in the pool of its layer (-1 for constant bricks)
+    std::vector<Pool> pool;                                                         //!< values of the dense bricks per layer (size^3 per brick)
+
+public:
+    /**
+     * @brief      constructor (empty grid)
+     */
+    SparseGrid();
+
+    /**
+     * @brief      build the sparse representation of a grid
+     *
+     * @param[in]  grid       grid values (x runs fastest)
+     * @param[in]  dim        grid dimensions
+     * @param[in]  threshold  bricks wherein all absolute values are below
+     *                        this threshold are stored as a constant
+     */
+    void build(const float* grid, const unsigned int dim[3], float threshold);
+
+    /**
+     * @brief      start building the sparse representation layer by layer;
+     *             all bricks are constant (zero) until their layer is added
+     *
+     * @param[in]  dim   grid dimensions
+     */
+    void begin(const unsigned int dim[3]);
+
+    /**
+     * @brief      add a layer of bricks along c
+     *
+     * @param[in]  bz         brick index along c
+     * @param[in]  layer      grid values of the planes in the layer (x runs
+     *                        fastest, the first plane is plane bz * size)
+     * @param[in]  threshold  bricks wherein all absolute values are below
+     *                        this threshold are stored as a constant
+     */
+    void add_layer(unsigned int bz, const float* layer, float threshold);
+
+    /**
+     * @brief      whether the sparse representation has been built
+     *
+     * @return     true if built
+     */
+    inline bool is_built() const {
+        return !this->slots.empty();
+    }
+
+    /**
+     * @brief      get the value at a grid point
+     *
+     * @param[in]  i     grid index along a
+     * @param[in]  j     grid index along b
+     * @param[in]  k     grid index along c
+     *
+     * @return     value
+     */
+    inline float get(unsigned int i, unsigned int j, unsigned int k) const {
+        const size_t b = ((size_t)(k / size) * this->nr_bricks[1] + j / size) * this->nr_bricks[0] + i / size;
+        const int slot = this->slots[b];
+        if(slot < 0) {
+            return this->constants[b];
+        }
+        return this->pool[k / size][(size_t)slot * size * size * size + ((k % size) * size + j % size) * size + i % size];
+    }
+
+    /**
+     * @brief      copy a row of grid points along a
+     *
+     * @param[in]  j     grid index along b
+     * @param[in]  k     grid index along c
+     * @param[out] row   output buffer (at least as long as the grid along a)
+     */
+    inline void copy_row(unsigned int j, unsigned int k, float* row) const {
+        this->copy_row(j, k, row, 0, this->grid_dimensions[0]);
+    }
+
+    /**
+     * @brief      copy part of a row of grid points along a; only the bricks
+     *             overlapping [i0, i1) are decoded
+     *
+     * @param[in]  j     grid index along b
+     * @param[in]  k     grid index along c
+     * @param[out] row   output buffer, indexed by i (elements i0 to i1 are set)
+     * @param[in]  i0    first grid index along a
+     * @param[in]  i1    one past the last grid index along a
+     */
+    void copy_row(unsigned int j, unsigned int k, float* row, unsigned int i0, unsigned int i1) const;
+
+    /**
+     * @brief      get the number of grid points
+     *
+     * @return     number of grid points
+     */
+    inline size_t get_size() const {
+        return (size_t)this->grid_dimensions[0] * this->grid_dimensions[1] * this->grid_dimensions[2];
+    }
+
+    /**
+     * @brief      get the number of bricks
+     *
+     * @return     number of bricks
+     */
+    inline size_t get_nr_bricks() const {
+        return this->slots.size();
+    }
+
+    /**
+     * @brief      get the number of bricks that are stored densely
+     *
+     * @return     number of dense bricks
+     */
+    size_t get_nr_dense_bricks() const;
+
+    /**
+     * @brief      get the memory used by the sparse representation
+     *
+     * @return     number of bytes
+     */
+    inline size_t get_memory_usage() const {
+        return this->constants.size() * sizeof(float) + this->slots.size() * sizeof(int) +
+               this->get_nr_dense_bricks() * size * size * size * sizeof(float);
+    }
+
+    /**
+     * @brief      estimate the memory used by the sparse representation of a
+     *             grid of which only the brick metadata is known beforehand
+     *
+     * @param[in]  dim   grid dimensions
+     *
+     * @return     number of bytes of the constants and slots
+     */
+    static size_t get_metadata_size(const unsigned int dim[3]);
+};
+
+#endif //_SPARSE_GRID_H
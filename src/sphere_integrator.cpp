@@ -0,0 +1,174 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "sphere_integrator.h"
+
+#include <fstream>
+#include <boost/format.hpp>
+
+/**
+ * @brief      constructor
+ *
+ * @param[in]  _sf             scalar field
+ * @param[in]  _lebedev_order  Lebedev order of the angular grid
+ * @param[in]  _radial_points  number of Gauss-Chebyshev nodes per shell
+ */
+SphereIntegrator::SphereIntegrator(const ScalarField* _sf,
+                                   unsigned int _lebedev_order,
+                                   unsigned int _radial_points) :
+    sf(_sf),
+    lebedev_order(_lebedev_order),
+    radial_points(_radial_points) {
+
+    if(this->radial_points == 0) {
+        throw std::runtime_error("At least one radial point per shell is required.");
+    }
+}
+
+/**
+ * @brief      integrate the scalar field within spheres
+ *
+ * Every shell of every sphere is integrated by a single thread, which keeps
+ * all threads busy also for a single atom.
+ *
+ * @param[in]  centers  centers of the spheres
+ * @param[in]  radii    increasing radii of the spheres
+ *
+ * @return     integral for each center (outer index) and radius (inner index)
+ */
+std::vector<std::vector<float> > SphereIntegrator::integrate(const std::vector<glm::vec3>& centers,
+                                                             const std::vector<float>& radii) const {
+    const LebedevSpan grid = Quadrature::get_lebedev(this->lebedev_order);
+    std::vector<double> x, w;
+    Quadrature::get_gauss_chebyshev(this->radial_points, x, w);
+
+    const unsigned int ncenters = centers.size();
+    const unsigned int nshells = radii.size();
+    std::vector<double> shells((size_t)ncenters * nshells, 0.0);
+
+    const size_t npoints = (size_t)this->radial_points * grid.size();
+
+    #pragma omp parallel
+    {
+        EDP_TRACE_SCOPE("sphere integration");
+
+        // quadrature points of a single shell, sampled in one batch
+        std::vector<float> positions(npoints * 3);
+        std::vector<float> values(npoints);
+
+        #pragma omp for collapse(2) schedule(dynamic) nowait
+        for(unsigned int c=0; c<ncenters; c++) {
+            for(unsigned int s=0; s<nshells; s++) {
+                // shell between the previous and the current radius
+                const double r0 = s > 0 ? radii[s-1] : 0.0;
+                const double r1 = radii[s];
+
+                for(unsigned int i=0; i<this->radial_points; i++) {
+                    const float r = 0.5 * (r0 + r1) + 0.5 * (r1 - r0) * x[i];
+                    for(unsigned int j=0; j<grid.size(); j++) {
+                        const glm::vec3 pp = centers[c] + glm::vec3(grid[j].x, grid[j].y, grid[j].z) * r;
+                        float* dest = &positions[((size_t)i * grid.size() + j) * 3];
+                        dest[0] = pp[0];
+                        dest[1] = pp[1];
+                        dest[2] = pp[2];
+                    }
+                }
+
+                // interpolate all quadrature points of the shell at once
+                this->sf->get_values_interp(positions.data(), npoints, values.data(), true, false);
+
+                double sum = 0.0;
+                for(unsigned int i=0; i<this->radial_points; i++) {
+                    const double r = 0.5 * (r0 + r1) + 0.5 * (r1 - r0) * x[i];
+
+                    // (weighted) average over the sphere of radius r
+                    double avg = 0.0;
+                    for(unsigned int j=0; j<grid.size(); j++) {
+                        avg += grid[j].w * values[(size_t)i * grid.size() + j];
+                    }
+
+                    // integrate 4 pi r^2 times the average over the shell
+                    sum += 0.5 * (r1 - r0) * w[i] * 4.0 * M_PI * r * r * avg;
+                }
+                shells[(size_t)c * nshells + s] = sum;
+            }
+        }
+    }
+
+    // the integral within a sphere is the sum over the enclosed shells
+    std::vector<std::vector<float> > integrals(ncenters, std::vector<float>(nshells));
+    for(unsigned int c=0; c<ncenters; c++) {
+        double sum = 0.0;
+        for(unsigned int s=0; s<nshells; s++) {
+            sum += shells[(size_t)c * nshells + s];
+            integrals[c][s] = sum;
+        }
+    }
+
+    return integrals;
+}
+
+/**
+ * @brief      integrate the scalar field within spheres around all atoms
+ *             and write a table with one column per atom
+ *
+ * @param[in]  filename  output file
+ * @param[in]  radius    largest radius
+ * @param[in]  step      distance between subsequent radii
+ */
+void SphereIntegrator::write_atom_table(const std::string& filename, float radius, float step) const {
+    ScopedTimer timer("sphere integration");
+
+    if(step <= 0.0f) {
+        throw std::runtime_error("Radial step should be positive.");
+    }
+
+    std::vector<float> radii;
+    for(unsigned int i=1; i * step <= radius; i++) {
+        radii.push_back(i * step);
+    }
+
+    std::vector<glm::vec3> centers;
+    for(unsigned int i=0; i<this->sf->get_nr_atoms(); i++) {
+        centers.push_back(this->sf->get_atom_position(i));
+    }
+
+    const std::vector<std::vector<float> > integrals = this->integrate(centers, radii);
+    timer.set_items(centers.size() * radii.size() * this->radial_points *
+                    Quadrature::num_lebedev_points[this->lebedev_order], "points");
+
+    // write to file
+    // open file and output results
+    std::ofstream out(filename);
+    out << boost::format("%12s") % "# radius";
+    for(unsigned int c=0; c<centers.size(); c++) {
+        out << boost::format("  %12s") % ("atom " + std::to_string(c+1));
+    }
+    out << "\n";
+    for(unsigned int s=0; s<radii.size(); s++) {
+        out << boost::format("%12.6f") % radii[s];
+        for(unsigned int c=0; c<centers.size(); c++) {
+            out << boost::format("  %12.6f") % integrals[c][s];
+        }
+        out << "\n";
+    }
+
+    out.close();
+}
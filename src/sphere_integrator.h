@@ -0,0 +1,81 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _SPHERE_INTEGRATOR_H
+#define _SPHERE_INTEGRATOR_H
+
+#include <vector>
+#include <string>
+#include <glm/glm.hpp>
+
+#include "scalar_field.h"
+#include "quadrature.h"
+
+/**
+ * @brief      integrates a scalar field over spheres of increasing radius
+ *             around a set of centers (e.g. the number of electrons within
+ *             a sphere around each atom)
+ *
+ * The spheres are divided in shells between subsequent radii. Each shell
+ * is integrated with a Gauss-Chebyshev rule in the radial direction and a
+ * Lebedev grid in the angular directions; the integral within a sphere is
+ * the cumulative sum over the shells.
+ */
+class SphereIntegrator {
+private:
+    const ScalarField* sf;
+    unsigned int lebedev_order;     //!< Lebedev order of the angular grid
+    unsigned int radial_points;     //!< number of Gauss-Chebyshev nodes per shell
+
+public:
+    /**
+     * @brief      constructor
+     *
+     * @param[in]  _sf             scalar field
+     * @param[in]  _lebedev_order  Lebedev order of the angular grid
+     * @param[in]  _radial_points  number of Gauss-Chebyshev nodes per shell
+     */
+    SphereIntegrator(const ScalarField* _sf,
+                     unsigned int _lebedev_order = Quadrature::LEBEDEV_194,
+                     unsigned int _radial_points = 8);
+
+    /**
+     * @brief      integrate the scalar field within spheres
+     *
+     * @param[in]  centers  centers of the spheres
+     * @param[in]  radii    increasing radii of the spheres
+     *
+     * @return     integral for each center (outer index) and radius (inner index)
+     */
+    std::vector<std::vector<float> > integrate(const std::vector<glm::vec3>& centers,
+                                               const std::vector<float>& radii) const;
+
+    /**
+     * @brief      integrate the scalar field within spheres around all atoms
+     *             and write a table with one column per atom
+     *
+     * @param[in]  filename  output file
+     * @param[in]  radius    largest radius
+     * @param[in]  step      distance between subsequent radii
+     */
+    void write_atom_table(const std::string& filename, float radius, float step) const;
+};
+
+#endif //_SPHERE_INTEGRATOR_H
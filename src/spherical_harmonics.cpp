@@ -0,0 +1,71 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "spherical_harmonics.h"
+
+#include <cmath>
+
+/**
+ * @brief      evaluate all harmonics up to lmax in a direction
+ *
+ * The normalized associated Legendre functions are obtained from the
+ * standard (stable) recurrences in l for fixed m.
+ *
+ * @param[in]  lmax  maximum angular momentum
+ * @param[in]  dir   unit vector
+ * @param[out] out   values (at least (lmax + 1)^2)
+ */
+void SphericalHarmonics::evaluate(unsigned int lmax, const glm::dvec3& dir, double* out) {
+    const double ct = std::max(-1.0, std::min(1.0, dir[2]));
+    const double st = std::sqrt(std::max(0.0, 1.0 - ct * ct));
+    const double phi = std::atan2(dir[1], dir[0]);
+
+    // normalized P_m^m, starting from P_0^0 = 1 / sqrt(4 pi)
+    double pmm = 1.0 / std::sqrt(4.0 * M_PI);
+    for(unsigned int m=0; m<=lmax; m++) {
+        if(m > 0) {
+            pmm *= std::sqrt((2.0 * m + 1.0) / (2.0 * m)) * st;
+        }
+
+        const double cm = m > 0 ? std::sqrt(2.0) * std::cos(m * phi) : 1.0;
+        const double sm = m > 0 ? std::sqrt(2.0) * std::sin(m * phi) : 0.0;
+
+        // recurrence in l for fixed m
+        double p_prev = 0.0;
+        double p_cur = pmm;
+        for(unsigned int l=m; l<=lmax; l++) {
+            if(l == m + 1) {
+                p_prev = p_cur;
+                p_cur = std::sqrt(2.0 * m + 3.0) * ct * pmm;
+            } else if(l > m + 1) {
+                const double a = std::sqrt((4.0 * l * l - 1.0) / ((double)l * l - (double)m * m));
+                const double b = std::sqrt(((l - 1.0) * (l - 1.0) - (double)m * m) / (4.0 * (l - 1.0) * (l - 1.0) - 1.0));
+                const double p_next = a * (ct * p_cur - b * p_prev);
+                p_prev = p_cur;
+                p_cur = p_next;
+            }
+
+            out[get_index(l, m)] = cm * p_cur;
+            if(m > 0) {
+                out[get_index(l, -(int)m)] = sm * p_cur;
+            }
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _SPHERICAL_HARMONICS_H
+#define _SPHERICAL_HARMONICS_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @brief      real spherical harmonics
+ *
+ * The harmonics are orthonormal on the unit sphere and do not include the
+ * Condon-Shortley phase:
+ *   Y_l0  = N_l0 P_l^0(cos theta)
+ *   Y_lm  = sqrt(2) N_lm P_l^m(cos theta) cos(m phi)    (m > 0)
+ *   Y_l-m = sqrt(2) N_lm P_l^m(cos theta) sin(m phi)    (m > 0)
+ *
+ * The values for all (l,m) up to lmax are stored consecutively at index
+ * l*l + l + m.
+ */
+class SphericalHarmonics {
+public:
+    /**
+     * @brief      number of harmonics up to and including lmax
+     *
+     * @param[in]  lmax  maximum angular momentum
+     *
+     * @return     (lmax + 1)^2
+     */
+    static inline unsigned int get_size(unsigned int lmax) {
+        return (lmax + 1) * (lmax + 1);
+    }
+
+    /**
+     * @brief      index of Y_lm
+     *
+     * @param[in]  l     angular momentum
+     * @param[in]  m     magnetic quantum number (-l <= m <= l)
+     *
+     * @return     index
+     */
+    static inline unsigned int get_index(unsigned int l, int m) {
+        return l * l + l + m;
+    }
+
+    /**
+     * @brief      evaluate all harmonics up to lmax in a direction
+     *
+     * @param[in]  lmax  maximum angular momentum
+     * @param[in]  dir   unit vector
+     * @param[out] out   values (at least (lmax + 1)^2)
+     */
+    static void evaluate(unsigned int lmax, const glm::dvec3& dir, double* out);
+};
+
+#endif //_SPHERICAL_HARMONICS_H
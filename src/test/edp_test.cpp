@@ -0,0 +1,356 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+/*
+ * PURPOSE
+ * =======
+ *
+ * Round-trip tests of the numerical paths that are hard to verify by eye:
+ * the CHGCAR/LOCPOT writer, the compressed archive and the minimum image
+ * convention of the cell list. Every check prints a message when it fails;
+ * the exit code is the number of failed checks (capped at 255).
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include <boost/format.hpp>
+#include <glm/glm.hpp>
+
+#include "scalar_field.h"
+#include "chgcar_writer.h"
+#include "grid_archive.h"
+#include "cell_list.h"
+#include "float_parser.h"
+
+namespace {
+
+unsigned int failures = 0;
+
+/**
+ * @brief      report a failed check
+ *
+ * @param[in]  condition  result of the check
+ * @param[in]  message    description of the check
+ */
+void check(bool condition, const std::string& message) {
+    if(!condition) {
+        std::cerr << "FAILED: " << message << std::endl;
+        failures++;
+    }
+}
+
+/**
+ * @brief      whether two values agree to within a relative tolerance; the
+ *             grid parser is not correctly rounded, hence values read from
+ *             text may differ in the last bits
+ *
+ * @param[in]  a     first value
+ * @param[in]  b     second value
+ *
+ * @return     true if equal within tolerance
+ */
+bool nearly_equal(float a, float b) {
+    return std::fabs(a - b) <= 1e-6f * std::max(std::fabs(a), std::fabs(b)) + std::numeric_limits<float>::denorm_min();
+}
+
+/**
+ * @brief      write a LOCPOT file with a cubic cell and a single atom
+ *
+ * @param[in]  filename  output file
+ * @param[in]  dim       grid dimensions
+ * @param[in]  values    grid values (x runs fastest)
+ */
+void write_locpot(const std::string& filename, const unsigned int dim[3], const std::vector<float>& values) {
+    std::ofstream out(filename);
+    out << "test LOCPOT\n   1.00000000000000\n";
+    out << "     5.000000     0.000000     0.000000\n";
+    out << "     0.000000     5.000000     0.000000\n";
+    out << "     0.000000     0.000000     5.000000\n";
+    out << "   H\n     1\nDirect\n  0.000000  0.000000  0.000000\n\n";
+    out << "   " << dim[0] << "   " << dim[1] << "   " << dim[2] << "\n";
+    for(size_t i=0; i<values.size(); i++) {
+        out << boost::format(" %17.11E") % values[i];
+        if(i % 5 == 4 || i + 1 == values.size()) {
+            out << "\n";
+        }
+    }
+}
+
+/**
+ * @brief      format values in the form of VASP and parse them again, both
+ *             exactly (strtof) and with the grid parser
+ */
+void test_format_round_trip() {
+    std::vector<float> values = {
+        0.0f, 1.0f, -1.0f, 0.1f, -0.1f, 123456.789f, -9.87654321e-12f,
+        FLT_MAX, -FLT_MAX, FLT_MIN, -FLT_MIN,
+        std::numeric_limits<float>::denorm_min(), -std::numeric_limits<float>::denorm_min(),
+        1e-40f, -1e-40f, 3.0e38f, -3.0e38f
+    };
+
+    // random bit patterns cover all exponents
+    std::mt19937 rng(42);
+    while(values.size() < 100000) {
+        const uint32_t bits = rng();
+        float f;
+        std::memcpy(&f, &bits, sizeof(float));
+        if(std::isfinite(f)) {
+            values.push_back(f);
+        }
+    }
+
+    const float_parser parser;
+    unsigned int wrong_width = 0;
+    unsigned int not_exact = 0;
+    unsigned int not_parsed = 0;
+    for(float value : values) {
+        char buffer[32];
+        char* end = ChgcarWriter::format_value(value, buffer);
+        const std::string text(buffer, end);
+
+        if(text.size() != 18 || text[0] != ' ' || text[2] != '.' || (text[1] != '0' && text[1] != '-')) {
+            if(wrong_width++ < 5) {
+                std::cerr << "unexpected format: '" << text << "'" << std::endl;
+            }
+        }
+
+        // eleven digits suffice to recover every float exactly
+        if(std::strtof(text.c_str(), nullptr) != value) {
+            not_exact++;
+        }
+
+        std::vector<float> parsed;
+        std::string::const_iterator b = text.begin();
+        boost::spirit::qi::phrase_parse(b, text.cend(), parser, boost::spirit::ascii::space, parsed);
+        if(b != text.cend() || parsed.size() != 1 || !nearly_equal(parsed[0], value)) {
+            not_parsed++;
+        }
+    }
+
+    check(wrong_width == 0, (boost::format("%i values are not formatted as 18 characters") % wrong_width).str());
+    check(not_exact == 0, (boost::format("%i values do not round-trip exactly") % not_exact).str());
+    check(not_parsed == 0, (boost::format("%i values are not read back by the grid parser") % not_parsed).str());
+}
+
+/**
+ * @brief      write a LOCPOT with ChgcarWriter and read it back
+ */
+void test_writer_round_trip() {
+    const unsigned int dim[3] = {7, 5, 3};     // not a multiple of five values
+    std::vector<float> values((size_t)dim[0] * dim[1] * dim[2]);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for(size_t i=0; i<values.size(); i++) {
+        values[i] = dist(rng) * std::pow(10.0f, (float)(i % 76) - 38.0f);
+    }
+    write_locpot("LOCPOT_test_input", dim, values);
+
+    ScalarField input("LOCPOT_test_input", true);
+    input.read();
+    const size_t bytes = ChgcarWriter(&input).write("LOCPOT_test_output");
+    check(bytes == boost::filesystem::file_size("LOCPOT_test_output"), "number of bytes written");
+
+    // the grid starts after the empty line before the grid dimensions
+    std::ifstream in("LOCPOT_test_output");
+    std::string line;
+    while(std::getline(in, line) && !line.empty()) {}
+    std::getline(in, line);
+    std::vector<std::string> lines;
+    while(std::getline(in, line)) {
+        lines.push_back(line);
+    }
+    check(lines.size() == (values.size() + 4) / 5, "number of grid lines");
+    bool widths = !lines.empty() && lines.back().size() == 18 * ((values.size() - 1) % 5 + 1);
+    for(size_t i=0; i+1<lines.size(); i++) {
+        widths &= lines[i].size() == 90;
+    }
+    check(widths, "grid lines hold five values of 18 characters");
+
+    ScalarField output("LOCPOT_test_output", true);
+    output.read();
+    bool equal = output.get_size() == input.get_size();
+    for(size_t i=0; equal && i<input.get_size(); i++) {
+        equal = nearly_equal(output.get_grid_ptr()[i], input.get_grid_ptr()[i]);
+    }
+    check(equal, "values read back from the written LOCPOT");
+
+    boost::filesystem::remove("LOCPOT_test_input");
+    boost::filesystem::remove("LOCPOT_test_output");
+}
+
+/**
+ * @brief      write a LOCPOT whose grid is not a multiple of the brick size
+ *             to lossless and error-bounded archives and read them back,
+ *             both completely and per region
+ */
+void test_archive_round_trip() {
+    const unsigned int dim[3] = {13, 10, 19};
+    std::vector<float> values((size_t)dim[0] * dim[1] * dim[2]);
+    for(unsigned int k=0; k<dim[2]; k++) {
+        for(unsigned int j=0; j<dim[1]; j++) {
+            for(unsigned int i=0; i<dim[0]; i++) {
+                values[((size_t)k * dim[1] + j) * dim[0] + i] = std::sin(0.5f * i) * std::cos(0.3f * j) - 0.1f * k;
+            }
+        }
+    }
+    values[0] = 1e6f;   // a brick with a range too large to be quantized
+    write_locpot("LOCPOT_test_archive", dim, values);
+
+    ScalarField input("LOCPOT_test_archive", true);
+    input.read();
+
+    // lossless
+    const size_t lossless_bytes = input.write_archive("LOCPOT_test_lossless.edpa", 0.0f);
+    ScalarField lossless("LOCPOT_test_lossless.edpa", true);
+    lossless.read();
+    bool equal = lossless.get_size() == input.get_size();
+    for(size_t i=0; equal && i<input.get_size(); i++) {
+        equal = lossless.get_grid_ptr()[i] == input.get_grid_ptr()[i];
+    }
+    check(equal, "lossless archive reproduces the grid exactly");
+
+    // error-bounded
+    const float error_bound = 1e-3f;
+    const size_t bounded_bytes = input.write_archive("LOCPOT_test_bounded.edpa", error_bound);
+    check(bounded_bytes < lossless_bytes, "error-bounded archive is smaller than the lossless one");
+    ScalarField bounded("LOCPOT_test_bounded.edpa", true);
+    bounded.read();
+    bool within = bounded.get_size() == input.get_size();
+    for(size_t i=0; within && i<input.get_size(); i++) {
+        within = std::fabs(bounded.get_grid_ptr()[i] - input.get_grid_ptr()[i]) <= error_bound;
+    }
+    check(within, "error-bounded archive stays within the error bound");
+
+    // random access to a region that crosses bricks and the grid boundary
+    for(const char* filename : {"LOCPOT_test_lossless.edpa", "LOCPOT_test_bounded.edpa"}) {
+        ScalarField field(filename, true);
+        const GridArchive archive = field.open_archive();
+        const float tolerance = archive.get_error_bound();
+        const unsigned int lo[3] = {3, 6, 5};
+        const unsigned int hi[3] = {13, 10, 17};
+        std::vector<float> region((size_t)(hi[0] - lo[0]) * (hi[1] - lo[1]) * (hi[2] - lo[2]));
+        archive.read_region(lo, hi, region.data());
+
+        bool match = true;
+        size_t idx = 0;
+        for(unsigned int k=lo[2]; k<hi[2]; k++) {
+            for(unsigned int j=lo[1]; j<hi[1]; j++) {
+                for(unsigned int i=lo[0]; i<hi[0]; i++, idx++) {
+                    match &= std::fabs(region[idx] - input.get_value(i, j, k)) <= tolerance;
+                }
+            }
+        }
+        check(match, std::string("region read from ") + filename);
+    }
+
+    boost::filesystem::remove("LOCPOT_test_archive");
+    boost::filesystem::remove("LOCPOT_test_lossless.edpa");
+    boost::filesystem::remove("LOCPOT_test_bounded.edpa");
+}
+
+/**
+ * @brief      compare the minimum image of the cell list with a brute-force
+ *             search in strongly skewed cells; every skewed cell is a
+ *             unimodular transformation of a nearly orthogonal cell, in
+ *             which the shortest image is among the neighbors of the
+ *             rounded one
+ */
+void test_minimum_image() {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    // columns of integer matrices with determinant one
+    const glm::mat3 transforms[] = {
+        glm::mat3(1.0f),
+        glm::mat3(glm::vec3(1, 0, 0), glm::vec3(2, 1, 0), glm::vec3(0, -1, 1)),
+        glm::mat3(glm::vec3(1, 1, 0), glm::vec3(0, 1, 0), glm::vec3(3, 2, 1)),
+        glm::mat3(glm::vec3(1, 0, -2), glm::vec3(-1, 1, 3), glm::vec3(0, 0, 1)),
+    };
+
+    unsigned int mismatches = 0;
+    unsigned int not_periodic = 0;
+    for(unsigned int c=0; c<20; c++) {
+        glm::mat3 cell;
+        for(unsigned int d=0; d<3; d++) {
+            cell[d] = glm::vec3(dist(rng), dist(rng), dist(rng)) * 0.3f;
+            cell[d][d] += 3.0f + dist(rng);
+        }
+        const glm::mat3 icell = glm::inverse(cell);
+
+        for(const glm::mat3& transform : transforms) {
+            const glm::mat3 mat = cell * transform;
+            const CellList cell_list(mat, std::vector<glm::vec3>(1, glm::vec3(0.0f)), 1.0f);
+
+            for(unsigned int t=0; t<100; t++) {
+                const glm::vec3 v = glm::vec3(dist(rng), dist(rng), dist(rng)) * 20.0f;
+
+                float shortest = std::numeric_limits<float>::max();
+                const glm::vec3 n0 = glm::round(icell * v);
+                for(int i=-2; i<=2; i++) {
+                    for(int j=-2; j<=2; j++) {
+                        for(int k=-2; k<=2; k++) {
+                            const glm::vec3 w = v - cell * (n0 + glm::vec3(i, j, k));
+                            shortest = std::min(shortest, glm::length(w));
+                        }
+                    }
+                }
+
+                const glm::vec3 image = cell_list.get_minimum_image(v);
+                if(std::fabs(glm::length(image) - shortest) > 1e-4f * std::max(1.0f, shortest)) {
+                    mismatches++;
+                }
+
+                // the image should differ from v by a lattice vector
+                const glm::vec3 n = icell * (image - v);
+                if(glm::length(n - glm::round(n)) > 1e-3f) {
+                    not_periodic++;
+                }
+            }
+        }
+    }
+
+    check(mismatches == 0, (boost::format("%i minimum images are longer than the shortest image") % mismatches).str());
+    check(not_periodic == 0, (boost::format("%i minimum images are not periodic images") % not_periodic).str());
+}
+
+} // namespace
+
+int main() {
+    test_format_round_trip();
+    test_writer_round_trip();
+    test_archive_round_trip();
+    test_minimum_image();
+
+    if(failures == 0) {
+        std::cout << "All tests passed" << std::endl;
+    } else {
+        std::cout << failures << " check(s) failed" << std::endl;
+    }
+    return std::min(failures, 255u);
+}
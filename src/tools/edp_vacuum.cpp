@@ -0,0 +1,118 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+/*
+ * PURPOSE
+ * =======
+ *
+ * Determines the vacuum level(s) and the dipole step from the planar
+ * average of one or more LOCPOT files, e.g. to compute the work functions
+ * of a series of slabs. Optionally, the planar and macroscopic averages are
+ * written to file.
+ */
+
+#include <iostream>
+#include <tclap/CmdLine.h>
+#include <boost/format.hpp>
+
+#include "scalar_field.h"
+#include "planeprojector.h"
+#include "potential_profile.h"
+#include "config.h"
+
+int main(int argc, char *argv[]) {
+    try {
+        TCLAP::CmdLine cmd("Determines the vacuum level of slabs from LOCPOT files.", ' ', PROGRAM_VERSION);
+
+        std::vector<unsigned int> axes = {0, 1, 2};
+        TCLAP::ValuesConstraint<unsigned int> axis_constraint(axes);
+        TCLAP::ValueArg<unsigned int> arg_axis("a","axis","Lattice vector normal to the slab",false,2,&axis_constraint);
+        cmd.add(arg_axis);
+
+        TCLAP::ValueArg<float> arg_period("p","period","Window of the macroscopic average in angstrom (interlayer distance)",false,0.0f,"float");
+        cmd.add(arg_period);
+
+        TCLAP::ValueArg<float> arg_width("w","width","Minimum width of a vacuum plateau in angstrom",false,2.0f,"float");
+        cmd.add(arg_width);
+
+        TCLAP::ValueArg<float> arg_tolerance("t","tolerance","Maximum gradient in a vacuum plateau in V/angstrom",false,0.02f,"float");
+        cmd.add(arg_tolerance);
+
+        TCLAP::SwitchArg arg_write("o","output","Write the planar and macroscopic averages to <file>.profile.txt", cmd, false);
+
+        TCLAP::UnlabeledMultiArg<std::string> arg_files("files","LOCPOT files",true,"filenames", cmd);
+
+        cmd.parse(argc, argv);
+
+        const unsigned int axis = arg_axis.getValue();
+
+        std::vector<std::string> lines;
+        for(const std::string& filename : arg_files.getValue()) {
+            // a file that cannot be read or analysed does not stop the others
+            try {
+                ScalarField sf(filename, true);
+                sf.read();
+
+                PlaneProjector pp(&sf, 0);
+                const std::vector<float> avg = pp.calculate_plane_averages()[axis];
+
+                // distance between the planes spanned by the other two lattice vectors
+                const glm::mat3& mat = sf.get_mat_unitcell();
+                const glm::vec3 normal = glm::cross(mat[(axis + 1) % 3], mat[(axis + 2) % 3]);
+                const float length = std::fabs(glm::dot(mat[axis], normal)) / glm::length(normal);
+
+                const PotentialProfile profile(avg, length);
+                const VacuumLevel vacuum = profile.find_vacuum_level(arg_width.getValue(), arg_tolerance.getValue(), arg_period.getValue());
+
+                if(arg_write.getValue()) {
+                    const std::vector<float> macro = profile.macroscopic_average(arg_period.getValue());
+                    std::ofstream out(filename + ".profile.txt");
+                    for(unsigned int i=0; i<avg.size(); i++) {
+                        out << boost::format("%12.6f  %12.6f  %12.6f\n") % ((i + 0.5f) * profile.get_spacing()) % avg[i] % macro[i];
+                    }
+                    out.close();
+                }
+
+                if(vacuum.found) {
+                    lines.push_back((boost::format("%-40s  %12.6f  %12.6f  %12.6f  %8.3f") % filename %
+                                     vacuum.level_low % vacuum.level_high % vacuum.dipole_step % vacuum.width).str());
+                } else {
+                    lines.push_back((boost::format("%-40s  %12s") % filename % "no vacuum found").str());
+                }
+            } catch(const std::exception& e) {
+                std::cerr << "error: " << filename << ": " << e.what() << std::endl;
+                lines.push_back((boost::format("%-40s  %12s") % filename % "failed").str());
+            }
+        }
+
+        std::cout << std::endl;
+        std::cout << boost::format("%-40s  %12s  %12s  %12s  %8s") % "file" % "vacuum low" % "vacuum high" % "dipole step" % "width" << std::endl;
+        for(const std::string& line : lines) {
+            std::cout << line << std::endl;
+        }
+
+        return 0;
+
+    } catch (TCLAP::ArgException &e) {
+        std::cerr << "error: " << e.error() <<
+                     " for arg " << e.argId() << std::endl;
+        return -1;
+    }
+}
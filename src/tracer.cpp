@@ -0,0 +1,133 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "tracer.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <boost/format.hpp>
+
+Tracer::Tracer() :
+    enabled(false),
+    start(std::chrono::steady_clock::now()) {}
+
+/**
+ * @brief      enable or disable recording of events
+ *
+ * @param[in]  _enabled  whether to record events
+ */
+void Tracer::set_enabled(bool _enabled) {
+    std::lock_guard<std::mutex> lock(this->mtx);
+    if(_enabled && !this->enabled) {
+        this->start = std::chrono::steady_clock::now();
+    }
+    this->enabled = _enabled;
+}
+
+/**
+ * @brief      get current time relative to the start of the trace
+ *
+ * @return     time in microseconds
+ */
+double Tracer::now() const {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - this->start).count();
+}
+
+/**
+ * @brief      record an event for the calling thread
+ *
+ * @param[in]  name   name of the event (should outlive the tracer)
+ * @param[in]  begin  start time in microseconds
+ * @param[in]  end    end time in microseconds
+ */
+void Tracer::record(const char* name, double begin, double end) {
+    if(!this->enabled) {
+        return;
+    }
+
+    Event event;
+    event.name = name;
+    event.ts = begin;
+    event.dur = end - begin;
+    this->get_thread_buffer()->events.push_back(event);
+}
+
+/**
+ * @brief      write all events in Chrome trace format
+ *
+ * @param[in]  filename  path to output file
+ */
+void Tracer::write_json(const std::string& filename) const {
+    std::lock_guard<std::mutex> lock(this->mtx);
+
+    std::ofstream out(filename);
+    if(!out.is_open()) {
+        throw std::runtime_error("Cannot open " + filename + " for writing the trace.");
+    }
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl;
+    bool first = true;
+    for(const auto& buffer : this->buffers) {
+        out << (first ? "" : ",\n")
+            << boost::format("{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %i, \"args\": {\"name\": \"thread %i\"}}")
+               % buffer->tid % buffer->tid;
+        first = false;
+
+        for(const Event& event : buffer->events) {
+            out << boost::format(",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %i, \"ts\": %.3f, \"dur\": %.3f}")
+                   % event.name % buffer->tid % event.ts % event.dur;
+        }
+    }
+    out << std::endl << "]}" << std::endl;
+
+    out.close();
+}
+
+/**
+ * @brief      get the event buffer of the calling thread; buffers are
+ *             created on first use and numbered in order of creation
+ *
+ * @return     pointer to buffer
+ */
+Tracer::ThreadBuffer* Tracer::get_thread_buffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if(buffer == nullptr) {
+        std::lock_guard<std::mutex> lock(this->mtx);
+        this->buffers.emplace_back(new ThreadBuffer);
+        buffer = this->buffers.back().get();
+        buffer->tid = this->buffers.size() - 1;
+    }
+    return buffer;
+}
+
+TraceScope::TraceScope(const char* _name) :
+    name(_name),
+    begin(0.0),
+    active(Tracer::get().is_enabled()) {
+    if(this->active) {
+        this->begin = Tracer::get().now();
+    }
+}
+
+TraceScope::~TraceScope() {
+    if(this->active) {
+        Tracer::get().record(this->name, this->begin, Tracer::get().now());
+    }
+}
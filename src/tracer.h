@@ -0,0 +1,136 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _TRACER_H
+#define _TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief      records begin/end events per thread and writes them as a
+ *             Chrome trace (chrome://tracing or https://ui.perfetto.dev)
+ *
+ * Every thread appends to its own buffer, such that recording an event does
+ * not require any locking.
+ */
+class Tracer {
+private:
+    class Event {
+    public:
+        const char* name;       //!< name of the event (string literal)
+        double ts;              //!< start time in microseconds
+        double dur;             //!< duration in microseconds
+    };
+
+    class ThreadBuffer {
+    public:
+        unsigned int tid;
+        std::vector<Event> events;
+    };
+
+    std::atomic<bool> enabled;
+    std::chrono::steady_clock::time_point start;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    mutable std::mutex mtx;
+
+public:
+    static Tracer& get() {
+        static Tracer tracer_instance;
+        return tracer_instance;
+    }
+
+    /**
+     * @brief      enable or disable recording of events
+     *
+     * @param[in]  _enabled  whether to record events
+     */
+    void set_enabled(bool _enabled);
+
+    inline bool is_enabled() const {
+        return this->enabled;
+    }
+
+    /**
+     * @brief      get current time relative to the start of the trace
+     *
+     * @return     time in microseconds
+     */
+    double now() const;
+
+    /**
+     * @brief      record an event for the calling thread
+     *
+     * @param[in]  name   name of the event (should outlive the tracer)
+     * @param[in]  begin  start time in microseconds
+     * @param[in]  end    end time in microseconds
+     */
+    void record(const char* name, double begin, double end);
+
+    /**
+     * @brief      write all events in Chrome trace format
+     *
+     * @param[in]  filename  path to output file
+     */
+    void write_json(const std::string& filename) const;
+
+private:
+    Tracer();
+
+    ThreadBuffer* get_thread_buffer();
+
+    Tracer(Tracer const&)              = delete;
+    void operator=(Tracer const&)      = delete;
+};
+
+/**
+ * @brief      records an event spanning the enclosing scope
+ */
+class TraceScope {
+private:
+    const char* name;
+    double begin;
+    bool active;
+
+public:
+    TraceScope(const char* _name);
+
+    ~TraceScope();
+
+private:
+    TraceScope(TraceScope const&)      = delete;
+    void operator=(TraceScope const&)  = delete;
+};
+
+// Place EDP_TRACE_SCOPE inside parallel regions to record the work of each
+// thread; compiled out unless EDP_TRACING is defined.
+#ifdef EDP_TRACING
+#define EDP_TRACE_CONCAT_IMPL(a, b) a##b
+#define EDP_TRACE_CONCAT(a, b) EDP_TRACE_CONCAT_IMPL(a, b)
+#define EDP_TRACE_SCOPE(name) TraceScope EDP_TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#else
+#define EDP_TRACE_SCOPE(name)
+#endif
+
+#endif // _TRACER_H
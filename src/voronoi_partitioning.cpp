@@ -0,0 +1,126 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "voronoi_partitioning.h"
+
+#include <fstream>
+#include <boost/format.hpp>
+
+/**
+ * @brief      constructor
+ *
+ * @param[in]  _sf   scalar field
+ */
+VoronoiPartitioning::VoronoiPartitioning(const ScalarField* _sf) :
+    sf(_sf) {}
+
+/**
+ * @brief      assign the grid points to the atoms and integrate
+ *
+ * The nearest atom of each grid point is looked up in a cell list whose
+ * cells hold about one atom, such that each lookup only visits the
+ * neighboring cells. The work is divided over the threads in slabs along
+ * z; each thread accumulates in its own buffers.
+ */
+void VoronoiPartitioning::calculate() {
+    ScopedTimer timer("voronoi partitioning");
+
+    const unsigned int natoms = this->sf->get_nr_atoms();
+    if(natoms == 0) {
+        throw std::runtime_error("Voronoi partitioning requires at least one atom.");
+    }
+
+    unsigned int dim[3];
+    this->sf->copy_grid_dimensions(dim);
+    const unsigned int nx = dim[0];
+    const unsigned int ny = dim[1];
+    const unsigned int nz = dim[2];
+    if(this->sf->get_size() != (size_t)nx * ny * nz) {
+        throw std::runtime_error("Grid has not been read.");
+    }
+
+    // a cutoff of the average distance between the atoms
+    const float spacing = std::cbrt(this->sf->get_volume() / natoms);
+    const CellList cell_list(this->sf->get_mat_unitcell(), this->sf->get_atom_positions(), spacing);
+
+    std::vector<double> sum(natoms, 0.0);
+    std::vector<size_t> count(natoms, 0);
+    const glm::mat3& mat = this->sf->get_mat_unitcell();
+
+    #pragma omp parallel
+    {
+        EDP_TRACE_SCOPE("voronoi partitioning");
+        std::vector<double> local_sum(natoms, 0.0);
+        std::vector<size_t> local_count(natoms, 0);
+        std::vector<float> buffer(nx);
+
+        #pragma omp for schedule(dynamic) nowait
+        for(unsigned int k=0; k<nz; k++) {
+            for(unsigned int j=0; j<ny; j++) {
+                const float* row = this->sf->get_row(j, k, buffer.data());
+                for(unsigned int i=0; i<nx; i++) {
+                    // grid values are located at the centers of the voxels
+                    const glm::vec3 p = mat * glm::vec3((i + 0.5f) / nx, (j + 0.5f) / ny, (k + 0.5f) / nz);
+                    const unsigned int atom = cell_list.find_nearest(p).atom;
+                    local_sum[atom] += row[i];
+                    local_count[atom]++;
+                }
+            }
+        }
+
+        #pragma omp critical
+        {
+            for(unsigned int a=0; a<natoms; a++) {
+                sum[a] += local_sum[a];
+                count[a] += local_count[a];
+            }
+        }
+    }
+
+    // every grid point represents an equal part of the unit cell
+    const double dv = this->sf->get_volume() / ((double)nx * ny * nz);
+    this->charges.resize(natoms);
+    this->volumes.resize(natoms);
+    for(unsigned int a=0; a<natoms; a++) {
+        this->charges[a] = sum[a] * dv;
+        this->volumes[a] = count[a] * dv;
+    }
+
+    timer.set_bytes(this->sf->get_size() * sizeof(float));
+    timer.set_items(this->sf->get_size(), "values");
+}
+
+/**
+ * @brief      write the volume and charge of each atom to a table
+ *
+ * @param[in]  filename  output file
+ */
+void VoronoiPartitioning::write(const std::string& filename) const {
+    std::ofstream out(filename);
+    out << boost::format("%6s  %14s  %14s\n") % "# atom" % "volume" % "charge";
+    double total = 0.0;
+    for(unsigned int a=0; a<this->charges.size(); a++) {
+        out << boost::format("%6i  %14.6f  %14.6f\n") % (a + 1) % this->volumes[a] % this->charges[a];
+        total += this->charges[a];
+    }
+    out.close();
+
+    std::cout << "Writing Voronoi charges of " << this->charges.size() << " atoms (total: " << total << ") to " << filename << std::endl;
+}
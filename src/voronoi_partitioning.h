@@ -0,0 +1,81 @@
+/**************************************************************************
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   EDP is free software:                                                *
+ *   you can redistribute it and/or modify it under the terms of the      *
+ *   GNU General Public License as published by the Free Software         *
+ *   Foundation, either version 3 of the License, or (at your option)     *
+ *   any later version.                                                   *
+ *                                                                        *
+ *   EDP is distributed in the hope that it will be useful,               *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#ifndef _VORONOI_PARTITIONING_H
+#define _VORONOI_PARTITIONING_H
+
+#include <vector>
+#include <string>
+
+#include "scalar_field.h"
+#include "cell_list.h"
+
+/**
+ * @brief      assigns every grid point to the nearest atom (periodic minimum
+ *             image) and integrates the scalar field over the Voronoi
+ *             (Wigner-Seitz) cell of each atom
+ */
+class VoronoiPartitioning {
+private:
+    const ScalarField* sf;
+
+    std::vector<double> charges;    //!< integral of the field over the cell of each atom
+    std::vector<double> volumes;    //!< volume of the cell of each atom
+
+public:
+    /**
+     * @brief      constructor
+     *
+     * @param[in]  _sf   scalar field
+     */
+    VoronoiPartitioning(const ScalarField* _sf);
+
+    /**
+     * @brief      assign the grid points to the atoms and integrate
+     */
+    void calculate();
+
+    /**
+     * @brief      write the volume and charge of each atom to a table
+     *
+     * @param[in]  filename  output file
+     */
+    void write(const std::string& filename) const;
+
+    /**
+     * @brief      get the integral of the field over the cell of each atom
+     *
+     * @return     charges
+     */
+    inline const std::vector<double>& get_charges() const {
+        return this->charges;
+    }
+
+    /**
+     * @brief      get the volume of the cell of each atom
+     *
+     * @return     volumes in angstrom^3
+     */
+    inline const std::vector<double>& get_volumes() const {
+        return this->volumes;
+    }
+};
+
+#endif //_VORONOI_PARTITIONING_H